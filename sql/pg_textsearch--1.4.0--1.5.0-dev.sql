@@ -14,3 +14,150 @@ BEGIN
             'Add pg_textsearch to shared_preload_libraries and restart.';
     END IF;
 END $$;
+
+-- Eviction-policy inspection scaffold (in-memory memtable cache).
+-- INTERNAL-ONLY; superuser-only, not a supported API.
+CREATE FUNCTION @extschema@.bm25_cache_eviction_candidates(
+    OUT index_oid oid,
+    OUT estimated_bytes bigint,
+    OUT access_count bigint,
+    OUT last_access timestamptz,
+    OUT rebuild_records bigint,
+    OUT eviction_score double precision)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'bm25_cache_eviction_candidates'
+LANGUAGE C STRICT;
+
+REVOKE EXECUTE ON FUNCTION @extschema@.bm25_cache_eviction_candidates()
+    FROM PUBLIC;
+
+-- Merge policy, per-level segment counts, and segment bytes written
+-- (write amplification), merges, parallel workers, build merge rounds
+-- and merge throttle sleeps since server start.
+CREATE FUNCTION @extschema@.bm25_merge_stats(
+    index_name text,
+    OUT merge_policy text,
+    OUT level_counts int4[],
+    OUT bytes_ingested bigint,
+    OUT bytes_merged bigint,
+    OUT write_amplification double precision,
+    OUT merges bigint,
+    OUT parallel_workers bigint,
+    OUT merge_rounds bigint,
+    OUT throttle_sleeps bigint)
+RETURNS record
+AS 'MODULE_PATHNAME', 'tp_merge_stats'
+LANGUAGE C STRICT STABLE;
+
+REVOKE EXECUTE ON FUNCTION @extschema@.bm25_merge_stats(text) FROM PUBLIC;
+
+-- Shared top-k result cache (pg_textsearch.result_cache): its size,
+-- occupied entries, and hits and misses since server start.
+CREATE FUNCTION @extschema@.bm25_result_cache_stats(
+    OUT entries int4,
+    OUT used int4,
+    OUT hits bigint,
+    OUT misses bigint)
+RETURNS record
+AS 'MODULE_PATHNAME', 'tp_result_cache_stats'
+LANGUAGE C STRICT VOLATILE;
+
+REVOKE EXECUTE ON FUNCTION @extschema@.bm25_result_cache_stats() FROM PUBLIC;
+
+-- This backend's BM25 scoring work since it started: scoring passes,
+-- passes that skipped an index whose best possible score was below
+-- their threshold (a LIMIT's shared top-k threshold or a pushed-down
+-- score bound), and documents scored.
+CREATE FUNCTION @extschema@.bm25_scoring_stats(
+    OUT scoring_passes bigint,
+    OUT indexes_skipped bigint,
+    OUT docs_scored bigint)
+RETURNS record
+AS 'MODULE_PATHNAME', 'tp_scoring_stats'
+LANGUAGE C STRICT VOLATILE;
+
+REVOKE EXECUTE ON FUNCTION @extschema@.bm25_scoring_stats() FROM PUBLIC;
+
+-- Match functions for text @@@ / @@& bm25query (any / all query terms)
+-- True when the document contains at least one (@@@) or every (@@&) term
+-- of the query.  Nothing is scored; a bm25 index answers these as a bitmap
+-- scan, so they combine with other indexes through BitmapAnd/BitmapOr.
+-- Outside an index scan the query must name its index, for the text
+-- search config to tokenize with.
+-- PARALLEL UNSAFE, STABLE: see bm25_text_bm25query_score.
+CREATE FUNCTION @extschema@.bm25_text_bm25query_match_any(
+    left_text text, right_query @extschema@.bm25query)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'bm25_text_bm25query_match_any'
+LANGUAGE C STABLE STRICT PARALLEL UNSAFE COST 1000;
+
+CREATE FUNCTION @extschema@.bm25_text_bm25query_match_all(
+    left_text text, right_query @extschema@.bm25query)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'bm25_text_bm25query_match_all'
+LANGUAGE C STABLE STRICT PARALLEL UNSAFE COST 1000;
+
+CREATE OPERATOR @extschema@.@@@ (
+    LEFTARG = text,
+    RIGHTARG = @extschema@.bm25query,
+    PROCEDURE = @extschema@.bm25_text_bm25query_match_any,
+    RESTRICT = contsel,
+    JOIN = contjoinsel
+);
+
+CREATE OPERATOR @extschema@.@@& (
+    LEFTARG = text,
+    RIGHTARG = @extschema@.bm25query,
+    PROCEDURE = @extschema@.bm25_text_bm25query_match_all,
+    RESTRICT = contsel,
+    JOIN = contjoinsel
+);
+
+-- Match functions for text[] @@@ / @@& bm25query; elements are
+-- flattened as for scoring.
+CREATE FUNCTION @extschema@.bm25_textarray_bm25query_match_any(
+    left_arr text[], right_query @extschema@.bm25query)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'bm25_textarray_bm25query_match_any'
+LANGUAGE C STABLE STRICT PARALLEL UNSAFE COST 1000;
+
+CREATE FUNCTION @extschema@.bm25_textarray_bm25query_match_all(
+    left_arr text[], right_query @extschema@.bm25query)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'bm25_textarray_bm25query_match_all'
+LANGUAGE C STABLE STRICT PARALLEL UNSAFE COST 1000;
+
+CREATE OPERATOR @extschema@.@@@ (
+    LEFTARG = text[],
+    RIGHTARG = @extschema@.bm25query,
+    PROCEDURE = @extschema@.bm25_textarray_bm25query_match_any,
+    RESTRICT = contsel,
+    JOIN = contjoinsel
+);
+
+CREATE OPERATOR @extschema@.@@& (
+    LEFTARG = text[],
+    RIGHTARG = @extschema@.bm25query,
+    PROCEDURE = @extschema@.bm25_textarray_bm25query_match_all,
+    RESTRICT = contsel,
+    JOIN = contjoinsel
+);
+
+ALTER OPERATOR FAMILY @extschema@.text_bm25_ops USING bm25 ADD
+    OPERATOR    2   @extschema@.@@@ (text, @extschema@.bm25query),
+    OPERATOR    3   @extschema@.@@& (text, @extschema@.bm25query);
+
+ALTER OPERATOR FAMILY @extschema@.text_array_bm25_ops USING bm25 ADD
+    OPERATOR    2   @extschema@.@@@ (text[], @extschema@.bm25query),
+    OPERATOR    3   @extschema@.@@& (text[], @extschema@.bm25query);
+
+-- Number of indexed documents containing any term of the query, as
+-- text @@@ bm25query selects them, counted from the posting lists without
+-- scoring or heap access.  Rows deleted since the last VACUUM, and rows
+-- of transactions still in progress, are included; count(*) with @@@
+-- gives the exact count visible to the query.
+-- PARALLEL UNSAFE, STABLE: see bm25_text_bm25query_score.
+CREATE FUNCTION @extschema@.bm25_count(index_name text, query text)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'bm25_count'
+LANGUAGE C STABLE STRICT PARALLEL UNSAFE;
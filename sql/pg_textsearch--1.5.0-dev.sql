@@ -191,12 +191,60 @@ CREATE OPERATOR @extschema@.= (
     HASHES
 );
 
+-- Match functions for text @@@ / @@& bm25query (any / all query terms)
+-- True when the document contains at least one (@@@) or every (@@&) term
+-- of the query.  Nothing is scored; a bm25 index answers these as a bitmap
+-- scan, so they combine with other indexes through BitmapAnd/BitmapOr.
+-- Outside an index scan the query must name its index, for the text
+-- search config to tokenize with.
+-- PARALLEL UNSAFE, STABLE: see bm25_text_bm25query_score.
+CREATE FUNCTION @extschema@.bm25_text_bm25query_match_any(
+    left_text text, right_query @extschema@.bm25query)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'bm25_text_bm25query_match_any'
+LANGUAGE C STABLE STRICT PARALLEL UNSAFE COST 1000;
+
+CREATE FUNCTION @extschema@.bm25_text_bm25query_match_all(
+    left_text text, right_query @extschema@.bm25query)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'bm25_text_bm25query_match_all'
+LANGUAGE C STABLE STRICT PARALLEL UNSAFE COST 1000;
+
+CREATE OPERATOR @extschema@.@@@ (
+    LEFTARG = text,
+    RIGHTARG = @extschema@.bm25query,
+    PROCEDURE = @extschema@.bm25_text_bm25query_match_any,
+    RESTRICT = contsel,
+    JOIN = contjoinsel
+);
+
+CREATE OPERATOR @extschema@.@@& (
+    LEFTARG = text,
+    RIGHTARG = @extschema@.bm25query,
+    PROCEDURE = @extschema@.bm25_text_bm25query_match_all,
+    RESTRICT = contsel,
+    JOIN = contjoinsel
+);
+
+-- Number of indexed documents containing any term of the query, as
+-- text @@@ bm25query selects them, counted from the posting lists without
+-- scoring or heap access.  Rows deleted since the last VACUUM, and rows
+-- of transactions still in progress, are included; count(*) with @@@
+-- gives the exact count visible to the query.
+-- PARALLEL UNSAFE, STABLE: see bm25_text_bm25query_score.
+CREATE FUNCTION @extschema@.bm25_count(index_name text, query text)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'bm25_count'
+LANGUAGE C STABLE STRICT PARALLEL UNSAFE;
+
 -- bm25 operator class for text columns
 -- The planner hook rewrites text <@> text to text <@> bm25query, so we only
 -- need to register the bm25query operator and support function here.
 CREATE OPERATOR CLASS @extschema@.text_bm25_ops
 DEFAULT FOR TYPE text USING bm25 AS
     OPERATOR    1   @extschema@.<@> (text, @extschema@.bm25query) FOR ORDER BY float_ops,
+    OPERATOR    2   @extschema@.@@@ (text, @extschema@.bm25query),
+    OPERATOR    3   @extschema@.@@& (text, @extschema@.bm25query),
     FUNCTION    8   (text, @extschema@.bm25query)   @extschema@.bm25_text_bm25query_score(text, @extschema@.bm25query);
 
 -- BM25 scoring function for text[] <@> bm25query operations
@@ -229,11 +277,43 @@ CREATE OPERATOR @extschema@.<@> (
     PROCEDURE = @extschema@.bm25_textarray_text_score
 );
 
+-- Match functions for text[] @@@ / @@& bm25query; elements are
+-- flattened as for scoring.
+CREATE FUNCTION @extschema@.bm25_textarray_bm25query_match_any(
+    left_arr text[], right_query @extschema@.bm25query)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'bm25_textarray_bm25query_match_any'
+LANGUAGE C STABLE STRICT PARALLEL UNSAFE COST 1000;
+
+CREATE FUNCTION @extschema@.bm25_textarray_bm25query_match_all(
+    left_arr text[], right_query @extschema@.bm25query)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'bm25_textarray_bm25query_match_all'
+LANGUAGE C STABLE STRICT PARALLEL UNSAFE COST 1000;
+
+CREATE OPERATOR @extschema@.@@@ (
+    LEFTARG = text[],
+    RIGHTARG = @extschema@.bm25query,
+    PROCEDURE = @extschema@.bm25_textarray_bm25query_match_any,
+    RESTRICT = contsel,
+    JOIN = contjoinsel
+);
+
+CREATE OPERATOR @extschema@.@@& (
+    LEFTARG = text[],
+    RIGHTARG = @extschema@.bm25query,
+    PROCEDURE = @extschema@.bm25_textarray_bm25query_match_all,
+    RESTRICT = contsel,
+    JOIN = contjoinsel
+);
+
 -- bm25 operator class for text[] columns
 CREATE OPERATOR CLASS @extschema@.text_array_bm25_ops
 DEFAULT FOR TYPE text[] USING bm25 AS
     OPERATOR    1   @extschema@.<@> (text[], @extschema@.bm25query)
                     FOR ORDER BY float_ops,
+    OPERATOR    2   @extschema@.@@@ (text[], @extschema@.bm25query),
+    OPERATOR    3   @extschema@.@@& (text[], @extschema@.bm25query),
     FUNCTION    8   (text[], @extschema@.bm25query)
                     @extschema@.bm25_textarray_bm25query_score(
                         text[], @extschema@.bm25query);
@@ -265,6 +345,47 @@ CREATE FUNCTION @extschema@.bm25_pending_free_pages(index_name text)
     AS 'MODULE_PATHNAME', 'tp_pending_free_pages'
     LANGUAGE C STRICT STABLE;
 
+-- Merge policy, per-level segment counts, and segment bytes written
+-- (write amplification), merges, parallel workers, build merge rounds
+-- and merge throttle sleeps since server start.
+CREATE FUNCTION @extschema@.bm25_merge_stats(
+    index_name text,
+    OUT merge_policy text,
+    OUT level_counts int4[],
+    OUT bytes_ingested bigint,
+    OUT bytes_merged bigint,
+    OUT write_amplification double precision,
+    OUT merges bigint,
+    OUT parallel_workers bigint,
+    OUT merge_rounds bigint,
+    OUT throttle_sleeps bigint)
+RETURNS record
+AS 'MODULE_PATHNAME', 'tp_merge_stats'
+LANGUAGE C STRICT STABLE;
+
+-- Shared top-k result cache (pg_textsearch.result_cache): its size,
+-- occupied entries, and hits and misses since server start.
+CREATE FUNCTION @extschema@.bm25_result_cache_stats(
+    OUT entries int4,
+    OUT used int4,
+    OUT hits bigint,
+    OUT misses bigint)
+RETURNS record
+AS 'MODULE_PATHNAME', 'tp_result_cache_stats'
+LANGUAGE C STRICT VOLATILE;
+
+-- This backend's BM25 scoring work since it started: scoring passes,
+-- passes that skipped an index whose best possible score was below
+-- their threshold (a LIMIT's shared top-k threshold or a pushed-down
+-- score bound), and documents scored.
+CREATE FUNCTION @extschema@.bm25_scoring_stats(
+    OUT scoring_passes bigint,
+    OUT indexes_skipped bigint,
+    OUT docs_scored bigint)
+RETURNS record
+AS 'MODULE_PATHNAME', 'tp_scoring_stats'
+LANGUAGE C STRICT VOLATILE;
+
 -- INTERNAL-ONLY test scaffold (issues #426, #427): return the live
 -- head tombstone page to the index FSM so the next allocator can pick
 -- it up, reproducing the stale-FSM / non-atomic-claim page-reuse
@@ -290,6 +411,9 @@ REVOKE EXECUTE ON FUNCTION @extschema@.bm25_dump_index(text) FROM PUBLIC;
 REVOKE EXECUTE ON FUNCTION @extschema@.bm25_summarize_index(text) FROM PUBLIC;
 REVOKE EXECUTE ON FUNCTION @extschema@.bm25_pending_free_pages(text)
     FROM PUBLIC;
+REVOKE EXECUTE ON FUNCTION @extschema@.bm25_merge_stats(text) FROM PUBLIC;
+REVOKE EXECUTE ON FUNCTION @extschema@.bm25_result_cache_stats() FROM PUBLIC;
+REVOKE EXECUTE ON FUNCTION @extschema@.bm25_scoring_stats() FROM PUBLIC;
 REVOKE EXECUTE ON FUNCTION
     @extschema@.bm25_test_recycle_tombstone_head(text) FROM PUBLIC;
 REVOKE EXECUTE ON FUNCTION
@@ -384,6 +508,17 @@ RETURNS text
 AS 'MODULE_PATHNAME', 'bm25_cache_evict_largest'
 LANGUAGE C STRICT;
 
+CREATE FUNCTION @extschema@.bm25_cache_eviction_candidates(
+    OUT index_oid oid,
+    OUT estimated_bytes bigint,
+    OUT access_count bigint,
+    OUT last_access timestamptz,
+    OUT rebuild_records bigint,
+    OUT eviction_score double precision)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'bm25_cache_eviction_candidates'
+LANGUAGE C STRICT;
+
 -- Cache source scaffold (in-memory memtable cache).
 -- Same INTERNAL-ONLY disclaimer as above.
 CREATE FUNCTION @extschema@.bm25_test_cache_source(
@@ -412,3 +547,5 @@ REVOKE EXECUTE ON FUNCTION @extschema@.bm25_cache_global_estimated_bytes()
     FROM PUBLIC;
 REVOKE EXECUTE ON FUNCTION @extschema@.bm25_cache_evict_largest(text)
     FROM PUBLIC;
+REVOKE EXECUTE ON FUNCTION @extschema@.bm25_cache_eviction_candidates()
+    FROM PUBLIC;
@@ -26,9 +26,10 @@ typedef struct TpScanOpaqueData
 	MemoryContext scan_context; /* Memory context for scan */
 
 	/* Query processing state */
-	char	 *query_text;	/* Search query text */
-	TpVector *query_vector; /* Original query vector from ORDER BY */
-	Oid		  index_oid;	/* Index OID */
+	char				*query_text;	  /* Search query text */
+	struct TpQueryTerms *query_terms;	  /* query_text tokenized, or NULL */
+	Oid					 text_config_oid; /* Index's text search config */
+	Oid					 index_oid;		  /* Index OID */
 
 	/* Scan results state */
 	ItemPointer result_ctids;  /* Array of matching CTIDs */
@@ -41,8 +42,46 @@ typedef struct TpScanOpaqueData
 	int limit;			  /* Query LIMIT value, -1 if none */
 	int max_results_used; /* Internal limit used for current batch */
 
+	/*
+	 * Score floor pushed down from the query's filter (0 for none): no
+	 * row scoring below it passes, so a batch cut short by it is the
+	 * end of the scan.
+	 */
+	float4 score_floor;
+
+	/*
+	 * Top-k threshold shared with sibling partitions' scans.  A batch
+	 * pruned by it may stop short of the scan's limit; the scan then
+	 * re-scores without it before reporting end of scan.  A batch
+	 * pruned to nothing first scores only its best row (topk_limit
+	 * keeps the size to re-score at after that).
+	 */
+	MemoryContext		 query_context;		 /* Context the scan began in */
+	struct TpSharedTopK *topk_share;		 /* Joined group, or NULL */
+	bool				 topk_share_off;	 /* Stop pruning by the group */
+	bool				 topk_floor_short;	 /* Batch pruned and short */
+	int					 topk_limit;		 /* Pruned batch's size, or 0 */
+
 	/* CTIDs already emitted; used across limit-doubling re-execs. */
 	struct HTAB *returned_ctids;
+
+	/*
+	 * Rescan memoization: a rescan with the same query text and no
+	 * match quals, as a nested loop issues per outer row, keeps the
+	 * last batch while the index's result generation is unchanged.
+	 */
+	bool   batch_reusable;	 /* Batch is the exact top of the index */
+	bool   batch_reused;	 /* Kept by rescan, scan not yet counted */
+	uint64 batch_generation; /* Result generation it was scored at */
+
+	/*
+	 * WHERE match quals (@@@, @@&), tokenized at rescan.  The operators
+	 * are strict, so a NULL argument matches nothing.
+	 */
+	int					 nmatch;		/* Number of match quals */
+	bool				 match_none;	/* Some qual's argument is NULL */
+	struct TpMatchQuals *match_quals;	/* Tokenized quals, or NULL */
+	MemoryContext		 match_context; /* Holds match_quals */
 } TpScanOpaqueData;
 
 typedef TpScanOpaqueData *TpScanOpaque;
@@ -50,12 +89,20 @@ typedef TpScanOpaqueData *TpScanOpaque;
 /* Index options structure */
 typedef struct TpOptions
 {
-	int32  vl_len_;			   /* varlena header (do not touch directly!) */
-	int32  text_config_offset; /* offset to text config string */
-	double k1;				   /* BM25 k1 parameter */
-	double b;				   /* BM25 b parameter */
+	int32  vl_len_;				  /* varlena header (do not touch directly!) */
+	int32  text_config_offset;	  /* offset to text config string */
+	double k1;					  /* BM25 k1 parameter */
+	double b;					  /* BM25 b parameter */
+	int	   merge_policy;		  /* TpMergePolicyKind */
+	int	   max_merged_segment_mb; /* tiered: merge size cap, 0 = none */
+	int	   merge_deletes_pct;	  /* dead-doc merge trigger */
 } TpOptions;
 
+/* Operator strategy numbers in the bm25 operator classes */
+#define TP_STRATEGY_SCORE	  1 /* <@>, ORDER BY only */
+#define TP_STRATEGY_MATCH_ANY 2 /* @@@, doc has any query term */
+#define TP_STRATEGY_MATCH_ALL 3 /* @@&, doc has every query term */
+
 /* Tapir-specific build phases for progress reporting */
 #define TP_PHASE_LOADING	2
 #define TP_PHASE_WRITING	3
@@ -155,8 +202,9 @@ void		  tp_rescan(
 				 int		   nkeys,
 				 ScanKey	   orderbys,
 				 int		   norderbys);
-void tp_endscan(IndexScanDesc scan);
-bool tp_gettuple(IndexScanDesc scan, ScanDirection dir);
+void  tp_endscan(IndexScanDesc scan);
+bool  tp_gettuple(IndexScanDesc scan, ScanDirection dir);
+int64 tp_getbitmap(IndexScanDesc scan, TIDBitmap *tbm);
 
 /*
  * Vacuum functions (am/vacuum.c)
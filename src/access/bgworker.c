@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * bgworker.c - Background spill and compaction worker
+ *
+ * A synchronous auto-spill runs tp_do_spill and the
+ * tp_maybe_compact_level cascade inside the inserting user's
+ * transaction, so an unlucky INSERT can wait out several level
+ * merges.  With pg_textsearch.background_spill on, the insert path
+ * only queues a request here and carries on.
+ *
+ * Processes:
+ *
+ *   launcher   Static worker registered from _PG_init, with shared
+ *              memory access but no database connection.  Sleeps on
+ *              its latch; when the queue is non-empty it starts a
+ *              db worker for the database of the oldest request and
+ *              waits for it to exit.
+ *
+ *   db worker  Dynamic worker connected to one database.  Drains
+ *              every queued request for that database, spilling each
+ *              index in its own transaction, then exits.
+ *
+ * The queue is a fixed-size array in main shared memory, ordered by
+ * enqueue sequence and protected by an LWLock.  Requests are
+ * de-duplicated per index through TpSharedIndexState.spill_queued,
+ * so the queue holds at most one request per index.
+ *
+ * Back-pressure lives in the caller (tp_auto_spill_if_needed): once
+ * the chain is TP_BACKGROUND_SPILL_BACKPRESSURE_FACTOR times past the
+ * threshold, or when tp_bgworker_request_spill refuses, the insert
+ * spills synchronously exactly as before.
+ */
+#include <postgres.h>
+
+#include <access/relation.h>
+#include <access/xact.h>
+#include <catalog/pg_class_d.h>
+#include <commands/defrem.h>
+#include <miscadmin.h>
+#include <pgstat.h>
+#include <postmaster/bgworker.h>
+#include <postmaster/interrupt.h>
+#include <storage/ipc.h>
+#include <storage/latch.h>
+#include <storage/lwlock.h>
+#include <storage/shmem.h>
+#include <tcop/tcopprot.h>
+#include <utils/guc.h>
+#include <utils/rel.h>
+#include <utils/snapmgr.h>
+
+#include "access/am.h"
+#include "access/bgworker.h"
+#include "constants.h"
+#include "index/registry.h"
+#include "index/state.h"
+
+/* One queued spill request. */
+typedef struct TpSpillRequest
+{
+	uint64 seq;		  /* enqueue order, for stale-request purge */
+	Oid	   dboid;	  /* database the index lives in */
+	Oid	   index_oid; /* index to spill */
+	uint32 min_pages; /* requester's memtable_pages_threshold */
+} TpSpillRequest;
+
+/* Spill request queue in main shared memory. */
+typedef struct TpBgWorkerShared
+{
+	LWLock		   lock;		   /* protects all fields below */
+	Latch		  *launcher_latch; /* NULL while no launcher runs */
+	uint64		   next_seq;	   /* seq for the next request */
+	int			   nrequests;	   /* valid entries in requests[] */
+	TpSpillRequest requests[TP_BGWORKER_QUEUE_SIZE];
+} TpBgWorkerShared;
+
+static TpBgWorkerShared *tp_bgworker_shared = NULL;
+
+void
+tp_bgworker_shmem_request(void)
+{
+	RequestAddinShmemSpace(sizeof(TpBgWorkerShared));
+}
+
+void
+tp_bgworker_shmem_startup(void)
+{
+	bool found;
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	tp_bgworker_shared = ShmemInitStruct(
+			"pg_textsearch spill queue", sizeof(TpBgWorkerShared), &found);
+	if (!found)
+	{
+		memset(tp_bgworker_shared, 0, sizeof(TpBgWorkerShared));
+		LWLockInitialize(&tp_bgworker_shared->lock, TP_TRANCHE_BGWORKER_QUEUE);
+	}
+
+	LWLockRelease(AddinShmemInitLock);
+
+	LWLockRegisterTranche(TP_TRANCHE_BGWORKER_QUEUE, "tapir_spill_queue");
+}
+
+void
+tp_bgworker_register_launcher(void)
+{
+	BackgroundWorker worker;
+
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags		= BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time	= BgWorkerStart_RecoveryFinished;
+	worker.bgw_restart_time = 10; /* seconds */
+	snprintf(worker.bgw_library_name, BGW_MAXLEN, "pg_textsearch");
+	snprintf(worker.bgw_function_name,
+			 BGW_MAXLEN,
+			 "tp_bgworker_launcher_main");
+	snprintf(worker.bgw_name, BGW_MAXLEN, "pg_textsearch spill launcher");
+	snprintf(worker.bgw_type, BGW_MAXLEN, "pg_textsearch spill launcher");
+
+	RegisterBackgroundWorker(&worker);
+}
+
+/* Remove requests[i], keeping the rest in enqueue order. */
+static void
+queue_remove(TpBgWorkerShared *q, int i)
+{
+	Assert(i >= 0 && i < q->nrequests);
+
+	memmove(&q->requests[i],
+			&q->requests[i + 1],
+			(q->nrequests - i - 1) * sizeof(TpSpillRequest));
+	q->nrequests--;
+}
+
+bool
+tp_bgworker_request_spill(TpLocalIndexState *index_state, uint32 min_pages)
+{
+	TpBgWorkerShared   *q = tp_bgworker_shared;
+	TpSharedIndexState *shared;
+	bool				queued = false;
+
+	if (q == NULL || index_state == NULL || index_state->shared == NULL)
+		return false;
+	shared = index_state->shared;
+
+	/*
+	 * A pending request covers our pages too: the worker spills
+	 * the whole chain, and it dequeues (clearing the flag) before
+	 * it takes the per-index lock.  Plain read first so inserts
+	 * past the threshold don't all bounce the cache line.
+	 */
+	if (pg_atomic_read_u32(&shared->spill_queued) != 0 ||
+		pg_atomic_exchange_u32(&shared->spill_queued, 1) != 0)
+		return true;
+
+	LWLockAcquire(&q->lock, LW_EXCLUSIVE);
+	if (q->launcher_latch != NULL && q->nrequests < TP_BGWORKER_QUEUE_SIZE)
+	{
+		TpSpillRequest *req = &q->requests[q->nrequests++];
+
+		req->seq	   = q->next_seq++;
+		req->dboid	   = MyDatabaseId;
+		req->index_oid = shared->index_oid;
+		req->min_pages = min_pages;
+		SetLatch(q->launcher_latch);
+		queued = true;
+	}
+	LWLockRelease(&q->lock);
+
+	if (!queued)
+		pg_atomic_write_u32(&shared->spill_queued, 0);
+
+	return queued;
+}
+
+/* ---------- launcher ---------- */
+
+static void
+launcher_detach(int code, Datum arg)
+{
+	(void)code;
+	(void)arg;
+
+	LWLockAcquire(&tp_bgworker_shared->lock, LW_EXCLUSIVE);
+	tp_bgworker_shared->launcher_latch = NULL;
+	LWLockRelease(&tp_bgworker_shared->lock);
+}
+
+/*
+ * Start a db worker for `dboid` and wait until it exits.  Returns
+ * without waiting if the worker could not be registered (e.g.
+ * max_worker_processes exhausted); the caller's purge then hands the
+ * requests back to the inserting backends.
+ */
+static void
+launcher_run_db_worker(Oid dboid)
+{
+	BackgroundWorker		worker;
+	BackgroundWorkerHandle *handle;
+	pid_t					pid;
+
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS |
+					   BGWORKER_BACKEND_DATABASE_CONNECTION;
+	worker.bgw_start_time	= BgWorkerStart_RecoveryFinished;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	snprintf(worker.bgw_library_name, BGW_MAXLEN, "pg_textsearch");
+	snprintf(worker.bgw_function_name, BGW_MAXLEN, "tp_bgworker_spill_main");
+	snprintf(worker.bgw_name,
+			 BGW_MAXLEN,
+			 "pg_textsearch spill worker for database %u",
+			 dboid);
+	snprintf(worker.bgw_type, BGW_MAXLEN, "pg_textsearch spill worker");
+	worker.bgw_main_arg	  = ObjectIdGetDatum(dboid);
+	worker.bgw_notify_pid = MyProcPid;
+
+	if (!RegisterDynamicBackgroundWorker(&worker, &handle))
+	{
+		ereport(LOG,
+				(errmsg("pg_textsearch: could not start spill worker for "
+						"database %u",
+						dboid),
+				 errhint("Consider increasing max_worker_processes.")));
+		return;
+	}
+
+	if (WaitForBackgroundWorkerStartup(handle, &pid) == BGWH_STARTED)
+		(void)WaitForBackgroundWorkerShutdown(handle);
+	pfree(handle);
+}
+
+/*
+ * Let the next insert on `index_oid` queue a spill again.  Goes
+ * through the registry, so it works for an index this process
+ * never opened or that has since been dropped.
+ */
+static void
+clear_spill_queued(Oid index_oid)
+{
+	dsa_pointer			shared_dp = tp_registry_lookup_dsa(index_oid);
+	TpSharedIndexState *shared;
+
+	if (!DsaPointerIsValid(shared_dp))
+		return;
+	shared = (TpSharedIndexState *)
+			dsa_get_address(tp_registry_get_dsa(), shared_dp);
+	pg_atomic_write_u32(&shared->spill_queued, 0);
+}
+
+/*
+ * Drop requests for `dboid` that were already queued when its db
+ * worker was launched.  A healthy worker drains all of them before
+ * exiting, so leftovers mean it failed (database dropped, ERROR
+ * mid-spill, no worker slot).  Clearing spill_queued lets the next
+ * insert on those indexes queue again, or spill synchronously.
+ */
+static void
+launcher_purge_stale(Oid dboid, uint64 launch_seq)
+{
+	TpBgWorkerShared *q = tp_bgworker_shared;
+	Oid				  stale[TP_BGWORKER_QUEUE_SIZE];
+	int				  nstale = 0;
+
+	LWLockAcquire(&q->lock, LW_EXCLUSIVE);
+	for (int i = 0; i < q->nrequests;)
+	{
+		if (q->requests[i].dboid == dboid && q->requests[i].seq < launch_seq)
+		{
+			stale[nstale++] = q->requests[i].index_oid;
+			queue_remove(q, i);
+		}
+		else
+			i++;
+	}
+	LWLockRelease(&q->lock);
+
+	for (int i = 0; i < nstale; i++)
+		clear_spill_queued(stale[i]);
+
+	if (nstale > 0)
+		ereport(LOG,
+				(errmsg("pg_textsearch: dropped %d background spill "
+						"request(s) for database %u",
+						nstale,
+						dboid)));
+}
+
+void
+tp_bgworker_launcher_main(Datum main_arg)
+{
+	TpBgWorkerShared *q = tp_bgworker_shared;
+
+	(void)main_arg;
+
+	pqsignal(SIGHUP, SignalHandlerForConfigReload);
+	pqsignal(SIGTERM, SignalHandlerForShutdownRequest);
+	BackgroundWorkerUnblockSignals();
+
+	before_shmem_exit(launcher_detach, (Datum)0);
+	LWLockAcquire(&q->lock, LW_EXCLUSIVE);
+	q->launcher_latch = MyLatch;
+	LWLockRelease(&q->lock);
+
+	while (!ShutdownRequestPending)
+	{
+		Oid	   dboid = InvalidOid;
+		uint64 launch_seq;
+
+		ResetLatch(MyLatch);
+
+		if (ConfigReloadPending)
+		{
+			ConfigReloadPending = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		LWLockAcquire(&q->lock, LW_SHARED);
+		if (q->nrequests > 0)
+			dboid = q->requests[0].dboid;
+		launch_seq = q->next_seq;
+		LWLockRelease(&q->lock);
+
+		if (OidIsValid(dboid))
+		{
+			launcher_run_db_worker(dboid);
+			launcher_purge_stale(dboid, launch_seq);
+			continue;
+		}
+
+		(void)WaitLatch(
+				MyLatch,
+				WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+				TP_BGWORKER_NAPTIME_MS,
+				PG_WAIT_EXTENSION);
+	}
+
+	proc_exit(0);
+}
+
+/* ---------- db worker ---------- */
+
+/* Pop the oldest request for `dboid`; false when none is left. */
+static bool
+dequeue_for_database(Oid dboid, TpSpillRequest *out)
+{
+	TpBgWorkerShared *q		= tp_bgworker_shared;
+	bool			  found = false;
+
+	LWLockAcquire(&q->lock, LW_EXCLUSIVE);
+	for (int i = 0; i < q->nrequests; i++)
+	{
+		if (q->requests[i].dboid == dboid)
+		{
+			*out = q->requests[i];
+			queue_remove(q, i);
+			found = true;
+			break;
+		}
+	}
+	LWLockRelease(&q->lock);
+
+	return found;
+}
+
+/*
+ * Spill one index in its own transaction.  tp_do_spill runs the
+ * L0 compaction cascade itself, so the merges land here too.
+ */
+static void
+process_spill_request(const TpSpillRequest *req)
+{
+	Relation index;
+
+	SetCurrentStatementStartTimestamp();
+	StartTransactionCommand();
+	PushActiveSnapshot(GetTransactionSnapshot());
+	pgstat_report_activity(STATE_RUNNING, "pg_textsearch background spill");
+
+	/*
+	 * Clear before spilling, whatever becomes of the request: an
+	 * insert that lands while we spill must be able to queue a
+	 * follow-up, and a request we skip must not leave the index
+	 * unable to queue one at all.
+	 */
+	clear_spill_queued(req->index_oid);
+
+	/* The index may have been dropped since the request was queued. */
+	index = try_relation_open(req->index_oid, RowExclusiveLock);
+	if (index != NULL)
+	{
+		TpLocalIndexState *index_state = NULL;
+
+		if (index->rd_rel->relkind == RELKIND_INDEX &&
+			index->rd_rel->relam == get_am_oid("bm25", true))
+			index_state = tp_get_local_index_state(req->index_oid);
+
+		if (index_state != NULL)
+			tp_spill_memtable_if_needed(index, index_state, req->min_pages);
+
+		relation_close(index, RowExclusiveLock);
+	}
+
+	PopActiveSnapshot();
+	CommitTransactionCommand();
+	pgstat_report_activity(STATE_IDLE, NULL);
+}
+
+void
+tp_bgworker_spill_main(Datum main_arg)
+{
+	Oid			   dboid = DatumGetObjectId(main_arg);
+	TpSpillRequest req;
+
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	BackgroundWorkerInitializeConnectionByOid(dboid, InvalidOid, 0);
+
+	while (dequeue_for_database(dboid, &req))
+	{
+		CHECK_FOR_INTERRUPTS();
+		process_spill_request(&req);
+	}
+
+	proc_exit(0);
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * bgworker.h - Background spill and compaction worker
+ *
+ * With pg_textsearch.background_spill on, an insert that pushes the
+ * memtable chain past memtable_pages_threshold queues a spill request
+ * instead of spilling (and cascading level compaction) inside the
+ * inserting transaction.  See bgworker.c for the process layout.
+ */
+#pragma once
+
+#include <postgres.h>
+
+#include <fmgr.h>
+
+#include "index/state.h"
+
+/* Shared memory hooks, called from mod.c */
+extern void tp_bgworker_shmem_request(void);
+extern void tp_bgworker_shmem_startup(void);
+
+/* Register the static launcher worker; _PG_init only. */
+extern void tp_bgworker_register_launcher(void);
+
+/*
+ * Ask the background worker to spill `index_state`'s memtable once
+ * its chain holds at least `min_pages` pages.  Returns true if a
+ * request is queued (by this call or an earlier one still pending),
+ * false if the caller must spill synchronously: no launcher is
+ * running or the queue is full.
+ */
+extern bool tp_bgworker_request_spill(
+		TpLocalIndexState *index_state, uint32 min_pages);
+
+/* Background worker entry points (bgw_function_name) */
+extern PGDLLEXPORT void tp_bgworker_launcher_main(Datum main_arg);
+extern PGDLLEXPORT void tp_bgworker_spill_main(Datum main_arg);
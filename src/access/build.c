@@ -20,6 +20,7 @@
 #include <nodes/makefuncs.h>
 #include <nodes/value.h>
 #include <optimizer/optimizer.h>
+#include <storage/buffile.h>
 #include <storage/bufmgr.h>
 #include <tsearch/ts_type.h>
 #include <utils/acl.h>
@@ -29,12 +30,14 @@
 #include <utils/regproc.h>
 
 #include "access/am.h"
+#include "access/bgworker.h"
 #include "access/build_context.h"
 #include "access/build_parallel.h"
 #include "constants.h"
 #include "index/metapage.h"
 #include "index/registry.h"
 #include "index/state.h"
+#include "memtable/cache.h"
 #include "memtable/chain_source.h"
 #include "memtable/log.h"
 #include "memtable/page.h"
@@ -42,6 +45,8 @@
 #include "segment/docmap.h"
 #include "segment/io.h"
 #include "segment/merge.h"
+#include "segment/merge_internal.h"
+#include "segment/merge_throttle.h"
 #include "segment/segment.h"
 #include "segment/tombstone.h"
 #include "types/array.h"
@@ -158,20 +163,38 @@ tp_do_spill(
 		return false;
 
 	/*
-	 * Open a chain source.  This idempotently re-acquires the
-	 * per-index LWLock in SHARED mode, which is a no-op since
-	 * the caller holds it EXCLUSIVE; the constructor returns
-	 * NULL for an empty chain.
+	 * Prefer the warm memtable cache: its posting lists already hold
+	 * everything the chain would decode to, so copying them out skips
+	 * a full re-walk of the chain pages.  It declines (cold, stale,
+	 * over budget, or empty) without touching the outputs.
 	 */
-	src = tp_memtable_chain_source_create(index_state, index_rel, NULL, 0);
-	if (src == NULL)
-		return false;
+	src = NULL;
+	if (!tp_cache_extract_for_spill(
+				index_state,
+				index_rel,
+				CurrentMemoryContext,
+				&terms,
+				&num_terms,
+				&docmap,
+				&docs_delta,
+				&len_delta))
+	{
+		/*
+		 * Fall back to a chain source.  This idempotently
+		 * re-acquires the per-index LWLock in SHARED mode, which is
+		 * a no-op since the caller holds it EXCLUSIVE; the
+		 * constructor returns NULL for an empty chain.
+		 */
+		src = tp_memtable_chain_source_create(index_state, index_rel, NULL, 0);
+		if (src == NULL)
+			return false;
 
-	docs_delta = (uint64)src->total_docs;
-	len_delta  = (uint64)src->total_len;
+		docs_delta = (uint64)src->total_docs;
+		len_delta  = (uint64)src->total_len;
 
-	tp_memtable_chain_source_extract(
-			src, CurrentMemoryContext, &terms, &num_terms, &docmap);
+		tp_memtable_chain_source_extract(
+				src, CurrentMemoryContext, &terms, &num_terms, &docmap);
+	}
 
 	if (num_terms == 0)
 	{
@@ -185,6 +208,7 @@ tp_do_spill(
 	else
 	{
 		root = tp_write_segment(index_rel, terms, num_terms, docmap);
+		tp_merge_account_write(index_rel, root, false);
 	}
 
 	if (out_segment_root != NULL)
@@ -227,10 +251,11 @@ tp_do_spill(
 			tp_memtable_mark_chain_dead(index_rel, chain_head, horizon);
 	}
 
-	/* Free dictionary + docmap (chain source no longer needed). */
+	/* Free dictionary + docmap (and the chain source, if used). */
 	tp_free_dictionary(terms, num_terms);
 	tp_docmap_destroy(docmap);
-	tp_source_close(src);
+	if (src != NULL)
+		tp_source_close(src);
 
 	/*
 	 * Reset chain_page_count: the chain is empty after
@@ -259,11 +284,20 @@ tp_do_spill(
  * unnecessary lock acquisition (re-checked under LW_EXCLUSIVE
  * below); false negatives mean this insert doesn't spill but
  * the next one will.
+ *
+ * With pg_textsearch.background_spill on, the spill is queued for
+ * the background worker instead, until the chain reaches
+ * TP_BACKGROUND_SPILL_BACKPRESSURE_FACTOR times the threshold:
+ * past that the worker is evidently not keeping up, and the insert
+ * pays for the spill itself.  Build mode keeps the synchronous
+ * path — its memtable lives in a private DSA and the index is not
+ * yet visible to any other transaction.
  */
 static void
 tp_auto_spill_if_needed(TpLocalIndexState *index_state, Relation index_rel)
 {
 	uint32 threshold;
+	uint32 pages;
 
 	if (!index_state || !index_rel || !index_state->shared)
 		return;
@@ -272,7 +306,14 @@ tp_auto_spill_if_needed(TpLocalIndexState *index_state, Relation index_rel)
 	if (threshold == 0)
 		return; /* auto-spill disabled */
 
-	if (pg_atomic_read_u32(&index_state->shared->chain_page_count) < threshold)
+	pages = pg_atomic_read_u32(&index_state->shared->chain_page_count);
+	if (pages < threshold)
+		return;
+
+	if (tp_background_spill && !index_state->is_build_mode &&
+		(uint64)pages <
+				(uint64)threshold * TP_BACKGROUND_SPILL_BACKPRESSURE_FACTOR &&
+		tp_bgworker_request_spill(index_state, threshold))
 		return;
 
 	/*
@@ -307,9 +348,160 @@ tp_build_flush_and_link(TpBuildContext *ctx, Relation index)
 	if (segment_root == InvalidBlockNumber)
 		return;
 
+	tp_merge_account_write(index, segment_root, false);
 	tp_link_l0_chain_head(index, segment_root);
 }
 
+/*
+ * Sorted runs of a serial build that outgrew its memory budget.  Each
+ * time the build context fills, it is written to a temp file in the
+ * flat segment layout parallel workers use, and cleared.  At the end
+ * all runs are merged in one pass into a single segment, instead of
+ * linking an L0 segment per batch and merging level by level.
+ */
+typedef struct TpBuildRuns
+{
+	BufFile *file;	   /* NULL until the first run */
+	uint64	*offsets;  /* Start of each run in file */
+	uint32	 count;	   /* Runs written */
+	uint32	 capacity; /* Allocated offsets */
+	uint64	 end;	   /* Logical end of file */
+} TpBuildRuns;
+
+/*
+ * Write the build context out as the next run.
+ */
+static void
+tp_build_spill_run(TpBuildRuns *runs, TpBuildContext *ctx)
+{
+	int	  fileno;
+	off_t file_offset;
+
+	if (runs->file == NULL)
+	{
+		runs->file	   = BufFileCreateTemp(false);
+		runs->capacity = 16;
+		runs->offsets  = palloc(runs->capacity * sizeof(uint64));
+	}
+	else if (runs->count >= runs->capacity)
+	{
+		runs->capacity *= 2;
+		runs->offsets =
+				repalloc(runs->offsets, runs->capacity * sizeof(uint64));
+	}
+
+	tp_buffile_decompose_offset(runs->end, &fileno, &file_offset);
+	BufFileSeek(runs->file, fileno, file_offset, SEEK_SET);
+
+	runs->offsets[runs->count++] = runs->end;
+	runs->end += tp_write_segment_to_buffile(ctx, runs->file);
+}
+
+/*
+ * Merge every run into one segment and link it as the L0 chain head.
+ * The runs hold consecutive stretches of the heap scan, so they are
+ * concatenated in order, and doc ids come out in scan order as with
+ * a build that fit in memory.
+ */
+static void
+tp_build_merge_runs(TpBuildRuns *runs, Relation index)
+{
+	TpMergeSource *sources;
+	int			   num_sources	= 0;
+	uint64		   total_tokens = 0;
+	TpMergedTerm  *terms;
+	uint32		   num_terms;
+	TpMergeSink	   sink;
+	BlockNumber	   segment_root;
+	MemoryContext  merge_ctx;
+	MemoryContext  old_ctx;
+	uint32		   i;
+
+	merge_ctx = AllocSetContextCreate(
+			CurrentMemoryContext, "Build Run Merge", ALLOCSET_DEFAULT_SIZES);
+	old_ctx = MemoryContextSwitchTo(merge_ctx);
+
+	sources = palloc0(sizeof(TpMergeSource) * runs->count);
+	for (i = 0; i < runs->count; i++)
+	{
+		TpSegmentReader *reader;
+
+		reader = tp_segment_open_from_buffile(runs->file, runs->offsets[i]);
+		if (merge_source_init_from_reader(&sources[num_sources], reader))
+		{
+			total_tokens += reader->header->total_tokens;
+			num_sources++;
+		}
+		else
+			tp_segment_close(reader);
+	}
+
+	terms = merge_collect_terms(sources, num_sources, UINT32_MAX, &num_terms);
+
+	/* A serial build holds the index lock from start to end */
+	merge_sink_init_pages(&sink, index, true);
+	if (sink.writer.pages_allocated == 0)
+		elog(ERROR, "merge: failed to allocate segment pages");
+	segment_root = sink.writer.pages[0];
+
+	write_merged_segment_to_sink(
+			&sink,
+			terms,
+			num_terms,
+			sources,
+			num_sources,
+			0, /* target_level: L0 */
+			total_tokens,
+			true /* disjoint_sources */,
+			NULL);
+
+	for (i = 0; i < (uint32)num_sources; i++)
+		merge_source_close(&sources[i]);
+	BufFileClose(runs->file);
+	runs->file = NULL;
+
+	MemoryContextSwitchTo(old_ctx);
+	MemoryContextDelete(merge_ctx);
+	pfree(runs->offsets);
+
+	tp_merge_account_write(index, segment_root, false);
+	tp_merge_account_rounds(index, 1);
+	tp_link_l0_chain_head(index, segment_root);
+}
+
+/*
+ * Account a finished parallel build in the shared state the caller
+ * just created: every L0 segment is build output, plus the build's
+ * merge rounds and throttle sleeps.
+ */
+static void
+tp_build_account_parallel(Relation index, const TpParallelBuildStats *stats)
+{
+	Buffer			metabuf;
+	TpIndexMetaPage metap;
+	BlockNumber		seg;
+
+	metabuf = ReadBuffer(index, TP_METAPAGE_BLKNO);
+	LockBuffer(metabuf, BUFFER_LOCK_SHARE);
+	metap = (TpIndexMetaPage)PageGetContents(BufferGetPage(metabuf));
+	seg	  = metap->level_heads[0];
+	UnlockReleaseBuffer(metabuf);
+
+	while (seg != InvalidBlockNumber)
+	{
+		TpSegmentReader *reader = tp_segment_open(index, seg);
+
+		if (reader == NULL)
+			break;
+		tp_merge_account_write(index, seg, false);
+		seg = reader->header->next_segment;
+		tp_segment_close(reader);
+	}
+
+	tp_merge_account_rounds(index, stats->merge_rounds);
+	tp_merge_account_throttle(index, stats->throttle_sleeps);
+}
+
 /*
  * Link a newly-written segment as the L0 chain head.
  *
@@ -621,6 +813,14 @@ tp_force_merge(PG_FUNCTION_ARGS)
 							"\"%s\"",
 							index_name)));
 
+		/*
+		 * Wait for a merge slot before taking the index lock, so a
+		 * force-merge queued behind max_concurrent_merges doesn't
+		 * block the index's writers while it waits.  The merges
+		 * below reuse the slot.
+		 */
+		tp_merge_slot_acquire();
+
 		tp_acquire_index_lock(index_state, LW_EXCLUSIVE);
 		/*
 		 * Spill the memtable first so force-merge produces a
@@ -631,6 +831,8 @@ tp_force_merge(PG_FUNCTION_ARGS)
 		tp_force_merge_all(index_rel);
 		tp_truncate_dead_pages(index_rel);
 		tp_release_index_lock(index_state);
+
+		tp_merge_slot_release();
 	}
 
 	index_close(index_rel, RowExclusiveLock);
@@ -1160,6 +1362,7 @@ typedef struct TpBuildCallbackState
 	uint64			total_docs;
 	uint64			total_len;
 	uint64			tuples_done;
+	TpBuildRuns		runs; /* Spilled runs, merged at the end */
 } TpBuildCallbackState;
 
 /*
@@ -1231,20 +1434,14 @@ tp_build_callback(
 	/* Reset per-doc context (frees tsvector, terms) */
 	MemoryContextReset(bs->per_doc_ctx);
 
-	/* Budget-based flush */
+	/* Budget-based flush to a sorted run */
 	if (tp_build_context_should_flush(bs->build_ctx))
 	{
 		bs->total_docs += bs->build_ctx->num_docs;
 		bs->total_len += bs->build_ctx->total_len;
 
-		tp_build_flush_and_link(bs->build_ctx, bs->index);
+		tp_build_spill_run(&bs->runs, bs->build_ctx);
 		tp_build_context_reset(bs->build_ctx);
-
-		pgstat_progress_update_param(
-				PROGRESS_CREATEIDX_SUBPHASE, TP_PHASE_COMPACTING);
-		tp_maybe_compact_level(bs->index, 0);
-		pgstat_progress_update_param(
-				PROGRESS_CREATEIDX_SUBPHASE, TP_PHASE_LOADING);
 	}
 
 	bs->tuples_done++;
@@ -1362,7 +1559,8 @@ tp_build(Relation heap, Relation index, IndexInfo *indexInfo)
 		if (nworkers > 0 && reltuples >= TP_MIN_PARALLEL_TUPLES &&
 			!indexInfo->ii_Concurrent)
 		{
-			IndexBuildResult *par_result;
+			IndexBuildResult	*par_result;
+			TpParallelBuildStats par_stats;
 
 			/*
 			 * Warn if table is very large but parallelism is limited.
@@ -1392,7 +1590,8 @@ tp_build(Relation heap, Relation index, IndexInfo *indexInfo)
 					k1,
 					b,
 					is_text_array,
-					nworkers);
+					nworkers,
+					&par_stats);
 
 			/*
 			 * Create shared index state for runtime queries.
@@ -1420,6 +1619,7 @@ tp_build(Relation heap, Relation index, IndexInfo *indexInfo)
 						RelationGetRelid(index),
 						RelationGetRelid(heap),
 						/* reuse_if_exists */ false);
+				tp_build_account_parallel(index, &par_stats);
 
 				if (build_progress.active)
 				{
@@ -1502,6 +1702,7 @@ tp_build(Relation heap, Relation index, IndexInfo *indexInfo)
 		bs.total_docs  = 0;
 		bs.total_len   = 0;
 		bs.tuples_done = 0;
+		memset(&bs.runs, 0, sizeof(TpBuildRuns));
 
 		/* Report loading phase */
 		pgstat_progress_update_param(
@@ -1537,8 +1738,20 @@ tp_build(Relation heap, Relation index, IndexInfo *indexInfo)
 		pgstat_progress_update_param(
 				PROGRESS_CREATEIDX_SUBPHASE, TP_PHASE_WRITING);
 
-		/* Write final segment if data remains */
-		if (build_ctx->num_docs > 0)
+		/*
+		 * Write the final segment: the remaining data directly if
+		 * nothing was spilled, else as the last run of one merge.
+		 */
+		if (bs.runs.count > 0)
+		{
+			if (build_ctx->num_docs > 0)
+				tp_build_spill_run(&bs.runs, build_ctx);
+
+			pgstat_progress_update_param(
+					PROGRESS_CREATEIDX_SUBPHASE, TP_PHASE_COMPACTING);
+			tp_build_merge_runs(&bs.runs, index);
+		}
+		else if (build_ctx->num_docs > 0)
 			tp_build_flush_and_link(build_ctx, index);
 
 		/* Update metapage with corpus statistics */
@@ -2,15 +2,26 @@
  * Copyright (c) 2025-2026 Tiger Data, Inc.
  * Licensed under the PostgreSQL License. See LICENSE for details.
  *
- * build_parallel.c - Parallel index build with leader-only merge
+ * build_parallel.c - Parallel index build with a tree merge
  *
  * Architecture:
- * - Phase 1: Each worker scans a heap partition, builds a local
- *   TpBuildContext, flushes L0 segments to BufFile. Workers
- *   report segment info (offsets and sizes).
- * - Barrier: Leader opens all worker BufFiles, performs a single
- *   N-way merge of ALL segments directly to paged storage.
- * - Leader links the single merged segment, updates metapage,
+ * - Phase 1: Workers claim chunks of heap blocks from a shared
+ *   cursor, build a local TpBuildContext, flush L0 segments to
+ *   BufFile. Workers report segment info (offsets and sizes).
+ *   Chunks interleave workers' CTIDs, but each chunk is scanned by
+ *   one worker, so the merges concatenate sources chunk by chunk
+ *   rather than ordering every doc by CTID.
+ * - Direct write: when the workers are expected to write fewer
+ *   segments than a level holds, they write them into the index
+ *   with the ordinary segment writer instead of BufFiles, and the
+ *   leader links them into L0 and skips the merges.
+ * - Merge rounds: while more segments remain than
+ *   pg_textsearch.parallel_build_merge_fanin, the leader splits
+ *   them into batches of consecutive segments, and workers and
+ *   leader merge one batch each at a time into a new BufFile
+ *   segment.
+ * - Leader merges the remaining segments directly to paged
+ *   storage, links the single merged segment, updates metapage,
  *   then wakes workers to exit.
  */
 #include <postgres.h>
@@ -43,6 +54,7 @@
 #include "segment/io.h"
 #include "segment/merge.h"
 #include "segment/merge_internal.h"
+#include "segment/merge_throttle.h"
 #include "segment/pagemapper.h"
 #include "segment/segment.h"
 #include "types/array.h"
@@ -54,8 +66,9 @@
 
 typedef struct WorkerSegmentEntry
 {
-	uint64 offset;	  /* BufFile offset */
-	uint64 data_size; /* Segment bytes */
+	uint64		offset;	   /* BufFile offset */
+	uint64		data_size; /* Segment bytes */
+	BlockNumber root;	   /* Root block, when written to the index */
 } WorkerSegmentEntry;
 
 typedef struct WorkerSegmentTracker
@@ -77,7 +90,10 @@ tracker_init(WorkerSegmentTracker *tracker)
 
 static void
 tracker_add_segment(
-		WorkerSegmentTracker *tracker, uint64 offset, uint64 data_size)
+		WorkerSegmentTracker *tracker,
+		uint64				  offset,
+		uint64				  data_size,
+		BlockNumber			  root)
 {
 	if (tracker->count >= tracker->capacity)
 	{
@@ -88,6 +104,7 @@ tracker_add_segment(
 	}
 	tracker->entries[tracker->count].offset	   = offset;
 	tracker->entries[tracker->count].data_size = data_size;
+	tracker->entries[tracker->count].root	   = root;
 	tracker->count++;
 }
 
@@ -98,6 +115,68 @@ tracker_destroy(WorkerSegmentTracker *tracker)
 		pfree(tracker->entries);
 }
 
+/*
+ * Per-worker memory budget: split maintenance_work_mem across
+ * workers. Minimum 64MB per worker to avoid excessive flushing.
+ */
+static Size
+build_worker_budget(int nworkers_launched)
+{
+	Size budget;
+
+	budget = (Size)maintenance_work_mem * 1024L / nworkers_launched;
+	if (budget < 64L * 1024 * 1024)
+		budget = 64L * 1024 * 1024;
+
+	/*
+	 * Clamp to the arena's addressable capacity: with few workers
+	 * launched, maintenance_work_mem / nworkers can still exceed the
+	 * 4 GiB arena, so the worker would overrun instead of spilling
+	 * (issue #433).
+	 */
+	return tp_arena_clamp_budget(budget);
+}
+
+/*
+ * Write the worker's build context out as an L0 segment and track
+ * it: into the index when the build writes directly, else at the
+ * current end of the worker's BufFile.
+ */
+static void
+build_worker_flush(
+		TpBuildContext		 *build_ctx,
+		Relation			  index,
+		BufFile				 *buffile,
+		WorkerSegmentTracker *tracker)
+{
+	uint64 data_size;
+	uint64 seg_offset;
+
+	if (buffile == NULL)
+	{
+		BlockNumber root = tp_write_segment_from_build_ctx(build_ctx, index);
+
+		if (root != InvalidBlockNumber)
+			tracker_add_segment(tracker, 0, 0, root);
+		return;
+	}
+
+	/* L0 segment starts at current end of BufFile */
+	seg_offset = tracker->buffile_end;
+	{
+		int	  fileno;
+		off_t file_offset;
+
+		tp_buffile_decompose_offset(seg_offset, &fileno, &file_offset);
+		BufFileSeek(buffile, fileno, file_offset, SEEK_SET);
+	}
+
+	data_size = tp_write_segment_to_buffile(build_ctx, buffile);
+
+	tracker_add_segment(tracker, seg_offset, data_size, InvalidBlockNumber);
+	tracker->buffile_end = seg_offset + data_size;
+}
+
 /* ----------------------------------------------------------------
  * Shared memory estimation and initialization
  * ----------------------------------------------------------------
@@ -112,7 +191,7 @@ tp_parallel_build_estimate_shmem(
 	(void)heap;
 	(void)snapshot;
 
-	/* Base shared structure (includes per-worker block ranges) */
+	/* Base shared structure */
 	size = MAXALIGN(sizeof(TpParallelBuildShared));
 
 	/* Per-worker result array */
@@ -150,9 +229,12 @@ tp_init_parallel_shared(
 	ConditionVariableInit(&shared->all_done_cv);
 	pg_atomic_init_u32(&shared->workers_done, 0);
 	pg_atomic_init_u64(&shared->tuples_done, 0);
+	pg_atomic_init_u64(&shared->throttle_sleeps, 0);
 
 	/* TID range scan coordination */
 	shared->nworkers_launched = 0;
+	shared->nblocks			  = 0;
+	pg_atomic_init_u32(&shared->next_block, 0);
 	pg_atomic_init_u32(&shared->scan_ready, 0);
 
 	/* Phase coordination */
@@ -160,12 +242,434 @@ tp_init_parallel_shared(
 	ConditionVariableInit(&shared->phase2_cv);
 	pg_atomic_init_u32(&shared->phase2_ready, 0);
 
+	/* Merge rounds: no batch can be claimed until one is published */
+	pg_atomic_init_u32(&shared->next_batch, 0);
+	pg_atomic_init_u32(&shared->batches_done, 0);
+	pg_atomic_init_u32(&shared->round_published, 0);
+
 	/* Initialize per-worker results */
 	results = TpParallelWorkerResults(shared);
 	for (i = 0; i < nworkers; i++)
 		memset(&results[i], 0, sizeof(TpParallelWorkerResult));
 }
 
+/* ----------------------------------------------------------------
+ * Heap chunks
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Size of the chunk claimed at block `cur`: the blocks left divided
+ * among the workers several times over, so claims shrink as the scan
+ * nears the end of the heap, as in PostgreSQL's block-based parallel
+ * scans.  Depends on nothing but `cur`, so the claims can be replayed.
+ */
+static uint32
+build_chunk_size(const TpParallelBuildShared *shared, uint32 cur)
+{
+	uint32 chunk;
+
+	chunk = (shared->nblocks - cur) / ((uint32)shared->nworkers_launched *
+									   TP_BUILD_SCAN_CHUNKS_PER_WORKER);
+	chunk = Max(chunk, 1);
+	return Min(chunk, TP_BUILD_SCAN_MAX_CHUNK);
+}
+
+/*
+ * The chunks the workers claimed, replayed from build_chunk_size.
+ * Each was scanned by one worker, which is what lets the merges
+ * concatenate their sources chunk by chunk (TpMergeChunks).
+ */
+static void
+build_scan_chunks(const TpParallelBuildShared *shared, TpMergeChunks *chunks)
+{
+	uint32 capacity = 64;
+	uint32 cur		= 0;
+
+	chunks->count  = 0;
+	chunks->starts = palloc(capacity * sizeof(BlockNumber));
+	while (cur < shared->nblocks)
+	{
+		if (chunks->count >= capacity)
+		{
+			capacity *= 2;
+			chunks->starts = repalloc_huge(
+					chunks->starts, capacity * sizeof(BlockNumber));
+		}
+		chunks->starts[chunks->count++] = cur;
+		cur += build_chunk_size(shared, cur);
+	}
+}
+
+/* ----------------------------------------------------------------
+ * Merge rounds
+ * ----------------------------------------------------------------
+ */
+
+static void
+build_run_file_name(const TpBuildRun *run, char *name, Size len)
+{
+	if (run->round == 0)
+		snprintf(name, len, "tp_worker_%u", run->file);
+	else
+		snprintf(name, len, "tp_run_%u_%u", run->round, run->file);
+}
+
+/*
+ * Open runs[0..nruns) as merge sources, in order.  Runs sharing a
+ * file (one worker's phase-1 segments) are adjacent and share one
+ * BufFile.  The files opened are returned in files[], *nfiles of
+ * them, for the caller to close after the sources.  Returns the
+ * number of sources; their token counts are added to *total_tokens.
+ */
+static int
+build_open_runs(
+		TpParallelBuildShared *shared,
+		const TpBuildRun	  *runs,
+		int					   nruns,
+		TpMergeSource		  *sources,
+		BufFile				 **files,
+		int					  *nfiles,
+		uint64				  *total_tokens)
+{
+	const TpBuildRun *open_run	  = NULL;
+	int				  num_sources = 0;
+	int				  i;
+
+	*nfiles = 0;
+	for (i = 0; i < nruns; i++)
+	{
+		TpSegmentReader *reader;
+
+		if (runs[i].size == 0)
+			continue;
+
+		if (open_run == NULL || open_run->round != runs[i].round ||
+			open_run->file != runs[i].file)
+		{
+			char fname[64];
+
+			build_run_file_name(&runs[i], fname, sizeof(fname));
+			files[(*nfiles)++] = BufFileOpenFileSet(
+					&shared->fileset.fs, fname, O_RDONLY, false);
+			open_run = &runs[i];
+		}
+
+		reader = tp_segment_open_from_buffile(
+				files[*nfiles - 1], runs[i].offset);
+		if (merge_source_init_from_reader(&sources[num_sources], reader))
+		{
+			*total_tokens += reader->header->total_tokens;
+			num_sources++;
+		}
+		else
+			tp_segment_close(reader);
+	}
+
+	return num_sources;
+}
+
+/*
+ * Merge batch `batch` of the current round into its own file and
+ * record the result in batch_out[batch].  Batches split the round's
+ * runs into consecutive, near-equal groups.  Inputs written by an
+ * earlier round are deleted once merged; the workers' phase-1 files
+ * go with the file set.
+ */
+static void
+build_merge_batch(TpParallelBuildShared *shared, uint32 batch)
+{
+	uint32			per	  = shared->nruns / shared->nbatches;
+	uint32			extra = shared->nruns % shared->nbatches;
+	uint32			first = batch * per + Min(batch, extra);
+	uint32			count = per + (batch < extra ? 1 : 0);
+	TpBuildRun	   *out	  = &shared->batch_out[batch];
+	TpMergeSource  *sources;
+	BufFile		  **files;
+	int				num_sources;
+	int				nfiles;
+	uint64			total_tokens = 0;
+	TpMergedTerm   *terms;
+	uint32			num_terms;
+	TpMergeChunks	chunks;
+	BufFile		   *outfile;
+	TpMergeSink		sink;
+	char			fname[64];
+	MemoryContext	batch_ctx;
+	MemoryContext	old_ctx;
+	uint64			sleeps;
+	uint32			i;
+
+	tp_io_throttle_reset();
+	sleeps = tp_io_throttle_sleeps();
+
+	batch_ctx = AllocSetContextCreate(
+			CurrentMemoryContext, "Build Merge Batch", ALLOCSET_DEFAULT_SIZES);
+	old_ctx = MemoryContextSwitchTo(batch_ctx);
+
+	sources		= palloc0(sizeof(TpMergeSource) * count);
+	files		= palloc0(sizeof(BufFile *) * count);
+	num_sources = build_open_runs(
+			shared,
+			&shared->runs[first],
+			count,
+			sources,
+			files,
+			&nfiles,
+			&total_tokens);
+
+	terms = merge_collect_terms(sources, num_sources, UINT32_MAX, &num_terms);
+	build_scan_chunks(shared, &chunks);
+
+	out->round	= shared->round;
+	out->file	= batch;
+	out->offset = 0;
+
+	build_run_file_name(out, fname, sizeof(fname));
+	outfile = BufFileCreateFileSet(&shared->fileset.fs, fname);
+	/* Nothing holds the index lock during a parallel build */
+	merge_sink_init_buffile(&sink, outfile, false);
+	write_merged_segment_to_sink(
+			&sink,
+			terms,
+			num_terms,
+			sources,
+			num_sources,
+			0, /* target_level: L0 */
+			total_tokens,
+			true /* disjoint_sources */,
+			&chunks);
+	out->size = sink.current_offset;
+
+	BufFileExportFileSet(outfile);
+	BufFileClose(outfile);
+
+	for (i = 0; i < (uint32)num_sources; i++)
+		merge_source_close(&sources[i]);
+	for (i = 0; i < (uint32)nfiles; i++)
+		BufFileClose(files[i]);
+
+	for (i = first; i < first + count; i++)
+	{
+		if (shared->runs[i].round == 0)
+			continue;
+		build_run_file_name(&shared->runs[i], fname, sizeof(fname));
+		BufFileDeleteFileSet(&shared->fileset.fs, fname, true);
+	}
+
+	MemoryContextSwitchTo(old_ctx);
+	MemoryContextDelete(batch_ctx);
+
+	pg_atomic_fetch_add_u64(
+			&shared->throttle_sleeps, tp_io_throttle_sleeps() - sleeps);
+}
+
+/*
+ * Claim and merge batches of the current round until none is left.
+ * The leader resets next_batch only once every batch of a round is
+ * done, after setting up the next one, so a claim always lands in
+ * the round whose fields we then read.  A participant late out of
+ * the previous round may still take a ticket past the end of the
+ * new one; the re-check drops it.
+ */
+static void
+build_claim_batches(TpParallelBuildShared *shared)
+{
+	for (;;)
+	{
+		uint32 batch = pg_atomic_read_u32(&shared->next_batch);
+
+		do
+		{
+			if (batch >= shared->nbatches)
+				return;
+		} while (!pg_atomic_compare_exchange_u32(
+				&shared->next_batch, &batch, batch + 1));
+
+		if (batch >= shared->nbatches)
+			return;
+
+		build_merge_batch(shared, batch);
+
+		pg_atomic_fetch_add_u32(&shared->batches_done, 1);
+		ConditionVariableBroadcast(&shared->all_done_cv);
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+/*
+ * Worker: join each merge round the leader publishes until the
+ * leader signals phase2_ready.
+ */
+static void
+build_worker_merge_rounds(TpParallelBuildShared *shared)
+{
+	uint32 seen = 0;
+
+	for (;;)
+	{
+		uint32 round;
+
+		ConditionVariablePrepareToSleep(&shared->phase2_cv);
+		for (;;)
+		{
+			round = pg_atomic_read_u32(&shared->round_published);
+			if (round != seen ||
+				pg_atomic_read_u32(&shared->phase2_ready) != 0)
+				break;
+			ConditionVariableSleep(&shared->phase2_cv, PG_WAIT_EXTENSION);
+		}
+		ConditionVariableCancelSleep();
+
+		if (round == seen)
+			break;
+
+		seen = round;
+		pg_read_barrier();
+		build_claim_batches(shared);
+	}
+}
+
+/*
+ * Leader: merge runs[] in rounds until at most
+ * parallel_build_merge_fanin runs remain, merging batches itself
+ * while the workers do.
+ */
+static void
+build_merge_rounds(TpParallelBuildShared *shared)
+{
+	uint32 fanin = (uint32)tp_parallel_build_merge_fanin;
+
+	while (shared->nruns > fanin)
+	{
+		uint32 nruns = 0;
+		uint32 b;
+
+		shared->round++;
+		shared->nbatches = (shared->nruns + fanin - 1) / fanin;
+		pg_atomic_write_u32(&shared->batches_done, 0);
+		pg_write_barrier();
+		pg_atomic_write_u32(&shared->next_batch, 0);
+		pg_atomic_write_u32(&shared->round_published, shared->round);
+		ConditionVariableBroadcast(&shared->phase2_cv);
+
+		build_claim_batches(shared);
+
+		ConditionVariablePrepareToSleep(&shared->all_done_cv);
+		while (pg_atomic_read_u32(&shared->batches_done) < shared->nbatches)
+		{
+			ConditionVariableTimedSleep(
+					&shared->all_done_cv, 1000 /* ms */, PG_WAIT_EXTENSION);
+		}
+		ConditionVariableCancelSleep();
+		pg_read_barrier();
+
+		/* This round's outputs are the next round's runs */
+		for (b = 0; b < shared->nbatches; b++)
+		{
+			if (shared->batch_out[b].size > 0)
+				shared->runs[nruns++] = shared->batch_out[b];
+		}
+		shared->nruns = nruns;
+	}
+}
+
+/*
+ * Link the segments the workers wrote into the index as L0 chain
+ * heads, in worker order.
+ */
+static void
+build_link_worker_segments(TpParallelBuildShared *shared, Relation index)
+{
+	TpParallelWorkerResult *results = TpParallelWorkerResults(shared);
+	int						w;
+
+	/* Segment pages must be durable before the metapage points at them */
+	FlushRelationBuffers(index);
+
+	for (w = 0; w < shared->nworkers_launched; w++)
+	{
+		uint32 s;
+
+		for (s = 0; s < results[w].final_segment_count; s++)
+			tp_link_l0_chain_head(index, results[w].seg_roots[s]);
+	}
+}
+
+/* ----------------------------------------------------------------
+ * Heap scan
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Claim the next chunk of heap blocks, [*start, *end).  Returns false
+ * once every block has been claimed.
+ */
+static bool
+build_claim_blocks(
+		TpParallelBuildShared *shared, BlockNumber *start, BlockNumber *end)
+{
+	uint32 cur = pg_atomic_read_u32(&shared->next_block);
+
+	for (;;)
+	{
+		uint32 chunk;
+
+		if (cur >= shared->nblocks)
+			return false;
+
+		chunk = build_chunk_size(shared, cur);
+
+		/* On failure cur is reloaded; recompute from there */
+		if (pg_atomic_compare_exchange_u32(
+					&shared->next_block, &cur, cur + chunk))
+		{
+			*start = cur;
+			*end   = cur + chunk;
+			return true;
+		}
+	}
+}
+
+/*
+ * Fetch the next tuple of this worker's share of the heap into slot,
+ * claiming further chunks as each one runs dry.  The TID range scan
+ * is opened on the first chunk into *scan and rescanned for the
+ * rest.  Chunks are claimed in increasing block order, so a worker
+ * sees its tuples, and writes its segments, in CTID order.
+ */
+static bool
+build_scan_next(
+		TpParallelBuildShared *shared,
+		Relation			   heap,
+		Snapshot			   snap,
+		TableScanDesc		  *scan,
+		TupleTableSlot		  *slot)
+{
+	for (;;)
+	{
+		BlockNumber		start_blk;
+		BlockNumber		end_blk;
+		ItemPointerData min_tid, max_tid;
+
+		if (*scan != NULL &&
+			table_scan_getnextslot_tidrange(*scan, ForwardScanDirection, slot))
+			return true;
+
+		if (!build_claim_blocks(shared, &start_blk, &end_blk))
+			return false;
+
+		CHECK_FOR_INTERRUPTS();
+
+		ItemPointerSet(&min_tid, start_blk, FirstOffsetNumber);
+		ItemPointerSet(&max_tid, end_blk - 1, MaxOffsetNumber);
+		if (*scan == NULL)
+			*scan = table_beginscan_tidrange(heap, snap, &min_tid, &max_tid);
+		else
+			table_rescan_tidrange(*scan, &min_tid, &max_tid);
+	}
+}
+
 /* ----------------------------------------------------------------
  * Worker entry point
  * ----------------------------------------------------------------
@@ -214,23 +718,28 @@ tp_parallel_build_worker_main(dsm_segment *seg, shm_toc *toc)
 		indexInfo->ii_PredicateState =
 				ExecPrepareQual(indexInfo->ii_Predicate, estate);
 
-	/* Attach to SharedFileSet and create worker's BufFile */
+	/* Attach to SharedFileSet for the merge rounds */
 	SharedFileSetAttach(&shared->fileset, seg);
-	snprintf(file_name, sizeof(file_name), "tp_worker_%d", worker_id);
-	buffile = BufFileCreateFileSet(&shared->fileset.fs, file_name);
 
 	/*
-	 * Wait for leader to set up per-worker block ranges.
+	 * Wait for leader to set up the shared heap cursor.
 	 * This is a brief spin (microseconds) after launch.
 	 */
 	while (pg_atomic_read_u32(&shared->scan_ready) == 0)
 		pg_usleep(100);
 	pg_read_barrier();
 
+	/* Create the worker's BufFile, unless writing to the index */
+	buffile = NULL;
+	if (!shared->direct_write)
+	{
+		snprintf(file_name, sizeof(file_name), "tp_worker_%d", worker_id);
+		buffile = BufFileCreateFileSet(&shared->fileset.fs, file_name);
+	}
+
 	/*
-	 * Open a TID range scan limited to this worker's block range.
-	 * Each worker scans a contiguous, non-overlapping range of
-	 * heap blocks, ensuring disjoint CTIDs across workers.
+	 * The TID range scan is opened on the first chunk this worker
+	 * claims; see build_scan_next.
 	 */
 	snap = GetTransactionSnapshot();
 #if PG_VERSION_NUM >= 180000
@@ -238,41 +747,9 @@ tp_parallel_build_worker_main(dsm_segment *seg, shm_toc *toc)
 #endif
 
 	slot = table_slot_create(heap, NULL);
-	{
-		BlockNumber start_blk = shared->worker_start_block[worker_id];
-		BlockNumber end_blk	  = shared->worker_end_block[worker_id];
-
-		if (start_blk < end_blk)
-		{
-			ItemPointerData min_tid, max_tid;
-
-			ItemPointerSet(&min_tid, start_blk, FirstOffsetNumber);
-			ItemPointerSet(&max_tid, end_blk - 1, MaxOffsetNumber);
-			scan = table_beginscan_tidrange(heap, snap, &min_tid, &max_tid);
-		}
-		else
-		{
-			/* Empty range: no blocks assigned to this worker */
-			scan = NULL;
-		}
-	}
-
-	/*
-	 * Per-worker memory budget: split maintenance_work_mem across
-	 * workers. Minimum 64MB per worker to avoid excessive flushing.
-	 */
-	budget = (Size)maintenance_work_mem * 1024L / shared->nworkers_launched;
-	if (budget < 64L * 1024 * 1024)
-		budget = 64L * 1024 * 1024;
-
-	/*
-	 * Clamp to the arena's addressable capacity: with few workers
-	 * launched, maintenance_work_mem / nworkers can still exceed the
-	 * 4 GiB arena, so the worker would overrun instead of spilling
-	 * (issue #433).
-	 */
-	budget = tp_arena_clamp_budget(budget);
+	scan = NULL;
 
+	budget	  = build_worker_budget(shared->nworkers_launched);
 	build_ctx = tp_build_context_create(budget);
 	tracker_init(&tracker);
 
@@ -281,9 +758,8 @@ tp_parallel_build_worker_main(dsm_segment *seg, shm_toc *toc)
 			"parallel build per-doc temp",
 			ALLOCSET_DEFAULT_SIZES);
 
-	/* Process tuples from this worker's block range */
-	while (scan != NULL &&
-		   table_scan_getnextslot_tidrange(scan, ForwardScanDirection, slot))
+	/* Process tuples from the block chunks this worker claims */
+	while (build_scan_next(shared, heap, snap, &scan, slot))
 	{
 		text	   *document_text;
 		ItemPointer ctid;
@@ -343,31 +819,13 @@ tp_parallel_build_worker_main(dsm_segment *seg, shm_toc *toc)
 		/* Reset per-doc context */
 		MemoryContextReset(build_tmpctx);
 
-		/* Budget-based flush to BufFile */
+		/* Budget-based flush */
 		if (tp_build_context_should_flush(build_ctx))
 		{
-			uint64 data_size;
-			uint64 seg_offset;
-
 			my_result->total_docs += build_ctx->num_docs;
 			my_result->total_len += build_ctx->total_len;
 
-			/* L0 segment starts at current end of BufFile */
-			seg_offset = tracker.buffile_end;
-			{
-				int	  fileno;
-				off_t file_offset;
-
-				tp_buffile_decompose_offset(seg_offset, &fileno, &file_offset);
-				BufFileSeek(buffile, fileno, file_offset, SEEK_SET);
-			}
-
-			data_size = tp_write_segment_to_buffile(build_ctx, buffile);
-
-			/* Track this L0 segment */
-			tracker_add_segment(&tracker, seg_offset, data_size);
-			tracker.buffile_end = seg_offset + data_size;
-
+			build_worker_flush(build_ctx, index, buffile, &tracker);
 			tp_build_context_reset(build_ctx);
 		}
 
@@ -386,25 +844,10 @@ tp_parallel_build_worker_main(dsm_segment *seg, shm_toc *toc)
 	/* Flush remaining data */
 	if (build_ctx->num_docs > 0)
 	{
-		uint64 data_size;
-		uint64 seg_offset;
-
 		my_result->total_docs += build_ctx->num_docs;
 		my_result->total_len += build_ctx->total_len;
 
-		seg_offset = tracker.buffile_end;
-		{
-			int	  fileno;
-			off_t file_offset;
-
-			tp_buffile_decompose_offset(seg_offset, &fileno, &file_offset);
-			BufFileSeek(buffile, fileno, file_offset, SEEK_SET);
-		}
-
-		data_size = tp_write_segment_to_buffile(build_ctx, buffile);
-
-		tracker_add_segment(&tracker, seg_offset, data_size);
-		tracker.buffile_end = seg_offset + data_size;
+		build_worker_flush(build_ctx, index, buffile, &tracker);
 	}
 
 	/*
@@ -443,13 +886,17 @@ tp_parallel_build_worker_main(dsm_segment *seg, shm_toc *toc)
 		{
 			my_result->seg_offsets[i] = tracker.entries[i].offset;
 			my_result->seg_sizes[i]	  = tracker.entries[i].data_size;
+			my_result->seg_roots[i]	  = tracker.entries[i].root;
 		}
 		my_result->final_segment_count = tracker.count;
 	}
 
 	/* Export BufFile so leader can reopen */
-	BufFileExportFileSet(buffile);
-	BufFileClose(buffile);
+	if (buffile != NULL)
+	{
+		BufFileExportFileSet(buffile);
+		BufFileClose(buffile);
+	}
 
 	/* Cleanup Phase 1 resources */
 	FreeExecutorState(estate);
@@ -464,16 +911,13 @@ tp_parallel_build_worker_main(dsm_segment *seg, shm_toc *toc)
 #endif
 	ExecDropSingleTupleTableSlot(slot);
 
-	/* Signal Phase 1 done, wait for leader to finish merge */
+	/* Signal Phase 1 done */
 	pg_atomic_fetch_add_u32(&shared->phase1_done, 1);
 	ConditionVariableBroadcast(&shared->all_done_cv);
 
-	ConditionVariablePrepareToSleep(&shared->phase2_cv);
-	while (pg_atomic_read_u32(&shared->phase2_ready) == 0)
-		ConditionVariableSleep(&shared->phase2_cv, PG_WAIT_EXTENSION);
-	ConditionVariableCancelSleep();
+	/* Help with the merge rounds until the leader has merged */
+	build_worker_merge_rounds(shared);
 
-	/* No Phase 2 work — leader did the merge. Just exit. */
 	index_close(index, AccessExclusiveLock);
 	table_close(heap, AccessShareLock);
 
@@ -487,14 +931,15 @@ tp_parallel_build_worker_main(dsm_segment *seg, shm_toc *toc)
  */
 IndexBuildResult *
 tp_build_parallel(
-		Relation   heap,
-		Relation   index,
-		IndexInfo *indexInfo,
-		Oid		   text_config_oid,
-		double	   k1,
-		double	   b,
-		bool	   is_text_array,
-		int		   nworkers)
+		Relation			  heap,
+		Relation			  index,
+		IndexInfo			 *indexInfo,
+		Oid					  text_config_oid,
+		double				  k1,
+		double				  b,
+		bool				  is_text_array,
+		int					  nworkers,
+		TpParallelBuildStats *stats)
 {
 	IndexBuildResult	  *result;
 	ParallelContext		  *pcxt;
@@ -502,12 +947,16 @@ tp_build_parallel(
 	Snapshot			   snapshot;
 	Size				   shmem_size;
 	int					   launched;
+	bool				   direct_write;
 	uint64				   total_docs = 0;
 	uint64				   total_len  = 0;
 
 	/* Workers reconstruct IndexInfo via BuildIndexInfo() */
 	(void)indexInfo;
 
+	stats->merge_rounds	   = 0;
+	stats->throttle_sleeps = 0;
+
 	/* Ensure reasonable number of workers */
 	if (nworkers > TP_MAX_PARALLEL_WORKERS)
 		nworkers = TP_MAX_PARALLEL_WORKERS;
@@ -584,29 +1033,33 @@ tp_build_parallel(
 					nworkers)));
 
 	/*
-	 * Compute per-worker block ranges for disjoint TID scans.
-	 * Must be done after launch so we know `launched`. Workers
-	 * spin on scan_ready until ranges are set.
+	 * Set up the shared heap cursor.  Must be done after launch so
+	 * chunk sizes account for `launched`.  Workers spin on
+	 * scan_ready until it is set.
+	 */
+	shared->nblocks			  = RelationGetNumberOfBlocks(heap);
+	shared->nworkers_launched = launched;
+
+	/*
+	 * Have workers write their segments straight into the index when
+	 * they are expected to write fewer than a level holds: each
+	 * worker's share of the heap fitting its memory budget about
+	 * once.  Those segments need no merge, so the temp-file round
+	 * trip would only double the build's I/O.  Heap size stands in
+	 * for what a worker accumulates; a wrong guess costs the L0
+	 * merge the leader then runs, not correctness.
 	 */
 	{
-		BlockNumber nblocks			  = RelationGetNumberOfBlocks(heap);
-		BlockNumber blocks_per_worker = nblocks / launched;
-		BlockNumber remainder		  = nblocks % launched;
-		BlockNumber cursor			  = 0;
-		int			i;
+		uint64 share	= (uint64)shared->nblocks * BLCKSZ / launched;
+		uint64 budget	= build_worker_budget(launched);
+		uint64 per_wkr	= Max((share + budget - 1) / budget, 1);
+		uint64 expected = per_wkr * launched;
 
-		for (i = 0; i < launched; i++)
-		{
-			BlockNumber count = blocks_per_worker +
-								(i < (int)remainder ? 1 : 0);
-			shared->worker_start_block[i] = cursor;
-			shared->worker_end_block[i]	  = cursor + count;
-			cursor += count;
-		}
-		shared->nworkers_launched = launched;
-		pg_write_barrier();
-		pg_atomic_write_u32(&shared->scan_ready, 1);
+		shared->direct_write = expected < (uint64)tp_segments_per_level;
 	}
+	direct_write = shared->direct_write;
+	pg_write_barrier();
+	pg_atomic_write_u32(&shared->scan_ready, 1);
 
 	/*
 	 * Phase 1 wait: wait for all workers to finish BufFile phase.
@@ -646,83 +1099,70 @@ tp_build_parallel(
 			PROGRESS_CREATEIDX_SUBPHASE, TP_PHASE_WRITING);
 
 	/*
-	 * Leader-only merge: open all worker BufFile segments and
-	 * perform a single N-way merge directly to paged storage.
+	 * Segments the workers wrote into the index only need linking;
+	 * the final merge below then finds no runs and just records the
+	 * corpus statistics.  Otherwise every worker segment is a run of
+	 * the first merge round.
 	 */
+	shared->nruns = 0;
+	if (direct_write)
+		build_link_worker_segments(shared, index);
+	else
 	{
 		TpParallelWorkerResult *results = TpParallelWorkerResults(shared);
-		BufFile				  **open_files;
-		bool				   *file_opened;
-		TpSegmentReader		  **readers;
-		TpMergeSource		   *sources;
-		uint32					total_segments = 0;
-		uint32					num_sources	   = 0;
-		uint64					total_tokens   = 0;
 		int						w;
-		uint32					i;
-		TpMergedTerm		   *merged_terms	 = NULL;
-		uint32					num_merged_terms = 0;
-		uint32					merged_capacity	 = 0;
-		MemoryContext			merge_ctx;
-		MemoryContext			old_ctx;
-
-		/* Count total segments across all workers */
-		for (w = 0; w < launched; w++)
-			total_segments += results[w].final_segment_count;
-
-		/* Open worker BufFiles and create segment readers */
-		open_files	= palloc0(sizeof(BufFile *) * launched);
-		file_opened = palloc0(sizeof(bool) * launched);
-		readers		= palloc0(sizeof(TpSegmentReader *) * total_segments);
-		sources		= palloc0(sizeof(TpMergeSource) * total_segments);
 
+		for (w = 0; w < launched; w++)
 		{
-			uint32 reader_idx = 0;
+			uint32 s;
 
-			for (w = 0; w < launched; w++)
+			for (s = 0; s < results[w].final_segment_count; s++)
 			{
-				uint32 s;
-				char   fname[64];
-
-				if (results[w].final_segment_count == 0)
-					continue;
-
-				snprintf(fname, sizeof(fname), "tp_worker_%d", w);
-				open_files[w] = BufFileOpenFileSet(
-						&shared->fileset.fs, fname, O_RDONLY, false);
-				file_opened[w] = true;
-
-				for (s = 0; s < results[w].final_segment_count; s++)
-				{
-					readers[reader_idx] = tp_segment_open_from_buffile(
-							open_files[w], results[w].seg_offsets[s]);
-					if (!readers[reader_idx])
-					{
-						reader_idx++;
-						continue;
-					}
-
-					if (merge_source_init_from_reader(
-								&sources[num_sources], readers[reader_idx]))
-					{
-						total_tokens +=
-								readers[reader_idx]->header->total_tokens;
-						/*
-						 * Source now owns this reader; clear
-						 * slot so cleanup won't double-close.
-						 */
-						readers[reader_idx] = NULL;
-						num_sources++;
-					}
-					reader_idx++;
-				}
+				TpBuildRun *run = &shared->runs[shared->nruns++];
+
+				run->round	= 0;
+				run->file	= w;
+				run->offset = results[w].seg_offsets[s];
+				run->size	= results[w].seg_sizes[s];
 			}
 		}
+	}
+
+	build_merge_rounds(shared);
+
+	/*
+	 * Final merge: open the remaining runs and merge them directly
+	 * to paged storage.
+	 */
+	{
+		TpMergeSource *sources;
+		BufFile		 **files;
+		int			   num_sources;
+		int			   nfiles;
+		uint64		   total_tokens = 0;
+		uint32		   i;
+		TpMergedTerm  *merged_terms		= NULL;
+		uint32		   num_merged_terms = 0;
+		MemoryContext  merge_ctx;
+		MemoryContext  old_ctx;
+
+		sources		= palloc0(sizeof(TpMergeSource) * shared->nruns);
+		files		= palloc0(sizeof(BufFile *) * shared->nruns);
+		num_sources = build_open_runs(
+				shared,
+				shared->runs,
+				shared->nruns,
+				sources,
+				files,
+				&nfiles,
+				&total_tokens);
 
 		if (num_sources > 0)
 		{
-			TpMergeSink sink;
-			BlockNumber segment_root;
+			TpMergeSink	  sink;
+			TpMergeChunks chunks;
+			BlockNumber	  segment_root;
+			uint64		  sleeps;
 
 			/* N-way term merge */
 			merge_ctx = AllocSetContextCreate(
@@ -731,64 +1171,16 @@ tp_build_parallel(
 					ALLOCSET_DEFAULT_SIZES);
 			old_ctx = MemoryContextSwitchTo(merge_ctx);
 
-			while (true)
-			{
-				int			  min_idx;
-				const char	 *min_term;
-				TpMergedTerm *current_merged;
-
-				min_idx = merge_find_min_source(sources, num_sources);
-				if (min_idx < 0)
-					break;
-
-				min_term = sources[min_idx].current_term;
-
-				if (num_merged_terms >= merged_capacity)
-				{
-					merged_capacity = merged_capacity == 0
-											? 1024
-											: merged_capacity * 2;
-					if (merged_terms == NULL)
-						merged_terms = palloc_extended(
-								merged_capacity * sizeof(TpMergedTerm),
-								MCXT_ALLOC_HUGE);
-					else
-						merged_terms = repalloc_huge(
-								merged_terms,
-								merged_capacity * sizeof(TpMergedTerm));
-				}
-
-				current_merged				 = &merged_terms[num_merged_terms];
-				current_merged->term_len	 = strlen(min_term);
-				current_merged->term		 = pstrdup(min_term);
-				current_merged->segment_refs = NULL;
-				current_merged->num_segment_refs	  = 0;
-				current_merged->segment_refs_capacity = 0;
-				current_merged->posting_offset		  = 0;
-				current_merged->posting_count		  = 0;
-				num_merged_terms++;
-
-				for (i = 0; i < num_sources; i++)
-				{
-					if (sources[i].exhausted)
-						continue;
-
-					if (strcmp(sources[i].current_term,
-							   current_merged->term) == 0)
-					{
-						merged_term_add_segment_ref(
-								current_merged, i, &sources[i].current_entry);
-						merge_source_advance(&sources[i]);
-					}
-				}
-
-				CHECK_FOR_INTERRUPTS();
-			}
+			merged_terms = merge_collect_terms(
+					sources, num_sources, UINT32_MAX, &num_merged_terms);
+			build_scan_chunks(shared, &chunks);
 
 			MemoryContextSwitchTo(old_ctx);
 
 			/* Write single merged segment to index pages */
-			merge_sink_init_pages(&sink, index);
+			tp_io_throttle_reset();
+			sleeps = tp_io_throttle_sleeps();
+			merge_sink_init_pages(&sink, index, false);
 			if (sink.writer.pages_allocated == 0)
 				elog(ERROR, "merge: failed to allocate segment pages");
 			segment_root = sink.writer.pages[0];
@@ -801,7 +1193,8 @@ tp_build_parallel(
 					num_sources,
 					0, /* target_level: L0 */
 					total_tokens,
-					true /* disjoint_sources */);
+					true /* disjoint_sources */,
+					&chunks);
 
 			/*
 			 * Flush dirty buffers before updating the metapage,
@@ -809,6 +1202,12 @@ tp_build_parallel(
 			 */
 			FlushRelationBuffers(index);
 
+			/* The merge rounds, and this final merge */
+			stats->merge_rounds = shared->round + 1;
+			pg_atomic_fetch_add_u64(
+					&shared->throttle_sleeps,
+					tp_io_throttle_sleeps() - sleeps);
+
 			/* Link as L0 head in metapage */
 			{
 				Buffer			  metabuf;
@@ -850,7 +1249,7 @@ tp_build_parallel(
 		}
 		else
 		{
-			/* No segments at all — just update metapage stats */
+			/* No runs to merge — just update metapage stats */
 			Buffer			  metabuf;
 			GenericXLogState *state;
 			Page			  metapage;
@@ -872,28 +1271,16 @@ tp_build_parallel(
 
 		/*
 		 * Close merge sources.  merge_source_close() frees term
-		 * data and closes the underlying reader, so we only need
-		 * to close readers that were not successfully wrapped in
-		 * a source (e.g. empty segments that were skipped).
+		 * data and closes the underlying reader; build_open_runs
+		 * already closed readers it could not wrap in a source.
 		 */
-		for (i = 0; i < num_sources; i++)
+		for (i = 0; i < (uint32)num_sources; i++)
 			merge_source_close(&sources[i]);
+		for (i = 0; i < (uint32)nfiles; i++)
+			BufFileClose(files[i]);
 
-		for (i = 0; i < total_segments; i++)
-		{
-			if (readers[i])
-				tp_segment_close(readers[i]);
-		}
-		for (w = 0; w < launched; w++)
-		{
-			if (file_opened[w])
-				BufFileClose(open_files[w]);
-		}
-
-		pfree(readers);
 		pfree(sources);
-		pfree(open_files);
-		pfree(file_opened);
+		pfree(files);
 	}
 
 	/* Wake workers so they can exit */
@@ -909,6 +1296,7 @@ tp_build_parallel(
 	}
 	ConditionVariableCancelSleep();
 	WaitForParallelWorkersToFinish(pcxt);
+	stats->throttle_sleeps = pg_atomic_read_u64(&shared->throttle_sleeps);
 
 	/* Build result */
 	result				 = palloc0(sizeof(IndexBuildResult));
@@ -922,5 +1310,12 @@ tp_build_parallel(
 	UnregisterSnapshot(snapshot);
 #endif
 
+	/*
+	 * If the workers wrote more segments than expected, merge L0 as
+	 * a serial build would, now that a merge may run in parallel.
+	 */
+	if (direct_write)
+		tp_maybe_compact_level(index, 0);
+
 	return result;
 }
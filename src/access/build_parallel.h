@@ -4,11 +4,18 @@
  *
  * build_parallel.h - Parallel index build structures
  *
- * Architecture (leader-only merge):
- * - Phase 1: Workers scan heap, flush L0 segments to BufFile.
- *   Workers report segment offsets/sizes and signal phase1_done.
- * - Leader: Opens all worker BufFiles, performs single N-way merge
- *   directly to paged storage. Updates metapage.
+ * Architecture (tree merge):
+ * - Phase 1: Workers claim chunks of heap blocks from a shared
+ *   cursor, flush L0 segments to BufFile.  Workers report segment
+ *   offsets/sizes and signal phase1_done.
+ * - Direct write: when the workers are expected to write fewer
+ *   segments than a level holds, they write them into the index
+ *   instead, and the leader only links them into L0.
+ * - Merge rounds: while there are more segments than
+ *   pg_textsearch.parallel_build_merge_fanin, workers and leader
+ *   merge batches of them into new BufFile segments in parallel.
+ * - Leader: merges the remaining segments directly to paged
+ *   storage. Updates metapage.
  * - Leader signals phase2_ready; workers wake and exit.
  */
 #pragma once
@@ -34,6 +41,13 @@
  */
 #define TP_MAX_WORKER_SEGMENTS 64
 
+/*
+ * Segments entering the first merge round, at most, and batches in a
+ * round (the fan-in is at least 2).
+ */
+#define TP_MAX_BUILD_RUNS	 (TP_MAX_PARALLEL_WORKERS * TP_MAX_WORKER_SEGMENTS)
+#define TP_MAX_BUILD_BATCHES (TP_MAX_BUILD_RUNS / 2)
+
 /*
  * Shared memory keys for parallel build TOC
  */
@@ -49,12 +63,28 @@ typedef struct TpParallelWorkerResult
 	uint64 total_len;  /* Sum of document lengths */
 	uint64 tuples_scanned;
 
-	/* Per-segment info (all L0, BufFile offsets) */
-	uint32 final_segment_count;
-	uint64 seg_offsets[TP_MAX_WORKER_SEGMENTS];
-	uint64 seg_sizes[TP_MAX_WORKER_SEGMENTS];
+	/*
+	 * Per-segment info, all L0: BufFile offsets and sizes, or with
+	 * direct_write the segments' root blocks in the index.
+	 */
+	uint32		final_segment_count;
+	uint64		seg_offsets[TP_MAX_WORKER_SEGMENTS];
+	uint64		seg_sizes[TP_MAX_WORKER_SEGMENTS];
+	BlockNumber seg_roots[TP_MAX_WORKER_SEGMENTS];
 } TpParallelWorkerResult;
 
+/*
+ * A segment in the shared file set: one a worker wrote in phase 1
+ * (round 0), or the output of a merge-round batch.
+ */
+typedef struct TpBuildRun
+{
+	uint32 round;  /* 0: tp_worker_<file>, else tp_run_<round>_<file> */
+	uint32 file;   /* worker number, or batch number in its round */
+	uint64 offset; /* segment start within the file */
+	uint64 size;   /* segment bytes; 0 = empty */
+} TpBuildRun;
+
 /*
  * Shared state for parallel index build
  *
@@ -72,10 +102,17 @@ typedef struct TpParallelBuildShared
 	int32  nworkers;		  /* Workers requested */
 	int32  nworkers_launched; /* Actual workers launched */
 
-	/* Per-worker heap block ranges for disjoint TID scan */
-	BlockNumber		 worker_start_block[TP_MAX_PARALLEL_WORKERS];
-	BlockNumber		 worker_end_block[TP_MAX_PARALLEL_WORKERS];
-	pg_atomic_uint32 scan_ready; /* 1 when block ranges set */
+	/*
+	 * Heap scan.  Workers claim chunks of blocks from next_block,
+	 * shrinking as fewer blocks remain, so a skewed region of the
+	 * heap does not leave one worker finishing long after the rest.
+	 */
+	BlockNumber		 nblocks;	 /* Heap blocks to scan */
+	pg_atomic_uint32 next_block; /* First unclaimed block */
+	pg_atomic_uint32 scan_ready; /* 1 when nblocks set */
+
+	/* Workers write segments into the index; set with nblocks */
+	bool direct_write;
 
 	/* Temp files for worker segments */
 	SharedFileSet fileset;
@@ -86,12 +123,30 @@ typedef struct TpParallelBuildShared
 
 	/* Phase coordination */
 	pg_atomic_uint32  phase1_done;	/* Workers done with BufFile */
-	ConditionVariable phase2_cv;	/* Leader signals merge done */
+	ConditionVariable phase2_cv;	/* Leader signals rounds, merge done */
 	pg_atomic_uint32  phase2_ready; /* 1 when leader merge done */
 
+	/*
+	 * Merge rounds.  The leader sets runs[] and the round's fields,
+	 * then publishes the round; participants claim batches of
+	 * consecutive runs through next_batch and record each batch's
+	 * output segment in batch_out[].
+	 */
+	TpBuildRun		 runs[TP_MAX_BUILD_RUNS];
+	uint32			 nruns;
+	uint32			 round;	   /* current round, from 1 */
+	uint32			 nbatches; /* batches in the current round */
+	TpBuildRun		 batch_out[TP_MAX_BUILD_BATCHES];
+	pg_atomic_uint32 next_batch;
+	pg_atomic_uint32 batches_done;
+	pg_atomic_uint32 round_published; /* latest round workers may join */
+
 	/* Progress reporting */
 	pg_atomic_uint64 tuples_done;
 
+	/* Merge throttle sleeps of every participant */
+	pg_atomic_uint64 throttle_sleeps;
+
 	/*
 	 * Per-worker results (variable-length array follows).
 	 * Workers write their own slot; leader reads after Phase 1.
@@ -108,20 +163,32 @@ TpParallelWorkerResults(TpParallelBuildShared *shared)
 									  MAXALIGN(sizeof(TpParallelBuildShared)));
 }
 
+/*
+ * What a parallel build merged, for bm25_merge_stats.  The index has
+ * no shared state until the build returns, so the caller accounts it
+ * once it has created one.
+ */
+typedef struct TpParallelBuildStats
+{
+	uint32 merge_rounds;	/* rounds, counting the final merge; 0 if none */
+	uint64 throttle_sleeps; /* merge_cost_delay sleeps while merging */
+} TpParallelBuildStats;
+
 /*
  * Function declarations
  */
 
 /* Main parallel build entry point */
 extern struct IndexBuildResult *tp_build_parallel(
-		Relation		  heap,
-		Relation		  index,
-		struct IndexInfo *indexInfo,
-		Oid				  text_config_oid,
-		double			  k1,
-		double			  b,
-		bool			  is_text_array,
-		int				  nworkers);
+		Relation			  heap,
+		Relation			  index,
+		struct IndexInfo	 *indexInfo,
+		Oid					  text_config_oid,
+		double				  k1,
+		double				  b,
+		bool				  is_text_array,
+		int					  nworkers,
+		TpParallelBuildStats *stats);
 
 /* Worker entry point (called by parallel infrastructure) */
 extern PGDLLEXPORT void
@@ -61,7 +61,7 @@ tp_handler(PG_FUNCTION_ARGS)
 
 	amroutine = makeNode(IndexAmRoutine);
 
-	amroutine->amstrategies	  = 0; /* No search strategies - ORDER BY only */
+	amroutine->amstrategies	  = 0; /* No fixed set; see TP_STRATEGY_* */
 	amroutine->amsupport	  = 8; /* 8 for distance */
 	amroutine->amoptsprocnum  = 0;
 	amroutine->amcanorder	  = false;
@@ -107,7 +107,7 @@ tp_handler(PG_FUNCTION_ARGS)
 	amroutine->ambeginscan		= tp_beginscan;
 	amroutine->amrescan			= tp_rescan;
 	amroutine->amgettuple		= tp_gettuple;
-	amroutine->amgetbitmap		= NULL; /* No bitmap scans - ORDER BY only */
+	amroutine->amgetbitmap		= tp_getbitmap; /* @@@ and @@& quals */
 	amroutine->amendscan		= tp_endscan;
 	amroutine->ammarkpos		= NULL; /* No mark/restore support */
 	amroutine->amrestrpos		= NULL;
@@ -138,7 +138,16 @@ tp_options(Datum reloptions, bool validate)
 			  .offset  = offsetof(TpOptions, k1)},
 			 {.optname = "b",
 			  .opttype = RELOPT_TYPE_REAL,
-			  .offset  = offsetof(TpOptions, b)}};
+			  .offset  = offsetof(TpOptions, b)},
+			 {.optname = "merge_policy",
+			  .opttype = RELOPT_TYPE_ENUM,
+			  .offset  = offsetof(TpOptions, merge_policy)},
+			 {.optname = "max_merged_segment_mb",
+			  .opttype = RELOPT_TYPE_INT,
+			  .offset  = offsetof(TpOptions, max_merged_segment_mb)},
+			 {.optname = "merge_deletes_pct",
+			  .opttype = RELOPT_TYPE_INT,
+			  .offset  = offsetof(TpOptions, merge_deletes_pct)}};
 
 	return (bytea *)build_reloptions(
 			reloptions,
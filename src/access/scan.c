@@ -11,6 +11,7 @@
 #include <access/sdir.h>
 #include <access/table.h>
 #include <catalog/namespace.h>
+#include <nodes/tidbitmap.h>
 #include <pgstat.h>
 #include <storage/bufmgr.h>
 #include <utils/builtins.h>
@@ -25,9 +26,12 @@
 #include "index/limit.h"
 #include "index/metapage.h"
 #include "index/resolve.h"
+#include "index/snapshot.h"
 #include "index/state.h"
 #include "memtable/scan.h"
+#include "scoring/match.h"
 #include "types/query.h"
+#include "types/query_terms.h"
 #include "types/vector.h"
 
 /*
@@ -122,22 +126,26 @@ tp_rescan_cleanup_results(TpScanOpaque so)
  * Handles both bm25query and plain text arguments to support:
  * - ORDER BY content <@> 'query'::bm25query (explicit bm25query)
  * - ORDER BY content <@> 'query' (plain text, implicit index resolution)
+ *
+ * Returns true when the query text is the one the scan already had,
+ * which is then kept along with its terms.
  */
-static void
+static bool
 tp_rescan_process_orderby(
 		IndexScanDesc	scan,
 		ScanKey			orderbys,
 		int				norderbys,
 		TpIndexMetaPage metap)
 {
-	TpScanOpaque so = (TpScanOpaque)scan->opaque;
+	TpScanOpaque so		   = (TpScanOpaque)scan->opaque;
+	bool		 unchanged = false;
 
 	for (int i = 0; i < norderbys; i++)
 	{
 		ScanKey orderby = &orderbys[i];
 
 		/* Check for <@> operator strategy */
-		if (orderby->sk_strategy == 1) /* Strategy 1: <@> operator */
+		if (orderby->sk_strategy == TP_STRATEGY_SCORE)
 		{
 			Datum query_datum = orderby->sk_argument;
 			char *query_cstr;
@@ -152,7 +160,8 @@ tp_rescan_process_orderby(
 				/* Plain text - use text directly */
 				text *query_text = (text *)DatumGetPointer(query_datum);
 
-				query_cstr = text_to_cstring(query_text);
+				query_cstr		= text_to_cstring(query_text);
+				so->score_floor = 0.0f;
 			}
 			else
 			{
@@ -161,6 +170,7 @@ tp_rescan_process_orderby(
 
 				query_cstr		= pstrdup(get_tpquery_text(query));
 				query_index_oid = get_tpquery_index_oid(query);
+				so->score_floor = tpquery_score_floor(query);
 
 				/* Validate index OID if provided in query */
 				if (tpquery_has_index(query))
@@ -170,11 +180,20 @@ tp_rescan_process_orderby(
 				}
 			}
 
-			/* Clear query vector since we're using text directly */
-			if (so->query_vector)
+			/* A nested loop's inner scan repeats its query text */
+			if (so->query_text && strcmp(so->query_text, query_cstr) == 0)
+			{
+				pfree(query_cstr);
+				unchanged = true;
+				continue;
+			}
+			unchanged = false;
+
+			/* Terms of the previous query text */
+			if (so->query_terms)
 			{
-				pfree(so->query_vector);
-				so->query_vector = NULL;
+				pfree(so->query_terms);
+				so->query_terms = NULL;
 			}
 
 			/* Free old query text if it exists */
@@ -196,14 +215,119 @@ tp_rescan_process_orderby(
 
 			/* Store index OID for this scan */
 			so->index_oid = RelationGetRelid(scan->indexRelation);
-
-			/* Mark all docs as candidates for ORDER BY operation */
-			if (metap && metap->total_docs > 0)
-				so->result_count = metap->total_docs;
+			if (metap)
+				so->text_config_oid = metap->text_config_oid;
 
 			pfree(query_cstr);
 		}
 	}
+
+	return unchanged;
+}
+
+/*
+ * Process WHERE scan keys for the @@@ and @@& match operators
+ *
+ * Each qual is tokenized here, once per rescan, with the index's text
+ * search configuration (through the backend's query term cache).
+ */
+static void
+tp_rescan_process_keys(IndexScanDesc scan, ScanKey keys, int nkeys)
+{
+	TpScanOpaque	so = (TpScanOpaque)scan->opaque;
+	TpMatchQuals   *quals;
+	TpIndexMetaPage metap;
+	MemoryContext	oldcontext;
+
+	so->nmatch		= 0;
+	so->match_none	= false;
+	so->match_quals = NULL;
+	if (so->match_context)
+		MemoryContextReset(so->match_context);
+
+	if (nkeys == 0)
+		return;
+
+	if (!so->match_context)
+		so->match_context = AllocSetContextCreate(
+				so->scan_context, "Tapir match quals", ALLOCSET_SMALL_SIZES);
+
+	metap	   = tp_get_metapage(scan->indexRelation);
+	oldcontext = MemoryContextSwitchTo(so->match_context);
+
+	quals				= palloc(sizeof(TpMatchQuals));
+	quals->nqual		= 0;
+	quals->terms		= palloc(nkeys * sizeof(char **));
+	quals->term_counts	= palloc(nkeys * sizeof(int));
+	quals->require_all	= palloc(nkeys * sizeof(bool));
+
+	for (int i = 0; i < nkeys; i++)
+	{
+		ScanKey		  key = &keys[i];
+		TpQuery		 *query;
+		TpQueryTerms *query_terms;
+		int			  q;
+
+		if (key->sk_strategy != TP_STRATEGY_MATCH_ANY &&
+			key->sk_strategy != TP_STRATEGY_MATCH_ALL)
+			elog(ERROR,
+				 "unexpected strategy number %d in bm25 scan key",
+				 key->sk_strategy);
+
+		so->nmatch++;
+
+		if (key->sk_flags & SK_ISNULL)
+		{
+			so->match_none = true;
+			continue;
+		}
+
+		query = (TpQuery *)PG_DETOAST_DATUM(key->sk_argument);
+		if (tpquery_has_index(query))
+			tp_validate_query_index(
+					get_tpquery_index_oid(query), scan->indexRelation);
+
+		q						= quals->nqual++;
+		quals->require_all[q]	= key->sk_strategy == TP_STRATEGY_MATCH_ALL;
+		query_terms = tp_query_terms_get(
+				metap->text_config_oid, get_tpquery_text(query));
+		quals->terms[q]		  = query_terms->terms;
+		quals->term_counts[q] = query_terms->term_count;
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+	pfree(metap);
+
+	so->match_quals = quals;
+}
+
+/*
+ * Can a rescan with an unchanged query text keep the last batch?  It
+ * must be an exact top of the whole index (no match quals, no shared
+ * threshold), deep enough for the new limit unless it already holds
+ * every match, and scored at the index's current result generation.
+ */
+static bool
+tp_rescan_batch_reusable(IndexScanDesc scan)
+{
+	TpScanOpaque	   so = (TpScanOpaque)scan->opaque;
+	TpLocalIndexState *index_state;
+	int				   needed;
+
+	if (!so->batch_reusable || so->result_ctids == NULL ||
+		so->nmatch > 0)
+		return false;
+
+	needed = so->limit > 0 ? so->limit : tp_default_limit;
+	if (so->result_count >= so->max_results_used &&
+		needed > so->max_results_used)
+		return false;
+
+	index_state = tp_get_local_index_state(
+			RelationGetRelid(scan->indexRelation));
+	return index_state != NULL &&
+		   pg_atomic_read_u64(&index_state->shared->result_generation) ==
+				   so->batch_generation;
 }
 
 /*
@@ -232,6 +356,7 @@ tp_beginscan(Relation index, int nkeys, int norderbys)
 			ALLOCSET_DEFAULT_SIZES);
 	so->limit			 = -1; /* Initialize limit to -1 (no limit) */
 	so->max_results_used = 0;
+	so->query_context	 = CurrentMemoryContext;
 	scan->opaque		 = so;
 
 	/*
@@ -254,13 +379,14 @@ tp_beginscan(Relation index, int nkeys, int norderbys)
 void
 tp_rescan(
 		IndexScanDesc scan,
-		ScanKey keys  pg_attribute_unused(),
-		int nkeys	  pg_attribute_unused(),
+		ScanKey		  keys,
+		int			  nkeys,
 		ScanKey		  orderbys,
 		int			  norderbys)
 {
-	TpScanOpaque	so	  = (TpScanOpaque)scan->opaque;
-	TpIndexMetaPage metap = NULL;
+	TpScanOpaque	so		   = (TpScanOpaque)scan->opaque;
+	TpIndexMetaPage metap	   = NULL;
+	bool			same_query = false;
 
 	Assert(scan != NULL);
 	Assert(scan->opaque != NULL);
@@ -274,34 +400,58 @@ tp_rescan(
 		so->limit		= (query_limit > 0) ? query_limit : -1;
 	}
 
-	/* Reset scan state */
-	if (so)
-	{
-		/* Clean up any previous results */
-		tp_rescan_cleanup_results(so);
+	/* Drop the emitted-CTID dedup set from any prior scan */
+	tp_returned_ctids_reset(so);
 
-		/* Drop the emitted-CTID dedup set from any prior scan */
-		tp_returned_ctids_reset(so);
+	/* Reset scan position and state */
+	so->current_pos		 = 0;
+	so->eof_reached		 = false;
+	so->batch_reused	 = false;
+	so->topk_floor_short = false;
+	so->topk_limit		 = 0;
 
-		/* Reset scan position and state */
-		so->current_pos	 = 0;
-		so->result_count = 0;
-		so->eof_reached	 = false;
-		so->query_vector = NULL;
-	}
+	/* Process WHERE scan keys for the match operators */
+	if (keys && nkeys > 0)
+		memmove(scan->keyData, keys, nkeys * sizeof(ScanKeyData));
+	tp_rescan_process_keys(scan, scan->keyData, scan->numberOfKeys);
 
 	/* Process ORDER BY scan keys for <@> operator */
-	if (norderbys > 0 && orderbys && so)
+	if (norderbys > 0 && orderbys)
 	{
 		/* Get index metadata to check if we have documents */
 		if (!metap)
 			metap = tp_get_metapage(scan->indexRelation);
 
-		tp_rescan_process_orderby(scan, orderbys, norderbys, metap);
+		same_query =
+				tp_rescan_process_orderby(scan, orderbys, norderbys, metap);
 
 		if (metap)
 			pfree(metap);
 	}
+
+	/*
+	 * An identical rescan restarts the last batch instead of scoring
+	 * again, as long as the index has not changed since.
+	 */
+	if (same_query && tp_rescan_batch_reusable(scan))
+	{
+		so->batch_reused = true;
+		return;
+	}
+
+	/* Clean up any previous results */
+	tp_rescan_cleanup_results(so);
+	so->result_count   = 0;
+	so->batch_reusable = false;
+	if (so->query_terms)
+	{
+		pfree(so->query_terms);
+		so->query_terms = NULL;
+	}
+
+	/* Rejoin the shared top-k group on the next batch */
+	so->topk_share	   = NULL;
+	so->topk_share_off = false;
 }
 
 /*
@@ -317,10 +467,6 @@ tp_endscan(IndexScanDesc scan)
 		if (so->scan_context)
 			MemoryContextDelete(so->scan_context);
 
-		/* Free query vector if it was allocated */
-		if (so->query_vector)
-			pfree(so->query_vector);
-
 		pfree(so);
 		scan->opaque = NULL;
 	}
@@ -341,11 +487,9 @@ tp_endscan(IndexScanDesc scan)
 static bool
 tp_execute_scoring_query(IndexScanDesc scan)
 {
-	TpScanOpaque	   so = (TpScanOpaque)scan->opaque;
-	TpIndexMetaPage	   metap;
+	TpScanOpaque	   so		   = (TpScanOpaque)scan->opaque;
 	bool			   success	   = false;
 	TpLocalIndexState *index_state = NULL;
-	TpVector		  *query_vector;
 
 	if (!so || !so->query_text)
 		return false;
@@ -387,68 +531,166 @@ tp_execute_scoring_query(IndexScanDesc scan)
 	}
 
 	/*
-	 * Acquire shared lock BEFORE reading metapage.
-	 * This ensures the metapage and memtable are read in a
-	 * consistent state — spill (which rewrites both) requires
-	 * LW_EXCLUSIVE, which is blocked while we hold shared.
+	 * No per-index lock here: tp_memtable_search captures an index
+	 * snapshot under a brief SHARED hold and scores against it, so
+	 * tokenization and scoring never block spill or merge.
 	 */
-	tp_acquire_index_lock(index_state, LW_SHARED);
 
-	/* Now read metapage under the lock */
-	metap = tp_get_metapage(scan->indexRelation);
-	if (!metap)
+	/*
+	 * Tokenize the query text once per scan; limit-doubling re-executions
+	 * reuse the terms.  Repeated query texts come from the backend's
+	 * query term cache.
+	 */
+	if (!so->query_terms)
 	{
-		tp_release_index_lock(index_state);
-		ereport(ERROR,
-				(errcode(ERRCODE_INTERNAL_ERROR),
-				 errmsg("failed to get metapage for index %s",
-						RelationGetRelationName(scan->indexRelation))));
+		MemoryContext oldcontext = MemoryContextSwitchTo(so->scan_context);
+
+		if (!OidIsValid(so->text_config_oid))
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("index \"%s\" has no text search configuration",
+							RelationGetRelationName(scan->indexRelation))));
+
+		so->query_terms =
+				tp_query_terms_get(so->text_config_oid, so->query_text);
+		MemoryContextSwitchTo(oldcontext);
 	}
 
-	/* Use the original query vector or create one from text */
-	query_vector = so->query_vector;
+	/* Find documents matching the query using posting lists */
+	success = tp_memtable_search(scan, index_state, so->query_terms);
+
+	return success;
+}
+
+/*
+ * Collect the CTIDs matching every WHERE match qual, sorted, into an
+ * array allocated in `result_cxt`; returns its length (0 leaves
+ * *ctids_out NULL).  Working memory lives in a temporary context.
+ */
+static int
+tp_collect_matches(
+		IndexScanDesc scan, MemoryContext result_cxt, ItemPointer *ctids_out)
+{
+	TpScanOpaque	   so = (TpScanOpaque)scan->opaque;
+	TpLocalIndexState *index_state;
+	TpIndexSnapshot	  *snapshot;
+	TpMatchFilter	  *filter;
+	MemoryContext	   match_cxt;
+	MemoryContext	   oldcontext;
+	char			 **all_terms;
+	int				   all_term_count;
+	ItemPointer		   ctids;
+	int				   count;
+
+	*ctids_out = NULL;
+	if (so->match_quals == NULL || so->match_none)
+		return 0;
+
+	index_state = tp_get_local_index_state(
+			RelationGetRelid(scan->indexRelation));
+	if (!index_state)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not get index state for BM25 "
+						"search")));
 
-	if (!query_vector && so->query_text)
+	match_cxt = AllocSetContextCreate(
+			CurrentMemoryContext, "Tapir match scan", ALLOCSET_DEFAULT_SIZES);
+	oldcontext = MemoryContextSwitchTo(match_cxt);
+
+	all_term_count = tp_match_quals_terms(so->match_quals, &all_terms);
+	snapshot	   = tp_index_snapshot_capture(
+			  index_state,
+			  scan->indexRelation,
+			  (const char *const *)all_terms,
+			  all_term_count);
+	filter = tp_match_filter_build(
+			scan->indexRelation, snapshot, so->match_quals);
+	count = tp_match_filter_ctids(filter, &ctids);
+	tp_index_snapshot_release(snapshot);
+
+	if (count > 0)
 	{
-		/*
-		 * We have a text query - convert it to a vector using the index.
-		 */
-		char *index_name = tp_get_qualified_index_name(scan->indexRelation);
+		*ctids_out = MemoryContextAlloc(
+				result_cxt, count * sizeof(ItemPointerData));
+		memcpy(*ctids_out, ctids, count * sizeof(ItemPointerData));
+	}
 
-		text *index_name_text  = cstring_to_text(index_name);
-		text *query_text_datum = cstring_to_text(so->query_text);
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextDelete(match_cxt);
 
-		Datum query_vec_datum = DirectFunctionCall2(
-				to_tpvector,
-				PointerGetDatum(query_text_datum),
-				PointerGetDatum(index_name_text));
+	return count;
+}
 
-		query_vector = (TpVector *)DatumGetPointer(query_vec_datum);
+/*
+ * Get next tuple of a scan with match quals but no ORDER BY: the
+ * matching documents in CTID order, unscored.
+ */
+static bool
+tp_gettuple_matches(IndexScanDesc scan)
+{
+	TpScanOpaque so = (TpScanOpaque)scan->opaque;
 
-		/* Free existing query vector if present */
-		if (so->query_vector)
-			pfree(so->query_vector);
+	if (so->result_ctids == NULL && !so->eof_reached)
+	{
+		/* Count index scan for pg_stat_user_indexes */
+		pgstat_count_index_scan(scan->indexRelation);
+#if PG_VERSION_NUM >= 180000
+		if (scan->instrument)
+			scan->instrument->nsearches++;
+#endif
 
-		/* Store the converted vector for this query execution */
-		so->query_vector = query_vector;
+		so->result_count = tp_collect_matches(
+				scan, so->scan_context, &so->result_ctids);
+		so->current_pos	 = 0;
+		if (so->result_count == 0)
+			so->eof_reached = true;
 	}
 
-	if (!query_vector)
-	{
-		pfree(metap);
+	if (so->eof_reached || so->current_pos >= so->result_count)
+		return false;
+
+	scan->xs_heaptid		= so->result_ctids[so->current_pos++];
+	scan->xs_recheck		= false;
+	scan->xs_recheckorderby = false;
+	return true;
+}
+
+/*
+ * Add the documents matching the scan's match quals to a bitmap
+ *
+ * The result is exact: match quals are evaluated against the same
+ * terms the index stores, so nothing needs rechecking.  Returns the
+ * number of CTIDs added.
+ */
+int64
+tp_getbitmap(IndexScanDesc scan, TIDBitmap *tbm)
+{
+	TpScanOpaque so = (TpScanOpaque)scan->opaque;
+	ItemPointer	 ctids;
+	int			 count;
+
+	if (so->nmatch == 0)
 		ereport(ERROR,
-				(errcode(ERRCODE_INTERNAL_ERROR),
-				 errmsg("no query vector available in scan state")));
-	}
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("bm25 bitmap scans require a @@@ or @@& "
+						"condition")));
 
-	/* Find documents matching the query using posting lists */
-	success = tp_memtable_search(scan, index_state, query_vector, metap);
+	/* Count index scan for pg_stat_user_indexes */
+	pgstat_count_index_scan(scan->indexRelation);
+#if PG_VERSION_NUM >= 180000
+	if (scan->instrument)
+		scan->instrument->nsearches++;
+#endif
 
-	/* Release the lock - we've extracted all CTIDs we need */
-	tp_release_index_lock(index_state);
+	count = tp_collect_matches(scan, CurrentMemoryContext, &ctids);
+	if (count > 0)
+	{
+		tbm_add_tuples(tbm, ctids, count, false);
+		pfree(ctids);
+	}
 
-	pfree(metap);
-	return success;
+	return count;
 }
 
 /*
@@ -465,7 +707,25 @@ tp_gettuple(IndexScanDesc scan, ScanDirection dir)
 
 	Assert(scan != NULL);
 	Assert(so != NULL);
-	Assert(so->query_text != NULL);
+
+	/* Match quals alone: return the matches, unranked */
+	if (so->query_text == NULL)
+		return tp_gettuple_matches(scan);
+
+	/* A NULL match qual argument: nothing can match */
+	if (so->match_none)
+		return false;
+
+	/* A batch kept by rescan counts as a scan of its own */
+	if (so->batch_reused)
+	{
+		so->batch_reused = false;
+		pgstat_count_index_scan(scan->indexRelation);
+#if PG_VERSION_NUM >= 180000
+		if (scan->instrument)
+			scan->instrument->nsearches++;
+#endif
+	}
 
 	/* Execute scoring query if we haven't done so yet */
 	if (so->result_ctids == NULL && !so->eof_reached)
@@ -477,7 +737,8 @@ tp_gettuple(IndexScanDesc scan, ScanDirection dir)
 			scan->instrument->nsearches++;
 #endif
 
-		if (!tp_execute_scoring_query(scan))
+		/* An empty batch pruned by the shared threshold is retried below */
+		if (!tp_execute_scoring_query(scan) && !so->topk_floor_short)
 		{
 			so->eof_reached = true;
 			return false;
@@ -490,11 +751,49 @@ tp_gettuple(IndexScanDesc scan, ScanDirection dir)
 		}
 	}
 
+
 	/* Advance, growing the scoring batch if needed. */
 	for (;;)
 	{
 		if (so->current_pos >= so->result_count || so->eof_reached)
 		{
+			/*
+			 * A batch pruned by the partitions' shared top-k threshold
+			 * stops short of documents scoring below it.  Its results
+			 * are still the best of the index, so the caller asking
+			 * for more means it needs those: re-score without the
+			 * threshold, just deep enough for the next row.
+			 *
+			 * The merge of the partitions asks each of them for its
+			 * first row at startup, before it knows whether it needs
+			 * any.  A batch pruned to nothing therefore scores only
+			 * its best row and stays pruned; the batch it was cut
+			 * from is re-scored only if the merge pulls past that row.
+			 */
+			if (!so->eof_reached && so->topk_floor_short)
+			{
+				int	 old_count = so->result_count;
+				bool best_only = old_count == 0;
+
+				if (best_only)
+				{
+					so->topk_limit = so->max_results_used;
+					so->limit	   = 1;
+				}
+				else
+					so->limit = Max(so->topk_limit, old_count + 1);
+				so->topk_share_off = true;
+				if (tp_execute_scoring_query(scan) &&
+					so->result_count > old_count)
+				{
+					so->topk_floor_short = best_only;
+					so->current_pos		 = 0;
+					continue;
+				}
+				so->eof_reached = true;
+				return false;
+			}
+
 			/*
 			 * If result_count hit the internal limit, there may be
 			 * more documents.  Double the limit and re-execute the
@@ -521,6 +820,12 @@ tp_gettuple(IndexScanDesc scan, ScanDirection dir)
 					so->current_pos = 0;
 					continue;
 				}
+				else if (so->topk_floor_short)
+				{
+					/* Retry without the shared threshold, above */
+					so->current_pos = so->result_count;
+					continue;
+				}
 				else
 				{
 					so->eof_reached = true;
@@ -32,8 +32,10 @@
 
 #include "access/am.h"
 #include "access/build_context.h"
+#include "access/vacuum_parallel.h"
 #include "index/freepage.h"
 #include "index/metapage.h"
+#include "index/result_cache.h"
 #include "index/state.h"
 #include "memtable/page.h"
 #include "segment/alive_bitset.h"
@@ -42,24 +44,6 @@
 #include "segment/segment.h"
 #include "segment/tombstone.h"
 
-/*
- * Per-segment state for VACUUM dead tuple tracking.
- * Tracks which segments contain dead CTIDs without storing the
- * CTIDs themselves.
- */
-typedef struct TpVacuumSegmentInfo
-{
-	BlockNumber root_block;
-	BlockNumber next_segment;
-	uint32		level;
-	uint32		num_docs;	  /* segment header num_docs */
-	uint64		total_tokens; /* segment header total_tokens */
-	uint32	   *dead_doc_ids; /* Array of dead doc_ids */
-	uint32		dead_count;
-	bool		affected;
-	bool		is_v5; /* true if segment has alive bitset */
-} TpVacuumSegmentInfo;
-
 /*
  * Convert a 32-bit xid (known to be in the allowable range when
  * nextFullXid was current) into a FullTransactionId.
@@ -320,23 +304,16 @@ tp_spill_memtable_if_needed(
 }
 
 /*
- * Walk all segment docmaps and call the callback for each CTID.
- * Returns an array of TpVacuumSegmentInfo with affected flags set.
- * *num_segments_out receives the total segment count.
+ * List every segment in the level chains, reading headers only.
+ * The dead-doc fields are left zeroed for the identify pass.
  */
 static TpVacuumSegmentInfo *
-tp_vacuum_identify_affected(
-		Relation				index,
-		TpIndexMetaPage			metap,
-		IndexBulkDeleteCallback callback,
-		void				   *callback_state,
-		int					   *num_segments_out,
-		int64				   *total_dead_out)
+tp_vacuum_list_segments(
+		Relation index, TpIndexMetaPage metap, int *num_segments_out)
 {
 	TpVacuumSegmentInfo *segments;
-	int					 capacity	= 32;
-	int					 count		= 0;
-	int64				 total_dead = 0;
+	int					 capacity = 32;
+	int					 count	  = 0;
 
 	segments = palloc(capacity * sizeof(TpVacuumSegmentInfo));
 
@@ -347,9 +324,8 @@ tp_vacuum_identify_affected(
 		while (seg != InvalidBlockNumber)
 		{
 			TpSegmentReader *reader;
-			uint32			 seg_dead = 0;
 
-			reader = tp_segment_open_ex(index, seg, true);
+			reader = tp_segment_open_ex(index, seg, false);
 			if (!reader || !reader->header)
 			{
 				if (reader)
@@ -357,66 +333,21 @@ tp_vacuum_identify_affected(
 				break;
 			}
 
-			/* Check each CTID against the callback */
+			if (count >= capacity)
 			{
-				uint32 *dead_ids   = NULL;
-				uint32	dead_cap   = 0;
-				bool	has_bitset = (reader->header->alive_bitset_offset > 0);
-
-				for (uint32 i = 0; i < reader->header->num_docs; i++)
-				{
-					ItemPointerData ctid;
-
-					/*
-					 * Skip docs already marked dead in the alive
-					 * bitset.  Without this, CTID reuse after a
-					 * previous VACUUM would double-count dead docs
-					 * and corrupt total_docs in the metapage.
-					 */
-					if (has_bitset && !tp_segment_is_alive(reader, i))
-						continue;
-
-					tp_segment_lookup_ctid(reader, i, &ctid);
-					if (ItemPointerIsValid(&ctid) &&
-						callback(&ctid, callback_state))
-					{
-						if (seg_dead >= dead_cap)
-						{
-							dead_cap = (dead_cap == 0) ? 64 : dead_cap * 2;
-							dead_ids = dead_ids
-											 ? repalloc(
-													   dead_ids,
-													   dead_cap *
-															   sizeof(uint32))
-											 : palloc(dead_cap *
-													  sizeof(uint32));
-						}
-						dead_ids[seg_dead] = i;
-						seg_dead++;
-					}
-				}
-
-				/* Record segment info */
-				if (count >= capacity)
-				{
-					capacity *= 2;
-					segments = repalloc(
-							segments, capacity * sizeof(TpVacuumSegmentInfo));
-				}
-
-				segments[count].root_block	 = seg;
-				segments[count].next_segment = reader->header->next_segment;
-				segments[count].level		 = level;
-				segments[count].num_docs	 = reader->header->num_docs;
-				segments[count].total_tokens = reader->header->total_tokens;
-				segments[count].dead_doc_ids = dead_ids;
-				segments[count].dead_count	 = seg_dead;
-				segments[count].affected	 = (seg_dead > 0);
-				segments[count].is_v5 =
-						(reader->header->alive_bitset_offset > 0);
+				capacity *= 2;
+				segments = repalloc(
+						segments, capacity * sizeof(TpVacuumSegmentInfo));
 			}
 
-			total_dead += seg_dead;
+			memset(&segments[count], 0, sizeof(TpVacuumSegmentInfo));
+			segments[count].root_block	 = seg;
+			segments[count].next_segment = reader->header->next_segment;
+			segments[count].level		 = level;
+			segments[count].num_docs	 = reader->header->num_docs;
+			segments[count].total_tokens = reader->header->total_tokens;
+			segments[count].is_v5 =
+					(reader->header->alive_bitset_offset > 0);
 			count++;
 
 			seg = reader->header->next_segment;
@@ -424,6 +355,107 @@ tp_vacuum_identify_affected(
 		}
 	}
 
+	*num_segments_out = count;
+	return segments;
+}
+
+/*
+ * Call the callback for each live CTID of one segment and record
+ * the dead doc IDs in `info`.
+ */
+static void
+tp_vacuum_probe_segment(
+		Relation				index,
+		TpVacuumSegmentInfo	   *info,
+		IndexBulkDeleteCallback callback,
+		void				   *callback_state)
+{
+	TpSegmentReader *reader;
+	uint32			*dead_ids	= NULL;
+	uint32			 dead_cap	= 0;
+	uint32			 seg_dead	= 0;
+	bool			 has_bitset;
+
+	reader = tp_segment_open_ex(index, info->root_block, true);
+	if (!reader || !reader->header)
+	{
+		if (reader)
+			tp_segment_close(reader);
+		return;
+	}
+
+	has_bitset = (reader->header->alive_bitset_offset > 0);
+
+	for (uint32 i = 0; i < reader->header->num_docs; i++)
+	{
+		ItemPointerData ctid;
+
+		/*
+		 * Skip docs already marked dead in the alive bitset.
+		 * Without this, CTID reuse after a previous VACUUM would
+		 * double-count dead docs and corrupt total_docs in the
+		 * metapage.
+		 */
+		if (has_bitset && !tp_segment_is_alive(reader, i))
+			continue;
+
+		tp_segment_lookup_ctid(reader, i, &ctid);
+		if (ItemPointerIsValid(&ctid) && callback(&ctid, callback_state))
+		{
+			if (seg_dead >= dead_cap)
+			{
+				dead_cap = (dead_cap == 0) ? 64 : dead_cap * 2;
+				dead_ids = dead_ids ? repalloc(dead_ids,
+											   dead_cap * sizeof(uint32))
+									: palloc(dead_cap * sizeof(uint32));
+			}
+			dead_ids[seg_dead] = i;
+			seg_dead++;
+		}
+	}
+
+	info->dead_doc_ids = dead_ids;
+	info->dead_count   = seg_dead;
+	info->affected	   = (seg_dead > 0);
+
+	tp_segment_close(reader);
+}
+
+/*
+ * Walk all segment docmaps and call the callback for each CTID.
+ * Returns an array of TpVacuumSegmentInfo with affected flags set.
+ * *num_segments_out receives the total segment count.
+ *
+ * Indexes with enough segments spread the docmap reads and the
+ * alive-bitset marking over parallel workers (vacuum_parallel.c);
+ * segments it marks come back with `marked` set.
+ */
+static TpVacuumSegmentInfo *
+tp_vacuum_identify_affected(
+		Relation				index,
+		TpIndexMetaPage			metap,
+		IndexBulkDeleteCallback callback,
+		void				   *callback_state,
+		int					   *num_segments_out,
+		int64				   *total_dead_out)
+{
+	TpVacuumSegmentInfo *segments;
+	int					 count;
+	int64				 total_dead = 0;
+
+	segments = tp_vacuum_list_segments(index, metap, &count);
+
+	if (!tp_parallel_vacuum_identify(
+				index, segments, count, callback, callback_state))
+	{
+		for (int i = 0; i < count; i++)
+			tp_vacuum_probe_segment(
+					index, &segments[i], callback, callback_state);
+	}
+
+	for (int i = 0; i < count; i++)
+		total_dead += segments[i].dead_count;
+
 	*num_segments_out = count;
 	*total_dead_out	  = total_dead;
 	return segments;
@@ -598,7 +630,10 @@ tp_vacuum_rebuild_segment(
 
 	/* Write new segment if any docs survived */
 	if (build_ctx->num_docs > 0)
+	{
 		new_root = tp_write_segment_from_build_ctx(build_ctx, index);
+		tp_merge_account_write(index, new_root, true);
+	}
 	else
 		new_root = InvalidBlockNumber;
 
@@ -775,7 +810,7 @@ tp_vacuum_replace_segment(
  * GenericXLog.  Returns the new alive_count, or 0 if all
  * docs are dead (caller should drop the segment).
  */
-static uint32
+uint32
 tp_vacuum_mark_dead(
 		Relation	index,
 		BlockNumber root_block,
@@ -973,11 +1008,16 @@ tp_bulkdelete(
 						 * V5 segment: flip bits in alive
 						 * bitset.
 						 */
-						uint32 alive = tp_vacuum_mark_dead(
-								info->index,
-								segments[i].root_block,
-								segments[i].dead_doc_ids,
-								segments[i].dead_count);
+						uint32 alive;
+
+						if (segments[i].marked)
+							alive = segments[i].alive_after;
+						else
+							alive = tp_vacuum_mark_dead(
+									info->index,
+									segments[i].root_block,
+									segments[i].dead_doc_ids,
+									segments[i].dead_count);
 
 						if (alive == 0)
 						{
@@ -1059,6 +1099,13 @@ tp_bulkdelete(
 				info->index, docs_shrinkage, tokens_shrinkage);
 	}
 
+	/*
+	 * The heap reuses the removed documents' CTIDs once we return, so
+	 * no cached result computed before this point may be served again,
+	 * however stale the reader allows it to be.
+	 */
+	tp_result_cache_invalidate_rel(info->index, true);
+
 	/* Identify + mark complete; drop the shared lock. */
 	if (index_state != NULL)
 		tp_release_index_lock(index_state);
@@ -1111,6 +1158,31 @@ tp_vacuumcleanup(IndexVacuumInfo *info, IndexBulkDeleteResult *stats)
 		tp_spill_memtable_if_needed(
 				info->index, index_state, TP_MIN_SPILL_PAGES);
 
+	/*
+	 * Merge away segments whose dead-doc share (1 - alive_count /
+	 * num_docs, as left by bulk-delete) has reached merge_deletes_pct.
+	 * Their dead postings would otherwise be read and skipped by every
+	 * query until a regular merge happened to pick them up.  The
+	 * policy batches each with the segments ahead of it on its level
+	 * instead of rewriting it alone.  Not for ANALYZE's cleanup call.
+	 */
+	if (index_state != NULL && !info->analyze_only &&
+		!RecoveryInProgress())
+	{
+		uint32 merges;
+
+		tp_acquire_index_lock(index_state, LW_EXCLUSIVE);
+		merges = tp_compact_deleted_segments(info->index);
+		tp_release_index_lock(index_state);
+
+		if (merges > 0)
+			elog(DEBUG1,
+				 "Tapir vacuum cleanup: %u merges of deleted segments "
+				 "in index %s",
+				 merges,
+				 RelationGetRelationName(info->index));
+	}
+
 	/*
 	 * Acquire the per-index LWLock in shared mode *before* reading the
 	 * metapage so the level_heads snapshot we walk in tp_count_live_docs
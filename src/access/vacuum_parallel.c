@@ -0,0 +1,595 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * vacuum_parallel.c - Parallel per-segment bulk-delete for VACUUM
+ *
+ * Bulk-delete does three things per segment: read the docmap's CTIDs
+ * for every live doc, ask the heap callback which are dead, and clear
+ * those docs in the segment's alive bitset.  Reading and marking are
+ * page I/O on independent segments, so workers (and the leader) claim
+ * them from two shared queues:
+ *
+ *   load  Segment i's live (doc_id, CTID) pairs are written to temp
+ *         file "tp_vac_ctids_<i>" in a SharedFileSet.
+ *   mark  The dead doc IDs of segment i, read from "tp_vac_dead_<i>",
+ *         are cleared in its alive bitset.
+ *
+ * The callback's state lives in the leader (a backend-local TidStore
+ * for VACUUM, a tuplesort for CREATE INDEX CONCURRENTLY), so only the
+ * leader probes: it takes segments in chain order as their loads
+ * finish, calls the callback for each CTID, and queues a mark job
+ * for V5 segments with dead docs.  Pre-V5 segments are rebuilt by
+ * the caller afterwards, as in the serial pass.  Chain edits for
+ * fully dead segments and the metapage updates stay with the leader.
+ *
+ * The leader holds the per-index LWLock, which holds off interrupts,
+ * so like the parallel merge it pumps worker messages itself.
+ */
+#include <postgres.h>
+
+#include <access/genam.h>
+#include <access/parallel.h>
+#include <access/xact.h>
+#include <miscadmin.h>
+#include <port/atomics.h>
+#include <postmaster/bgworker.h>
+#include <storage/buffile.h>
+#include <storage/condition_variable.h>
+#include <storage/latch.h>
+#include <storage/sharedfileset.h>
+#include <storage/shm_mq.h>
+#include <utils/rel.h>
+#include <utils/snapmgr.h>
+#include <utils/wait_event.h>
+
+#include "access/build_parallel.h"
+#include "access/vacuum_parallel.h"
+#include "constants.h"
+#include "segment/alive_bitset.h"
+#include "segment/io.h"
+#include "segment/merge.h"
+#include "segment/segment.h"
+
+/*
+ * Shared memory keys for parallel vacuum TOC
+ */
+#define TP_VACUUM_KEY_SHARED UINT64CONST(0xB175DA7A00000201)
+
+/* CTIDs read back per BufFileRead when probing */
+#define TP_VACUUM_PROBE_BATCH 512
+
+/*
+ * One live doc of a loaded segment, as written to its CTID file.
+ */
+typedef struct TpVacuumCtid
+{
+	uint32			doc_id;
+	ItemPointerData ctid;
+} TpVacuumCtid;
+
+/*
+ * Per-segment slot.  Each field is written by one participant before
+ * it publishes the step through an atomic.
+ */
+typedef struct TpParallelVacuumSegment
+{
+	BlockNumber		 root;		  /* Segment header block */
+	pg_atomic_uint32 loaded;	  /* 1 once the CTID file is complete */
+	uint32			 live_count;  /* Records in the CTID file (loader) */
+	uint32			 dead_count;  /* Doc IDs in the dead file (leader) */
+	uint32			 alive_after; /* alive_count after marking (marker) */
+} TpParallelVacuumSegment;
+
+/*
+ * Shared state for parallel bulk-delete
+ *
+ * Stored in DSM segment, accessible to all workers and leader.
+ */
+typedef struct TpParallelVacuumShared
+{
+	/* Immutable configuration (set before workers launch) */
+	Oid	   indexrelid;	 /* Index relation OID */
+	uint32 num_segments; /* Segments to load */
+
+	/* Temp files for CTIDs and dead doc IDs */
+	SharedFileSet fileset;
+
+	/* Coordination */
+	pg_atomic_uint32  next_load;	/* Next segment to load */
+	pg_atomic_uint32  marks_queued; /* Entries in the mark queue */
+	pg_atomic_uint32  next_mark;	/* Next mark queue entry to claim */
+	pg_atomic_uint32  marks_done;	/* Mark jobs finished */
+	pg_atomic_uint32  probing_done; /* 1 once no more marks will come */
+	ConditionVariable progress_cv;	/* Signaled on every step */
+
+	/*
+	 * Per-segment array, then the mark queue (segment indexes in the
+	 * order the leader queued them); both num_segments long.
+	 */
+} TpParallelVacuumShared;
+
+static inline TpParallelVacuumSegment *
+TpParallelVacuumSegments(TpParallelVacuumShared *shared)
+{
+	return (TpParallelVacuumSegment
+					*)((char *)shared +
+					   MAXALIGN(sizeof(TpParallelVacuumShared)));
+}
+
+static inline uint32 *
+TpParallelVacuumMarkQueue(TpParallelVacuumShared *shared)
+{
+	return (uint32 *)((char *)TpParallelVacuumSegments(shared) +
+					  MAXALIGN(shared->num_segments *
+							   sizeof(TpParallelVacuumSegment)));
+}
+
+static Size
+parallel_vacuum_shared_size(uint32 num_segments)
+{
+	return add_size(
+			add_size(
+					MAXALIGN(sizeof(TpParallelVacuumShared)),
+					MAXALIGN(mul_size(
+							num_segments, sizeof(TpParallelVacuumSegment)))),
+			mul_size(num_segments, sizeof(uint32)));
+}
+
+static void
+ctid_file_name(char *name, Size len, uint32 seg)
+{
+	snprintf(name, len, "tp_vac_ctids_%u", seg);
+}
+
+static void
+dead_file_name(char *name, Size len, uint32 seg)
+{
+	snprintf(name, len, "tp_vac_dead_%u", seg);
+}
+
+/*
+ * Claim the next entry of a queue whose published length is `limit`.
+ * Unlike a plain fetch-add this never moves `next` past `limit`, so
+ * entries published later are not skipped.
+ */
+static bool
+parallel_vacuum_claim(pg_atomic_uint32 *next, uint32 limit, uint32 *claimed)
+{
+	uint32 cur = pg_atomic_read_u32(next);
+
+	while (cur < limit)
+	{
+		if (pg_atomic_compare_exchange_u32(next, &cur, cur + 1))
+		{
+			*claimed = cur;
+			return true;
+		}
+	}
+	return false;
+}
+
+/* ----------------------------------------------------------------
+ * Jobs (leader and workers)
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Write segment `seg`'s live (doc_id, CTID) pairs to its CTID file.
+ * Docs already dead in the alive bitset are skipped, as in the
+ * serial pass, so a reused CTID is not counted twice.
+ */
+static void
+parallel_vacuum_load(
+		TpParallelVacuumShared *shared, Relation index, uint32 seg)
+{
+	TpParallelVacuumSegment *slot = &TpParallelVacuumSegments(shared)[seg];
+	TpSegmentReader			*reader;
+	BufFile					*file;
+	char					 file_name[64];
+	uint32					 live = 0;
+
+	ctid_file_name(file_name, sizeof(file_name), seg);
+	file = BufFileCreateFileSet(&shared->fileset.fs, file_name);
+
+	reader = tp_segment_open_ex(index, slot->root, true);
+	if (reader != NULL && reader->header != NULL)
+	{
+		bool has_bitset = (reader->header->alive_bitset_offset > 0);
+
+		for (uint32 i = 0; i < reader->header->num_docs; i++)
+		{
+			TpVacuumCtid rec;
+
+			if (has_bitset && !tp_segment_is_alive(reader, i))
+				continue;
+
+			tp_segment_lookup_ctid(reader, i, &rec.ctid);
+			if (!ItemPointerIsValid(&rec.ctid))
+				continue;
+
+			rec.doc_id = i;
+			BufFileWrite(file, &rec, sizeof(rec));
+			live++;
+		}
+	}
+	if (reader != NULL)
+		tp_segment_close(reader);
+
+	BufFileExportFileSet(file);
+	BufFileClose(file);
+
+	slot->live_count = live;
+	pg_write_barrier();
+	pg_atomic_write_u32(&slot->loaded, 1);
+	ConditionVariableBroadcast(&shared->progress_cv);
+}
+
+/*
+ * Clear segment `seg`'s dead docs in its alive bitset.
+ */
+static void
+parallel_vacuum_mark(
+		TpParallelVacuumShared *shared, Relation index, uint32 seg)
+{
+	TpParallelVacuumSegment *slot = &TpParallelVacuumSegments(shared)[seg];
+	BufFile					*file;
+	char					 file_name[64];
+	uint32					*dead_ids;
+
+	dead_file_name(file_name, sizeof(file_name), seg);
+	file = BufFileOpenFileSet(
+			&shared->fileset.fs, file_name, O_RDONLY, false);
+
+	dead_ids = palloc(slot->dead_count * sizeof(uint32));
+	BufFileReadExact(file, dead_ids, slot->dead_count * sizeof(uint32));
+	BufFileClose(file);
+
+	slot->alive_after = tp_vacuum_mark_dead(
+			index, slot->root, dead_ids, slot->dead_count);
+	pfree(dead_ids);
+
+	pg_atomic_fetch_add_u32(&shared->marks_done, 1);
+	ConditionVariableBroadcast(&shared->progress_cv);
+}
+
+/*
+ * Run one queued job, loads first.  Returns false if neither queue
+ * has anything to claim right now.
+ */
+static bool
+parallel_vacuum_run_one(TpParallelVacuumShared *shared, Relation index)
+{
+	uint32 job;
+
+	if (parallel_vacuum_claim(
+				&shared->next_load, shared->num_segments, &job))
+	{
+		parallel_vacuum_load(shared, index, job);
+		return true;
+	}
+
+	if (parallel_vacuum_claim(
+				&shared->next_mark,
+				pg_atomic_read_u32(&shared->marks_queued),
+				&job))
+	{
+		pg_read_barrier();
+		parallel_vacuum_mark(
+				shared, index, TpParallelVacuumMarkQueue(shared)[job]);
+		return true;
+	}
+
+	return false;
+}
+
+/* ----------------------------------------------------------------
+ * Worker entry point
+ * ----------------------------------------------------------------
+ */
+PGDLLEXPORT void
+tp_parallel_vacuum_worker_main(dsm_segment *seg, shm_toc *toc)
+{
+	TpParallelVacuumShared *shared;
+	Relation				index;
+
+	shared = (TpParallelVacuumShared *)
+			shm_toc_lookup(toc, TP_VACUUM_KEY_SHARED, false);
+
+	/* Lock is shared with the leader's lock group */
+	index = index_open(shared->indexrelid, RowExclusiveLock);
+
+	/* Attach to SharedFileSet for CTID and dead-ID files */
+	SharedFileSetAttach(&shared->fileset, seg);
+
+	for (;;)
+	{
+		if (parallel_vacuum_run_one(shared, index))
+			continue;
+
+		/* Nothing to claim: done once the leader queues no more marks */
+		if (pg_atomic_read_u32(&shared->probing_done) != 0 &&
+			pg_atomic_read_u32(&shared->next_mark) >=
+					pg_atomic_read_u32(&shared->marks_queued))
+			break;
+
+		ConditionVariableTimedSleep(
+				&shared->progress_cv, 100 /* ms */, PG_WAIT_EXTENSION);
+	}
+	ConditionVariableCancelSleep();
+
+	index_close(index, RowExclusiveLock);
+}
+
+/* ----------------------------------------------------------------
+ * Leader
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Wait for progress on the shared state, relaying worker messages
+ * (and rethrowing worker errors) while interrupts are held off.
+ */
+static void
+parallel_vacuum_leader_sleep(TpParallelVacuumShared *shared)
+{
+	HandleParallelMessages();
+	ConditionVariableTimedSleep(
+			&shared->progress_cv, 100 /* ms */, PG_WAIT_EXTENSION);
+}
+
+/*
+ * Call the bulk-delete callback for each CTID in segment `seg`'s CTID
+ * file and record the dead doc IDs in `info`.  A V5 segment with dead
+ * docs gets its IDs written out and a mark job queued.
+ */
+static void
+parallel_vacuum_probe(
+		TpParallelVacuumShared *shared,
+		uint32					seg,
+		TpVacuumSegmentInfo	   *info,
+		IndexBulkDeleteCallback callback,
+		void				   *callback_state)
+{
+	TpParallelVacuumSegment *slot = &TpParallelVacuumSegments(shared)[seg];
+	TpVacuumCtid			 batch[TP_VACUUM_PROBE_BATCH];
+	BufFile					*file;
+	char					 file_name[64];
+	uint32					 remaining = slot->live_count;
+	uint32					*dead_ids  = NULL;
+	uint32					 dead_cap  = 0;
+	uint32					 dead	   = 0;
+
+	ctid_file_name(file_name, sizeof(file_name), seg);
+	file = BufFileOpenFileSet(
+			&shared->fileset.fs, file_name, O_RDONLY, false);
+
+	while (remaining > 0)
+	{
+		uint32 n = Min(remaining, TP_VACUUM_PROBE_BATCH);
+
+		BufFileReadExact(file, batch, n * sizeof(TpVacuumCtid));
+		for (uint32 k = 0; k < n; k++)
+		{
+			if (!callback(&batch[k].ctid, callback_state))
+				continue;
+
+			if (dead >= dead_cap)
+			{
+				dead_cap = (dead_cap == 0) ? 64 : dead_cap * 2;
+				dead_ids = dead_ids ? repalloc(dead_ids,
+											   dead_cap * sizeof(uint32))
+									: palloc(dead_cap * sizeof(uint32));
+			}
+			dead_ids[dead++] = batch[k].doc_id;
+		}
+		remaining -= n;
+	}
+	BufFileClose(file);
+
+	info->dead_doc_ids = dead_ids;
+	info->dead_count   = dead;
+	info->affected	   = (dead > 0);
+
+	if (dead > 0 && info->is_v5)
+	{
+		uint32 *queue = TpParallelVacuumMarkQueue(shared);
+		uint32	pos	  = pg_atomic_read_u32(&shared->marks_queued);
+
+		dead_file_name(file_name, sizeof(file_name), seg);
+		file = BufFileCreateFileSet(&shared->fileset.fs, file_name);
+		BufFileWrite(file, dead_ids, dead * sizeof(uint32));
+		BufFileExportFileSet(file);
+		BufFileClose(file);
+
+		slot->dead_count = dead;
+		queue[pos]		 = seg;
+		pg_write_barrier();
+		pg_atomic_fetch_add_u32(&shared->marks_queued, 1);
+		ConditionVariableBroadcast(&shared->progress_cv);
+	}
+}
+
+/*
+ * Wait until every launched worker has exited, relaying their
+ * messages as we go.  See parallel_merge_wait_for_workers.
+ */
+static void
+parallel_vacuum_wait_for_workers(ParallelContext *pcxt)
+{
+	for (;;)
+	{
+		bool all_exited = true;
+
+		HandleParallelMessages();
+
+		for (int i = 0; i < pcxt->nworkers_launched; i++)
+		{
+			pid_t pid;
+
+			if (pcxt->worker[i].error_mqh == NULL)
+				continue;
+
+			/* A worker that never started will send nothing */
+			if (shm_mq_get_sender(shm_mq_get_queue(
+						pcxt->worker[i].error_mqh)) == NULL &&
+				GetBackgroundWorkerPid(pcxt->worker[i].bgwhandle, &pid) ==
+						BGWH_STOPPED)
+				continue;
+
+			all_exited = false;
+		}
+
+		if (all_exited)
+			break;
+
+		(void)WaitLatch(
+				MyLatch,
+				WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+				100 /* ms */,
+				PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+	}
+}
+
+bool
+tp_parallel_vacuum_identify(
+		Relation				index,
+		TpVacuumSegmentInfo	   *segments,
+		int						num_segments,
+		IndexBulkDeleteCallback callback,
+		void				   *callback_state)
+{
+	ParallelContext			*pcxt;
+	TpParallelVacuumShared	*shared;
+	TpParallelVacuumSegment *slots;
+	Size					 shared_size;
+	uint64					 total_docs = 0;
+	int						 nworkers;
+
+	nworkers = Min(max_parallel_maintenance_workers, num_segments - 1);
+	nworkers = Min(nworkers, TP_MAX_PARALLEL_WORKERS);
+	if (nworkers <= 0 || num_segments < TP_PARALLEL_VACUUM_MIN_SEGMENTS)
+		return false;
+
+	for (int i = 0; i < num_segments; i++)
+		total_docs += segments[i].num_docs;
+	if (total_docs < TP_PARALLEL_VACUUM_MIN_DOCS)
+		return false;
+
+	/* Workers need a snapshot to restore and a shared buffer pool */
+	if (IsInParallelMode() || !ActiveSnapshotSet() ||
+		RelationUsesLocalBuffers(index))
+		return false;
+
+	/*
+	 * Autovacuum workers never launch parallel workers, as PostgreSQL's
+	 * own parallel vacuum does not; keep them on the serial pass.
+	 */
+	if (AmAutoVacuumWorkerProcess())
+		return false;
+
+	shared_size = parallel_vacuum_shared_size(num_segments);
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext(
+			"pg_textsearch", "tp_parallel_vacuum_worker_main", nworkers);
+
+	shm_toc_estimate_chunk(&pcxt->estimator, shared_size);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+
+	InitializeParallelDSM(pcxt);
+
+	/* No DSM segment (e.g. out of slots): workers cannot attach */
+	if (pcxt->nworkers == 0)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return false;
+	}
+
+	shared = (TpParallelVacuumShared *)
+			shm_toc_allocate(pcxt->toc, shared_size);
+	memset(shared, 0, sizeof(TpParallelVacuumShared));
+	shared->indexrelid	 = RelationGetRelid(index);
+	shared->num_segments = num_segments;
+	pg_atomic_init_u32(&shared->next_load, 0);
+	pg_atomic_init_u32(&shared->marks_queued, 0);
+	pg_atomic_init_u32(&shared->next_mark, 0);
+	pg_atomic_init_u32(&shared->marks_done, 0);
+	pg_atomic_init_u32(&shared->probing_done, 0);
+	ConditionVariableInit(&shared->progress_cv);
+	SharedFileSetInit(&shared->fileset, pcxt->seg);
+
+	slots = TpParallelVacuumSegments(shared);
+	for (int i = 0; i < num_segments; i++)
+	{
+		memset(&slots[i], 0, sizeof(TpParallelVacuumSegment));
+		slots[i].root = segments[i].root_block;
+		pg_atomic_init_u32(&slots[i].loaded, 0);
+	}
+
+	shm_toc_insert(pcxt->toc, TP_VACUUM_KEY_SHARED, shared);
+
+	LaunchParallelWorkers(pcxt);
+	if (pcxt->nworkers_launched == 0)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return false;
+	}
+
+	tp_merge_account_workers(index, pcxt->nworkers_launched);
+
+	elog(DEBUG1,
+		 "parallel bulk-delete: %d segments, %d of %d workers",
+		 num_segments,
+		 pcxt->nworkers_launched,
+		 nworkers);
+
+	/*
+	 * Probe segments in chain order as their loads complete, helping
+	 * with loads and marks while the next one is still pending.
+	 */
+	ConditionVariablePrepareToSleep(&shared->progress_cv);
+	for (int i = 0; i < num_segments; i++)
+	{
+		while (pg_atomic_read_u32(&slots[i].loaded) == 0)
+		{
+			if (!parallel_vacuum_run_one(shared, index))
+				parallel_vacuum_leader_sleep(shared);
+		}
+		pg_read_barrier();
+
+		parallel_vacuum_probe(
+				shared, i, &segments[i], callback, callback_state);
+	}
+
+	pg_atomic_write_u32(&shared->probing_done, 1);
+	ConditionVariableBroadcast(&shared->progress_cv);
+
+	/* Finish the remaining marks alongside the workers */
+	while (pg_atomic_read_u32(&shared->marks_done) <
+		   pg_atomic_read_u32(&shared->marks_queued))
+	{
+		if (!parallel_vacuum_run_one(shared, index))
+			parallel_vacuum_leader_sleep(shared);
+	}
+	ConditionVariableCancelSleep();
+	pg_read_barrier();
+
+	parallel_vacuum_wait_for_workers(pcxt);
+
+	for (int i = 0; i < num_segments; i++)
+	{
+		if (segments[i].affected && segments[i].is_v5)
+		{
+			segments[i].marked		= true;
+			segments[i].alive_after = slots[i].alive_after;
+		}
+	}
+
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+	return true;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * vacuum_parallel.h - Parallel per-segment bulk-delete for VACUUM
+ *
+ * PostgreSQL's parallel vacuum gives each index to one worker.  For a
+ * bm25 index with many segments, tp_bulkdelete can in addition spread
+ * its own segments over parallel workers; see vacuum_parallel.c.
+ */
+#pragma once
+
+#include <postgres.h>
+
+#include <access/genam.h>
+#include <access/parallel.h>
+#include <storage/block.h>
+#include <utils/relcache.h>
+
+/*
+ * Per-segment state for VACUUM dead tuple tracking.
+ * Tracks which segments contain dead CTIDs without storing the
+ * CTIDs themselves.
+ */
+typedef struct TpVacuumSegmentInfo
+{
+	BlockNumber root_block;
+	BlockNumber next_segment;
+	uint32		level;
+	uint32		num_docs;	  /* segment header num_docs */
+	uint64		total_tokens; /* segment header total_tokens */
+	uint32	   *dead_doc_ids; /* Array of dead doc_ids */
+	uint32		dead_count;
+	bool		affected;
+	bool		is_v5;		 /* true if segment has alive bitset */
+	bool		marked;		 /* alive bitset already updated */
+	uint32		alive_after; /* alive_count after marking, if marked */
+} TpVacuumSegmentInfo;
+
+/*
+ * Apply dead doc marks to a V5 segment's alive bitset (vacuum.c).
+ * Returns the new alive_count; 0 means the segment must be dropped.
+ */
+extern uint32 tp_vacuum_mark_dead(
+		Relation	index,
+		BlockNumber root_block,
+		uint32	   *dead_doc_ids,
+		uint32		dead_count);
+
+/*
+ * Fill in dead_doc_ids / dead_count / affected for every segment in
+ * segments[] using parallel workers, and mark the dead docs of V5
+ * segments in their alive bitsets (setting marked / alive_after).
+ * Only root_block, num_docs and is_v5 are read on input.
+ *
+ * The bulk-delete callback is only ever called in this process, once
+ * per live CTID and in segment order, as the serial pass calls it.
+ * Returns false, having done nothing, when the pass should stay
+ * serial: too few segments or docs, no workers configured or
+ * launched, running in an autovacuum worker, or already in parallel
+ * mode (e.g. inside PostgreSQL's own parallel vacuum).  Launched
+ * workers are counted in bm25_merge_stats' parallel_workers.
+ *
+ * Caller holds the per-index LWLock, as for the serial pass.
+ */
+extern bool tp_parallel_vacuum_identify(
+		Relation				index,
+		TpVacuumSegmentInfo	   *segments,
+		int						num_segments,
+		IndexBulkDeleteCallback callback,
+		void				   *callback_state);
+
+/* Parallel worker entry point */
+extern PGDLLEXPORT void
+tp_parallel_vacuum_worker_main(dsm_segment *seg, shm_toc *toc);
@@ -76,16 +76,70 @@
 #define TP_MAX_LEVELS				  8 /* Supports 8^8 = 16M segments */
 #define TP_DEFAULT_SEGMENTS_PER_LEVEL 8
 
+/*
+ * Tiered merge policy (merge_policy = 'tiered').  A segment whose
+ * dead-doc percentage reaches merge_deletes_pct is merged even when
+ * its level is not full.  Segments below TP_MERGE_TIER_FLOOR_BYTES
+ * all count as the smallest tier; each further tier is
+ * segments_per_level times larger.
+ */
+#define TP_DEFAULT_MERGE_DELETES_PCT 30
+#define TP_MERGE_TIER_FLOOR_BYTES	 (1024 * 1024)
+
+/*
+ * Parallel posting merge (pg_textsearch.parallel_merge_workers).
+ * Merges with fewer terms stay serial; the term range is cut into
+ * this many chunks per participant so uneven chunks balance out.
+ */
+#define TP_PARALLEL_MERGE_MIN_TERMS			10000
+#define TP_PARALLEL_MERGE_CHUNKS_PER_WORKER 4
+
+/*
+ * Parallel build heap scan.  A worker's claim takes the blocks left
+ * divided by this many per worker, at least one and at most
+ * TP_BUILD_SCAN_MAX_CHUNK, so chunks shrink towards the end of the
+ * heap and workers finish together.
+ */
+#define TP_BUILD_SCAN_CHUNKS_PER_WORKER 8
+#define TP_BUILD_SCAN_MAX_CHUNK			8192
+
+/*
+ * Parallel build merge rounds (pg_textsearch.parallel_build_merge_fanin).
+ * While the workers' segments outnumber the fan-in, workers and leader
+ * merge them into temp files in batches of at most that many; the
+ * leader merges the rest into the index.
+ */
+#define TP_DEFAULT_BUILD_MERGE_FANIN 8
+
+/*
+ * Parallel VACUUM bulk-delete across one index's segments.  Indexes
+ * with fewer segments or docs are vacuumed serially.
+ */
+#define TP_PARALLEL_VACUUM_MIN_SEGMENTS 4
+#define TP_PARALLEL_VACUUM_MIN_DOCS		10000
+
+/*
+ * Merge I/O throttling (pg_textsearch.merge_cost_delay,
+ * merge_cost_limit), charged like vacuum_cost_*.  A sleep is capped
+ * at TP_MERGE_COST_MAX_DELAY_FACTOR times merge_cost_delay, as
+ * vacuum caps its own.
+ */
+#define TP_DEFAULT_MERGE_COST_LIMIT		200
+#define TP_MERGE_COST_MAX_DELAY_FACTOR	4
+#define TP_MERGE_SLOT_WAIT_MS			10
+
 /* BM25 scoring constants */
 #define TP_DEFAULT_K1 1.2
 #define TP_DEFAULT_B  0.75
 
 /* Memory and capacity limits */
-#define TP_QUERY_LIMITS_HASH_SIZE	   128
-#define TP_DEFAULT_QUERY_LIMIT		   1000
-#define TP_MAX_QUERY_LIMIT			   100000
-#define TP_DEFAULT_SEGMENT_THRESHOLD   10000
-#define TP_DEFAULT_BULK_LOAD_THRESHOLD 100000 /* terms/xact trigger spill */
+#define TP_QUERY_LIMITS_HASH_SIZE		128
+#define TP_DEFAULT_QUERY_LIMIT			1000
+#define TP_MAX_QUERY_LIMIT				100000
+#define TP_DEFAULT_SEGMENT_THRESHOLD	10000
+#define TP_DEFAULT_BULK_LOAD_THRESHOLD	100000 /* terms/xact trigger spill */
+#define TP_DEFAULT_QUERY_CACHE_SIZE		4096   /* query texts per backend */
+#define TP_DEFAULT_RESULT_CACHE_ENTRIES	1024   /* shared top-k results */
 
 /*
  * Selectivity-seeded top-K for filtered BM25 search.  When a filter
@@ -109,6 +163,26 @@
  */
 #define TP_DEFAULT_MEMTABLE_PAGES_THRESHOLD 64
 
+/*
+ * Background spill back-pressure (pg_textsearch.background_spill).
+ * Inserts hand spills to the background worker while the chain is
+ * under this multiple of memtable_pages_threshold; past it, the
+ * inserting backend spills synchronously so a stalled or saturated
+ * worker cannot let the chain grow without bound.
+ */
+#define TP_BACKGROUND_SPILL_BACKPRESSURE_FACTOR 4
+
+/*
+ * Capacity of the shared spill request queue.  One slot per index
+ * with a pending request (requests are de-duplicated per index), so
+ * this bounds the number of indexes awaiting a background spill;
+ * when full, inserts fall back to spilling synchronously.
+ */
+#define TP_BGWORKER_QUEUE_SIZE 64
+
+/* Launcher poll interval while idle (ms); requests set its latch. */
+#define TP_BGWORKER_NAPTIME_MS 10000
+
 /*
  * Lower bound on chain pages for VACUUM-cleanup and shutdown-hook
  * spills.  Below this, leaving the documents on the in-relation
@@ -135,9 +209,27 @@
 #define TP_POSTING_LIST_HASH_MAX_SIZE	  256
 
 /* Posting list and array parameters */
-#define TP_INITIAL_POSTING_LIST_CAPACITY 16
+#define TP_INITIAL_POSTING_LIST_CAPACITY 4
 #define TP_POSTING_LIST_GROWTH_FACTOR	 2
 
+/*
+ * Memtable cache posting lists keep at most this many entries in
+ * their uncompressed open tail; a full tail is sealed into a
+ * delta+varint compressed block.
+ */
+#define TP_POSTING_BLOCK_ENTRIES 128
+
+/*
+ * Memtable cache dense doc store: documents are numbered in apply
+ * order and stored in fixed-size DSA chunks that never move, so
+ * readers can index them while an applier appends.  The chunk
+ * directory lives inline in TpMemtable; a cache that would need
+ * more than CHUNK_DOCS * MAX_CHUNKS documents falls back to the
+ * chain source.
+ */
+#define TP_CACHE_DOC_CHUNK_DOCS 8192
+#define TP_CACHE_DOC_MAX_CHUNKS 512
+
 /* Query processing timeouts and limits */
 #define TP_MAX_INDEX_NAME_LENGTH 1024
 #define TP_MAX_TERM_LENGTH		 (1024 * 1024) /* 1MB sanity limit */
@@ -149,6 +241,15 @@
 #define TP_DEFAULT_INDEX_SELECTIVITY 0.1
 #define TP_DEFAULT_INDEX_PAGES		 1000.0
 
+/*
+ * Term-statistics cost model (tp_costestimate).  A scored posting
+ * costs a decode and a BM25 evaluation; a skipped block costs one
+ * block-max comparison.  Postings are costed at their uncompressed
+ * size, which over-counts pages a little for compressed segments.
+ */
+#define TP_COST_POSTING_OPS	  2.0
+#define TP_COST_POSTING_BYTES 8.0
+
 /*
  * Fixed LWLock tranche IDs.
  * These must be consistent across all backends to allow DSA attachment.
@@ -190,6 +291,12 @@
  */
 #define TP_TRANCHE_EVICTION_MUTEX 1012
 
+/* Background spill worker request queue (src/access/bgworker.c). */
+#define TP_TRANCHE_BGWORKER_QUEUE 1013
+
+/* Shared top-k result cache sets (src/index/result_cache.c). */
+#define TP_TRANCHE_RESULT_CACHE 1014
+
 /*
  * Global GUC variables declared in mod.c
  * Note: tp_relopt_kind is declared in index.c as it requires
@@ -198,6 +305,18 @@
 extern bool	  tp_log_scores;
 extern int	  tp_bulk_load_threshold;
 extern int	  tp_memtable_pages_threshold;
+extern bool	  tp_background_spill;
 extern int	  tp_segments_per_level;
+extern int	  tp_parallel_merge_workers;
+extern int	  tp_parallel_build_merge_fanin;
+extern double tp_merge_cost_delay;
+extern int	  tp_merge_cost_limit;
+extern int	  tp_max_concurrent_merges;
 extern bool	  tp_filtered_seed;
 extern double tp_filtered_seed_margin;
+extern bool	  tp_shared_topk;
+extern bool	  tp_score_pushdown;
+extern int	  tp_query_cache_size;
+extern bool	  tp_result_cache;
+extern int	  tp_result_cache_entries;
+extern int	  tp_result_cache_staleness;
@@ -9,17 +9,27 @@
  */
 #include <postgres.h>
 
+#include <access/genam.h>
+#include <access/htup_details.h>
+#include <access/table.h>
 #include <access/xact.h>
+#include <catalog/pg_inherits.h>
 #include <nodes/pathnodes.h>
+#include <utils/fmgroids.h>
 #include <utils/guc.h>
+#include <utils/hsearch.h>
+#include <utils/memutils.h>
 
 #include "index/limit.h"
 
 /*
- * Per-backend structure for current query limit - stores LIMIT value
- * extracted during query planning for use during query execution
+ * Per-backend LIMIT values extracted during query planning for use
+ * during query execution, one per index (TpCurrentLimit entries).
+ * A partitioned query costs every partition's index before any of
+ * them is scanned, so a single slot would leave all but the last
+ * partition without its limit.
  */
-static TpCurrentLimit tp_current_limit = {InvalidOid, -1, false};
+static HTAB *tp_current_limits = NULL;
 
 /*
  * Default limit when no LIMIT clause is detected - prevents
@@ -37,15 +47,28 @@ int tp_default_limit = TP_DEFAULT_QUERY_LIMIT;
 void
 tp_store_query_limit(Oid index_oid, int limit)
 {
-	/* Safety check - warn if we're overwriting a different index's limit */
-	if (tp_current_limit.is_valid && tp_current_limit.index_oid != index_oid)
+	TpCurrentLimit *entry;
+
+	if (tp_current_limits == NULL)
 	{
+		HASHCTL ctl;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize	  = sizeof(Oid);
+		ctl.entrysize = sizeof(TpCurrentLimit);
+		ctl.hcxt	  = TopMemoryContext;
+
+		tp_current_limits = hash_create(
+				"Tapir query limits",
+				16,
+				&ctl,
+				HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
 	}
 
-	/* Store the limit in our simple structure */
-	tp_current_limit.index_oid = index_oid;
-	tp_current_limit.limit	   = limit;
-	tp_current_limit.is_valid  = true;
+	entry = (TpCurrentLimit *)
+			hash_search(tp_current_limits, &index_oid, HASH_ENTER, NULL);
+	entry->limit	= limit;
+	entry->is_valid = true;
 }
 
 /*
@@ -58,25 +81,27 @@ tp_store_query_limit(Oid index_oid, int limit)
 int
 tp_get_query_limit(Relation index_rel)
 {
-	Oid index_oid;
-	int result = -1;
+	TpCurrentLimit *entry;
+	Oid				index_oid;
+	int				result = -1;
 
 	if (!RelationIsValid(index_rel))
 		return -1;
 
 	/* Check if we have valid limit data */
-	if (!tp_current_limit.is_valid)
+	if (tp_current_limits == NULL)
 		return -1;
 
 	index_oid = RelationGetRelid(index_rel);
+	entry	  = (TpCurrentLimit *)
+			hash_search(tp_current_limits, &index_oid, HASH_FIND, NULL);
 
-	/* Check if the stored limit applies to this index */
-	if (tp_current_limit.index_oid == index_oid)
+	if (entry != NULL && entry->is_valid)
 	{
-		result = tp_current_limit.limit;
+		result = entry->limit;
 
 		/* Clear the limit after retrieval to prevent stale data */
-		tp_current_limit.is_valid = false;
+		entry->is_valid = false;
 	}
 
 	return result;
@@ -95,12 +120,11 @@ tp_cleanup_query_limits(void)
 	if (!IsTransactionState())
 		return;
 
-	/* Clear the current limit structure */
-	if (tp_current_limit.is_valid)
+	/* Drop every stashed limit */
+	if (tp_current_limits != NULL)
 	{
-		tp_current_limit.index_oid = InvalidOid;
-		tp_current_limit.limit	   = -1;
-		tp_current_limit.is_valid  = false;
+		hash_destroy(tp_current_limits);
+		tp_current_limits = NULL;
 	}
 }
 
@@ -111,7 +135,10 @@ tp_cleanup_query_limits(void)
  * 1. The index scan produces results in the same order as the query's ORDER BY
  * 2. There are no intervening operations that could reorder results
  * 3. We have exactly one ORDER BY clause (our BM25 score)
- * 4. No additional WHERE clauses that might interfere with ordering
+ *
+ * Index clauses are @@@ / @@& match quals, which the scan applies
+ * before ranking (see tp_match_filter_build), so they do not shrink
+ * the top-k.
  */
 bool
 tp_can_pushdown_limit(PlannerInfo *root, IndexPath *path, int limit)
@@ -129,15 +156,143 @@ tp_can_pushdown_limit(PlannerInfo *root, IndexPath *path, int limit)
 		return false;
 	}
 
-	/*
-	 * For now, be conservative: don't push down LIMIT if there are
-	 * additional WHERE clauses beyond the BM25 score ordering.
-	 * This could be relaxed later with more sophisticated analysis.
-	 */
-	if (path->indexclauses && list_length(path->indexclauses) > 0)
+	return true;
+}
+
+/*
+ * A group of sibling scans sharing a top-k threshold.  Groups are
+ * kept on a backend-local list and unlinked when their query memory
+ * context goes away.
+ */
+struct TpSharedTopK
+{
+	MemoryContext		  query_cxt;  /* Executor query context */
+	Oid					  parent_oid; /* Parent table of the partitions */
+	char				 *query_text;
+	int					  limit;
+	float4				  threshold; /* Highest kth score reported */
+	MemoryContextCallback reset_cb;
+	struct TpSharedTopK	 *next;
+};
+
+static TpSharedTopK *tp_shared_topk_groups = NULL;
+
+static void
+tp_shared_topk_unlink(void *arg)
+{
+	TpSharedTopK  *shared = (TpSharedTopK *)arg;
+	TpSharedTopK **link	  = &tp_shared_topk_groups;
+
+	while (*link != NULL)
 	{
-		return false;
+		if (*link == shared)
+		{
+			*link = shared->next;
+			break;
+		}
+		link = &(*link)->next;
 	}
+}
 
-	return true;
+/*
+ * Parent of an inheritance child or partition, or InvalidOid.
+ * Hypertable chunks are inheritance children of the hypertable.
+ */
+static Oid
+tp_find_parent_table(Oid relid)
+{
+	Relation	inhrel;
+	SysScanDesc scan;
+	HeapTuple	tuple;
+	ScanKeyData skey;
+	Oid			parent_oid = InvalidOid;
+
+	inhrel = table_open(InheritsRelationId, AccessShareLock);
+
+	ScanKeyInit(
+			&skey,
+			Anum_pg_inherits_inhrelid,
+			BTEqualStrategyNumber,
+			F_OIDEQ,
+			ObjectIdGetDatum(relid));
+
+	scan = systable_beginscan(
+			inhrel, InheritsRelidSeqnoIndexId, true, NULL, 1, &skey);
+
+	tuple = systable_getnext(scan);
+	if (tuple != NULL)
+	{
+		Form_pg_inherits inhform = (Form_pg_inherits)GETSTRUCT(tuple);
+		parent_oid				 = inhform->inhparent;
+	}
+
+	systable_endscan(scan);
+	table_close(inhrel, AccessShareLock);
+
+	return parent_oid;
+}
+
+/*
+ * Join the top-k group of a partition's ranked scan
+ *
+ * Scores are partition-local (each index has its own IDF and average
+ * length), but they are also what the merge above the partitions
+ * orders by, so comparing them across siblings is exactly as
+ * consistent as the merge itself.
+ */
+TpSharedTopK *
+tp_shared_topk_join(
+		MemoryContext query_cxt,
+		Relation	  heap,
+		const char	 *query_text,
+		int			  limit)
+{
+	TpSharedTopK *shared;
+	Oid			  parent_oid;
+
+	if (!tp_shared_topk || !RelationIsValid(heap) || query_text == NULL ||
+		limit <= 0)
+		return NULL;
+
+	parent_oid = tp_find_parent_table(RelationGetRelid(heap));
+	if (!OidIsValid(parent_oid))
+		return NULL;
+
+	for (shared = tp_shared_topk_groups; shared != NULL;
+		 shared = shared->next)
+	{
+		if (shared->query_cxt == query_cxt &&
+			shared->parent_oid == parent_oid && shared->limit == limit &&
+			strcmp(shared->query_text, query_text) == 0)
+			return shared;
+	}
+
+	shared = MemoryContextAllocZero(query_cxt, sizeof(TpSharedTopK));
+	shared->query_cxt  = query_cxt;
+	shared->parent_oid = parent_oid;
+	shared->query_text = MemoryContextStrdup(query_cxt, query_text);
+	shared->limit	   = limit;
+	shared->threshold  = 0.0f;
+
+	shared->reset_cb.func = tp_shared_topk_unlink;
+	shared->reset_cb.arg  = shared;
+	MemoryContextRegisterResetCallback(query_cxt, &shared->reset_cb);
+
+	shared->next		  = tp_shared_topk_groups;
+	tp_shared_topk_groups = shared;
+
+	return shared;
+}
+
+float4
+tp_shared_topk_threshold(TpSharedTopK *shared)
+{
+	return shared != NULL ? shared->threshold : 0.0f;
+}
+
+void
+tp_shared_topk_raise(TpSharedTopK *shared, float4 kth_score)
+{
+	if (shared != NULL && kth_score > shared->threshold)
+		shared->threshold = kth_score;
 }
@@ -22,12 +22,13 @@
  */
 
 /*
- * Simple per-backend structure to track the current query's limit
- * Replaces the hash table approach for better simplicity and performance
+ * Per-backend LIMIT stashed for one index between planning and
+ * execution.  Entries are keyed by index OID, so each partition's
+ * index receives its own limit.
  */
 typedef struct TpCurrentLimit
 {
-	Oid	 index_oid; /* Index OID for which this limit applies */
+	Oid	 index_oid; /* Index OID for which this limit applies (key) */
 	int	 limit;		/* LIMIT value from query */
 	bool is_valid;	/* Whether this data is current and valid */
 } TpCurrentLimit;
@@ -46,3 +47,35 @@ void tp_cleanup_query_limits(void);
  * LIMIT pushdown analysis for cost estimation
  */
 bool tp_can_pushdown_limit(PlannerInfo *root, IndexPath *path, int limit);
+
+/*
+ * Cross-partition top-k threshold
+ *
+ * A LIMIT over the partitions of a table (declarative partitions or
+ * hypertable chunks) is answered by merging each partition's ranked
+ * scan.  Once one partition has produced k results, no document of a
+ * sibling scoring below that partition's kth score can be among the
+ * merged top k, so sibling scans of the same query join a group that
+ * keeps the highest such score and prune against it.
+ *
+ * The group lives in the executor's query memory context and is
+ * backend-local; parallel workers each keep their own.
+ */
+typedef struct TpSharedTopK TpSharedTopK;
+
+/*
+ * Join (creating if needed) the group for scans of `heap`'s siblings
+ * running `query_text` with `limit`.  Returns NULL when `heap` is not
+ * a partition or inheritance child.
+ */
+TpSharedTopK *tp_shared_topk_join(
+		MemoryContext query_cxt,
+		Relation	  heap,
+		const char	 *query_text,
+		int			  limit);
+
+/* Highest kth score a member has reported, or 0 */
+float4 tp_shared_topk_threshold(TpSharedTopK *shared);
+
+/* Report a member's kth score */
+void tp_shared_topk_raise(TpSharedTopK *shared, float4 kth_score);
@@ -161,6 +161,9 @@ tp_registry_shmem_startup(void)
 				&tapir_registry->eviction_mutex, TP_TRANCHE_EVICTION_MUTEX);
 		pg_atomic_init_u64(&tapir_registry->estimated_total_bytes, 0);
 
+		/* Merge slots, see merge_throttle.c */
+		pg_atomic_init_u32(&tapir_registry->active_merges, 0);
+
 		/* Initialize handles as invalid - DSA/dshash created on first use */
 		tapir_registry->dsa_handle		= DSA_HANDLE_INVALID;
 		tapir_registry->registry_handle = DSHASH_HANDLE_INVALID;
@@ -520,6 +523,13 @@ tp_registry_eviction_mutex(void)
 	return &tapir_registry->eviction_mutex;
 }
 
+pg_atomic_uint32 *
+tp_registry_active_merges(void)
+{
+	Assert(tapir_registry != NULL);
+	return &tapir_registry->active_merges;
+}
+
 void
 tp_registry_walk(TpRegistryWalkCb cb, void *ctx)
 {
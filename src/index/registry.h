@@ -50,6 +50,9 @@ typedef struct TpRegistryEntry
  * tp_cache_evict_largest invocations (and DROP-time shared-state
  * teardown) so a victim's TpSharedIndexState cannot be dsa_freed
  * while another backend is inspecting it.
+ *
+ * active_merges counts the merges holding a slot under
+ * pg_textsearch.max_concurrent_merges; see merge_throttle.h.
  */
 typedef struct TpGlobalRegistry
 {
@@ -58,6 +61,7 @@ typedef struct TpGlobalRegistry
 	dshash_table_handle registry_handle; /* Handle for the registry dshash */
 	LWLock				eviction_mutex;	 /* Serializes cache eviction */
 	pg_atomic_uint64	estimated_total_bytes; /* Σ per-index est bytes */
+	pg_atomic_uint32	active_merges; /* merges holding a merge slot */
 } TpGlobalRegistry;
 
 /* Registry management functions */
@@ -101,6 +105,9 @@ extern void				   tp_registry_unregister(Oid index_oid);
 extern pg_atomic_uint64 *tp_registry_estimated_total_bytes(void);
 extern LWLock			*tp_registry_eviction_mutex(void);
 
+/* Cluster-wide count of running merges, for merge_throttle.c */
+extern pg_atomic_uint32 *tp_registry_active_merges(void);
+
 /*
  * Callback-based registry iterator.  For each registered index,
  * invokes `cb(oid, shared_state_dp, ctx)`.  Stops early when the
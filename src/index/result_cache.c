@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * result_cache.c - Shared top-k result cache
+ *
+ * A fixed array of entries in the main shared memory segment, sized
+ * by pg_textsearch.result_cache_entries at server start.  Entries are
+ * grouped into sets of TP_RESULT_CACHE_WAYS; a key hashes to one set,
+ * which has its own LWLock, and replaces the set's least recently used
+ * entry.  Each entry holds up to TP_RESULT_CACHE_MAX_RESULTS CTIDs and
+ * scores inline, so nothing is allocated after startup.
+ */
+#include <postgres.h>
+
+#include <access/htup_details.h>
+#include <access/xlog.h>
+#include <common/hashfn.h>
+#include <fmgr.h>
+#include <funcapi.h>
+#include <port/atomics.h>
+#include <storage/ipc.h>
+#include <storage/lwlock.h>
+#include <storage/shmem.h>
+#include <utils/rel.h>
+#include <utils/timestamp.h>
+
+#include "constants.h"
+#include "index/registry.h"
+#include "index/result_cache.h"
+
+/* Entries per set */
+#define TP_RESULT_CACHE_WAYS 4
+
+typedef struct TpResultCacheSlot
+{
+	Oid				 index_oid; /* InvalidOid while empty */
+	int				 limit;
+	uint32			 hash;
+	int				 key_len;
+	int				 count; /* Results held */
+	uint64			 generation;
+	uint64			 tid_generation;
+	TimestampTz		 stored_at;
+	pg_atomic_uint64 last_used; /* Clock value of the last use */
+	char			 key[TP_RESULT_CACHE_KEY_LEN];
+	ItemPointerData	 ctids[TP_RESULT_CACHE_MAX_RESULTS];
+	float4			 scores[TP_RESULT_CACHE_MAX_RESULTS];
+} TpResultCacheSlot;
+
+typedef struct TpResultCacheSet
+{
+	LWLock			  lock;
+	TpResultCacheSlot slots[TP_RESULT_CACHE_WAYS];
+} TpResultCacheSet;
+
+typedef struct TpResultCacheShared
+{
+	pg_atomic_uint64 epoch; /* Next generation range */
+	pg_atomic_uint64 clock; /* Recency of entries */
+	pg_atomic_uint64 hits;
+	pg_atomic_uint64 misses;
+	int				 nsets;
+	TpResultCacheSet sets[FLEXIBLE_ARRAY_MEMBER];
+} TpResultCacheShared;
+
+static TpResultCacheShared *tp_result_cache_shared = NULL;
+
+static int
+result_cache_nsets(void)
+{
+	return (tp_result_cache_entries + TP_RESULT_CACHE_WAYS - 1) /
+		   TP_RESULT_CACHE_WAYS;
+}
+
+static Size
+result_cache_shmem_size(void)
+{
+	return add_size(
+			offsetof(TpResultCacheShared, sets),
+			mul_size(result_cache_nsets(), sizeof(TpResultCacheSet)));
+}
+
+void
+tp_result_cache_shmem_request(void)
+{
+	if (tp_result_cache_entries > 0)
+		RequestAddinShmemSpace(result_cache_shmem_size());
+}
+
+void
+tp_result_cache_shmem_startup(void)
+{
+	bool found;
+
+	if (tp_result_cache_entries == 0)
+		return;
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	tp_result_cache_shared = ShmemInitStruct(
+			"pg_textsearch result cache", result_cache_shmem_size(), &found);
+	if (!found)
+	{
+		TpResultCacheShared *shared = tp_result_cache_shared;
+
+		memset(shared, 0, result_cache_shmem_size());
+		pg_atomic_init_u64(&shared->epoch, 1);
+		pg_atomic_init_u64(&shared->clock, 0);
+		pg_atomic_init_u64(&shared->hits, 0);
+		pg_atomic_init_u64(&shared->misses, 0);
+		shared->nsets = result_cache_nsets();
+
+		for (int s = 0; s < shared->nsets; s++)
+		{
+			LWLockInitialize(&shared->sets[s].lock, TP_TRANCHE_RESULT_CACHE);
+			for (int w = 0; w < TP_RESULT_CACHE_WAYS; w++)
+				pg_atomic_init_u64(&shared->sets[s].slots[w].last_used, 0);
+		}
+	}
+
+	LWLockRelease(AddinShmemInitLock);
+
+	LWLockRegisterTranche(TP_TRANCHE_RESULT_CACHE, "tapir_result_cache");
+}
+
+uint64
+tp_result_cache_epoch(void)
+{
+	if (tp_result_cache_shared == NULL)
+		return 0;
+
+	/* 2^32 changes per index state before ranges could meet */
+	return pg_atomic_fetch_add_u64(&tp_result_cache_shared->epoch, 1) << 32;
+}
+
+void
+tp_result_cache_invalidate(TpSharedIndexState *shared, bool tids_recycled)
+{
+	/* Advanced without a cache too: rescans check result_generation */
+	if (shared == NULL)
+		return;
+
+	pg_atomic_fetch_add_u64(&shared->result_generation, 1);
+	if (tids_recycled)
+		pg_atomic_fetch_add_u64(&shared->result_tid_generation, 1);
+}
+
+void
+tp_result_cache_invalidate_rel(Relation index, bool tids_recycled)
+{
+	tp_result_cache_invalidate(
+			tp_registry_lookup(RelationGetRelid(index)), tids_recycled);
+}
+
+static int
+result_cache_term_cmp(const void *a, const void *b, void *arg)
+{
+	char **terms = (char **)arg;
+
+	return strcmp(terms[*(const int *)a], terms[*(const int *)b]);
+}
+
+bool
+tp_result_cache_key_init(
+		TpResultCacheKey   *key,
+		TpSharedIndexState *shared,
+		Oid					index_oid,
+		TpQueryTerms	   *terms,
+		int					limit)
+{
+	int *order;
+	int	 len = 0;
+
+	if (!tp_result_cache || tp_result_cache_shared == NULL ||
+		shared == NULL || limit <= 0 || limit > TP_RESULT_CACHE_MAX_RESULTS)
+		return false;
+
+	/*
+	 * Redo does not bump the index's generations, so on a standby an
+	 * entry would outlive the changes replayed after it was stored.
+	 */
+	if (RecoveryInProgress())
+		return false;
+
+	/* The term set, in term order, so word order does not matter */
+	order = palloc(terms->term_count * sizeof(int));
+	for (int i = 0; i < terms->term_count; i++)
+		order[i] = i;
+	qsort_arg(order,
+			  terms->term_count,
+			  sizeof(int),
+			  result_cache_term_cmp,
+			  terms->terms);
+
+	for (int i = 0; i < terms->term_count; i++)
+	{
+		const char *term	 = terms->terms[order[i]];
+		int32		freq	 = terms->frequencies[order[i]];
+		Size		term_len = strlen(term) + 1;
+
+		if (len + term_len + sizeof(int32) > TP_RESULT_CACHE_KEY_LEN)
+		{
+			pfree(order);
+			return false;
+		}
+		memcpy(key->bytes + len, term, term_len);
+		len += term_len;
+		memcpy(key->bytes + len, &freq, sizeof(int32));
+		len += sizeof(int32);
+	}
+	pfree(order);
+
+	key->index_oid = index_oid;
+	key->limit	   = limit;
+	key->len	   = len;
+	key->hash	   = hash_bytes((const unsigned char *)key->bytes, len);
+	key->hash	   = hash_combine(key->hash, index_oid);
+	key->hash	   = hash_combine(key->hash, (uint32)limit);
+
+	/* Read before the scan scores: its results are at least this new */
+	key->tid_generation = pg_atomic_read_u64(&shared->result_tid_generation);
+	key->generation		= pg_atomic_read_u64(&shared->result_generation);
+	return true;
+}
+
+static TpResultCacheSet *
+result_cache_set(TpResultCacheKey *key)
+{
+	return &tp_result_cache_shared
+					->sets[key->hash % tp_result_cache_shared->nsets];
+}
+
+static bool
+result_cache_slot_matches(TpResultCacheSlot *slot, TpResultCacheKey *key)
+{
+	return slot->index_oid == key->index_oid && slot->limit == key->limit &&
+		   slot->hash == key->hash && slot->key_len == key->len &&
+		   memcmp(slot->key, key->bytes, key->len) == 0;
+}
+
+/*
+ * Can `slot` answer a scan at the key's generations?  Besides current
+ * entries, pg_textsearch.result_cache_staleness admits older ones
+ * whose CTIDs are still those of the same documents.
+ */
+static bool
+result_cache_slot_usable(TpResultCacheSlot *slot, TpResultCacheKey *key)
+{
+	if (slot->tid_generation != key->tid_generation)
+		return false;
+	if (slot->generation == key->generation)
+		return true;
+
+	return tp_result_cache_staleness > 0 &&
+		   !TimestampDifferenceExceeds(
+				   slot->stored_at,
+				   GetCurrentTimestamp(),
+				   tp_result_cache_staleness);
+}
+
+bool
+tp_result_cache_lookup(
+		TpResultCacheKey *key, ItemPointer ctids, float4 *scores, int *count)
+{
+	TpResultCacheSet *set = result_cache_set(key);
+	bool			  hit = false;
+
+	LWLockAcquire(&set->lock, LW_SHARED);
+	for (int w = 0; w < TP_RESULT_CACHE_WAYS; w++)
+	{
+		TpResultCacheSlot *slot = &set->slots[w];
+
+		if (!result_cache_slot_matches(slot, key) ||
+			!result_cache_slot_usable(slot, key))
+			continue;
+
+		memcpy(ctids, slot->ctids, slot->count * sizeof(ItemPointerData));
+		memcpy(scores, slot->scores, slot->count * sizeof(float4));
+		*count = slot->count;
+		pg_atomic_write_u64(
+				&slot->last_used,
+				pg_atomic_fetch_add_u64(&tp_result_cache_shared->clock, 1));
+		hit = true;
+		break;
+	}
+	LWLockRelease(&set->lock);
+
+	pg_atomic_fetch_add_u64(
+			hit ? &tp_result_cache_shared->hits
+				: &tp_result_cache_shared->misses,
+			1);
+	return hit;
+}
+
+void
+tp_result_cache_store(
+		TpResultCacheKey *key, ItemPointer ctids, float4 *scores, int count)
+{
+	TpResultCacheSet  *set	  = result_cache_set(key);
+	TpResultCacheSlot *victim = NULL;
+	TimestampTz		   now	  = GetCurrentTimestamp();
+
+	Assert(count <= key->limit);
+
+	LWLockAcquire(&set->lock, LW_EXCLUSIVE);
+
+	/* The key's own entry, else an empty one, else the least recent */
+	for (int w = 0; w < TP_RESULT_CACHE_WAYS; w++)
+	{
+		TpResultCacheSlot *slot = &set->slots[w];
+
+		if (result_cache_slot_matches(slot, key))
+		{
+			/* Never replace a newer result with an older one */
+			if (slot->generation > key->generation)
+			{
+				LWLockRelease(&set->lock);
+				return;
+			}
+			victim = slot;
+			break;
+		}
+		if (victim == NULL || !OidIsValid(slot->index_oid) ||
+			(OidIsValid(victim->index_oid) &&
+			 pg_atomic_read_u64(&slot->last_used) <
+					 pg_atomic_read_u64(&victim->last_used)))
+			victim = slot;
+	}
+
+	victim->index_oid	   = key->index_oid;
+	victim->limit		   = key->limit;
+	victim->hash		   = key->hash;
+	victim->key_len		   = key->len;
+	victim->count		   = count;
+	victim->generation	   = key->generation;
+	victim->tid_generation = key->tid_generation;
+	victim->stored_at	   = now;
+	memcpy(victim->key, key->bytes, key->len);
+	memcpy(victim->ctids, ctids, count * sizeof(ItemPointerData));
+	memcpy(victim->scores, scores, count * sizeof(float4));
+	pg_atomic_write_u64(
+			&victim->last_used,
+			pg_atomic_fetch_add_u64(&tp_result_cache_shared->clock, 1));
+
+	LWLockRelease(&set->lock);
+}
+
+PG_FUNCTION_INFO_V1(tp_result_cache_stats);
+
+/*
+ * SQL-callable: bm25_result_cache_stats() → record
+ *
+ * The cache's size and occupied entries, and the hits and misses of
+ * cacheable scans since server start.
+ */
+Datum
+tp_result_cache_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc tupdesc;
+	Datum	  values[4];
+	bool	  nulls[4] = {false, false, false, false};
+	int		  used	   = 0;
+	int		  entries  = 0;
+	uint64	  hits	   = 0;
+	uint64	  misses   = 0;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	if (tp_result_cache_shared != NULL)
+	{
+		TpResultCacheShared *shared = tp_result_cache_shared;
+
+		for (int s = 0; s < shared->nsets; s++)
+		{
+			LWLockAcquire(&shared->sets[s].lock, LW_SHARED);
+			for (int w = 0; w < TP_RESULT_CACHE_WAYS; w++)
+			{
+				if (OidIsValid(shared->sets[s].slots[w].index_oid))
+					used++;
+			}
+			LWLockRelease(&shared->sets[s].lock);
+		}
+
+		entries = shared->nsets * TP_RESULT_CACHE_WAYS;
+		hits	= pg_atomic_read_u64(&shared->hits);
+		misses	= pg_atomic_read_u64(&shared->misses);
+	}
+
+	values[0] = Int32GetDatum(entries);
+	values[1] = Int32GetDatum(used);
+	values[2] = Int64GetDatum((int64)hits);
+	values[3] = Int64GetDatum((int64)misses);
+
+	PG_RETURN_DATUM(
+			HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * result_cache.h - Shared top-k result cache
+ *
+ * Ranked scans of the same terms with the same limit against an
+ * unchanged index return the same CTIDs and scores, whichever backend
+ * runs them.  With pg_textsearch.result_cache on, a scan's results are
+ * kept in a fixed-size shared-memory cache and reused by identical
+ * scans, in any backend, until the index changes.
+ *
+ * Every change to an index that could change a ranking (memtable
+ * append, spill, merge, VACUUM) advances its result generation, and an
+ * entry only answers scans at the generation it was computed at.  A
+ * scan may instead accept an entry up to
+ * pg_textsearch.result_cache_staleness old, as long as no VACUUM has
+ * run since: VACUUM also advances the TID generation, because the
+ * CTIDs of the documents it removes can be reused by new rows.
+ *
+ * Results do not depend on the reader's snapshot: rows the snapshot
+ * cannot see are filtered out by the executor exactly as when the
+ * scan scores.
+ */
+#pragma once
+
+#include <postgres.h>
+
+#include <storage/itemptr.h>
+
+#include "index/state.h"
+#include "types/query_terms.h"
+
+/* Longest normalized term set that is cached */
+#define TP_RESULT_CACHE_KEY_LEN 256
+
+/* Largest limit whose results are cached */
+#define TP_RESULT_CACHE_MAX_RESULTS 128
+
+/*
+ * A scan's cache key: its index, normalized term set and limit, with
+ * the index's generations read before the scan scored.
+ */
+typedef struct TpResultCacheKey
+{
+	Oid	   index_oid;
+	int	   limit;
+	uint32 hash;
+	int	   len;
+	char   bytes[TP_RESULT_CACHE_KEY_LEN]; /* Sorted (term, frequency) */
+	uint64 generation;
+	uint64 tid_generation;
+} TpResultCacheKey;
+
+/* Shared memory setup, from the shmem request and startup hooks */
+extern void tp_result_cache_shmem_request(void);
+extern void tp_result_cache_shmem_startup(void);
+
+/*
+ * Initial generation for a newly created shared index state.  Each
+ * state draws a fresh range, so entries left by a dropped or rebuilt
+ * index under the same OID never match.
+ */
+extern uint64 tp_result_cache_epoch(void);
+
+/*
+ * Advance an index's result generation after a change to its
+ * contents; `tids_recycled` also advances the TID generation.
+ */
+extern void
+tp_result_cache_invalidate(TpSharedIndexState *shared, bool tids_recycled);
+
+/* tp_result_cache_invalidate for an index by relation */
+extern void tp_result_cache_invalidate_rel(Relation index, bool tids_recycled);
+
+/*
+ * Build the key of a ranked scan.  Returns false when the scan is not
+ * cacheable: the cache is off or absent, the server is in recovery, or
+ * the terms or limit are too large.
+ */
+extern bool tp_result_cache_key_init(
+		TpResultCacheKey   *key,
+		TpSharedIndexState *shared,
+		Oid					index_oid,
+		TpQueryTerms	   *terms,
+		int					limit);
+
+/*
+ * Copy a cached result into `ctids` and `scores`, which hold at least
+ * key->limit entries.  Returns false on a miss.
+ */
+extern bool tp_result_cache_lookup(
+		TpResultCacheKey *key, ItemPointer ctids, float4 *scores, int *count);
+
+/* Cache a scan's complete, unfiltered result */
+extern void tp_result_cache_store(
+		TpResultCacheKey *key, ItemPointer ctids, float4 *scores, int count);
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * snapshot.c - Point-in-time view of an index for query scoring
+ *
+ * See snapshot.h for what a snapshot pins and why the segment side
+ * needs no lock once the metapage has been read.
+ */
+#include <postgres.h>
+
+#include <utils/hsearch.h>
+#include <utils/memutils.h>
+
+#include "index/metapage.h"
+#include "index/snapshot.h"
+#include "index/source.h"
+#include "index/state.h"
+#include "memtable/cache_source.h"
+
+/*
+ * One query term's memtable contribution.  Query term lists are
+ * short, so lookups are a linear strcmp scan.
+ */
+typedef struct SnapshotTermEntry
+{
+	char		  *term;
+	TpPostingData *postings; /* NULL when the memtable lacks the term */
+	uint32		   doc_freq;
+} SnapshotTermEntry;
+
+typedef struct SnapshotDocLenEntry
+{
+	ItemPointerData ctid;
+	int32			doc_length;
+} SnapshotDocLenEntry;
+
+/*
+ * Backend-local TpDataSource holding everything scoring will ask
+ * the memtable for: postings and doc_freq for each query term, and
+ * doc lengths for every CTID those postings reference.
+ */
+typedef struct TpSnapshotMemtableSource
+{
+	TpDataSource	   base; /* must be first */
+	SnapshotTermEntry *terms;
+	int				   num_terms;
+	HTAB			  *doclen_ht; /* ItemPointerData -> doc length */
+} TpSnapshotMemtableSource;
+
+static SnapshotTermEntry *
+snapshot_find_term(TpSnapshotMemtableSource *src, const char *term)
+{
+	for (int i = 0; i < src->num_terms; i++)
+	{
+		if (strcmp(src->terms[i].term, term) == 0)
+			return &src->terms[i];
+	}
+	return NULL;
+}
+
+static TpPostingData *
+snapshot_get_postings(TpDataSource *source, const char *term)
+{
+	SnapshotTermEntry *entry;
+
+	entry = snapshot_find_term((TpSnapshotMemtableSource *)source, term);
+	return entry != NULL ? entry->postings : NULL;
+}
+
+/* Postings are owned by the snapshot and freed with its context. */
+static void
+snapshot_free_postings(TpDataSource *source, TpPostingData *data)
+{
+	(void)source;
+	(void)data;
+}
+
+static int32
+snapshot_get_doc_length(TpDataSource *source, ItemPointer ctid)
+{
+	TpSnapshotMemtableSource *src = (TpSnapshotMemtableSource *)source;
+	SnapshotDocLenEntry		 *dle;
+
+	dle = (SnapshotDocLenEntry *)
+			hash_search(src->doclen_ht, ctid, HASH_FIND, NULL);
+	return dle != NULL ? dle->doc_length : -1;
+}
+
+static uint32
+snapshot_get_doc_freq(TpDataSource *source, const char *term)
+{
+	SnapshotTermEntry *entry;
+
+	entry = snapshot_find_term((TpSnapshotMemtableSource *)source, term);
+	return entry != NULL ? entry->doc_freq : 0;
+}
+
+/* Owned by the snapshot; tp_index_snapshot_release frees it. */
+static void
+snapshot_close(TpDataSource *source)
+{
+	(void)source;
+}
+
+static const TpDataSourceOps snapshot_source_ops = {
+		.get_postings	= snapshot_get_postings,
+		.free_postings	= snapshot_free_postings,
+		.get_doc_length = snapshot_get_doc_length,
+		.get_doc_freq	= snapshot_get_doc_freq,
+		.close			= snapshot_close,
+};
+
+/*
+ * Copy the query terms' slice of `inner` into a backend-local
+ * source.  Runs with the per-index LWLock held; allocates in
+ * CurrentMemoryContext (the snapshot's context).
+ */
+static TpDataSource *
+snapshot_materialize_memtable(
+		TpDataSource	  *inner,
+		const char *const *query_terms,
+		int				   query_term_count)
+{
+	TpSnapshotMemtableSource *src;
+	HASHCTL					  info;
+
+	src = (TpSnapshotMemtableSource *)palloc0(
+			sizeof(TpSnapshotMemtableSource));
+	src->base.ops		 = &snapshot_source_ops;
+	src->base.total_docs = inner->total_docs;
+	src->base.total_len	 = inner->total_len;
+	src->terms			 = (SnapshotTermEntry *)palloc0(
+			  Max(query_term_count, 1) * sizeof(SnapshotTermEntry));
+
+	memset(&info, 0, sizeof(info));
+	info.keysize   = sizeof(ItemPointerData);
+	info.entrysize = sizeof(SnapshotDocLenEntry);
+	info.hcxt	   = CurrentMemoryContext;
+	src->doclen_ht = hash_create(
+			"pg_textsearch snapshot: doc lengths",
+			256,
+			&info,
+			HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	for (int q = 0; q < query_term_count; q++)
+	{
+		const char		  *term = query_terms[q];
+		SnapshotTermEntry *entry;
+		TpPostingData	  *postings;
+
+		/* Duplicate query terms ("the the") share one entry. */
+		if (term == NULL || snapshot_find_term(src, term) != NULL)
+			continue;
+
+		entry		= &src->terms[src->num_terms++];
+		entry->term = pstrdup(term);
+
+		/*
+		 * Source postings are fresh copies in CurrentMemoryContext,
+		 * so the snapshot can keep them past the source's close.
+		 */
+		entry->doc_freq = tp_source_get_doc_freq(inner, term);
+		postings		= tp_source_get_postings(inner, term);
+		if (postings == NULL || postings->count == 0)
+		{
+			if (postings != NULL)
+				tp_source_free_postings(inner, postings);
+			continue;
+		}
+		entry->postings = postings;
+
+		for (int i = 0; i < postings->count; i++)
+		{
+			SnapshotDocLenEntry *dle;
+			bool				 found;
+
+			dle = (SnapshotDocLenEntry *)hash_search(
+					src->doclen_ht, &postings->ctids[i], HASH_ENTER, &found);
+			if (found)
+				continue;
+			if (postings->doc_lengths != NULL)
+				dle->doc_length = postings->doc_lengths[i];
+			else
+				dle->doc_length =
+						tp_source_get_doc_length(inner, &postings->ctids[i]);
+		}
+	}
+
+	return (TpDataSource *)src;
+}
+
+TpIndexSnapshot *
+tp_index_snapshot_capture(
+		TpLocalIndexState *state,
+		Relation		   index,
+		const char *const *query_terms,
+		int				   query_term_count)
+{
+	TpIndexSnapshot *snapshot;
+	TpIndexMetaPage	 metap;
+	TpDataSource	*inner;
+	MemoryContext	 old;
+	bool			 release_lock;
+
+	Assert(state != NULL && state->shared != NULL);
+	Assert(query_term_count == 0 || query_terms != NULL);
+
+	snapshot	   = (TpIndexSnapshot *)palloc0(sizeof(TpIndexSnapshot));
+	snapshot->mcxt = AllocSetContextCreate(
+			CurrentMemoryContext,
+			"pg_textsearch index snapshot",
+			ALLOCSET_DEFAULT_SIZES);
+
+	/*
+	 * Same ownership convention as the memtable sources: release
+	 * only what we acquired, so a caller that already holds the
+	 * lock (e.g. a spill or insert earlier in this transaction)
+	 * keeps it.
+	 */
+	release_lock = !state->lock_held;
+	tp_acquire_index_lock(state, LW_SHARED);
+
+	/*
+	 * Metapage and memtable are read under the same SHARED hold, so
+	 * they describe one consistent state: spill, which moves docs
+	 * from one to the other, needs EXCLUSIVE.
+	 */
+	metap = tp_get_metapage(index);
+	memcpy(snapshot->level_heads,
+		   metap->level_heads,
+		   sizeof(snapshot->level_heads));
+	snapshot->total_docs = (int64)metap->total_docs;
+	snapshot->total_len	 = (int64)metap->total_len;
+	snapshot->k1		 = metap->k1;
+	snapshot->b			 = metap->b;
+	pfree(metap);
+
+	snapshot->spill_generation =
+			pg_atomic_read_u64(&state->shared->spill_generation);
+
+	old	  = MemoryContextSwitchTo(snapshot->mcxt);
+	inner = tp_memtable_source_create_for_read(
+			state, index, query_terms, query_term_count);
+	if (inner != NULL)
+	{
+		snapshot->memtable = snapshot_materialize_memtable(
+				inner, query_terms, query_term_count);
+		tp_source_close(inner);
+	}
+	MemoryContextSwitchTo(old);
+
+	if (release_lock)
+		tp_release_index_lock(state);
+
+	if (snapshot->memtable != NULL)
+	{
+		snapshot->total_docs += snapshot->memtable->total_docs;
+		snapshot->total_len += snapshot->memtable->total_len;
+	}
+
+	return snapshot;
+}
+
+void
+tp_index_snapshot_release(TpIndexSnapshot *snapshot)
+{
+	if (snapshot == NULL)
+		return;
+
+	MemoryContextDelete(snapshot->mcxt);
+	pfree(snapshot);
+}
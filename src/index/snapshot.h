@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * snapshot.h - Point-in-time view of an index for query scoring
+ *
+ * A query captures a TpIndexSnapshot under a brief per-index
+ * LWLock SHARED hold and then scores against it with the lock
+ * released.  Spill and merge (which take the lock EXCLUSIVE) no
+ * longer wait out a slow query, and a spill no longer stalls
+ * every query behind it.
+ *
+ * What the snapshot pins, and how:
+ *
+ *   segments  The level heads read from the metapage.  Segment
+ *             pages displaced by a later merge or vacuum rewrite
+ *             are parked on the tombstone chain (pending_free_head)
+ *             and only reach the FSM once their merge horizon is
+ *             older than every running transaction's xmin
+ *             (tp_tombstone_drain).  The query's own MVCC snapshot
+ *             is therefore the epoch that keeps them readable; no
+ *             separate refcount is needed.
+ *
+ *   memtable  The query terms' postings and the doc lengths they
+ *             reference are copied out of the memtable source
+ *             (cache or chain) into backend-local memory at
+ *             capture time, so a concurrent spill is free to clear
+ *             the cache and retire the chain.
+ */
+#pragma once
+
+#include <postgres.h>
+
+#include <storage/block.h>
+#include <utils/rel.h>
+
+#include "constants.h"
+#include "index/source.h"
+#include "index/state.h"
+
+typedef struct TpIndexSnapshot
+{
+	BlockNumber level_heads[TP_MAX_LEVELS]; /* segment chains */
+	int64		total_docs;					/* segments + memtable */
+	int64		total_len;					/* segments + memtable */
+	float4		k1;							/* BM25 k1 parameter */
+	float4		b;							/* BM25 b parameter */
+	uint64		spill_generation;			/* epoch seen at capture */
+
+	/*
+	 * Materialized memtable contribution, restricted to the terms
+	 * passed at capture time; NULL when the memtable was empty.
+	 * Owned by the snapshot; do not tp_source_close() it.
+	 */
+	TpDataSource *memtable;
+
+	MemoryContext mcxt; /* private, deleted by release */
+} TpIndexSnapshot;
+
+/*
+ * Capture a snapshot of `index` for scoring `query_terms`.  Takes
+ * the per-index LWLock SHARED only for the duration of the call
+ * (and leaves it held if the caller already held it).
+ */
+extern TpIndexSnapshot *tp_index_snapshot_capture(
+		TpLocalIndexState *state,
+		Relation		   index,
+		const char *const *query_terms,
+		int				   query_term_count);
+
+/* Free a snapshot and everything it materialized. */
+extern void tp_index_snapshot_release(TpIndexSnapshot *snapshot);
@@ -16,11 +16,16 @@
 /*
  * Columnar posting data for a term.
  * Arrays are parallel - ctids[i] corresponds to frequencies[i].
+ *
+ * doc_lengths is optional: a source that can produce each
+ * document's length as cheaply as its CTID fills it in, sparing
+ * callers a get_doc_length() lookup per posting.  NULL otherwise.
  */
 typedef struct TpPostingData
 {
 	ItemPointerData *ctids;		  /* Array of document CTIDs */
 	int32			*frequencies; /* Array of term frequencies */
+	int32			*doc_lengths; /* Array of doc lengths, or NULL */
 	int32			 count;		  /* Number of entries */
 	int32			 doc_freq;	  /* Document frequency (for IDF) */
 } TpPostingData;
@@ -88,7 +93,7 @@ struct TpDataSource
 
 /*
  * Helper to allocate posting data with given capacity.
- * Allocates in CurrentMemoryContext.
+ * Allocates in CurrentMemoryContext; doc_lengths starts NULL.
  */
 extern TpPostingData *tp_alloc_posting_data(int32 capacity);
 
@@ -37,6 +37,7 @@
 #include "constants.h"
 #include "index/metapage.h"
 #include "index/registry.h"
+#include "index/result_cache.h"
 #include "index/source.h"
 #include "index/state.h"
 #include "memtable/cache.h"
@@ -44,6 +45,7 @@
 #include "memtable/log.h"
 #include "segment/io.h"
 #include "segment/merge.h"
+#include "segment/merge_throttle.h"
 #include "segment/segment.h"
 
 /* Cache of local index states */
@@ -88,6 +90,8 @@ tp_shutdown_spill_one(LocalStateCacheEntry *entry)
 	{
 		/* Don't leak the per-index LWLock to racing shutdown hooks */
 		tp_release_index_lock(entry->local_state);
+		/* Nor a merge slot taken by the spill's compaction */
+		tp_merge_slot_release_all();
 		FlushErrorState();
 		if (index_rel != NULL)
 			index_close(index_rel, RowExclusiveLock);
@@ -353,6 +357,7 @@ tp_create_shared_index_state(Oid index_oid, Oid heap_oid, bool reuse_if_exists)
 	shared_state->heap_oid	= heap_oid;
 	pg_atomic_init_u64(&shared_state->estimated_bytes, 0);
 	pg_atomic_init_u32(&shared_state->chain_page_count, 0);
+	pg_atomic_init_u32(&shared_state->spill_queued, 0);
 	shared_state->is_build_mode = false; /* runtime-mode publication */
 	/*
 	 * Initialize per-index LWLock + spill_generation in the
@@ -367,13 +372,27 @@ tp_create_shared_index_state(Oid index_oid, Oid heap_oid, bool reuse_if_exists)
 	 */
 	LWLockInitialize(&shared_state->lock, TP_TRANCHE_INDEX_LOCK);
 	pg_atomic_init_u64(&shared_state->spill_generation, 0);
+	pg_atomic_init_u64(&shared_state->cache_access_count, 0);
+	pg_atomic_init_u64(&shared_state->cache_last_access, 0);
+	pg_atomic_init_u64(&shared_state->bytes_ingested, 0);
+	pg_atomic_init_u64(&shared_state->bytes_merged, 0);
+	pg_atomic_init_u64(&shared_state->merges, 0);
+	pg_atomic_init_u64(&shared_state->parallel_workers, 0);
+	pg_atomic_init_u64(&shared_state->merge_rounds, 0);
+	pg_atomic_init_u64(&shared_state->throttle_sleeps, 0);
+	pg_atomic_init_u64(
+			&shared_state->result_generation, tp_result_cache_epoch());
+	pg_atomic_init_u64(
+			&shared_state->result_tid_generation, tp_result_cache_epoch());
 	memtable_dp = dsa_allocate(dsa, sizeof(TpMemtable));
 	if (!DsaPointerIsValid(memtable_dp))
 		elog(ERROR, "Failed to allocate memtable in DSA");
 
 	memtable = (TpMemtable *)dsa_get_address(dsa, memtable_dp);
 	memtable->string_hash_handle = DSHASH_HANDLE_INVALID;
-	memtable->doc_lengths_handle = DSHASH_HANDLE_INVALID;
+	for (int i = 0; i < TP_CACHE_DOC_MAX_CHUNKS; i++)
+		memtable->doc_chunks[i] = InvalidDsaPointer;
+	pg_atomic_init_u32(&memtable->doc_count, 0);
 	LWLockInitialize(&memtable->apply_lock, TP_TRANCHE_CACHE_APPLY_LOCK);
 	LWLockInitialize(&memtable->lock, TP_TRANCHE_CACHE_LOCK);
 	memtable->cursor_gen_spill_count = 0;
@@ -510,6 +529,7 @@ tp_create_build_index_state(Oid index_oid, Oid heap_oid)
 	shared_state->is_build_mode = true;
 	pg_atomic_init_u64(&shared_state->estimated_bytes, 0);
 	pg_atomic_init_u32(&shared_state->chain_page_count, 0);
+	pg_atomic_init_u32(&shared_state->spill_queued, 0);
 
 	/*
 	 * Initialize per-index LWLock using a fixed tranche ID.
@@ -518,6 +538,18 @@ tp_create_build_index_state(Oid index_oid, Oid heap_oid)
 	 */
 	LWLockInitialize(&shared_state->lock, TP_TRANCHE_INDEX_LOCK);
 	pg_atomic_init_u64(&shared_state->spill_generation, 0);
+	pg_atomic_init_u64(&shared_state->cache_access_count, 0);
+	pg_atomic_init_u64(&shared_state->cache_last_access, 0);
+	pg_atomic_init_u64(&shared_state->bytes_ingested, 0);
+	pg_atomic_init_u64(&shared_state->bytes_merged, 0);
+	pg_atomic_init_u64(&shared_state->merges, 0);
+	pg_atomic_init_u64(&shared_state->parallel_workers, 0);
+	pg_atomic_init_u64(&shared_state->merge_rounds, 0);
+	pg_atomic_init_u64(&shared_state->throttle_sleeps, 0);
+	pg_atomic_init_u64(
+			&shared_state->result_generation, tp_result_cache_epoch());
+	pg_atomic_init_u64(
+			&shared_state->result_tid_generation, tp_result_cache_epoch());
 
 	/* Check if index already registered (rebuild case) */
 	if (tp_registry_lookup(index_oid) != NULL)
@@ -554,7 +586,9 @@ tp_create_build_index_state(Oid index_oid, Oid heap_oid)
 
 	memtable = (TpMemtable *)dsa_get_address(private_dsa, memtable_dp);
 	memtable->string_hash_handle = DSHASH_HANDLE_INVALID;
-	memtable->doc_lengths_handle = DSHASH_HANDLE_INVALID;
+	for (int i = 0; i < TP_CACHE_DOC_MAX_CHUNKS; i++)
+		memtable->doc_chunks[i] = InvalidDsaPointer;
+	pg_atomic_init_u32(&memtable->doc_count, 0);
 	LWLockInitialize(&memtable->apply_lock, TP_TRANCHE_CACHE_APPLY_LOCK);
 	LWLockInitialize(&memtable->lock, TP_TRANCHE_CACHE_LOCK);
 	memtable->cursor_gen_spill_count = 0;
@@ -636,7 +670,9 @@ tp_finalize_build_mode(TpLocalIndexState *local_state)
 
 	memtable = (TpMemtable *)dsa_get_address(global_dsa, memtable_dp);
 	memtable->string_hash_handle = DSHASH_HANDLE_INVALID;
-	memtable->doc_lengths_handle = DSHASH_HANDLE_INVALID;
+	for (int i = 0; i < TP_CACHE_DOC_MAX_CHUNKS; i++)
+		memtable->doc_chunks[i] = InvalidDsaPointer;
+	pg_atomic_init_u32(&memtable->doc_count, 0);
 	LWLockInitialize(&memtable->apply_lock, TP_TRANCHE_CACHE_APPLY_LOCK);
 	LWLockInitialize(&memtable->lock, TP_TRANCHE_CACHE_LOCK);
 	memtable->cursor_gen_spill_count = 0;
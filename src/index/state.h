@@ -20,6 +20,8 @@
  */
 #include <storage/block.h>
 
+#include "constants.h"
+
 /* Forward declarations */
 struct TpMemtable;
 typedef struct TpIndexMetaPageData *TpIndexMetaPage;
@@ -46,9 +48,14 @@ typedef struct TpDsmSegmentHeader
  * consumption, and memory cap live in cache.c / cache_source.c.
  *
  * Lifetimes:
- *   - string_hash_handle / doc_lengths_handle:
- *       DSHASH_HANDLE_INVALID until cold_build allocates them; reset
+ *   - string_hash_handle:
+ *       DSHASH_HANDLE_INVALID until cold_build allocates it; reset
  *       back to DSHASH_HANDLE_INVALID by tp_cache_clear.
+ *   - doc_chunks / doc_count:
+ *       all InvalidDsaPointer / 0 at init and after tp_cache_clear.
+ *       Appended only under apply_lock EXCL; chunks are never
+ *       reallocated, so readers holding lock SHARED index them
+ *       without further locking.
  *   - apply_lock / lock:
  *       initialized once at TpMemtable allocation, never destroyed
  *       across cache clears (the structs survive; tp_cache_clear only
@@ -70,8 +77,16 @@ typedef struct TpMemtable
 	/* dshash inverted index: term -> TpStringHashEntry. */
 	dshash_table_handle string_hash_handle;
 
-	/* dshash doc-length map: ctid -> TpDocLengthEntry. */
-	dshash_table_handle doc_lengths_handle;
+	/*
+	 * Dense doc store.  Each applied document gets the next
+	 * sequence number; seq / TP_CACHE_DOC_CHUNK_DOCS selects the
+	 * TpDocChunk holding its length and CTID.  Posting entries
+	 * carry the sequence number, so a doc-length lookup is one
+	 * indexed load.  doc_count is published with a write barrier
+	 * after the slot is filled.
+	 */
+	dsa_pointer		 doc_chunks[TP_CACHE_DOC_MAX_CHUNKS];
+	pg_atomic_uint32 doc_count;
 
 	/*
 	 * Serializes every path that mutates the cache (reader catchup,
@@ -168,6 +183,15 @@ typedef struct TpSharedIndexState
 	 */
 	pg_atomic_uint32 chain_page_count;
 
+	/*
+	 * 1 while a background spill request for this index sits in
+	 * the worker queue (pg_textsearch.background_spill).  Set by
+	 * the inserting backend that enqueues, cleared when the
+	 * worker dequeues, so a burst of inserts past the threshold
+	 * produces one request rather than one per insert.
+	 */
+	pg_atomic_uint32 spill_queued;
+
 	/*
 	 * Cached estimated memtable size in bytes, updated
 	 * atomically by writers. Used to maintain the global
@@ -199,6 +223,50 @@ typedef struct TpSharedIndexState
 	 * generation tracking is sufficient.
 	 */
 	pg_atomic_uint64 spill_generation;
+
+	/*
+	 * Read-side demand for the memtable cache, bumped by every
+	 * tp_memtable_source_create_for_read that may serve from it.
+	 * The eviction policy weighs these against the bytes a clear
+	 * would free (see tp_cache_evict_largest).  cache_last_access
+	 * holds a TimestampTz (0 = never read).  Relaxed, lossy
+	 * updates: the policy only needs approximate values.
+	 */
+	pg_atomic_uint64 cache_access_count;
+	pg_atomic_uint64 cache_last_access;
+
+	/*
+	 * Segment bytes written since server start: bytes_ingested by
+	 * spills and builds, bytes_merged by merges and VACUUM segment
+	 * rewrites (tp_merge_account_write).  Their ratio is the write
+	 * amplification reported by bm25_merge_stats.  Not persisted.
+	 */
+	pg_atomic_uint64 bytes_ingested;
+	pg_atomic_uint64 bytes_merged;
+
+	/*
+	 * Merges completed (including VACUUM segment rewrites), parallel
+	 * workers launched for the index's merges and VACUUM bulk-deletes,
+	 * rounds of merging a build's temporary segments, and the
+	 * merge_cost_delay sleeps of those builds' merges, since server
+	 * start.  Reported by bm25_merge_stats.  Not persisted.
+	 */
+	pg_atomic_uint64 merges;
+	pg_atomic_uint64 parallel_workers;
+	pg_atomic_uint64 merge_rounds;
+	pg_atomic_uint64 throttle_sleeps;
+
+	/*
+	 * Generations of the index's rankings, checked by the shared
+	 * result cache (src/index/result_cache.c) and by rescans reusing
+	 * their last batch.  result_generation advances on every change
+	 * that can alter a ranking; result_tid_generation only on VACUUM,
+	 * after which a removed document's CTID may name another row.
+	 * Both start from tp_result_cache_epoch() so that a rebuilt index
+	 * never matches entries of its predecessor.
+	 */
+	pg_atomic_uint64 result_generation;
+	pg_atomic_uint64 result_tid_generation;
 } TpSharedIndexState;
 
 /*
@@ -8,8 +8,8 @@
  * for the design.  Three entry points:
  *
  *   tp_cache_cold_build()    cache.apply_lock EXCL +
- *                            cache.lock EXCL.  Allocates dshash
- *                            tables, walks the chain from
+ *                            cache.lock EXCL.  Allocates the
+ *                            term table, walks the chain from
  *                            meta.head_blkno, populates the
  *                            cache, seeds the cursor.
  *
@@ -20,13 +20,17 @@
  *                            to the logical tail, applies each
  *                            record, advances the cursor.
  *
- *   tp_cache_clear()         drops the dshash tables, resets the
- *                            apply cursor + estimated_bytes, and
+ *   tp_cache_clear()         drops the term table and doc store,
+ *                            resets the apply cursor +
+ *                            estimated_bytes, and
  *                            drains accounting in lockstep with
  *                            the global counter.  Caller-supplied
  *                            lock contract (see the function
  *                            comment).
  *
+ * tp_cache_extract_for_spill() lets tp_do_spill build its segment
+ * input straight from a warm cache instead of re-decoding the chain.
+ *
  * Both paths share the same record-apply primitive
  * (apply_one_record) that decodes the on-disk TpVector, runs
  * the memory-cap check, calls tp_cache_apply_document(), and
@@ -45,15 +49,19 @@
 
 #include <access/htup_details.h>
 #include <access/relation.h>
+#include <access/xlog.h>
 #include <catalog/index.h>
+#include <catalog/pg_type.h>
 #include <fmgr.h>
 #include <funcapi.h>
 #include <lib/dshash.h>
+#include <math.h>
 #include <miscadmin.h>
 #include <storage/lwlock.h>
 #include <utils/builtins.h>
 #include <utils/memutils.h>
 #include <utils/rel.h>
+#include <utils/timestamp.h>
 
 #include "constants.h"
 #include "index/metapage.h"
@@ -64,11 +72,17 @@
 #include "memtable/chain_walker.h"
 #include "memtable/posting.h"
 #include "memtable/stringtable.h"
+#include "segment/dictionary.h"
+#include "segment/docmap.h"
 #include "types/vector.h"
 
 /* GUC: in mod.c, declared in kB; we work in bytes. */
 extern int tp_memory_limit_kb;
 
+/* GUCs in mod.c; gate and trace the spill-from-cache path. */
+extern bool tp_memtable_cache_enabled;
+extern bool tp_log_cache_state;
+
 /*
  * Per-index soft cap = global memory limit / 8.
  *
@@ -134,6 +148,23 @@ account_bytes_add(TpMemtable *memtable, uint64 delta)
 	pg_atomic_fetch_add_u64(tp_registry_estimated_total_bytes(), delta);
 }
 
+/*
+ * Credit `delta` bytes back to both counters, clamped at zero so
+ * accounting drift cannot wrap them.  Same lock contract as
+ * account_bytes_add.
+ */
+static inline void
+account_bytes_sub(TpMemtable *memtable, uint64 delta)
+{
+	pg_atomic_uint64 *gp = tp_registry_estimated_total_bytes();
+	uint64			  cur;
+
+	cur = pg_atomic_read_u64(&memtable->estimated_bytes);
+	pg_atomic_fetch_sub_u64(&memtable->estimated_bytes, Min(delta, cur));
+	cur = pg_atomic_read_u64(gp);
+	pg_atomic_fetch_sub_u64(gp, Min(delta, cur));
+}
+
 /*
  * Drain the per-index counter to zero and subtract the drained
  * amount from the global counter.  Used by tp_cache_clear and
@@ -190,19 +221,8 @@ tp_cache_clear(dsa_area *dsa, TpMemtable *memtable)
 		memtable->string_hash_handle = DSHASH_HANDLE_INVALID;
 	}
 
-	if (memtable->doc_lengths_handle != DSHASH_HANDLE_INVALID)
-	{
-		dshash_table *doclength_table =
-				tp_doclength_table_attach(dsa, memtable->doc_lengths_handle);
-
-		/*
-		 * Doc-length entries are POD (ItemPointerData + int32) with
-		 * no nested DSA allocations, so dshash_destroy alone is
-		 * sufficient.
-		 */
-		dshash_destroy(doclength_table);
-		memtable->doc_lengths_handle = DSHASH_HANDLE_INVALID;
-	}
+	/* Doc store chunks are POD; freeing them is all there is to do. */
+	tp_doc_store_clear(dsa, memtable);
 
 	memtable->cursor_gen_spill_count = 0;
 	memtable->cursor_next_blkno		 = InvalidBlockNumber;
@@ -222,38 +242,66 @@ tp_cache_clear(dsa_area *dsa, TpMemtable *memtable)
 /* ---------- eviction ---------- */
 
 /*
- * Argmax callback state.  We track (oid, dsa_pointer, bytes) of
- * the largest non-caller cache observed so far.  The dsa pointer
- * lets the post-walk path resolve the victim's shared state
- * without re-walking the registry.
+ * Eviction-relevant view of one registered index, read lock-free
+ * from its shared state and memtable.
  */
-typedef struct EvictCandidate
+typedef struct EvictStats
 {
-	Oid			caller_oid;
-	Oid			best_oid;
-	dsa_pointer best_shared_dp;
-	uint64		best_bytes;
-} EvictCandidate;
+	uint64		bytes;			 /* estimated_bytes a clear would free */
+	uint64		access_count;	 /* memtable reads since registration */
+	TimestampTz last_access;	 /* 0 if never read */
+	uint64		rebuild_records; /* records a cold rebuild re-applies */
+	double		score;			 /* evict_score(); higher = evict first */
+} EvictStats;
 
 /*
- * Per-entry argmax walker.  Reads memtable->estimated_bytes
- * without taking any cache lock — atomic reads are sufficient,
- * since the only mutators (apply_one_record adds,
- * tp_cache_account_bytes_drain subtracts) are themselves atomic
- * and we only need an approximate maximum for the soft-cap
- * eviction policy.
+ * Cost-aware eviction score: higher means a better victim.
+ *
+ * A cache is worth keeping in proportion to how often it is read
+ * and how much work a cold rebuild would redo.  "heat" is the
+ * log-damped access count divided by the seconds since the last
+ * read, so an index nobody has queried lately cools towards zero
+ * however busy it once was; rebuild cost is the number of chain
+ * records the cache has applied (cursor_seq).  Dividing the bytes
+ * a clear frees by (1 + heat * cost) favours large, idle, cheap
+ * caches — the GreedyDual-Size trade-off — and falls back to
+ * largest-first among caches that are never read.
+ */
+static double
+evict_score(const EvictStats *st, TimestampTz now)
+{
+	double idle_secs;
+	double heat;
+
+	if (st->access_count == 0 || st->last_access == 0)
+		return (double)st->bytes;
+
+	idle_secs = (double)(now - st->last_access) / USECS_PER_SEC;
+	if (idle_secs < 0)
+		idle_secs = 0;
+	heat = log2(1.0 + (double)st->access_count) / (1.0 + idle_secs);
+
+	return (double)st->bytes / (1.0 + heat * (double)st->rebuild_records);
+}
+
+/*
+ * Fill *out for the index whose shared state lives at shared_dp.
+ * Returns false for entries the eviction walker must skip.
+ * Caller holds tp_registry_eviction_mutex.
+ *
+ * Reads memtable->estimated_bytes without taking any cache lock —
+ * atomic reads are sufficient, since the only mutators
+ * (apply_one_record adds, tp_cache_account_bytes_drain subtracts)
+ * are themselves atomic and the policy only needs approximate
+ * values.
  */
 static bool
-evict_walk_cb(Oid oid, dsa_pointer shared_dp, void *ctx)
+evict_read_stats(dsa_pointer shared_dp, TimestampTz now, EvictStats *out)
 {
-	EvictCandidate	   *c = (EvictCandidate *)ctx;
 	dsa_area		   *dsa;
 	TpSharedIndexState *st;
 	TpMemtable		   *mt;
-	uint64				bytes;
 
-	if (oid == c->caller_oid)
-		return false;
 	if (!DsaPointerIsValid(shared_dp))
 		return false;
 
@@ -284,12 +332,51 @@ evict_walk_cb(Oid oid, dsa_pointer shared_dp, void *ctx)
 	if (mt == NULL)
 		return false;
 
-	bytes = pg_atomic_read_u64(&mt->estimated_bytes);
-	if (bytes > c->best_bytes)
+	out->bytes			 = pg_atomic_read_u64(&mt->estimated_bytes);
+	out->access_count	 = pg_atomic_read_u64(&st->cache_access_count);
+	out->last_access	 = (TimestampTz)
+			pg_atomic_read_u64(&st->cache_last_access);
+	out->rebuild_records = pg_atomic_read_u64(&mt->cursor_seq);
+	out->score			 = evict_score(out, now);
+	return true;
+}
+
+/*
+ * Argmax callback state.  We track (oid, dsa_pointer, score) of
+ * the best non-caller victim observed so far.  The dsa pointer
+ * lets the post-walk path resolve the victim's shared state
+ * without re-walking the registry.
+ */
+typedef struct EvictCandidate
+{
+	Oid			caller_oid;
+	TimestampTz now;
+	Oid			best_oid;
+	dsa_pointer best_shared_dp;
+	double		best_score;
+} EvictCandidate;
+
+/* Per-entry argmax walker over evict_score(). */
+static bool
+evict_walk_cb(Oid oid, dsa_pointer shared_dp, void *ctx)
+{
+	EvictCandidate *c = (EvictCandidate *)ctx;
+	EvictStats		stats;
+
+	if (oid == c->caller_oid)
+		return false;
+	if (!evict_read_stats(shared_dp, c->now, &stats))
+		return false;
+
+	/* Nothing to free: never a victim, however cold. */
+	if (stats.bytes == 0)
+		return false;
+
+	if (!OidIsValid(c->best_oid) || stats.score > c->best_score)
 	{
 		c->best_oid		  = oid;
 		c->best_shared_dp = shared_dp;
-		c->best_bytes	  = bytes;
+		c->best_score	  = stats.score;
 	}
 	return false; /* don't stop early; scan all entries */
 }
@@ -309,9 +396,10 @@ tp_cache_evict_largest(Oid caller_oid)
 	LWLockAcquire(mutex, LW_EXCLUSIVE);
 
 	c.caller_oid	 = caller_oid;
+	c.now			 = GetCurrentTimestamp();
 	c.best_oid		 = InvalidOid;
 	c.best_shared_dp = InvalidDsaPointer;
-	c.best_bytes	 = 0;
+	c.best_score	 = 0;
 
 	tp_registry_walk(evict_walk_cb, &c);
 
@@ -451,10 +539,18 @@ typedef struct DecodedDoc
  * estimated_size is an UPPER BOUND on the bytes the apply will
  * push into the DSA arena:
  *
- *   - sizeof(TpDocLengthEntry) for the doclength insert
+ *   - a whole TpDocChunk when the document opens a new dense doc
+ *     store chunk, nothing otherwise: the slots are allocated
+ *     TP_CACHE_DOC_CHUNK_DOCS at a time
  *   - per term: lexeme bytes (with NUL) + sizeof(TpStringHashEntry)
- *               for the dshash key + sizeof(TpPostingEntry) for
- *               the per-doc posting slot.
+ *               for the dshash key + a TpPostingEntry in the
+ *               posting list's uncompressed open tail.
+ *
+ * When a full tail is sealed, apply_one_record credits back the
+ * difference between the tail entries and the compressed block,
+ * so sealed postings end up charged at their varint size.  The
+ * tail's growth slack is bounded per term
+ * (TP_POSTING_BLOCK_ENTRIES) and not charged.
  *
  * We charge the full per-term cost on every record, even though
  * shared terms reuse the existing TpStringHashEntry (the
@@ -464,8 +560,15 @@ typedef struct DecodedDoc
  * for a lookup-before-charge that the apply path will repeat
  * anyway.
  */
+#define DOC_STORE_BYTES(next_doc_seq)                                        \
+	((next_doc_seq) % TP_CACHE_DOC_CHUNK_DOCS == 0 ? sizeof(TpDocChunk) : 0)
+
 static void
-decode_record(const char *vector_bytes, uint32 vector_len, DecodedDoc *out)
+decode_record(
+		const char *vector_bytes,
+		uint32		vector_len,
+		uint32		next_doc_seq,
+		DecodedDoc *out)
 {
 	TpVector	  *vec;
 	TpVectorEntry *entry;
@@ -477,7 +580,7 @@ decode_record(const char *vector_bytes, uint32 vector_len, DecodedDoc *out)
 		out->terms			= NULL;
 		out->frequencies	= NULL;
 		out->term_count		= 0;
-		out->estimated_size = sizeof(TpDocLengthEntry);
+		out->estimated_size = DOC_STORE_BYTES(next_doc_seq);
 		return;
 	}
 
@@ -488,7 +591,7 @@ decode_record(const char *vector_bytes, uint32 vector_len, DecodedDoc *out)
 	out->terms		 = (n > 0) ? palloc(sizeof(char *) * n) : NULL;
 	out->frequencies = (n > 0) ? palloc(sizeof(int32) * n) : NULL;
 
-	sz = sizeof(TpDocLengthEntry);
+	sz = DOC_STORE_BYTES(next_doc_seq);
 
 	entry = get_tpvector_first_entry(vec);
 	for (int i = 0; i < n; i++)
@@ -507,8 +610,8 @@ decode_record(const char *vector_bytes, uint32 vector_len, DecodedDoc *out)
 
 		/*
 		 * Per-term charge: lexeme bytes (+ NUL) for the interned
-		 * string, plus the dshash key entry, plus the posting
-		 * slot.  Underestimates the dshash bucket overhead and
+		 * string, plus the dshash key entry, plus the open-tail
+		 * posting.  Underestimates the dshash bucket overhead and
 		 * the posting list's growth amortisation; that's the
 		 * "soft" in soft cap.
 		 */
@@ -522,8 +625,9 @@ decode_record(const char *vector_bytes, uint32 vector_len, DecodedDoc *out)
 
 /*
  * Apply one decoded record to the cache.  Returns true on
- * success, false if the per-index soft cap would be exceeded
- * (caller must not advance the cursor in that case).
+ * success, false if the per-index soft cap would be exceeded or
+ * the dense doc store is full (caller must not advance the
+ * cursor in that case).
  *
  * Assumes the caller holds cache.apply_lock EXCL (so we are the
  * sole writer of estimated_bytes) and cache.lock at SHARED or
@@ -535,7 +639,8 @@ decode_record(const char *vector_bytes, uint32 vector_len, DecodedDoc *out)
  * estimate to estimated_bytes — even if the underlying
  * dshash inserts found existing entries.  The asymmetry (charge
  * the full upper bound, only credit on full drop) is intentional
- * for the soft cap.
+ * for the soft cap.  The one exception is posting tails sealed
+ * by the apply: what compression saved is credited straight back.
  */
 static bool
 apply_one_record(
@@ -547,6 +652,7 @@ apply_one_record(
 		uint64			   soft_cap)
 {
 	uint64 cur_bytes;
+	uint64 sealed_bytes;
 
 	if (soft_cap > 0)
 	{
@@ -555,15 +661,19 @@ apply_one_record(
 			return false;
 	}
 
-	tp_cache_apply_document(
-			local_state,
-			ctid,
-			doc->terms,
-			doc->frequencies,
-			doc->term_count,
-			doc_length);
+	if (!tp_cache_apply_document(
+				local_state,
+				ctid,
+				doc->terms,
+				doc->frequencies,
+				doc->term_count,
+				doc_length,
+				&sealed_bytes))
+		return false;
 
 	account_bytes_add(memtable, doc->estimated_size);
+	if (sealed_bytes > 0)
+		account_bytes_sub(memtable, sealed_bytes);
 	return true;
 }
 
@@ -586,6 +696,16 @@ cursor_to_walker_seed(
 
 /* ---------- catchup ---------- */
 
+/*
+ * Generation token written into the cursor when an apply errors
+ * out part-way through a record.  tp_cache_apply_document is not
+ * idempotent (the dense doc store has no CTID gate), so the
+ * partially applied record cannot simply be retried; no spill
+ * generation ever reaches this value, so the next apply sees a
+ * mismatch and drops the cache.
+ */
+#define CACHE_GEN_POISONED PG_UINT64_MAX
+
 TpCacheApplyResult
 tp_cache_apply_to_tail(TpLocalIndexState *local_state, Relation rel)
 {
@@ -599,7 +719,8 @@ tp_cache_apply_to_tail(TpLocalIndexState *local_state, Relation rel)
 	MemoryContext		decode_cxt;
 	MemoryContext		walker_cxt;
 	MemoryContext		oldcxt;
-	bool				budget_ok = true;
+	bool				budget_ok  = true;
+	volatile bool		mid_record = false;
 
 	Assert(local_state != NULL);
 	Assert(local_state->lock_held);
@@ -676,9 +797,14 @@ tp_cache_apply_to_tail(TpLocalIndexState *local_state, Relation rel)
 
 			MemoryContextReset(decode_cxt);
 			oldcxt = MemoryContextSwitchTo(decode_cxt);
-			decode_record(rec.vector_bytes, rec.vector_len, &doc);
+			decode_record(
+					rec.vector_bytes,
+					rec.vector_len,
+					tp_doc_store_count(memtable),
+					&doc);
 			MemoryContextSwitchTo(oldcxt);
 
+			mid_record = true;
 			if (!apply_one_record(
 						local_state,
 						memtable,
@@ -687,9 +813,11 @@ tp_cache_apply_to_tail(TpLocalIndexState *local_state, Relation rel)
 						&doc,
 						soft_cap))
 			{
-				budget_ok = false;
+				mid_record = false;
+				budget_ok  = false;
 				break;
 			}
+			mid_record = false;
 
 			memtable->cursor_next_blkno = rec.next_blkno;
 			memtable->cursor_next_off	= rec.next_off;
@@ -704,6 +832,8 @@ tp_cache_apply_to_tail(TpLocalIndexState *local_state, Relation rel)
 			tp_chain_walker_close(walker);
 		MemoryContextDelete(decode_cxt);
 		MemoryContextDelete(walker_cxt);
+		if (mid_record)
+			memtable->cursor_gen_spill_count = CACHE_GEN_POISONED;
 		LWLockRelease(&memtable->lock);
 		LWLockRelease(&memtable->apply_lock);
 		PG_RE_THROW();
@@ -810,9 +940,9 @@ tp_cache_cold_build(TpLocalIndexState *local_state, Relation rel)
 	soft_cap = tp_cache_per_index_soft_cap_bytes();
 
 	/*
-	 * Allocate the dshash tables now that we know there's work
+	 * Allocate the term table now that we know there's work
 	 * to do.  We hold cache.lock EXCL, so it is safe to mutate
-	 * memtable->{string_hash_handle, doc_lengths_handle} here:
+	 * memtable->string_hash_handle here:
 	 * no reader can be holding a SHARED lifetime lock that
 	 * would observe a mid-build handle reset.  This mirrors the
 	 * tp_ensure_string_table_initialized contract documented in
@@ -852,7 +982,11 @@ tp_cache_cold_build(TpLocalIndexState *local_state, Relation rel)
 
 			MemoryContextReset(decode_cxt);
 			oldcxt = MemoryContextSwitchTo(decode_cxt);
-			decode_record(rec.vector_bytes, rec.vector_len, &doc);
+			decode_record(
+					rec.vector_bytes,
+					rec.vector_len,
+					tp_doc_store_count(memtable),
+					&doc);
 			MemoryContextSwitchTo(oldcxt);
 
 			if (!apply_one_record(
@@ -911,6 +1045,256 @@ tp_cache_cold_build(TpLocalIndexState *local_state, Relation rel)
 	return result;
 }
 
+/* ---------- spill extraction ---------- */
+
+static int
+spill_term_info_cmp(const void *a, const void *b)
+{
+	const TermInfo *ta = (const TermInfo *)a;
+	const TermInfo *tb = (const TermInfo *)b;
+
+	return strcmp(ta->term, tb->term);
+}
+
+/*
+ * Copy every cached posting list into a TermInfo[] and every
+ * doc store slot into a fresh TpDocMapBuilder.  Caller holds
+ * cache.apply_lock EXCL + cache.lock SHARED with valid handles.
+ * Posting doc_seq values are translated back to CTIDs through the
+ * doc store's side array.
+ *
+ * dshash has no entry count, so the TermInfo array grows
+ * geometrically; the per-term ctid/freq arrays are sized exactly
+ * from doc_count, so there is no slack there.
+ *
+ * The doc store has no CTID gate, so the docmap's CTID hash is the
+ * duplicate check: a CTID applied twice would make the segment
+ * count its document twice.  Returns false, with no outputs, when
+ * it finds one; the chain is authoritative and never repeats one.
+ */
+static bool
+extract_cache_contents(
+		TpLocalIndexState *local_state,
+		TpMemtable		  *memtable,
+		TermInfo		 **out_terms,
+		uint32			  *out_num_terms,
+		TpDocMapBuilder	 **out_docmap,
+		uint64			  *out_docs,
+		uint64			  *out_len)
+{
+	dsa_area		  *dsa = local_state->dsa;
+	dshash_table	  *string_table;
+	dshash_seq_status  seq;
+	TpStringHashEntry *se;
+	TpDocMapBuilder	  *docmap;
+	TermInfo		  *terms	 = NULL;
+	uint32			   capacity	 = 0;
+	uint32			   n		 = 0;
+	uint32			   doc_count = tp_doc_store_count(memtable);
+	uint64			   len		 = 0;
+
+	docmap = tp_docmap_create();
+	for (uint32 seq_no = 0; seq_no < doc_count; seq_no++)
+	{
+		TpDocChunk *chunk = tp_doc_store_chunk(dsa, memtable, seq_no);
+		uint32		slot  = seq_no % TP_CACHE_DOC_CHUNK_DOCS;
+
+		tp_docmap_add(
+				docmap, &chunk->ctids[slot], (uint32)chunk->doc_lengths[slot]);
+		len += (uint32)chunk->doc_lengths[slot];
+	}
+
+	if (docmap->num_docs != doc_count)
+	{
+		tp_docmap_destroy(docmap);
+		return false;
+	}
+	tp_docmap_finalize(docmap);
+
+	string_table = tp_string_table_attach(dsa, memtable->string_hash_handle);
+	dshash_seq_init(&seq, string_table, false);
+	while ((se = (TpStringHashEntry *)dshash_seq_next(&seq)) != NULL)
+	{
+		TpPostingList *pl;
+		uint32		  *doc_seqs;
+		const char	  *term;
+		uint32		   count;
+
+		if (!DsaPointerIsValid(se->key.posting_list))
+			continue;
+
+		pl = (TpPostingList *)dsa_get_address(dsa, se->key.posting_list);
+		LWLockAcquire(&pl->lock, LW_SHARED);
+		if (pl->doc_count <= 0)
+		{
+			LWLockRelease(&pl->lock);
+			continue;
+		}
+
+		if (n >= capacity)
+		{
+			capacity = (capacity == 0) ? 1024 : capacity * 2;
+			if (terms == NULL)
+				terms = (TermInfo *)palloc_extended(
+						capacity * sizeof(TermInfo), MCXT_ALLOC_HUGE);
+			else
+				terms = (TermInfo *)
+						repalloc_huge(terms, capacity * sizeof(TermInfo));
+		}
+
+		count = (uint32)pl->doc_count;
+		term  = tp_get_key_str(dsa, &se->key);
+
+		terms[n].term_len = (uint32)strlen(term);
+		terms[n].term	  = (char *)palloc(terms[n].term_len + 1);
+		memcpy(terms[n].term, term, terms[n].term_len + 1);
+		terms[n].count	  = count;
+		terms[n].doc_freq = (uint32)pl->doc_freq;
+		terms[n].ctids	  = (ItemPointerData *)palloc_extended(
+				   count * sizeof(ItemPointerData), MCXT_ALLOC_HUGE);
+		terms[n].freqs = (int32 *)
+				palloc_extended(count * sizeof(int32), MCXT_ALLOC_HUGE);
+		doc_seqs = (uint32 *)
+				palloc_extended(count * sizeof(uint32), MCXT_ALLOC_HUGE);
+		tp_posting_list_read(dsa, pl, doc_seqs, terms[n].freqs);
+		for (uint32 i = 0; i < count; i++)
+			terms[n].ctids[i] = tp_doc_store_ctid(dsa, memtable, doc_seqs[i]);
+		LWLockRelease(&pl->lock);
+		pfree(doc_seqs);
+		n++;
+	}
+	dshash_seq_term(&seq);
+	dshash_detach(string_table);
+
+	/* Sort lexicographically for the segment writer's dict layout. */
+	if (n > 0)
+	{
+		qsort(terms, n, sizeof(TermInfo), spill_term_info_cmp);
+		for (uint32 i = 0; i < n; i++)
+			terms[i].dict_entry_idx = i;
+	}
+
+	*out_terms	   = terms;
+	*out_num_terms = n;
+	*out_docmap	   = docmap;
+	*out_docs	   = doc_count;
+	*out_len	   = len;
+	return true;
+}
+
+bool
+tp_cache_extract_for_spill(
+		TpLocalIndexState *local_state,
+		Relation		   rel,
+		MemoryContext	   dest_mcxt,
+		TermInfo		 **out_terms,
+		uint32			  *out_num_terms,
+		TpDocMapBuilder	 **out_docmap,
+		uint64			  *out_docs,
+		uint64			  *out_len)
+{
+	TpMemtable	 *memtable;
+	MemoryContext old;
+	volatile bool extracted = false;
+
+	Assert(local_state != NULL);
+	Assert(local_state->lock_held &&
+		   local_state->lock_mode == LW_EXCLUSIVE);
+
+	if (!tp_memtable_cache_enabled || local_state->is_build_mode ||
+		RecoveryInProgress())
+		return false;
+
+	memtable = get_memtable(local_state);
+	if (memtable == NULL)
+		return false;
+
+	/*
+	 * Cheap pre-checks before the catchup: per-index EXCL excludes
+	 * every other cache mutator, so the cursor can't move under us.
+	 * A cold or stale cache is never worth warming just to spill it.
+	 */
+	if (memtable->cursor_next_blkno == InvalidBlockNumber ||
+		memtable->cursor_gen_spill_count !=
+				pg_atomic_read_u64(&local_state->shared->spill_generation))
+		return false;
+
+	if (tp_cache_apply_to_tail(local_state, rel) != TP_CACHE_APPLY_OK)
+	{
+		if (tp_log_cache_state)
+			elog(LOG,
+				 "pg_textsearch cache spill: catchup failed, "
+				 "using chain (oid=%u)",
+				 local_state->shared->index_oid);
+		return false;
+	}
+
+	LWLockAcquire(&memtable->apply_lock, LW_EXCLUSIVE);
+	LWLockAcquire(&memtable->lock, LW_SHARED);
+
+	if (memtable->string_hash_handle == DSHASH_HANDLE_INVALID)
+	{
+		LWLockRelease(&memtable->lock);
+		LWLockRelease(&memtable->apply_lock);
+		return false;
+	}
+
+	old = MemoryContextSwitchTo(dest_mcxt);
+	PG_TRY();
+	{
+		extracted = extract_cache_contents(
+				local_state,
+				memtable,
+				out_terms,
+				out_num_terms,
+				out_docmap,
+				out_docs,
+				out_len);
+	}
+	PG_CATCH();
+	{
+		MemoryContextSwitchTo(old);
+		LWLockRelease(&memtable->lock);
+		LWLockRelease(&memtable->apply_lock);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	MemoryContextSwitchTo(old);
+
+	LWLockRelease(&memtable->lock);
+	LWLockRelease(&memtable->apply_lock);
+
+	if (!extracted)
+	{
+		elog(WARNING,
+			 "pg_textsearch cache spill: duplicate CTID in cache, "
+			 "using chain (oid=%u)",
+			 local_state->shared->index_oid);
+		return false;
+	}
+
+	/*
+	 * A warm cache over an empty chain: let the chain path make the
+	 * "nothing to spill" call so both paths agree on the return.
+	 */
+	if (*out_docs == 0)
+	{
+		tp_free_dictionary(*out_terms, *out_num_terms);
+		tp_docmap_destroy(*out_docmap);
+		return false;
+	}
+
+	if (tp_log_cache_state)
+		elog(LOG,
+			 "pg_textsearch cache spill: from_cache (oid=%u, terms=%u, "
+			 "docs=" UINT64_FORMAT ")",
+			 local_state->shared->index_oid,
+			 *out_num_terms,
+			 *out_docs);
+
+	return true;
+}
+
 /* ---------------------------------------------------------------------
  * Scaffold SQL functions.  Internal-only unit-test entry points,
  * complementing the end-to-end coverage in the regression suite.
@@ -1110,7 +1494,7 @@ bm25_cache_apply_to_tail(PG_FUNCTION_ARGS)
  * Permanent test scaffold for the DROPPED defensive branch of
  * tp_cache_apply_to_tail.  Real spill paths (tp_spill_finalize)
  * bump shared->spill_generation AND immediately drop the cache's
- * dshash tables via tp_cache_clear, so a subsequent apply_to_tail
+ * tables via tp_cache_clear, so a subsequent apply_to_tail
  * lands on the NOT_INITIALIZED branch instead of DROPPED.  This
  * helper increments the generation without touching the tables,
  * exposing the DROPPED branch to test coverage so the safety net
@@ -1209,3 +1593,132 @@ bm25_cache_evict_largest(PG_FUNCTION_ARGS)
 	}
 	return PointerGetDatum(cstring_to_text(txt));
 }
+
+/*
+ * Collector for bm25_cache_eviction_candidates: one row per walk
+ * callback.  Rows are palloc'd in the SRF's multi-call context,
+ * which is safe here — the walk holds only a dshash partition
+ * lock, and palloc never takes LWLocks.
+ */
+typedef struct EvictRow
+{
+	Oid		   oid;
+	EvictStats stats;
+} EvictRow;
+
+typedef struct EvictRowCollector
+{
+	TimestampTz now;
+	EvictRow   *rows;
+	int			nrows;
+	int			capacity;
+} EvictRowCollector;
+
+static bool
+evict_collect_cb(Oid oid, dsa_pointer shared_dp, void *ctx)
+{
+	EvictRowCollector *c = (EvictRowCollector *)ctx;
+	EvictStats		   stats;
+
+	if (!evict_read_stats(shared_dp, c->now, &stats))
+		return false;
+
+	if (c->nrows == c->capacity)
+	{
+		c->capacity *= 2;
+		c->rows = (EvictRow *)repalloc(c->rows, c->capacity * sizeof(EvictRow));
+	}
+	c->rows[c->nrows].oid	= oid;
+	c->rows[c->nrows].stats = stats;
+	c->nrows++;
+	return false;
+}
+
+/*
+ * bm25_cache_eviction_candidates() -> setof record
+ *
+ * One row per registered index with a global-DSA memtable: the
+ * inputs tp_cache_evict_largest weighs (estimated_bytes, access
+ * count and recency, rebuild cost in chain records) and the
+ * resulting eviction_score.  The next victim for a caller is the
+ * highest-scoring row with nonzero bytes other than the caller's
+ * own index.  last_access is NULL for a never-read cache.
+ *
+ * INTERNAL-only; revoked from PUBLIC in the install/upgrade SQL.
+ */
+PG_FUNCTION_INFO_V1(bm25_cache_eviction_candidates);
+
+Datum
+bm25_cache_eviction_candidates(PG_FUNCTION_ARGS)
+{
+	FuncCallContext	  *funcctx;
+	EvictRowCollector *c;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		LWLock		 *mutex = tp_registry_eviction_mutex();
+		TupleDesc	  tupdesc;
+
+		funcctx	   = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		c			= (EvictRowCollector *)palloc0(sizeof(EvictRowCollector));
+		c->now		= GetCurrentTimestamp();
+		c->capacity = 8;
+		c->rows		= (EvictRow *)palloc(c->capacity * sizeof(EvictRow));
+
+		/*
+		 * Same mutex as tp_cache_evict_largest: it is what makes the
+		 * is_build_mode check in evict_read_stats sound.
+		 */
+		if (mutex != NULL && tp_registry_get_dsa() != NULL)
+		{
+			LWLockAcquire(mutex, LW_EXCLUSIVE);
+			tp_registry_walk(evict_collect_cb, c);
+			LWLockRelease(mutex);
+		}
+
+		tupdesc = CreateTemplateTupleDesc(6);
+		TupleDescInitEntry(tupdesc, 1, "index_oid", OIDOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 2, "estimated_bytes", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 3, "access_count", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 4, "last_access", TIMESTAMPTZOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 5, "rebuild_records", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 6, "eviction_score", FLOAT8OID, -1, 0);
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+		funcctx->user_fctx	= c;
+		funcctx->max_calls	= c->nrows;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	c		= (EvictRowCollector *)funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		EvictRow  *row		 = &c->rows[funcctx->call_cntr];
+		Datum	   values[6];
+		bool	   nulls[6] = {false, false, false, false, false, false};
+		HeapTuple  tup;
+
+		values[0] = ObjectIdGetDatum(row->oid);
+		values[1] = Int64GetDatum((int64)row->stats.bytes);
+		values[2] = Int64GetDatum((int64)row->stats.access_count);
+		if (row->stats.last_access == 0)
+		{
+			values[3] = (Datum)0;
+			nulls[3]  = true;
+		}
+		else
+			values[3] = TimestampTzGetDatum(row->stats.last_access);
+		values[4] = Int64GetDatum((int64)row->stats.rebuild_records);
+		values[5] = Float8GetDatum(row->stats.score);
+
+		tup = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tup));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
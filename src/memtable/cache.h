@@ -170,9 +170,11 @@ typedef enum TpCacheEvictResult
 } TpCacheEvictResult;
 
 /*
- * Pick the largest cache other than `caller_oid` and evict it
+ * Pick the best victim other than `caller_oid` and evict it
  * (clear its dshash tables, subtract its bytes from the global
- * counter).  Caller MUST hold its own per-index LWLock SHARED
+ * counter).  Victims are ranked by bytes freed against access
+ * rate and rebuild cost; with no access history this is simply
+ * the largest cache.  Caller MUST hold its own per-index LWLock SHARED
  * (the read path's natural state); MUST NOT hold any cache lock.
  * See docs/memtable_cache.md §"Memory cap (3 tiers)".
  */
@@ -189,7 +191,7 @@ extern void tp_cache_account_bytes_drain(TpMemtable *memtable);
 
 /*
  * Drop the in-memory cache state.  Frees the dshash inverted index
- * and doc-length table (returning their DSA memory to the arena),
+ * and dense doc store (returning their DSA memory to the arena),
  * resets the apply cursor and estimated_bytes to their post-init
  * values, and trims the DSA.  Safe to call when the cache is
  * already empty (handles == DSHASH_HANDLE_INVALID): a no-op then.
@@ -214,3 +216,35 @@ extern void tp_cache_account_bytes_drain(TpMemtable *memtable);
  * is needed there.  See docs/memtable_cache.md.
  */
 extern void tp_cache_clear(dsa_area *dsa, TpMemtable *memtable);
+
+/*
+ * Spill consumption from the cache (docs/memtable_cache.md
+ * §"Spill path").
+ *
+ * If the cache is warm — initialized, generation-matched, and
+ * caught up to the chain tail by a final apply_to_tail — build the
+ * spill's sorted term dictionary and finalized doc map straight
+ * from the dshash posting lists and dense doc store, without
+ * re-walking or re-decoding the chain.  Output arrays live in
+ * `dest_mcxt` exactly as with tp_memtable_chain_source_extract, and
+ * *out_docs / *out_len carry the chain's corpus contribution.
+ *
+ * Returns false (outputs untouched) when the cache is disabled,
+ * cold, stale, or catchup hits the budget; the caller then falls
+ * back to the chain source.  Never cold-builds: a cold build costs
+ * the same chain walk the fallback would do, plus dshash inserts.
+ *
+ * Caller MUST hold the per-index LWLock EXCLUSIVE (spill).  The
+ * cache itself is left populated; tp_spill_finalize clears it.
+ */
+struct TermInfo;
+struct TpDocMapBuilder;
+extern bool tp_cache_extract_for_spill(
+		TpLocalIndexState		*local_state,
+		Relation				 rel,
+		MemoryContext			 dest_mcxt,
+		struct TermInfo		   **out_terms,
+		uint32					*out_num_terms,
+		struct TpDocMapBuilder **out_docmap,
+		uint64					*out_docs,
+		uint64					*out_len);
@@ -7,13 +7,15 @@
  *
  * See cache_source.h for the public contract.  The constructor
  * invokes the cache apply protocol (cache.c) to bring the cache
- * up to date with the on-disk chain, then attaches the dshash
- * tables for the source lifetime and returns an ops-table-backed
- * TpDataSource that serves per-term postings, per-ctid doc
+ * up to date with the on-disk chain, then attaches the term table
+ * for the source lifetime and returns an ops-table-backed
+ * TpDataSource that serves per-term postings (with their doc
+ * lengths, read straight from the dense doc store), per-ctid doc
  * lengths, and per-term doc frequencies out of the cache.
  */
 #include <postgres.h>
 
+#include <access/xact.h>
 #include <fmgr.h>
 #include <funcapi.h>
 #include <lib/dshash.h>
@@ -22,8 +24,10 @@
 #include <storage/lwlock.h>
 #include <utils/builtins.h>
 #include <utils/dsa.h>
+#include <utils/hsearch.h>
 #include <utils/memutils.h>
 #include <utils/rel.h>
+#include <utils/timestamp.h>
 
 #include "constants.h"
 #include "index/resolve.h"
@@ -53,7 +57,20 @@ typedef struct TpMemtableCacheSource
 								  * if get_memtable() ever returns
 								  * NULL again. */
 	dshash_table *string_table;
-	dshash_table *doclength_table;
+
+	/*
+	 * Number of doc store slots visible to this source, fixed at
+	 * construction so corpus totals and lookups agree even while
+	 * an applier appends behind us.
+	 */
+	uint32 doc_count;
+
+	/*
+	 * ctid -> doc_seq, built on the first get_doc_length() call.
+	 * Postings already carry their lengths, so scoring never
+	 * needs it.
+	 */
+	HTAB *ctid_ht;
 
 	/*
 	 * If non-NULL, this is the state on which *this* source
@@ -80,8 +97,9 @@ cache_get_postings(TpDataSource *source, const char *term)
 	TpMemtableCacheSource *cs = (TpMemtableCacheSource *)source;
 	TpStringHashEntry	  *entry;
 	TpPostingList		  *posting_list;
-	TpPostingEntry		  *entries;
 	TpPostingData		  *data;
+	uint32				  *doc_seqs;
+	dsa_area			  *dsa = cs->state->dsa;
 	size_t				   term_len;
 	int32				   count;
 	int32				   doc_freq;
@@ -111,23 +129,35 @@ cache_get_postings(TpDataSource *source, const char *term)
 	LWLockAcquire(&posting_list->lock, LW_SHARED);
 	count	 = posting_list->doc_count;
 	doc_freq = posting_list->doc_freq;
-	if (count <= 0 || !DsaPointerIsValid(posting_list->entries_dp))
+	if (count <= 0)
 	{
 		LWLockRelease(&posting_list->lock);
 		return NULL;
 	}
-	entries = (TpPostingEntry *)
-			dsa_get_address(cs->state->dsa, posting_list->entries_dp);
 
-	data		   = tp_alloc_posting_data(count);
-	data->count	   = count;
-	data->doc_freq = doc_freq;
+	data			  = tp_alloc_posting_data(count);
+	data->doc_lengths = (int32 *)palloc(count * sizeof(int32));
+	data->count		  = count;
+	data->doc_freq	  = doc_freq;
+	doc_seqs		  = (uint32 *)palloc(count * sizeof(uint32));
+	tp_posting_list_read(dsa, posting_list, doc_seqs, data->frequencies);
 	for (i = 0; i < count; i++)
 	{
-		data->ctids[i]		 = entries[i].ctid;
-		data->frequencies[i] = entries[i].frequency;
+		TpDocChunk *chunk;
+		uint32		slot;
+
+		/*
+		 * Postings are appended after their doc store slot is
+		 * published, and the posting-list lock orders us after
+		 * that append.
+		 */
+		chunk = tp_doc_store_chunk(dsa, cs->memtable, doc_seqs[i]);
+		slot  = doc_seqs[i] % TP_CACHE_DOC_CHUNK_DOCS;
+		data->ctids[i]		 = chunk->ctids[slot];
+		data->doc_lengths[i] = chunk->doc_lengths[slot];
 	}
 	LWLockRelease(&posting_list->lock);
+	pfree(doc_seqs);
 
 	return data;
 }
@@ -139,12 +169,53 @@ cache_free_postings(TpDataSource *source, TpPostingData *data)
 	tp_free_posting_data(data);
 }
 
+typedef struct CacheCtidEntry
+{
+	ItemPointerData ctid;
+	uint32			doc_seq;
+} CacheCtidEntry;
+
+/*
+ * Map a CTID to its doc store slot.  The store is indexed by
+ * sequence number only, so the first call builds a backend-local
+ * hash over the slots visible to this source.
+ */
 static int32
 cache_get_doc_length(TpDataSource *source, ItemPointer ctid)
 {
-	TpMemtableCacheSource *cs = (TpMemtableCacheSource *)source;
+	TpMemtableCacheSource *cs  = (TpMemtableCacheSource *)source;
+	dsa_area			  *dsa = cs->state->dsa;
+	CacheCtidEntry		  *entry;
+
+	if (cs->ctid_ht == NULL)
+	{
+		HASHCTL info;
+
+		memset(&info, 0, sizeof(info));
+		info.keysize   = sizeof(ItemPointerData);
+		info.entrysize = sizeof(CacheCtidEntry);
+		info.hcxt	   = GetMemoryChunkContext(cs);
+		cs->ctid_ht	   = hash_create(
+				   "pg_textsearch cache source: ctid map",
+				   Max(cs->doc_count, 16),
+				   &info,
+				   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+		for (uint32 seq = 0; seq < cs->doc_count; seq++)
+		{
+			ItemPointerData seq_ctid;
+
+			seq_ctid = tp_doc_store_ctid(dsa, cs->memtable, seq);
+			entry	 = (CacheCtidEntry *)
+					hash_search(cs->ctid_ht, &seq_ctid, HASH_ENTER, NULL);
+			entry->doc_seq = seq;
+		}
+	}
 
-	return tp_get_document_length_attached(cs->doclength_table, ctid);
+	entry = (CacheCtidEntry *)hash_search(cs->ctid_ht, ctid, HASH_FIND, NULL);
+	if (entry == NULL)
+		return -1;
+	return tp_doc_store_length(dsa, cs->memtable, entry->doc_seq);
 }
 
 static uint32
@@ -186,10 +257,10 @@ cache_close(TpDataSource *source)
 		dshash_detach(cs->string_table);
 		cs->string_table = NULL;
 	}
-	if (cs->doclength_table != NULL)
+	if (cs->ctid_ht != NULL)
 	{
-		dshash_detach(cs->doclength_table);
-		cs->doclength_table = NULL;
+		hash_destroy(cs->ctid_ht);
+		cs->ctid_ht = NULL;
 	}
 
 	if (cs->holding_cache_lock)
@@ -219,27 +290,29 @@ static const TpDataSourceOps cache_source_ops = {
 /* ---------- helpers ---------- */
 
 /*
- * Walk the doclength dshash once to compute corpus totals
- * (doc count + sum of lengths).  The caller holds cache.lock
- * SHARED, which keeps the table stable; the per-bucket locks
- * are taken by dshash_seq itself.
+ * Sum the doc store's length column over the slots this source
+ * sees to compute corpus totals.  The caller holds cache.lock
+ * SHARED, which keeps the chunks in place; an applier appending
+ * concurrently only writes slots at or past cs->doc_count.
  */
 static void
 compute_corpus_totals(
 		TpMemtableCacheSource *cs, int32 *out_total_docs, int64 *out_total_len)
 {
-	dshash_seq_status seq;
-	TpDocLengthEntry *entry;
-	uint32			  count	  = 0;
-	uint64			  sum_len = 0;
+	dsa_area *dsa	  = cs->state->dsa;
+	uint32	  count	  = cs->doc_count;
+	uint64	  sum_len = 0;
+	uint32	  seq	  = 0;
 
-	dshash_seq_init(&seq, cs->doclength_table, false);
-	while ((entry = (TpDocLengthEntry *)dshash_seq_next(&seq)) != NULL)
+	while (seq < count)
 	{
-		count++;
-		sum_len += (uint32)entry->doc_length;
+		TpDocChunk *chunk = tp_doc_store_chunk(dsa, cs->memtable, seq);
+		uint32		slot  = seq % TP_CACHE_DOC_CHUNK_DOCS;
+		uint32		end	  = Min(TP_CACHE_DOC_CHUNK_DOCS, slot + (count - seq));
+
+		for (; slot < end; slot++, seq++)
+			sum_len += (uint32)chunk->doc_lengths[slot];
 	}
-	dshash_seq_term(&seq);
 
 	*out_total_docs = (count > (uint32)PG_INT32_MAX) ? PG_INT32_MAX
 													 : (int32)count;
@@ -362,8 +435,8 @@ tp_memtable_cache_source_create(
 	 * Mirror chain_source's lock-ownership convention: remember
 	 * whether *we* acquired the per-index lock, so close() only
 	 * releases what we acquired.  If an outer caller already
-	 * holds it (e.g., the scan layer), we must not release on
-	 * close.
+	 * holds it (e.g., the index snapshot capture), we must not
+	 * release on close.
 	 */
 	if (state->lock_held)
 		lock_state_to_release = NULL;
@@ -400,7 +473,7 @@ tp_memtable_cache_source_create(
 	cs->lock_state		   = lock_state_to_release;
 	cs->holding_cache_lock = false;
 	cs->string_table	   = NULL;
-	cs->doclength_table	   = NULL;
+	cs->ctid_ht			   = NULL;
 
 	PG_TRY();
 	{
@@ -418,8 +491,7 @@ tp_memtable_cache_source_create(
 		 * we already returned from catchup_cache with OK, so any
 		 * invalidation is structural.
 		 */
-		if (memtable->string_hash_handle == DSHASH_HANDLE_INVALID ||
-			memtable->doc_lengths_handle == DSHASH_HANDLE_INVALID)
+		if (memtable->string_hash_handle == DSHASH_HANDLE_INVALID)
 			ereport(ERROR,
 					(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
 					 errmsg("pg_textsearch cache_source: dshash handles "
@@ -429,8 +501,7 @@ tp_memtable_cache_source_create(
 
 		cs->string_table = tp_string_table_attach(
 				state->dsa, memtable->string_hash_handle);
-		cs->doclength_table = tp_doclength_table_attach(
-				state->dsa, memtable->doc_lengths_handle);
+		cs->doc_count = tp_doc_store_count(memtable);
 
 		compute_corpus_totals(cs, &cs->base.total_docs, &cs->base.total_len);
 	}
@@ -438,8 +509,6 @@ tp_memtable_cache_source_create(
 	{
 		if (cs->string_table != NULL)
 			dshash_detach(cs->string_table);
-		if (cs->doclength_table != NULL)
-			dshash_detach(cs->doclength_table);
 		if (cs->holding_cache_lock)
 			LWLockRelease(&memtable->lock);
 		if (lock_state_to_release != NULL)
@@ -512,6 +581,18 @@ tp_memtable_source_create_for_read(
 				state, rel, query_terms, query_term_count);
 	}
 
+	/*
+	 * Record demand before knowing whether the cache can serve it:
+	 * a fallback read is exactly the one a warm cache would have
+	 * saved, so it must count toward keeping (or rebuilding) it.
+	 * The statement timestamp is cheap and precise enough for an
+	 * idle-time estimate.
+	 */
+	pg_atomic_fetch_add_u64(&state->shared->cache_access_count, 1);
+	pg_atomic_write_u64(
+			&state->shared->cache_last_access,
+			(uint64)GetCurrentStatementStartTimestamp());
+
 	src = tp_memtable_cache_source_create(
 			state, rel, query_terms, query_term_count);
 	if (src != NULL)
@@ -46,7 +46,8 @@
  * On success the returned source holds:
  *   - the per-index LWLock at SHARED (acquired here if not already held)
  *   - cache.lock at SHARED (acquired here, released in close)
- *   - dshash attachments for the string and doc-length tables
+ *   - a dshash attachment for the string table (doc lengths are
+ *     read from the dense doc store, which needs no attachment)
  *
  * Returns NULL when the cache cannot serve the query — either
  * because the GUC is disabled, the per-index cache state is
@@ -474,19 +474,19 @@ tp_memtable_chain_source_create(
 	 * otherwise rip chain pages out from under us.
 	 *
 	 * Lock ownership: if the caller already held the lock (e.g.,
-	 * scan.c acquires SHARED for the whole scan and we're being
-	 * created from inside that scope), tp_acquire_index_lock is a
-	 * no-op and *we* must not release on close — otherwise the
-	 * outer caller would suddenly be operating without the lock.
-	 * We remember whether we ourselves grabbed the lock; close()
-	 * releases only when we own the acquisition.  Releasing
-	 * eagerly in close() (instead of deferring to the xact-end
-	 * callback) is required because the LWLock memory lives in
-	 * the shared DSA region, which is freed by
+	 * tp_index_snapshot_capture acquires SHARED around the whole
+	 * capture and we're being created from inside that scope),
+	 * tp_acquire_index_lock is a no-op and *we* must not release on
+	 * close — otherwise the outer caller would suddenly be operating
+	 * without the lock.  We remember whether we ourselves grabbed
+	 * the lock; close() releases only when we own the acquisition.
+	 * Releasing eagerly in close() (instead of deferring to the
+	 * xact-end callback) is required because the LWLock memory lives
+	 * in the shared DSA region, which is freed by
 	 * tp_cleanup_index_shared_memory() when an index is dropped
-	 * (including ON COMMIT DROP on a temp table); leaving the
-	 * lock held past the source's lifetime risks the
-	 * LWLockReleaseAll() at xact-end dereferencing freed memory.
+	 * (including ON COMMIT DROP on a temp table); leaving the lock
+	 * held past the source's lifetime risks the LWLockReleaseAll()
+	 * at xact-end dereferencing freed memory.
 	 */
 	if (state->lock_held)
 		lock_state_to_release = NULL;
@@ -87,7 +87,8 @@ extern uint32 tp_memtable_chain_source_page_count(TpDataSource *src);
 /*
  * Extract a sorted term dictionary + finalized doc map from a
  * chain source.  Used by the spill path (`tp_do_spill`) to feed
- * `tp_write_segment` without re-walking the chain pages.
+ * `tp_write_segment` without re-walking the chain pages, when the
+ * memtable cache can't serve it (see tp_cache_extract_for_spill).
  *
  * The output arrays live in `dest_mcxt` and survive the source's
  * `close()`.  Each TermInfo's `term`, `ctids`, and `freqs` are
@@ -47,6 +47,7 @@
 #include "index/freepage.h"
 #include "index/metapage.h"
 #include "index/resolve.h"
+#include "index/result_cache.h"
 #include "index/state.h"
 #include "memtable/log.h"
 #include "memtable/page.h"
@@ -775,6 +776,10 @@ tp_spill_finalize(
 		UnlockReleaseBuffer(seg_buf);
 	UnlockReleaseBuffer(metabuf);
 
+	/* Cached top-k results predate the new segment */
+	if (local_state != NULL && local_state->shared != NULL)
+		tp_result_cache_invalidate(local_state->shared, false);
+
 	/*
 	 * Step 2: drop the in-memory cache's dshash tables.
 	 *
@@ -988,6 +993,10 @@ tp_add_document_terms(
 {
 	tp_memtable_append(rel, ctid, doc_length, vector_bytes, vector_len);
 
+	/* After the append, so no scan caches a ranking without it */
+	if (local_state->shared != NULL)
+		tp_result_cache_invalidate(local_state->shared, false);
+
 	/* Track terms added in this transaction for bulk load detection. */
 	local_state->terms_added_this_xact += term_count;
 }
@@ -2,7 +2,7 @@
  * Copyright (c) 2025-2026 Tiger Data, Inc.
  * Licensed under the PostgreSQL License. See LICENSE for details.
  *
- * posting.c — posting list and doclength table management for
+ * posting.c — posting list and dense doc store management for
  * the in-memory memtable cache.  See docs/memtable_cache.md.
  */
 #include <postgres.h>
@@ -15,19 +15,19 @@
 #include <utils/hsearch.h>
 #include <utils/memutils.h>
 
-#include "common/hashfn.h"
 #include "constants.h"
 #include "index/metapage.h"
 #include "index/registry.h"
 #include "index/state.h"
 #include "memtable/posting.h"
 #include "memtable/stringtable.h"
+#include "types/vector.h"
 
 /* Configuration parameters */
 int tp_posting_list_growth_factor = TP_POSTING_LIST_GROWTH_FACTOR;
 
 /*
- * Free a posting list and its entries array
+ * Free a posting list, its sealed blocks and its tail array
  */
 void
 tp_free_posting_list(dsa_area *area, dsa_pointer posting_list_dp)
@@ -39,6 +39,17 @@ tp_free_posting_list(dsa_area *area, dsa_pointer posting_list_dp)
 
 	posting_list = (TpPostingList *)dsa_get_address(area, posting_list_dp);
 
+	/* Free sealed blocks, oldest first */
+	while (DsaPointerIsValid(posting_list->blocks_head_dp))
+	{
+		TpPostingBlock *block = (TpPostingBlock *)
+				dsa_get_address(area, posting_list->blocks_head_dp);
+		dsa_pointer next_dp = block->next_dp;
+
+		dsa_free(area, posting_list->blocks_head_dp);
+		posting_list->blocks_head_dp = next_dp;
+	}
+
 	/* Free entries array if it exists */
 	if (DsaPointerIsValid(posting_list->entries_dp))
 		dsa_free(area, posting_list->entries_dp);
@@ -66,7 +77,7 @@ tp_get_posting_entries(dsa_area *area, TpPostingList *posting_list)
 	 * If memory was freed by tp_dsa_free, it will be filled with
 	 * 0xDD sentinel pattern. Detecting this indicates use-after-free.
 	 */
-	if (entries && posting_list->doc_count > 0)
+	if (entries && posting_list->doc_count > posting_list->sealed_count)
 	{
 		unsigned char *check = (unsigned char *)entries;
 		bool		   looks_freed =
@@ -105,38 +116,159 @@ tp_alloc_posting_list(dsa_area *dsa)
 	/* Initialize posting list */
 	memset(posting_list, 0, sizeof(TpPostingList));
 	LWLockInitialize(&posting_list->lock, TP_TRANCHE_POSTING_LOCK);
-	posting_list->doc_count	 = 0;
-	posting_list->capacity	 = 0;
-	posting_list->is_sorted	 = false;
-	posting_list->doc_freq	 = 0;
-	posting_list->entries_dp = InvalidDsaPointer;
+	posting_list->doc_count		 = 0;
+	posting_list->sealed_count	 = 0;
+	posting_list->capacity		 = 0;
+	posting_list->is_sorted		 = false;
+	posting_list->doc_freq		 = 0;
+	posting_list->entries_dp	 = InvalidDsaPointer;
+	posting_list->blocks_head_dp = InvalidDsaPointer;
+	posting_list->blocks_tail_dp = InvalidDsaPointer;
 
 	return posting_list_dp;
 }
 
 /*
- * Add a document entry to a posting list - simplified
+ * Compress the full open tail into a new sealed block at the end
+ * of the chain and empty the tail.  The tail array is kept for
+ * reuse.  Caller holds the posting list lock EXCL.
+ *
+ * Returns how many bytes smaller the block is than the tail
+ * entries it replaces, for the cache's memory accounting.
  */
-void
+static uint64
+seal_posting_tail(dsa_area *area, TpPostingList *posting_list)
+{
+	uint8			buf[TP_POSTING_BLOCK_ENTRIES *
+						TP_POSTING_BLOCK_MAX_ENTRY_BYTES];
+	TpPostingEntry *entries;
+	TpPostingBlock *block;
+	dsa_pointer		block_dp;
+	int32			count;
+	uint32			prev;
+	size_t			nbytes = 0;
+	size_t			tail_bytes;
+	size_t			block_bytes;
+
+	count = posting_list->doc_count - posting_list->sealed_count;
+	Assert(count > 0 && count <= TP_POSTING_BLOCK_ENTRIES);
+
+	entries = tp_get_posting_entries(area, posting_list);
+	prev	= entries[0].doc_seq;
+	for (int32 i = 0; i < count; i++)
+	{
+		Assert(entries[i].doc_seq >= prev);
+		nbytes += tpvector_varint_encode(entries[i].doc_seq - prev,
+										 buf + nbytes);
+		nbytes += tpvector_varint_encode((uint32)entries[i].frequency,
+										 buf + nbytes);
+		prev = entries[i].doc_seq;
+	}
+
+	block_dp = dsa_allocate(area, offsetof(TpPostingBlock, data) + nbytes);
+	if (!DsaPointerIsValid(block_dp))
+		elog(ERROR, "Failed to allocate posting block in DSA");
+
+	block			 = (TpPostingBlock *)dsa_get_address(area, block_dp);
+	block->next_dp	 = InvalidDsaPointer;
+	block->first_seq = entries[0].doc_seq;
+	block->count	 = (uint16)count;
+	block->nbytes	 = (uint16)nbytes;
+	memcpy(block->data, buf, nbytes);
+
+	if (DsaPointerIsValid(posting_list->blocks_tail_dp))
+	{
+		TpPostingBlock *last = (TpPostingBlock *)
+				dsa_get_address(area, posting_list->blocks_tail_dp);
+
+		last->next_dp = block_dp;
+	}
+	else
+		posting_list->blocks_head_dp = block_dp;
+	posting_list->blocks_tail_dp = block_dp;
+	posting_list->sealed_count += count;
+
+	tail_bytes	= (size_t)count * sizeof(TpPostingEntry);
+	block_bytes = offsetof(TpPostingBlock, data) + nbytes;
+	return tail_bytes > block_bytes ? tail_bytes - block_bytes : 0;
+}
+
+int32
+tp_posting_list_read(
+		dsa_area	  *area,
+		TpPostingList *posting_list,
+		uint32		  *doc_seqs,
+		int32		  *frequencies)
+{
+	dsa_pointer		block_dp = posting_list->blocks_head_dp;
+	TpPostingEntry *entries;
+	int32			n = 0;
+
+	while (DsaPointerIsValid(block_dp))
+	{
+		TpPostingBlock *block = (TpPostingBlock *)
+				dsa_get_address(area, block_dp);
+		const uint8 *cur = block->data;
+		const uint8 *end = block->data + block->nbytes;
+		uint32		 seq = block->first_seq;
+
+		for (int i = 0; i < block->count; i++)
+		{
+			seq += tpvector_varint_decode(&cur, end);
+			doc_seqs[n]	   = seq;
+			frequencies[n] = (int32)tpvector_varint_decode(&cur, end);
+			n++;
+		}
+		block_dp = block->next_dp;
+	}
+	Assert(n == posting_list->sealed_count);
+
+	entries = tp_get_posting_entries(area, posting_list);
+	for (int32 i = 0; i < posting_list->doc_count - posting_list->sealed_count;
+		 i++)
+	{
+		doc_seqs[n]	   = entries[i].doc_seq;
+		frequencies[n] = entries[i].frequency;
+		n++;
+	}
+
+	return n;
+}
+
+/*
+ * Add a document entry to a posting list.  A full tail is sealed
+ * first; otherwise the tail grows geometrically up to
+ * TP_POSTING_BLOCK_ENTRIES.  Returns the bytes a seal saved (see
+ * seal_posting_tail), 0 when nothing was sealed.
+ */
+uint64
 tp_add_document_to_posting_list(
 		TpLocalIndexState *local_state,
 		TpPostingList	  *posting_list,
-		ItemPointer		   ctid,
+		uint32			   doc_seq,
 		int32			   frequency)
 {
 	TpPostingEntry *entries;
 	TpPostingEntry *new_entry;
 	dsa_pointer		new_entries_dp;
+	int32			tail_count;
+	uint64			saved = 0;
 
 	Assert(local_state != NULL);
 	Assert(posting_list != NULL);
-	Assert(ItemPointerIsValid(ctid));
 
 	if (!local_state->is_build_mode)
 		LWLockAcquire(&posting_list->lock, LW_EXCLUSIVE);
 
-	/* Expand array if needed */
-	if (posting_list->doc_count >= posting_list->capacity)
+	tail_count = posting_list->doc_count - posting_list->sealed_count;
+	if (tail_count >= TP_POSTING_BLOCK_ENTRIES)
+	{
+		saved	   = seal_posting_tail(local_state->dsa, posting_list);
+		tail_count = 0;
+	}
+
+	/* Expand the tail if needed */
+	if (tail_count >= posting_list->capacity)
 	{
 		int32 new_capacity;
 		Size  new_size;
@@ -155,6 +287,7 @@ tp_add_document_to_posting_list(
 			new_capacity = posting_list->capacity *
 						   tp_posting_list_growth_factor;
 		}
+		new_capacity = Min(new_capacity, TP_POSTING_BLOCK_ENTRIES);
 		new_size = (Size)new_capacity * sizeof(TpPostingEntry);
 
 		new_entries_dp = dsa_allocate(local_state->dsa, new_size);
@@ -162,8 +295,7 @@ tp_add_document_to_posting_list(
 			elog(ERROR, "Failed to allocate posting entries in DSA");
 
 		/* Copy existing entries if any */
-		if (posting_list->doc_count > 0 &&
-			DsaPointerIsValid(posting_list->entries_dp))
+		if (tail_count > 0 && DsaPointerIsValid(posting_list->entries_dp))
 		{
 			TpPostingEntry *old_entries =
 					tp_get_posting_entries(local_state->dsa, posting_list);
@@ -171,7 +303,7 @@ tp_add_document_to_posting_list(
 					dsa_get_address(local_state->dsa, new_entries_dp);
 			memcpy(new_entries,
 				   old_entries,
-				   posting_list->doc_count * sizeof(TpPostingEntry));
+				   tail_count * sizeof(TpPostingEntry));
 
 			dsa_free(local_state->dsa, posting_list->entries_dp);
 		}
@@ -181,9 +313,9 @@ tp_add_document_to_posting_list(
 	}
 
 	/* Add new document entry */
-	entries			= tp_get_posting_entries(local_state->dsa, posting_list);
-	new_entry		= &entries[posting_list->doc_count];
-	new_entry->ctid = *ctid;
+	entries				 = tp_get_posting_entries(local_state->dsa, posting_list);
+	new_entry			 = &entries[tail_count];
+	new_entry->doc_seq	 = doc_seq;
 	new_entry->frequency = frequency;
 
 	posting_list->doc_count++;
@@ -192,166 +324,88 @@ tp_add_document_to_posting_list(
 
 	if (!local_state->is_build_mode)
 		LWLockRelease(&posting_list->lock);
-}
-
-/*
- * Hash function for document length entries (CTID-based)
- */
-static dshash_hash
-tp_doclength_hash_function(const void *key, size_t keysize, void *arg)
-{
-	const ItemPointer ctid = (const ItemPointer)key;
-
-	Assert(keysize == sizeof(ItemPointerData));
-	(void)keysize;
-	(void)arg;
-
-	/* Hash both block number and offset */
-	return hash_bytes((const unsigned char *)ctid, sizeof(ItemPointerData));
-}
-
-/*
- * Compare function for document length entries (CTID comparison)
- */
-static int
-tp_doclength_compare_function(
-		const void *a, const void *b, size_t keysize, void *arg)
-{
-	const ItemPointer ctid_a = (const ItemPointer)a;
-	const ItemPointer ctid_b = (const ItemPointer)b;
-
-	Assert(keysize == sizeof(ItemPointerData));
-	(void)keysize;
-	(void)arg;
-
-	return ItemPointerCompare(ctid_a, ctid_b);
-}
-
-/*
- * Copy function for document length entries (CTID copy)
- */
-static void
-tp_doclength_copy_function(
-		void *dest, const void *src, size_t keysize, void *arg)
-{
-	Assert(keysize == sizeof(ItemPointerData));
-	(void)keysize;
-	(void)arg;
-
-	*((ItemPointer)dest) = *((const ItemPointer)src);
-}
-
-/*
- * Create document length hash table
- */
-dshash_table *
-tp_doclength_table_create(dsa_area *area)
-{
-	dshash_parameters params;
-
-	params.key_size			= sizeof(ItemPointerData);
-	params.entry_size		= sizeof(TpDocLengthEntry);
-	params.hash_function	= tp_doclength_hash_function;
-	params.compare_function = tp_doclength_compare_function;
-	params.copy_function	= tp_doclength_copy_function;
-	params.tranche_id		= TP_DOCLENGTH_HASH_TRANCHE_ID;
-
-	return dshash_create(area, &params, area);
-}
-
-/*
- * Attach to existing document length hash table
- */
-dshash_table *
-tp_doclength_table_attach(dsa_area *area, dshash_table_handle handle)
-{
-	dshash_parameters params;
-
-	params.key_size			= sizeof(ItemPointerData);
-	params.entry_size		= sizeof(TpDocLengthEntry);
-	params.hash_function	= tp_doclength_hash_function;
-	params.compare_function = tp_doclength_compare_function;
-	params.copy_function	= tp_doclength_copy_function;
-	params.tranche_id		= TP_DOCLENGTH_HASH_TRANCHE_ID;
 
-	return dshash_attach(area, &params, handle, area);
+	return saved;
 }
 
 /*
- * Reserve the doc-length slot for `ctid` in the document length hash
- * table. Returns true if the entry is newly inserted (caller now
- * owns the addition of this doc to the cache), false if an entry
- * for `ctid` was already present.
+ * Append a document to the dense doc store.
  *
- * Used as the idempotency gate in tp_cache_apply_document so that
- * concurrent cache appliers cannot double-add the same CTID into
- * the cache.  The doc-length table is the gate (rather than a
- * separate "seen" set) so we get insert + dedup in a single
- * dshash op under the partition lock.
+ * Only one applier runs at a time (cache.apply_lock EXCL), so
+ * the slot is ours without an atomic increment.  Readers holding
+ * cache.lock SHARED may be indexing earlier slots concurrently:
+ * chunks are never moved, and the new slot becomes visible only
+ * through the doc_count store that follows the write barrier.
  */
 bool
-tp_store_document_length(
-		TpLocalIndexState *local_state, ItemPointer ctid, int32 doc_length)
+tp_doc_store_append(
+		TpLocalIndexState *local_state,
+		ItemPointer		   ctid,
+		int32			   doc_length,
+		uint32			  *out_seq)
 {
-	TpMemtable		 *memtable;
-	dshash_table	 *doclength_table;
-	TpDocLengthEntry *entry;
-	bool			  found;
+	TpMemtable *memtable;
+	TpDocChunk *chunk;
+	uint32		seq;
+	uint32		chunk_idx;
 
 	Assert(local_state != NULL);
-	Assert(ctid != NULL);
+	Assert(ItemPointerIsValid(ctid));
 
 	memtable = get_memtable(local_state);
 	if (!memtable)
 		elog(ERROR, "Cannot get memtable - index state corrupted");
 
-	/* Initialize document length table if needed */
-	if (memtable->doc_lengths_handle == DSHASH_HANDLE_INVALID)
-	{
-		doclength_table = tp_doclength_table_create(local_state->dsa);
-		memtable->doc_lengths_handle = dshash_get_hash_table_handle(
-				doclength_table);
-	}
-	else
+	seq		  = pg_atomic_read_u32(&memtable->doc_count);
+	chunk_idx = seq / TP_CACHE_DOC_CHUNK_DOCS;
+	if (chunk_idx >= TP_CACHE_DOC_MAX_CHUNKS)
+		return false;
+
+#ifdef USE_ASSERT_CHECKING
+	/* A record applied twice lands in consecutive slots */
+	if (seq > 0)
 	{
-		doclength_table = tp_doclength_table_attach(
-				local_state->dsa, memtable->doc_lengths_handle);
+		ItemPointerData prev;
+
+		prev = tp_doc_store_ctid(local_state->dsa, memtable, seq - 1);
+		Assert(!ItemPointerEquals(ctid, &prev));
 	}
+#endif
 
-	entry = (TpDocLengthEntry *)
-			dshash_find_or_insert(doclength_table, ctid, &found);
-	if (!found)
+	if (!DsaPointerIsValid(memtable->doc_chunks[chunk_idx]))
 	{
-		entry->ctid		  = *ctid;
-		entry->doc_length = doc_length;
+		dsa_pointer chunk_dp;
+
+		chunk_dp = dsa_allocate(local_state->dsa, sizeof(TpDocChunk));
+		if (!DsaPointerIsValid(chunk_dp))
+			elog(ERROR, "Failed to allocate doc store chunk in DSA");
+		memtable->doc_chunks[chunk_idx] = chunk_dp;
 	}
 
-	dshash_release_lock(doclength_table, entry);
-	dshash_detach(doclength_table);
+	chunk = (TpDocChunk *)
+			dsa_get_address(local_state->dsa, memtable->doc_chunks[chunk_idx]);
+	chunk->doc_lengths[seq % TP_CACHE_DOC_CHUNK_DOCS] = doc_length;
+	chunk->ctids[seq % TP_CACHE_DOC_CHUNK_DOCS]		  = *ctid;
+
+	pg_write_barrier();
+	pg_atomic_write_u32(&memtable->doc_count, seq + 1);
 
-	return !found;
+	*out_seq = seq;
+	return true;
 }
 
 /*
- * Get document length using a pre-attached doclength table.
- * This is the optimized version for bulk lookups - avoids repeated
- * dshash_attach/detach overhead.
+ * Free the doc store chunks and reset doc_count.
  */
-int32
-tp_get_document_length_attached(
-		dshash_table *doclength_table, ItemPointer ctid)
+void
+tp_doc_store_clear(dsa_area *area, TpMemtable *memtable)
 {
-	TpDocLengthEntry *entry;
-
-	Assert(doclength_table != NULL);
-	Assert(ctid != NULL);
-
-	entry = (TpDocLengthEntry *)dshash_find(doclength_table, ctid, false);
-	if (entry)
+	for (int i = 0; i < TP_CACHE_DOC_MAX_CHUNKS; i++)
 	{
-		int32 doc_length = entry->doc_length;
-		dshash_release_lock(doclength_table, entry);
-		return doc_length;
+		if (!DsaPointerIsValid(memtable->doc_chunks[i]))
+			break;
+		dsa_free(area, memtable->doc_chunks[i]);
+		memtable->doc_chunks[i] = InvalidDsaPointer;
 	}
-	return -1; /* Not found */
-}
\ No newline at end of file
+	pg_atomic_write_u32(&memtable->doc_count, 0);
+}
@@ -2,20 +2,21 @@
  * Copyright (c) 2025-2026 Tiger Data, Inc.
  * Licensed under the PostgreSQL License. See LICENSE for details.
  *
- * posting.h — in-memory posting list + doclength entry types
+ * posting.h — in-memory posting list + dense doc store types
  *
  * The cache holds DSA-resident posting lists keyed by term, each
- * a sorted (after finalization) array of (ctid, frequency)
- * entries.  Mutated by the cache apply protocol from chain doc
- * records; queried by the cache TpDataSource.  The doclength
- * hash entry (TpDocLengthEntry) is colocated here because the
- * doclength table API + DSA storage are owned by this module.
- * See docs/memtable_cache.md.
+ * an append-ordered run of (doc_seq, frequency) entries held as
+ * compressed sealed blocks plus an uncompressed tail, and a
+ * dense doc store mapping doc_seq to (ctid, doc_length).  Mutated
+ * by the cache apply protocol from chain doc records; queried by
+ * the cache TpDataSource.  See docs/memtable_cache.md.
  */
 #pragma once
 
 #include <postgres.h>
 
+#include <port/atomics.h>
+#include <storage/itemptr.h>
 #include <storage/lwlock.h>
 #include <storage/spin.h>
 #include <utils/dsa.h>
@@ -25,30 +26,56 @@
 #include "memtable/posting_entry.h"
 
 /*
- * Posting list for a single term
- * Uses dynamic arrays with O(1) amortized inserts during building,
- * then sorts once at finalization for optimal query performance
+ * Posting list for a single term.
+ *
+ * Entries arrive in apply order, so doc_seq is strictly
+ * increasing along the list.  The newest entries sit in an
+ * uncompressed open tail (entries_dp) that grows geometrically up
+ * to TP_POSTING_BLOCK_ENTRIES; a full tail is sealed into a
+ * TpPostingBlock and appended to the block chain, after which the
+ * tail array is reused.  Read the list with tp_posting_list_read.
  */
 typedef struct TpPostingList
 {
-	LWLock		lock;		/* Per-posting-list concurrency */
-	int32		doc_count;	/* Length of the entries array */
-	int32		capacity;	/* Allocated array capacity */
-	bool		is_sorted;	/* True after final sort for queries */
-	int32		doc_freq;	/* Document frequency (for IDF calculation) */
-	dsa_pointer entries_dp; /* DSA pointer to TpPostingEntry array */
+	LWLock		lock;			/* Per-posting-list concurrency */
+	int32		doc_count;		/* Total entries, sealed + tail */
+	int32		sealed_count;	/* Entries in the block chain */
+	int32		capacity;		/* Allocated tail capacity */
+	bool		is_sorted;		/* True after final sort for queries */
+	int32		doc_freq;		/* Document frequency (for IDF calculation) */
+	dsa_pointer entries_dp;		/* DSA pointer to TpPostingEntry tail */
+	dsa_pointer blocks_head_dp; /* Oldest sealed TpPostingBlock */
+	dsa_pointer blocks_tail_dp; /* Newest sealed TpPostingBlock */
 } TpPostingList;
 
 /*
- * Document length entry for the dshash hash table.
- * Maps document CTID to its length for BM25 calculations.
+ * Sealed, compressed run of posting entries.  data holds, per
+ * entry, varint(doc_seq delta from the previous entry, or from
+ * first_seq for the first) followed by varint(frequency).
+ */
+typedef struct TpPostingBlock
+{
+	dsa_pointer next_dp;   /* Next (newer) block, or invalid */
+	uint32		first_seq; /* doc_seq of the first entry */
+	uint16		count;	   /* Entries encoded in data */
+	uint16		nbytes;	   /* Length of data */
+	uint8		data[FLEXIBLE_ARRAY_MEMBER];
+} TpPostingBlock;
+
+/* Worst-case encoded size of one entry: two 5-byte varints. */
+#define TP_POSTING_BLOCK_MAX_ENTRY_BYTES 10
+
+/*
+ * One chunk of the dense doc store.  Slot i holds the document
+ * with sequence number chunk_index * TP_CACHE_DOC_CHUNK_DOCS + i.
+ * The two arrays are kept separate so the scoring path (lengths
+ * only) touches 4 bytes per document.
  */
-typedef struct TpDocLengthEntry
+typedef struct TpDocChunk
 {
-	ItemPointerData ctid;		/* Key: Document heap tuple ID */
-	int32			doc_length; /* Value: Document length (sum of term
-								 * frequencies) */
-} TpDocLengthEntry;
+	int32			doc_lengths[TP_CACHE_DOC_CHUNK_DOCS];
+	ItemPointerData ctids[TP_CACHE_DOC_CHUNK_DOCS];
+} TpDocChunk;
 
 /* Array growth multiplier */
 extern int tp_posting_list_growth_factor;
@@ -59,35 +86,82 @@ extern void tp_free_posting_list(dsa_area *area, dsa_pointer posting_list_dp);
 extern TpPostingEntry *
 tp_get_posting_entries(dsa_area *area, TpPostingList *posting_list);
 
-extern void tp_add_document_to_posting_list(
+/*
+ * Decode the whole list, oldest first, into caller-supplied
+ * arrays of at least posting_list->doc_count elements.  Returns
+ * the number of entries written.  Caller holds the posting list
+ * lock (SHARED suffices).
+ */
+extern int32 tp_posting_list_read(
+		dsa_area	  *area,
+		TpPostingList *posting_list,
+		uint32		  *doc_seqs,
+		int32		  *frequencies);
+
+/*
+ * Append (doc_seq, frequency) to the open tail, sealing a full
+ * tail first.  Returns the bytes the seal saved over the tail
+ * entries it compressed, 0 when nothing was sealed.
+ */
+extern uint64 tp_add_document_to_posting_list(
 		TpLocalIndexState *local_state,
 		TpPostingList	  *posting_list,
-		ItemPointer		   ctid,
+		uint32			   doc_seq,
 		int32			   frequency);
 
-/* Document length hash table tranche ID */
-#define TP_DOCLENGTH_HASH_TRANCHE_ID (LWTRANCHE_FIRST_USER_DEFINED + 1)
+/*
+ * Append a document to the dense doc store and return its
+ * sequence number in *out_seq.  Returns false, storing nothing,
+ * when the chunk directory is full; the apply path treats that as
+ * a budget overrun.  Caller holds cache.apply_lock EXCL.
+ */
+extern bool tp_doc_store_append(
+		TpLocalIndexState *local_state,
+		ItemPointer		   ctid,
+		int32			   doc_length,
+		uint32			  *out_seq);
 
 /*
- * Reserve a doc-length slot for `ctid`. Returns true if newly
- * inserted, false if an entry for `ctid` was already present.
- * Acts as the idempotency gate in tp_cache_apply_document so
- * that concurrent appliers cannot double-add the same CTID.
+ * Free every doc store chunk and reset doc_count.  Same lock
+ * contract as tp_cache_clear.
  */
-extern bool tp_store_document_length(
-		TpLocalIndexState *local_state, ItemPointer ctid, int32 doc_length);
+extern void tp_doc_store_clear(dsa_area *area, TpMemtable *memtable);
 
 /*
- * Get document length using a pre-attached doclength table.
- * This avoids repeated dshash_attach/detach overhead when looking up
- * multiple document lengths.
+ * Number of documents readers may index.  Pairs with the write
+ * barrier in tp_doc_store_append.
  */
-extern int32 tp_get_document_length_attached(
-		dshash_table *doclength_table, ItemPointer ctid);
+static inline uint32
+tp_doc_store_count(TpMemtable *memtable)
+{
+	uint32 count = pg_atomic_read_u32(&memtable->doc_count);
+
+	pg_read_barrier();
+	return count;
+}
 
-extern dshash_table *tp_doclength_table_create(dsa_area *area);
-extern dshash_table *
-tp_doclength_table_attach(dsa_area *area, dshash_table_handle handle);
+/* Chunk holding `doc_seq`; doc_seq must be below doc_count. */
+static inline TpDocChunk *
+tp_doc_store_chunk(dsa_area *area, TpMemtable *memtable, uint32 doc_seq)
+{
+	Assert(doc_seq / TP_CACHE_DOC_CHUNK_DOCS < TP_CACHE_DOC_MAX_CHUNKS);
+	return (TpDocChunk *)dsa_get_address(
+			area, memtable->doc_chunks[doc_seq / TP_CACHE_DOC_CHUNK_DOCS]);
+}
+
+static inline int32
+tp_doc_store_length(dsa_area *area, TpMemtable *memtable, uint32 doc_seq)
+{
+	return tp_doc_store_chunk(area, memtable, doc_seq)
+			->doc_lengths[doc_seq % TP_CACHE_DOC_CHUNK_DOCS];
+}
+
+static inline ItemPointerData
+tp_doc_store_ctid(dsa_area *area, TpMemtable *memtable, uint32 doc_seq)
+{
+	return tp_doc_store_chunk(area, memtable, doc_seq)
+			->ctids[doc_seq % TP_CACHE_DOC_CHUNK_DOCS];
+}
 
 /* tp_calculate_idf lives in src/scoring/bm25.c; declared in
  * src/scoring/bm25.h.  Not re-declared here. */
@@ -13,38 +13,40 @@
 #include <utils/memutils.h>
 
 #include "index/limit.h"
-#include "index/metapage.h"
+#include "index/result_cache.h"
+#include "index/snapshot.h"
 #include "index/state.h"
 #include "memtable/scan.h"
 #include "scoring/bm25.h"
-#include "types/vector.h"
+#include "scoring/match.h"
+#include "types/query_terms.h"
 
 /*
- * Search the memtable (and segments) for documents matching the query vector.
+ * Search the memtable (and segments) for documents matching the query terms.
  * Returns true on success (results stored in scan opaque), false on failure.
  *
  * This is the main entry point called from am/scan.c during tp_gettuple.
+ * The per-index LWLock is held only while the index snapshot is
+ * captured; scoring itself runs lock-free against the snapshot.
  */
 bool
 tp_memtable_search(
 		IndexScanDesc	   scan,
 		TpLocalIndexState *index_state,
-		TpVector		  *query_vector,
-		TpIndexMetaPage	   metap)
+		TpQueryTerms	  *query_terms)
 {
-	TpScanOpaque  so = (TpScanOpaque)scan->opaque;
-	int			  max_results;
-	int			  result_count = 0;
-	float4		  k1_value;
-	float4		  b_value;
-	MemoryContext oldcontext;
-
-	/* Extract terms and frequencies from query vector */
-	char		 **query_terms;
-	int32		  *query_frequencies;
-	TpVectorEntry *entries_ptr;
-	int			   entry_count;
-	char		  *ptr;
+	TpScanOpaque	 so = (TpScanOpaque)scan->opaque;
+	int				 max_results;
+	int				 result_count = 0;
+	TpIndexSnapshot *snapshot;
+	TpMatchFilter	*filter = NULL;
+	float4			 min_score;
+	char		   **snapshot_terms;
+	int				 snapshot_term_count;
+	MemoryContext	 oldcontext;
+	int				 entry_count = query_terms->term_count;
+	TpResultCacheKey cache_key;
+	bool			 cacheable;
 
 	if (!so)
 		return false;
@@ -55,29 +57,6 @@ tp_memtable_search(
 	else
 		max_results = tp_default_limit;
 
-	entry_count		  = query_vector->entry_count;
-	query_terms		  = palloc(entry_count * sizeof(char *));
-	query_frequencies = palloc(entry_count * sizeof(int32));
-	entries_ptr		  = TPVECTOR_ENTRIES_PTR(query_vector);
-
-	/* Parse the query vector entries */
-	ptr = (char *)entries_ptr;
-	for (int i = 0; i < entry_count; i++)
-	{
-		TpVectorEntry	 *entry = (TpVectorEntry *)ptr;
-		TpVectorEntryView v;
-		char			 *term_str;
-
-		ptr = (char *)tpvector_entry_decode_advance(entry, &v);
-
-		term_str = palloc(v.lexeme_len + 1);
-		memcpy(term_str, v.lexeme, v.lexeme_len);
-		term_str[v.lexeme_len] = '\0';
-
-		query_terms[i]		 = term_str;
-		query_frequencies[i] = (int32)v.frequency;
-	}
-
 	/* Allocate result arrays in scan context */
 	oldcontext		 = MemoryContextSwitchTo(so->scan_context);
 	so->result_ctids = palloc(max_results * sizeof(ItemPointerData));
@@ -85,39 +64,151 @@ tp_memtable_search(
 	memset(so->result_ctids, 0, max_results * sizeof(ItemPointerData));
 	MemoryContextSwitchTo(oldcontext);
 
-	/* Extract values from metap */
-	Assert(metap != NULL);
-	k1_value = metap->k1;
-	b_value	 = metap->b;
-
 	Assert(index_state != NULL);
 	Assert(query_terms != NULL);
-	Assert(query_frequencies != NULL);
 	Assert(so->result_ctids != NULL);
 
+	/* Read before scoring: the batch is at least this new */
+	so->batch_generation =
+			pg_atomic_read_u64(&index_state->shared->result_generation);
+	so->batch_reusable = false;
+
+	/*
+	 * A ranking over the whole index may come from the shared result
+	 * cache; one restricted by match quals is always computed.
+	 */
+	cacheable = so->match_quals == NULL &&
+				tp_result_cache_key_init(
+						&cache_key,
+						index_state->shared,
+						RelationGetRelid(scan->indexRelation),
+						query_terms,
+						max_results);
+	if (cacheable)
+	{
+		so->result_scores = MemoryContextAlloc(
+				so->scan_context, max_results * sizeof(float4));
+		if (tp_result_cache_lookup(
+					&cache_key,
+					so->result_ctids,
+					so->result_scores,
+					&result_count))
+		{
+			so->topk_floor_short = false;
+			so->batch_reusable	 = true;
+			so->result_count	 = result_count;
+			so->current_pos		 = 0;
+			so->max_results_used = max_results;
+			return result_count > 0;
+		}
+		pfree(so->result_scores);
+		so->result_scores = NULL;
+	}
+
+	/*
+	 * Pin a consistent view of segments + memtable for these terms,
+	 * and for the terms of any match quals: their documents are the
+	 * only candidates, so they are matched against the same view.
+	 */
+	snapshot_terms		= query_terms->terms;
+	snapshot_term_count = entry_count;
+	if (so->match_quals != NULL)
+	{
+		char **qual_terms;
+		int	   qual_term_count;
+
+		qual_term_count =
+				tp_match_quals_terms(so->match_quals, &qual_terms);
+		snapshot_terms = palloc(
+				(entry_count + qual_term_count) * sizeof(char *));
+		memcpy(snapshot_terms,
+			   query_terms->terms,
+			   entry_count * sizeof(char *));
+		memcpy(snapshot_terms + entry_count,
+			   qual_terms,
+			   qual_term_count * sizeof(char *));
+		snapshot_term_count += qual_term_count;
+		pfree(qual_terms);
+	}
+
+	snapshot = tp_index_snapshot_capture(
+			index_state,
+			scan->indexRelation,
+			(const char *const *)snapshot_terms,
+			snapshot_term_count);
+
+	if (so->match_quals != NULL)
+		filter = tp_match_filter_build(
+				scan->indexRelation, snapshot, so->match_quals);
+
+	/* Rows scoring below the scan's floor never pass its filter */
+	min_score = so->score_floor;
+
+	/*
+	 * Prune against the best kth score a sibling partition's scan of
+	 * this query has found: the merge of the partitions needs nothing
+	 * below it unless rows are filtered out above the scan, which
+	 * tp_gettuple covers by re-scoring when the batch runs short.
+	 */
+	if (so->limit > 0 && !so->topk_share_off)
+	{
+		if (so->topk_share == NULL)
+		{
+			so->topk_share = tp_shared_topk_join(
+					so->query_context,
+					scan->heapRelation,
+					so->query_text,
+					so->limit);
+			if (so->topk_share == NULL)
+				so->topk_share_off = true;
+		}
+		min_score = Max(min_score, tp_shared_topk_threshold(so->topk_share));
+	}
+
 	/* Score documents using the unified scoring function */
 	result_count = tp_score_documents(
 			index_state,
 			scan->indexRelation,
-			query_terms,
-			query_frequencies,
+			snapshot,
+			query_terms->terms,
+			query_terms->frequencies,
 			entry_count,
-			k1_value,
-			b_value,
+			snapshot->k1,
+			snapshot->b,
 			max_results,
+			min_score,
+			filter,
 			so->result_ctids,
 			&so->result_scores);
 
+	/* Only a ranking no threshold has cut is complete */
+	if (cacheable && min_score == 0.0f)
+		tp_result_cache_store(
+				&cache_key, so->result_ctids, so->result_scores, result_count);
+
+	/*
+	 * Short of the limit, the batch may have been cut by the shared
+	 * threshold.  Cut by the scan's own floor, it is complete.
+	 */
+	so->topk_floor_short = min_score > so->score_floor &&
+						   result_count < max_results;
+	if (so->topk_share != NULL && !so->topk_share_off &&
+		result_count >= max_results)
+		tp_shared_topk_raise(
+				so->topk_share, so->result_scores[result_count - 1]);
+
+	if (filter != NULL)
+		tp_match_filter_free(filter);
+	tp_index_snapshot_release(snapshot);
+	if (snapshot_terms != query_terms->terms)
+		pfree(snapshot_terms);
+
+	/* Only a batch no threshold has cut can answer a later rescan */
+	so->batch_reusable = so->match_quals == NULL && min_score == 0.0f;
+
 	so->result_count	 = result_count;
 	so->current_pos		 = 0;
 	so->max_results_used = max_results;
 
-	/* Free the query terms array and individual term strings */
-	for (int i = 0; i < entry_count; i++)
-		pfree(query_terms[i]);
-
-	pfree(query_terms);
-	pfree(query_frequencies);
-
 	return result_count > 0;
 }
@@ -11,12 +11,11 @@
 #include <access/relscan.h>
 
 #include "access/am.h"
-#include "index/metapage.h"
 #include "index/state.h"
-#include "types/vector.h"
+#include "types/query_terms.h"
 
 /*
- * Search the memtable and segments for documents matching the query vector.
+ * Search the memtable and segments for documents matching the query terms.
  * Results are stored in the scan opaque structure.
  *
  * Returns true on success (at least one result), false otherwise.
@@ -24,5 +23,4 @@
 bool tp_memtable_search(
 		IndexScanDesc	   scan,
 		TpLocalIndexState *index_state,
-		TpVector		  *query_vector,
-		TpIndexMetaPage	   metap);
+		TpQueryTerms	  *query_terms);
@@ -284,16 +284,6 @@ tp_ensure_string_table_initialized(TpLocalIndexState *local_state)
 		memtable->string_hash_handle = dshash_get_hash_table_handle(table);
 		dshash_detach(table);
 	}
-
-	/* Initialize doc lengths hash table if needed */
-	if (memtable->doc_lengths_handle == DSHASH_HANDLE_INVALID)
-	{
-		table = tp_doclength_table_create(local_state->dsa);
-		if (!table)
-			elog(ERROR, "Failed to create doc length table");
-		memtable->doc_lengths_handle = dshash_get_hash_table_handle(table);
-		dshash_detach(table);
-	}
 }
 
 /*
@@ -387,37 +377,45 @@ tp_get_or_create_posting_list(TpLocalIndexState *local_state, const char *term)
 
 /*
  * tp_cache_apply_document — apply a single doc record into the
- * in-memory cache structures (string table, posting lists, doc-
- * length table).
+ * in-memory cache structures (string table, posting lists, dense
+ * doc store).
  *
  * Used by the cache apply protocol to bring the cache up to
  * date with the on-disk chain. The caller has already parsed a
  * (ctid, terms[], frequencies[], doc_length) tuple out of a
  * chain doc record.
  *
- * Idempotent by CTID: tp_store_document_length is the single
- * check-and-add gate.  If the CTID is already in the doclength
- * table (e.g., another applier raced us), we return without
- * touching the posting lists.  Corpus statistics
+ * Not idempotent: the caller holds cache.apply_lock EXCL and
+ * applies each chain record exactly once, at the cursor (the
+ * chain itself never repeats a CTID; chain_source treats that as
+ * corruption).  An error part-way through leaves the cache
+ * partially applied, which the apply paths handle by invalidating
+ * it.  Returns false, applying nothing, when the dense doc store
+ * is full.  *sealed_bytes receives what sealing full posting
+ * tails saved, for the caller to credit back.  Corpus statistics
  * (TpSharedIndexState.total_docs / total_len) are NOT updated
  * here — those are owned by the on-disk write path
  * (tp_add_document_terms in src/memtable/log.c) and reflect the
  * chain, not the cache.  Bulk-load counter is also untouched
  * for the same reason.
  */
-void
+bool
 tp_cache_apply_document(
 		TpLocalIndexState *local_state,
 		ItemPointer		   ctid,
 		char			 **terms,
 		int32			  *frequencies,
 		int				   term_count,
-		int32			   doc_length)
+		int32			   doc_length,
+		uint64			  *sealed_bytes)
 {
-	int i;
+	uint32 doc_seq;
+	int	   i;
 
-	if (!tp_store_document_length(local_state, ctid, doc_length))
-		return;
+	*sealed_bytes = 0;
+
+	if (!tp_doc_store_append(local_state, ctid, doc_length, &doc_seq))
+		return false;
 
 	for (i = 0; i < term_count; i++)
 	{
@@ -428,7 +426,9 @@ tp_cache_apply_document(
 		posting_list = tp_get_or_create_posting_list(local_state, terms[i]);
 
 		/* Add document entry to posting list */
-		tp_add_document_to_posting_list(
-				local_state, posting_list, ctid, frequency);
+		*sealed_bytes += tp_add_document_to_posting_list(
+				local_state, posting_list, doc_seq, frequency);
 	}
+
+	return true;
 }
@@ -76,16 +76,19 @@ extern void tp_ensure_string_table_initialized(TpLocalIndexState *local_state);
  * (source of truth).
  * This version applies an already-parsed record (terms +
  * frequencies + doc_length for a CTID) into the in-memory cache
- * structures (string interning table, posting lists, doclength
- * table).  Used by the cache apply protocol to bring the cache
- * up to date with the chain. */
-extern void tp_cache_apply_document(
+ * structures (string interning table, posting lists, dense doc
+ * store).  Used by the cache apply protocol to bring the cache
+ * up to date with the chain.  Returns false when the doc store
+ * is full.  *sealed_bytes receives the bytes saved by posting
+ * tails sealed along the way. */
+extern bool tp_cache_apply_document(
 		TpLocalIndexState *local_state,
 		ItemPointer		   ctid,
 		char			 **terms,
 		int32			  *frequencies,
 		int				   term_count,
-		int32			   doc_length);
+		int32			   doc_length,
+		uint64			  *sealed_bytes);
 
 /* LWLock tranche for string table locking */
 #define TP_STRING_HASH_TRANCHE_ID LWTRANCHE_FIRST_USER_DEFINED
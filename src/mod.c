@@ -24,11 +24,16 @@
 #include <utils/inval.h>
 
 #include "access/am.h"
+#include "access/bgworker.h"
+#include "access/build_parallel.h"
 #include "constants.h"
 #include "index/registry.h"
+#include "index/result_cache.h"
 #include "index/state.h"
 #include "planner/hooks.h"
 #include "scoring/bm25.h"
+#include "segment/merge.h"
+#include "segment/merge_throttle.h"
 
 #if PG_VERSION_NUM >= 180000
 PG_MODULE_MAGIC_EXT(.name = "pg_textsearch", .version = "1.5.0-dev");
@@ -39,6 +44,12 @@ PG_MODULE_MAGIC;
 /* Relation options for Tapir indexes */
 relopt_kind tp_relopt_kind;
 
+/* merge_policy reloption values; see TpMergePolicyKind */
+static relopt_enum_elt_def tp_merge_policy_relopt_values[] = {
+		{"level", TP_MERGE_POLICY_LEVEL},
+		{"tiered", TP_MERGE_POLICY_TIERED},
+		{(const char *)NULL}};
+
 /* External variable from limits module */
 extern int tp_default_limit;
 
@@ -60,9 +71,37 @@ int tp_bulk_load_threshold = TP_DEFAULT_BULK_LOAD_THRESHOLD;
  */
 int tp_memtable_pages_threshold = TP_DEFAULT_MEMTABLE_PAGES_THRESHOLD;
 
+/*
+ * Hand memtable_pages_threshold spills (and the compaction cascade
+ * they trigger) to the background worker instead of running them in
+ * the inserting transaction.  See src/access/bgworker.c.
+ */
+bool tp_background_spill = false;
+
 /* Global variable for segments per level before compaction */
 int tp_segments_per_level = TP_DEFAULT_SEGMENTS_PER_LEVEL;
 
+/*
+ * Workers that stream a segment merge's postings in parallel, split
+ * by term range (0 = serial).  See src/segment/merge_parallel.c.
+ */
+int tp_parallel_merge_workers = 0;
+
+/*
+ * Fan-in of the merge rounds that combine a parallel build's worker
+ * segments.  See src/access/build_parallel.c.
+ */
+int tp_parallel_build_merge_fanin = TP_DEFAULT_BUILD_MERGE_FANIN;
+
+/*
+ * Cost-based throttling of parallel build merge I/O, and the cluster-wide
+ * cap on concurrently running merges (0 = no cap).  See
+ * src/segment/merge_throttle.c.
+ */
+double tp_merge_cost_delay		= 0;
+int	   tp_merge_cost_limit		= TP_DEFAULT_MERGE_COST_LIMIT;
+int	   tp_max_concurrent_merges = 0;
+
 /* Global variable for segment compression (on by default - benchmarks show
  * compression improves both size and query performance)
  */
@@ -77,6 +116,35 @@ bool tp_compress_segments = true;
 bool   tp_filtered_seed		   = true;
 double tp_filtered_seed_margin = TP_DEFAULT_FILTERED_SEED_MARGIN;
 
+/*
+ * Cross-partition top-k threshold sharing: ranked scans of sibling
+ * partitions prune against the best kth score any of them has found
+ * (see tp_shared_topk_join).
+ */
+bool tp_shared_topk = true;
+
+/*
+ * Score comparison pushdown: a ranked scan filtered by a constant score
+ * bound stops at it (see push_score_floor in src/planner/hooks.c).
+ */
+bool tp_score_pushdown = true;
+
+/*
+ * Entries in each backend's cache of tokenized query texts
+ * (0 = disabled).  See src/types/query_terms.c.
+ */
+int tp_query_cache_size = TP_DEFAULT_QUERY_CACHE_SIZE;
+
+/*
+ * Shared top-k result cache: whether scans use it, its size in
+ * entries (fixed at server start, 0 = not allocated), and how old a
+ * result scans accept from before the index last changed.  See
+ * src/index/result_cache.c.
+ */
+bool tp_result_cache		   = false;
+int	 tp_result_cache_entries   = TP_DEFAULT_RESULT_CACHE_ENTRIES;
+int	 tp_result_cache_staleness = 0;
+
 /*
  * Memtable shared-memory cache enable flag.  Gates the read-path
  * chooser (tp_memtable_source_create_for_read) on the cache vs
@@ -262,6 +330,23 @@ _PG_init(void)
 			NULL,
 			NULL);
 
+	DefineCustomBoolVariable(
+			"pg_textsearch.background_spill",
+			"Spill the memtable from a background worker",
+			"When enabled, an insert that grows the memtable chain past "
+			"memtable_pages_threshold queues the spill and its level "
+			"compaction for the pg_textsearch background worker instead "
+			"of running them in the inserting transaction.  Inserts "
+			"still spill synchronously once the chain reaches four "
+			"times the threshold, or when the worker is unavailable.",
+			&tp_background_spill,
+			false,
+			PGC_SUSET,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
 	DefineCustomIntVariable(
 			"pg_textsearch.segments_per_level",
 			"Segments per level before compaction",
@@ -277,6 +362,92 @@ _PG_init(void)
 			NULL,
 			NULL);
 
+	DefineCustomIntVariable(
+			"pg_textsearch.parallel_merge_workers",
+			"Parallel workers per segment merge",
+			"Segment merges with many terms split the term range across "
+			"this many parallel workers, each streaming its terms' "
+			"postings to a temp file that the leader stitches into the "
+			"merged segment.  Also capped by "
+			"max_parallel_maintenance_workers.  Set to 0 to merge "
+			"serially.",
+			&tp_parallel_merge_workers,
+			0,						 /* default 0 (serial) */
+			0,						 /* min 0 */
+			TP_MAX_PARALLEL_WORKERS, /* max 32 */
+			PGC_SUSET,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomIntVariable(
+			"pg_textsearch.parallel_build_merge_fanin",
+			"Segments merged together per round of a parallel build",
+			"While the segments written by parallel build workers "
+			"outnumber this, workers and leader merge them into temp "
+			"files in parallel rounds of batches of at most this many; "
+			"the leader then merges what is left into the index.",
+			&tp_parallel_build_merge_fanin,
+			TP_DEFAULT_BUILD_MERGE_FANIN, /* default 8 */
+			2,							  /* min 2 */
+			64,							  /* max 64 */
+			PGC_SUSET,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomRealVariable(
+			"pg_textsearch.merge_cost_delay",
+			"Cost delay for parallel index build merge I/O, in milliseconds",
+			"The merges of a parallel CREATE INDEX charge the pages they "
+			"hit, read and dirty at vacuum_cost_page_hit, "
+			"vacuum_cost_page_miss and vacuum_cost_page_dirty, and sleep "
+			"this long once the charge reaches "
+			"pg_textsearch.merge_cost_limit.  Spills and merges under the "
+			"index lock are never throttled.  Set to 0 to run unthrottled.",
+			&tp_merge_cost_delay,
+			0,	   /* default 0 (off) */
+			0,	   /* min 0 */
+			100.0, /* max 100 ms, as vacuum_cost_delay */
+			PGC_SUSET,
+			GUC_UNIT_MS,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomIntVariable(
+			"pg_textsearch.merge_cost_limit",
+			"Cost accumulated by a parallel index build merge before it "
+			"sleeps",
+			"See pg_textsearch.merge_cost_delay.",
+			&tp_merge_cost_limit,
+			TP_DEFAULT_MERGE_COST_LIMIT, /* default 200 */
+			1,							 /* min 1 */
+			10000,						 /* max 10000 */
+			PGC_SUSET,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomIntVariable(
+			"pg_textsearch.max_concurrent_merges",
+			"Maximum segment merges running at once across the cluster",
+			"Automatic level compaction that finds every merge slot busy "
+			"is deferred to the next spill; bm25_force_merge waits for a "
+			"slot.  Set to 0 for no limit.",
+			&tp_max_concurrent_merges,
+			0,	  /* default 0 (no limit) */
+			0,	  /* min 0 */
+			1024, /* max 1024 */
+			PGC_SIGHUP,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
 	DefineCustomBoolVariable(
 			"pg_textsearch.compress_segments",
 			"Enable compression for new segment blocks",
@@ -325,6 +496,102 @@ _PG_init(void)
 			NULL,
 			NULL);
 
+	DefineCustomBoolVariable(
+			"pg_textsearch.shared_topk",
+			"Share the top-k threshold across partitions of a BM25 query.",
+			"When a LIMIT query ranks the partitions (or hypertable "
+			"chunks) of a table, each partition's scan skips documents "
+			"scoring below the kth score a sibling has already found, "
+			"and partitions that cannot reach it are not scored.  "
+			"Results are identical either way.",
+			&tp_shared_topk,
+			true, /* default on */
+			PGC_USERSET,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomBoolVariable(
+			"pg_textsearch.score_pushdown",
+			"Push constant BM25 score bounds down into index scans.",
+			"A query ranked by <@> whose WHERE clause bounds the same "
+			"score by a constant, as in (content <@> q) < -2.5, scores "
+			"no document below the bound, so the scan stops where the "
+			"bound does instead of ranking the rest of the index.  "
+			"Results are identical either way.",
+			&tp_score_pushdown,
+			true, /* default on */
+			PGC_USERSET,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomIntVariable(
+			"pg_textsearch.query_cache_size",
+			"Tokenized query texts cached by each backend.",
+			"BM25 scans look up the terms of their query text in a "
+			"backend-local cache of this many entries, least recently "
+			"used first out, instead of running the text search parser "
+			"and dictionaries again.  Set to 0 to disable.",
+			&tp_query_cache_size,
+			TP_DEFAULT_QUERY_CACHE_SIZE, /* default 4096 */
+			0,							 /* min 0 (disabled) */
+			1000000,					 /* max */
+			PGC_USERSET,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomBoolVariable(
+			"pg_textsearch.result_cache",
+			"Share the results of identical BM25 queries across backends.",
+			"Ranked scans with a LIMIT of at most 128 look up their "
+			"index, terms and limit in a shared-memory cache, and store "
+			"what they score.  An entry is used until its index next "
+			"changes.",
+			&tp_result_cache,
+			false, /* default off */
+			PGC_USERSET,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomIntVariable(
+			"pg_textsearch.result_cache_entries",
+			"Entries in the shared BM25 result cache.",
+			"Each entry takes about 1.6 kB of shared memory.  Set to 0 "
+			"to allocate no cache.",
+			&tp_result_cache_entries,
+			TP_DEFAULT_RESULT_CACHE_ENTRIES, /* default 1024 */
+			0,								 /* min 0 (disabled) */
+			1000000,						 /* max */
+			PGC_POSTMASTER,
+			0,
+			NULL,
+			NULL,
+			NULL);
+
+	DefineCustomIntVariable(
+			"pg_textsearch.result_cache_staleness",
+			"How old a cached BM25 result may be once its index changed.",
+			"A cached result computed before the latest insert, spill or "
+			"merge is still used if it is at most this old.  Results "
+			"never outlive a VACUUM of their index.  0 uses only "
+			"current results.",
+			&tp_result_cache_staleness,
+			0,		 /* default 0 */
+			0,		 /* min 0 */
+			3600000, /* max 1 hour */
+			PGC_USERSET,
+			GUC_UNIT_MS,
+			NULL,
+			NULL,
+			NULL);
+
 	DefineCustomBoolVariable(
 			"pg_textsearch.memtable_cache_enabled",
 			"Enable the in-memory memtable cache for queries.",
@@ -430,6 +697,32 @@ _PG_init(void)
 			0.0,
 			1.0,
 			NoLock);
+	add_enum_reloption(
+			tp_relopt_kind,
+			"merge_policy",
+			"Segment merge policy",
+			tp_merge_policy_relopt_values,
+			TP_MERGE_POLICY_LEVEL,
+			"Valid values are \"level\" and \"tiered\".",
+			ShareUpdateExclusiveLock);
+	add_int_reloption(
+			tp_relopt_kind,
+			"max_merged_segment_mb",
+			"Largest segment the tiered merge policy builds (0 = no limit)",
+			0,
+			0,
+			INT_MAX / 1024,
+			ShareUpdateExclusiveLock);
+	add_int_reloption(
+			tp_relopt_kind,
+			"merge_deletes_pct",
+			"Dead-document percentage that makes a segment due for "
+			"merging: at VACUUM under any merge policy, and at every "
+			"compaction check under the tiered policy (0 = never)",
+			TP_DEFAULT_MERGE_DELETES_PCT,
+			0,
+			100,
+			ShareUpdateExclusiveLock);
 
 	/*
 	 * Install shared memory hooks (needed for registry)
@@ -440,6 +733,13 @@ _PG_init(void)
 	prev_shmem_startup_hook = shmem_startup_hook;
 	shmem_startup_hook		= tp_shmem_startup;
 
+	/*
+	 * Background spill launcher (needs the shmem hooks above).  Always
+	 * registered, since background_spill can be turned on per session;
+	 * it idles on its latch and costs one max_worker_processes slot.
+	 */
+	tp_bgworker_register_launcher();
+
 	/* Install object access hook for DROP INDEX detection */
 	prev_object_access_hook = object_access_hook;
 	object_access_hook		= tp_object_access;
@@ -507,6 +807,12 @@ tp_shmem_request(void)
 
 	/* Request shared memory for registry (includes DSA control) */
 	tp_registry_init();
+
+	/* Background spill request queue */
+	tp_bgworker_shmem_request();
+
+	/* Shared top-k result cache */
+	tp_result_cache_shmem_request();
 }
 
 /*
@@ -521,6 +827,12 @@ tp_shmem_startup(void)
 
 	/* Initialize the registry in shared memory (includes DSA control) */
 	tp_registry_shmem_startup();
+
+	/* Initialize the background spill request queue */
+	tp_bgworker_shmem_startup();
+
+	/* Initialize the shared top-k result cache */
+	tp_result_cache_shmem_startup();
 }
 
 /*
@@ -556,6 +868,8 @@ tp_xact_callback(XactEvent event, void *arg pg_attribute_unused())
 		tp_cleanup_build_mode_on_abort();
 		/* Release all index locks held by this backend */
 		tp_release_all_index_locks();
+		/* Give back a merge slot the failed merge held */
+		tp_merge_slot_release_all();
 		/* Reset bulk load counters for next transaction */
 		tp_reset_bulk_load_counters();
 		break;
@@ -574,6 +888,7 @@ tp_xact_callback(XactEvent event, void *arg pg_attribute_unused())
  * 1. Clean up registry/shared memory for indexes created in that
  *    subtransaction (OAT_DROP doesn't fire for subtransaction abort)
  * 2. Reset lock tracking (LWLockReleaseAll releases all locks)
+ * 3. Give back a merge slot held by a merge that errored out
  *
  * When a subtransaction commits (RELEASE SAVEPOINT), we promote
  * states to the parent subtransaction so they get cleaned up if the
@@ -590,6 +905,7 @@ tp_subxact_callback(
 	{
 	case SUBXACT_EVENT_ABORT_SUB:
 		tp_cleanup_subxact_abort(mySubid);
+		tp_merge_slot_release_all();
 		break;
 
 	case SUBXACT_EVENT_COMMIT_SUB:
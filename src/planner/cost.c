@@ -7,17 +7,39 @@
 #include <postgres.h>
 
 #include <access/genam.h>
+#include <catalog/pg_type.h>
 #include <math.h>
 #include <nodes/pathnodes.h>
+#include <optimizer/cost.h>
 #include <optimizer/optimizer.h>
+#include <utils/builtins.h>
 #include <utils/float.h>
+#include <utils/lsyscache.h>
 #include <utils/rel.h>
 #include <utils/selfuncs.h>
+#include <utils/spccache.h>
 
+#include "access/am.h"
 #include "constants.h"
 #include "index/limit.h"
 #include "index/metapage.h"
 #include "planner/cost.h"
+#include "segment/segment.h"
+#include "types/query.h"
+
+/*
+ * Doc-frequency statistics of a query's terms, summed over the
+ * index's segments.
+ */
+typedef struct TpQueryTermStats
+{
+	int	   term_count;	  /* distinct query terms */
+	int	   segment_count; /* segments each term is looked up in */
+	double sum_df;		  /* postings an exhaustive scan scores */
+	double max_df;		  /* postings of the most common term */
+	double matches;		  /* docs containing any query term */
+	double all_matches;	  /* docs containing every query term */
+} TpQueryTermStats;
 
 /*
  * Seed the pushed-down internal top-K from the estimated selectivity of
@@ -47,6 +69,8 @@ static int
 tp_seed_limit_for_filter(PlannerInfo *root, IndexPath *path, int user_limit)
 {
 	RelOptInfo *rel;
+	List	   *filter_clauses = NIL;
+	ListCell   *lc;
 	Selectivity s;
 	double		seeded;
 
@@ -57,13 +81,34 @@ tp_seed_limit_for_filter(PlannerInfo *root, IndexPath *path, int user_limit)
 	if (rel == NULL || rel->baserestrictinfo == NIL)
 		return user_limit;
 
+	/* Match quals are applied inside the scan, not by a Filter */
+	foreach (lc, rel->baserestrictinfo)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+		ListCell	 *ic;
+		bool		  in_scan = false;
+
+		foreach (ic, path->indexclauses)
+		{
+			if (lfirst_node(IndexClause, ic)->rinfo == rinfo)
+			{
+				in_scan = true;
+				break;
+			}
+		}
+		if (!in_scan)
+			filter_clauses = lappend(filter_clauses, rinfo);
+	}
+	if (filter_clauses == NIL)
+		return user_limit;
+
 	/*
 	 * Combined selectivity of the Filter clauses, matching how the core
 	 * planner sizes the base relation (set_baserel_size_estimates passes
 	 * varRelid 0 for a single base rel's baserestrictinfo).
 	 */
-	s = clauselist_selectivity(
-			root, rel->baserestrictinfo, 0, JOIN_INNER, NULL);
+	s = clauselist_selectivity(root, filter_clauses, 0, JOIN_INNER, NULL);
+	list_free(filter_clauses);
 
 	/* Only seed for a genuinely selective, non-degenerate filter. */
 	if (s <= 0.0 || s >= 1.0)
@@ -79,6 +124,249 @@ tp_seed_limit_for_filter(PlannerInfo *root, IndexPath *path, int user_limit)
 	return (int)seeded;
 }
 
+/*
+ * Query text of a <@>, @@@ or @@& index operand, when the planner has
+ * folded it to a constant.  Returns NULL for a Param or any other
+ * expression whose value is not known until execution.
+ */
+static text *
+tp_query_operand_text(Node *expr)
+{
+	Node  *arg;
+	Const *query;
+
+	if (!IsA(expr, OpExpr) || list_length(((OpExpr *)expr)->args) != 2)
+		return NULL;
+
+	arg = (Node *)lsecond(((OpExpr *)expr)->args);
+	if (IsA(arg, RelabelType))
+		arg = (Node *)((RelabelType *)arg)->arg;
+	if (!IsA(arg, Const) || ((Const *)arg)->constisnull)
+		return NULL;
+
+	query = (Const *)arg;
+	if (query->consttype == TEXTOID)
+		return DatumGetTextPP(query->constvalue);
+
+	return cstring_to_text(get_tpquery_text(
+			(TpQuery *)PG_DETOAST_DATUM(query->constvalue)));
+}
+
+/*
+ * Look up the segment doc frequencies of the query's terms.
+ *
+ * This is the dictionary probe scoring does first, batched so each
+ * segment is opened once; no postings are read.  Docs still in the
+ * memtable are not counted, matching metap->total_docs.  Returns
+ * false when there is nothing to go on (no segments or no terms),
+ * leaving the caller to its generic estimate.
+ */
+static bool
+tp_query_term_stats(
+		Relation		  index,
+		TpIndexMetaPage	  metap,
+		text			 *query,
+		TpQueryTermStats *stats)
+{
+	char  **terms;
+	int32  *frequencies;
+	uint32 *doc_freqs;
+	double	miss = 1.0;
+	double	hit	 = 1.0;
+	int		level;
+	int		i;
+
+	memset(stats, 0, sizeof(TpQueryTermStats));
+
+	for (level = 0; level < TP_MAX_LEVELS; level++)
+		stats->segment_count += metap->level_counts[level];
+	if (metap->total_docs == 0 || stats->segment_count == 0)
+		return false;
+
+	(void)tp_tokenize_text(
+			query,
+			metap->text_config_oid,
+			&terms,
+			&frequencies,
+			&stats->term_count);
+	if (stats->term_count == 0)
+		return false;
+
+	doc_freqs = palloc0(stats->term_count * sizeof(uint32));
+	for (level = 0; level < TP_MAX_LEVELS; level++)
+	{
+		if (metap->level_heads[level] != InvalidBlockNumber)
+			tp_batch_get_segment_doc_freq(
+					index,
+					metap->level_heads[level],
+					terms,
+					stats->term_count,
+					doc_freqs);
+	}
+
+	/* Terms assumed independent for the size of their union */
+	for (i = 0; i < stats->term_count; i++)
+	{
+		double df = Min((double)doc_freqs[i], (double)metap->total_docs);
+
+		stats->sum_df += df;
+		stats->max_df = Max(stats->max_df, df);
+		miss *= 1.0 - df / (double)metap->total_docs;
+		hit *= df / (double)metap->total_docs;
+		pfree(terms[i]);
+	}
+	stats->matches	   = (double)metap->total_docs * (1.0 - miss);
+	stats->all_matches = (double)metap->total_docs * hit;
+
+	pfree(doc_freqs);
+	pfree(terms);
+	pfree(frequencies);
+	return true;
+}
+
+/*
+ * Cost a BM25 scan from its query-term statistics.
+ *
+ * The scan scores everything before returning its first row, so the
+ * scoring work is startup cost.  Without a limit every posting of
+ * every term is scored.  With a top-k limit, block-max WAND reads the
+ * postings of the rarer terms in full -- they decide which docs are
+ * candidates at all -- but skips most blocks of the most common term:
+ * it decodes about one block per result and pays one block-max
+ * comparison for each block it skips.  The saving therefore grows
+ * with the share of postings held by the most common term, and is
+ * nil when the limit reaches past the matching docs.
+ */
+static void
+tp_cost_from_term_stats(
+		IndexPath		 *path,
+		TpQueryTermStats *stats,
+		double			  total_docs,
+		int				  limit,
+		Cost			 *indexStartupCost,
+		Cost			 *indexTotalCost,
+		Selectivity		 *indexSelectivity,
+		double			 *indexPages)
+{
+	double probes	= stats->term_count * stats->segment_count;
+	double scored	= stats->sum_df;
+	double skipped	= 0.0;
+	double returned = stats->matches;
+	double posting_pages;
+	double spc_random_page_cost;
+	double spc_seq_page_cost;
+
+	if (limit > 0 && limit < stats->matches)
+	{
+		double decoded = Min(
+				stats->max_df, (double)limit * TP_POSTING_BLOCK_ENTRIES);
+
+		scored	 = stats->sum_df - stats->max_df + decoded;
+		skipped	 = (stats->max_df - decoded) / TP_POSTING_BLOCK_ENTRIES;
+		returned = limit;
+	}
+
+	get_tablespace_page_costs(
+			path->indexinfo->reltablespace,
+			&spc_random_page_cost,
+			&spc_seq_page_cost);
+
+	/* Posting lists are contiguous; each dictionary probe is a seek */
+	posting_pages = ceil(scored * TP_COST_POSTING_BYTES / BLCKSZ);
+
+	*indexStartupCost =
+			probes * spc_random_page_cost + posting_pages * spc_seq_page_cost +
+			scored * TP_COST_POSTING_OPS * cpu_operator_cost +
+			skipped * cpu_operator_cost;
+	*indexTotalCost = *indexStartupCost + returned * cpu_index_tuple_cost;
+
+	/* Fraction of the heap the scan's rows are fetched from */
+	*indexSelectivity = Min(1.0, Max(returned, 1.0) / total_docs);
+	*indexPages		  = probes + posting_pages;
+}
+
+/*
+ * Cost a scan that only evaluates @@@ / @@& match quals, as a bitmap
+ * scan or an unordered index scan.
+ *
+ * Each qual reads every posting of its terms -- nothing is skipped
+ * without a top-k to prune against -- and sorts them to find the
+ * matching docs.  Quals are assumed independent.  Returns false when a
+ * qual's terms cannot be looked up at plan time.
+ */
+static bool
+tp_match_costestimate(
+		IndexPath	*path,
+		Cost		*indexStartupCost,
+		Cost		*indexTotalCost,
+		Selectivity *indexSelectivity,
+		double		*indexPages)
+{
+	Relation		index_rel;
+	TpIndexMetaPage metap;
+	double			total_docs;
+	double			probes	 = 0.0;
+	double			postings = 0.0;
+	double			selectivity = 1.0;
+	double			posting_pages;
+	double			spc_random_page_cost;
+	double			spc_seq_page_cost;
+	bool			ok = true;
+	ListCell	   *lc;
+
+	index_rel  = index_open(path->indexinfo->indexoid, AccessShareLock);
+	metap	   = tp_get_metapage(index_rel);
+	total_docs = (double)metap->total_docs;
+
+	foreach (lc, path->indexclauses)
+	{
+		IndexClause		*iclause = lfirst_node(IndexClause, lc);
+		Node			*clause	 = (Node *)iclause->rinfo->clause;
+		text			*query	 = tp_query_operand_text(clause);
+		TpQueryTermStats stats;
+		bool			 require_all;
+
+		if (query == NULL ||
+			!tp_query_term_stats(index_rel, metap, query, &stats))
+		{
+			ok = false;
+			break;
+		}
+
+		require_all = get_op_opfamily_strategy(
+							  ((OpExpr *)clause)->opno,
+							  path->indexinfo->opfamily[0]) ==
+					  TP_STRATEGY_MATCH_ALL;
+
+		probes += stats.term_count * stats.segment_count;
+		postings += stats.sum_df;
+		selectivity *= (require_all ? stats.all_matches : stats.matches) /
+					   total_docs;
+	}
+
+	pfree(metap);
+	index_close(index_rel, AccessShareLock);
+
+	if (!ok)
+		return false;
+
+	get_tablespace_page_costs(
+			path->indexinfo->reltablespace,
+			&spc_random_page_cost,
+			&spc_seq_page_cost);
+
+	posting_pages	  = ceil(postings * TP_COST_POSTING_BYTES / BLCKSZ);
+	*indexStartupCost = probes * spc_random_page_cost +
+						posting_pages * spc_seq_page_cost +
+						postings * (1.0 + log2(postings + 1.0)) *
+								cpu_operator_cost;
+	*indexTotalCost = *indexStartupCost +
+					  selectivity * total_docs * cpu_index_tuple_cost;
+	*indexSelectivity = Max(selectivity, 1.0 / total_docs);
+	*indexPages		  = probes + posting_pages;
+	return true;
+}
+
 /*
  * Estimate cost of BM25 index scan
  */
@@ -93,15 +381,40 @@ tp_costestimate(
 		double		*indexCorrelation,
 		double		*indexPages)
 {
-	GenericCosts	costs;
-	TpIndexMetaPage metap;
-	double			num_tuples = TP_DEFAULT_TUPLE_ESTIMATE;
+	GenericCosts	 costs;
+	TpIndexMetaPage	 metap;
+	TpQueryTermStats stats;
+	double			 num_tuples = TP_DEFAULT_TUPLE_ESTIMATE;
+	int				 scan_limit = 0;
+	bool			 have_stats = false;
+	text			*query_text;
 
-	/* Never use index without ORDER BY clause */
-	if (!path->indexorderbys || list_length(path->indexorderbys) == 0)
+	/* Without an ORDER BY the index can only serve match quals */
+	if (path->indexorderbys == NIL)
 	{
-		*indexStartupCost = get_float8_infinity();
-		*indexTotalCost	  = get_float8_infinity();
+		if (path->indexclauses == NIL)
+		{
+			*indexStartupCost = get_float8_infinity();
+			*indexTotalCost	  = get_float8_infinity();
+			return;
+		}
+
+		*indexCorrelation = 0.0;
+		if (tp_match_costestimate(
+					path,
+					indexStartupCost,
+					indexTotalCost,
+					indexSelectivity,
+					indexPages))
+			return;
+
+		MemSet (&costs, 0, sizeof(costs))
+			;
+		genericcostestimate(root, path, loop_count, &costs);
+		*indexStartupCost = costs.indexStartupCost;
+		*indexTotalCost	  = costs.indexTotalCost;
+		*indexSelectivity = costs.indexSelectivity;
+		*indexPages		  = costs.numIndexPages;
 		return;
 	}
 
@@ -118,17 +431,17 @@ tp_costestimate(
 			 * avoid the executor's backoff re-drives (no-op when there
 			 * is no filter).
 			 *
-			 * NOTE: tp_store_query_limit uses a single per-backend slot
-			 * keyed only by index_oid, so multiple BM25 scans of the
-			 * SAME index in one statement (e.g. a faceted UNION ALL)
-			 * share it and may not each receive their own seed.  This
-			 * is a pre-existing limitation of the limit stash;
-			 * correctness is unaffected (executor Filter + backoff).
-			 * Tracked in #435.
+			 * NOTE: tp_store_query_limit keeps one entry per index, so
+			 * each partition's index gets its own limit, but multiple
+			 * BM25 scans of the SAME index in one statement (e.g. a
+			 * faceted UNION ALL) share it and may not each receive
+			 * their own seed.  Correctness is unaffected (executor
+			 * Filter + backoff).  Tracked in #435.
 			 */
 			int seeded = tp_seed_limit_for_filter(root, path, limit);
 
 			tp_store_query_limit(path->indexinfo->indexoid, seeded);
+			scan_limit = seeded;
 		}
 	}
 
@@ -144,6 +457,16 @@ tp_costestimate(
 			if (metap && metap->total_docs > 0)
 				num_tuples = (double)metap->total_docs;
 
+			/*
+			 * With the query known at plan time, cost the scan from how
+			 * many postings its terms actually have.
+			 */
+			query_text = tp_query_operand_text(
+					(Node *)linitial(path->indexorderbys));
+			if (metap && query_text)
+				have_stats = tp_query_term_stats(
+						index_rel, metap, query_text, &stats);
+
 			if (metap)
 				pfree(metap);
 
@@ -151,6 +474,21 @@ tp_costestimate(
 		}
 	}
 
+	if (have_stats)
+	{
+		tp_cost_from_term_stats(
+				path,
+				&stats,
+				num_tuples,
+				scan_limit,
+				indexStartupCost,
+				indexTotalCost,
+				indexSelectivity,
+				indexPages);
+		*indexCorrelation = 0.0;
+		return;
+	}
+
 	/* Initialize generic costs */
 	MemSet (&costs, 0, sizeof(costs))
 		;
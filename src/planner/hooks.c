@@ -24,6 +24,9 @@
 #include <catalog/pg_type.h>
 #include <catalog/pg_type_d.h>
 #include <commands/defrem.h>
+#include <common/hashfn.h>
+#include <float.h>
+#include <math.h>
 #include <nodes/makefuncs.h>
 #include <nodes/nodeFuncs.h>
 #include <nodes/plannodes.h>
@@ -39,11 +42,14 @@
 #include <utils/builtins.h>
 #include <utils/catcache.h>
 #include <utils/fmgroids.h>
+#include <utils/hsearch.h>
 #include <utils/inval.h>
 #include <utils/lsyscache.h>
+#include <utils/memutils.h>
 #include <utils/rel.h>
 #include <utils/syscache.h>
 
+#include "constants.h"
 #include "planner/hooks.h"
 #include "scoring/bm25.h"
 #include "types/query.h"
@@ -81,6 +87,36 @@ static CacheState	oid_cache_state = CACHE_UNKNOWN;
 static BM25OidCache cached_oids;
 static bool			invalidation_registered = false;
 
+/*
+ * Backend-local cache of implicit index resolution: the BM25 index
+ * serving a column, or an expression, of a table.  Without it every
+ * parse of a <@> query (and every re-analysis of a prepared one)
+ * scans pg_index for the operand's table.  A table's entries are
+ * dropped on its relcache invalidation, which creating, dropping or
+ * revalidating any of its indexes sends.
+ */
+typedef struct ResolvedIndexKey
+{
+	Oid		   relid;
+	AttrNumber attnum;	  /* Column, or 0 for an expression */
+	uint32	   expr_hash; /* Hash of expr_text, or 0 for a column */
+} ResolvedIndexKey;
+
+typedef struct ResolvedIndexEntry
+{
+	ResolvedIndexKey key;
+	char			*expr_text;		  /* Expression with varno 1, or NULL */
+	Oid				 index_oid;		  /* First matching index, if any */
+	int				 index_count;	  /* Matching non-partial indexes */
+	int				 partial_skipped; /* Matching partial indexes */
+} ResolvedIndexEntry;
+
+static HTAB			*resolved_index_cache = NULL;
+static MemoryContext resolved_index_cxt	  = NULL;
+
+/* Bumped by every invalidation, to spot one during a catalog scan */
+static uint64 resolved_index_inval_count = 0;
+
 /*
  * Structure to track explicit index requirements for a relation/column.
  * Used during planning to force the planner to use the specified index.
@@ -105,13 +141,6 @@ typedef struct PlanningContext
 
 static PlanningContext *current_planning_context = NULL;
 
-/*
- * Flag to track if the current query has any BM25 operators.
- * Set during post_parse_analyze, used in planner_hook to skip expensive
- * plan tree walks for non-BM25 queries.
- */
-static bool query_has_bm25_operators = false;
-
 /*
  * Context for query tree mutation
  */
@@ -119,12 +148,13 @@ typedef struct ResolveIndexContext
 {
 	Query		 *query;
 	BM25OidCache *oid_cache;
-	bool		  found_bm25_operator; /* Set to true if any BM25 op found */
 } ResolveIndexContext;
 
 /*
  * Syscache invalidation callback - reset cache when pg_am or pg_type changes.
  */
+static void resolved_index_cache_invalidate(Datum arg, Oid relid);
+
 static void
 bm25_cache_invalidation_callback(
 		Datum arg		 pg_attribute_unused(),
@@ -132,6 +162,9 @@ bm25_cache_invalidation_callback(
 		uint32 hashvalue pg_attribute_unused())
 {
 	oid_cache_state = CACHE_UNKNOWN;
+
+	/* Resolutions name the bm25 access method's OID */
+	resolved_index_cache_invalidate((Datum)0, InvalidOid);
 }
 
 /*
@@ -202,6 +235,8 @@ get_bm25_oids(BM25OidCache *cache)
 				AMOID, bm25_cache_invalidation_callback, (Datum)0);
 		CacheRegisterSyscacheCallback(
 				TYPEOID, bm25_cache_invalidation_callback, (Datum)0);
+		CacheRegisterRelcacheCallback(
+				resolved_index_cache_invalidate, (Datum)0);
 		invalidation_registered = true;
 	}
 
@@ -229,6 +264,131 @@ get_bm25_oids(BM25OidCache *cache)
 	return true;
 }
 
+/*
+ * Relcache invalidation callback - drop the cached resolutions for a
+ * table, or all of them when relid is InvalidOid.
+ */
+static void
+resolved_index_cache_invalidate(Datum arg pg_attribute_unused(), Oid relid)
+{
+	HASH_SEQ_STATUS		status;
+	ResolvedIndexEntry *entry;
+
+	resolved_index_inval_count++;
+
+	if (resolved_index_cache == NULL)
+		return;
+
+	hash_seq_init(&status, resolved_index_cache);
+	while ((entry = (ResolvedIndexEntry *)hash_seq_search(&status)) != NULL)
+	{
+		if (OidIsValid(relid) && entry->key.relid != relid)
+			continue;
+
+		if (entry->expr_text)
+			pfree(entry->expr_text);
+		hash_search(resolved_index_cache, &entry->key, HASH_REMOVE, NULL);
+	}
+}
+
+/*
+ * Key for a table's column (expr_text NULL) or expression, whose Vars
+ * have been renumbered to varno 1.
+ */
+static void
+resolved_index_key(
+		ResolvedIndexKey *key,
+		Oid				  relid,
+		AttrNumber		  attnum,
+		const char		 *expr_text)
+{
+	/* Hashed as raw bytes, padding included */
+	memset(key, 0, sizeof(ResolvedIndexKey));
+	key->relid	= relid;
+	key->attnum = attnum;
+	if (expr_text)
+		key->expr_hash = hash_bytes(
+				(const unsigned char *)expr_text, strlen(expr_text));
+}
+
+/*
+ * Look up a cached resolution.  Returns false on a miss.
+ */
+static bool
+resolved_index_lookup(
+		ResolvedIndexKey *key, const char *expr_text, ResolvedIndexEntry *out)
+{
+	ResolvedIndexEntry *entry;
+
+	if (resolved_index_cache == NULL)
+		return false;
+
+	entry = (ResolvedIndexEntry *)
+			hash_search(resolved_index_cache, key, HASH_FIND, NULL);
+	if (entry == NULL)
+		return false;
+
+	/* Tell colliding expressions apart */
+	if (expr_text &&
+		(entry->expr_text == NULL || strcmp(entry->expr_text, expr_text) != 0))
+		return false;
+
+	*out = *entry;
+	return true;
+}
+
+/*
+ * Cache a resolution computed from the catalogs.  Skipped when an
+ * invalidation arrived since `inval_count` was read: the scan may have
+ * seen the catalogs from before it.
+ */
+static void
+resolved_index_store(
+		ResolvedIndexKey		 *key,
+		const char				 *expr_text,
+		const ResolvedIndexEntry *result,
+		uint64					  inval_count)
+{
+	ResolvedIndexEntry *entry;
+	bool				found;
+
+	if (inval_count != resolved_index_inval_count)
+		return;
+
+	if (resolved_index_cache == NULL)
+	{
+		HASHCTL ctl;
+
+		resolved_index_cxt = AllocSetContextCreate(
+				CacheMemoryContext,
+				"BM25 index resolution cache",
+				ALLOCSET_SMALL_SIZES);
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize	  = sizeof(ResolvedIndexKey);
+		ctl.entrysize = sizeof(ResolvedIndexEntry);
+		ctl.hcxt	  = resolved_index_cxt;
+
+		resolved_index_cache = hash_create(
+				"BM25 index resolution cache",
+				64,
+				&ctl,
+				HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	entry = (ResolvedIndexEntry *)
+			hash_search(resolved_index_cache, key, HASH_ENTER, &found);
+	if (found && entry->expr_text)
+		pfree(entry->expr_text);
+
+	entry->expr_text	   = NULL;
+	entry->index_oid	   = result->index_oid;
+	entry->index_count	   = result->index_count;
+	entry->partial_skipped = result->partial_skipped;
+	if (expr_text)
+		entry->expr_text = MemoryContextStrdup(resolved_index_cxt, expr_text);
+}
+
 /*
  * Check if an index is on a specific column of a table.
  * Returns true if the index is on the given table and column.
@@ -266,21 +426,20 @@ index_is_on_column(Oid index_oid, Oid relid, AttrNumber attnum)
 }
 
 /*
- * Find BM25 index for a column.
+ * Scan pg_index for the BM25 indexes on a column.
  */
-static Oid
-find_bm25_index_for_column(Oid relid, AttrNumber attnum, Oid bm25_am_oid)
+static void
+scan_bm25_indexes_for_column(
+		Oid relid, AttrNumber attnum, Oid bm25_am_oid, ResolvedIndexEntry *res)
 {
 	Relation	indexRelation;
 	SysScanDesc scan;
 	HeapTuple	indexTuple;
-	Oid			result			= InvalidOid;
-	int			index_count		= 0;
-	int			partial_skipped = 0;
 	ScanKeyData scanKey;
 
-	if (!OidIsValid(bm25_am_oid))
-		return InvalidOid;
+	res->index_oid		 = InvalidOid;
+	res->index_count	 = 0;
+	res->partial_skipped = 0;
 
 	indexRelation = table_open(IndexRelationId, AccessShareLock);
 
@@ -327,7 +486,7 @@ find_bm25_index_for_column(Oid relid, AttrNumber attnum, Oid bm25_am_oid)
 				{
 					if (indexForm->indkey.values[i] == attnum)
 					{
-						partial_skipped++;
+						res->partial_skipped++;
 						break;
 					}
 				}
@@ -339,9 +498,9 @@ find_bm25_index_for_column(Oid relid, AttrNumber attnum, Oid bm25_am_oid)
 			{
 				if (indexForm->indkey.values[i] == attnum)
 				{
-					index_count++;
-					if (result == InvalidOid)
-						result = indexOid;
+					res->index_count++;
+					if (res->index_oid == InvalidOid)
+						res->index_oid = indexOid;
 					break;
 				}
 			}
@@ -351,25 +510,47 @@ find_bm25_index_for_column(Oid relid, AttrNumber attnum, Oid bm25_am_oid)
 
 	systable_endscan(scan);
 	table_close(indexRelation, AccessShareLock);
+}
+
+/*
+ * Find BM25 index for a column.
+ */
+static Oid
+find_bm25_index_for_column(Oid relid, AttrNumber attnum, Oid bm25_am_oid)
+{
+	ResolvedIndexKey   key;
+	ResolvedIndexEntry res;
+
+	if (!OidIsValid(bm25_am_oid))
+		return InvalidOid;
+
+	resolved_index_key(&key, relid, attnum, NULL);
+	if (!resolved_index_lookup(&key, NULL, &res))
+	{
+		uint64 inval_count = resolved_index_inval_count;
+
+		scan_bm25_indexes_for_column(relid, attnum, bm25_am_oid, &res);
+		resolved_index_store(&key, NULL, &res, inval_count);
+	}
 
-	if (index_count > 1)
+	if (res.index_count > 1)
 		ereport(WARNING,
 				(errmsg("multiple BM25 indexes exist on the same column"),
 				 errhint("Use explicit to_bm25query('query', 'index_name') "
 						 "to specify which index to use.")));
 
-	if (index_count == 0 && partial_skipped > 0)
+	if (res.index_count == 0 && res.partial_skipped > 0)
 		ereport(ERROR,
 				(errcode(ERRCODE_UNDEFINED_OBJECT),
 				 errmsg("no non-partial BM25 index found "
 						"for this column "
 						"(%d partial index(es) skipped)",
-						partial_skipped),
+						res.partial_skipped),
 				 errhint("Use to_bm25query('query', "
 						 "'index_name') to specify which "
 						 "partial index to use.")));
 
-	return result;
+	return res.index_oid;
 }
 
 /*
@@ -469,33 +650,25 @@ find_index_for_var(Var *var, ResolveIndexContext *context)
 }
 
 /*
- * Find BM25 index matching an expression on a relation.
- * For plain Var, delegates to find_bm25_index_for_column.
- * For complex expressions, compares expression trees.
+ * Scan pg_index for the BM25 indexes on an expression of a relation.
  */
-static Oid
-find_bm25_index_for_expr(Node *expr, Oid relid, Index varno, Oid bm25_am_oid)
+static void
+scan_bm25_indexes_for_expr(
+		Node			   *expr,
+		Oid					relid,
+		Index				varno,
+		Oid					bm25_am_oid,
+		ResolvedIndexEntry *res)
 {
 	Relation	indexRelation;
 	SysScanDesc scan;
 	HeapTuple	indexTuple;
-	Oid			result			= InvalidOid;
-	int			index_count		= 0;
-	int			partial_skipped = 0;
 	ScanKeyData scanKey;
 
-	if (!OidIsValid(bm25_am_oid))
-		return InvalidOid;
-
-	/* Fast path: plain column reference */
-	if (IsA(expr, Var))
-	{
-		Var *var = (Var *)expr;
-
-		return find_bm25_index_for_column(relid, var->varattno, bm25_am_oid);
-	}
+	res->index_oid		 = InvalidOid;
+	res->index_count	 = 0;
+	res->partial_skipped = 0;
 
-	/* Slow path: expression comparison */
 	indexRelation = table_open(IndexRelationId, AccessShareLock);
 
 	ScanKeyInit(
@@ -542,7 +715,7 @@ find_bm25_index_for_expr(Node *expr, Oid relid, Index varno, Oid bm25_am_oid)
 			(void)predDatum;
 			if (!predNull)
 			{
-				partial_skipped++;
+				res->partial_skipped++;
 				continue;
 			}
 		}
@@ -572,17 +745,64 @@ find_bm25_index_for_expr(Node *expr, Oid relid, Index varno, Oid bm25_am_oid)
 
 			if (equal(idx_expr, expr))
 			{
-				index_count++;
-				if (result == InvalidOid)
-					result = indexOid;
+				res->index_count++;
+				if (res->index_oid == InvalidOid)
+					res->index_oid = indexOid;
 			}
 		}
 	}
 
 	systable_endscan(scan);
 	table_close(indexRelation, AccessShareLock);
+}
 
-	if (index_count > 1)
+/*
+ * Find BM25 index matching an expression on a relation.
+ * For plain Var, delegates to find_bm25_index_for_column.
+ * For complex expressions, compares expression trees.
+ */
+static Oid
+find_bm25_index_for_expr(Node *expr, Oid relid, Index varno, Oid bm25_am_oid)
+{
+	ResolvedIndexKey   key;
+	ResolvedIndexEntry res;
+	Node			  *normalized;
+	char			  *expr_text;
+
+	if (!OidIsValid(bm25_am_oid))
+		return InvalidOid;
+
+	/* Fast path: plain column reference */
+	if (IsA(expr, Var))
+	{
+		Var *var = (Var *)expr;
+
+		return find_bm25_index_for_column(relid, var->varattno, bm25_am_oid);
+	}
+
+	/*
+	 * Cache by the expression as pg_index stores it (varno 1).  Node
+	 * output omits parse locations, so the same expression written
+	 * anywhere in any query has the same text.
+	 */
+	normalized = copyObject(expr);
+	if (varno != 1)
+		ChangeVarNodes(normalized, varno, 1, 0);
+	expr_text = nodeToString(normalized);
+
+	resolved_index_key(&key, relid, 0, expr_text);
+	if (!resolved_index_lookup(&key, expr_text, &res))
+	{
+		uint64 inval_count = resolved_index_inval_count;
+
+		/* Slow path: expression comparison */
+		scan_bm25_indexes_for_expr(expr, relid, varno, bm25_am_oid, &res);
+		resolved_index_store(&key, expr_text, &res, inval_count);
+	}
+
+	pfree(expr_text);
+
+	if (res.index_count > 1)
 		ereport(WARNING,
 				(errmsg("multiple BM25 indexes match the "
 						"expression"),
@@ -590,18 +810,18 @@ find_bm25_index_for_expr(Node *expr, Oid relid, Index varno, Oid bm25_am_oid)
 						 " 'index_name') to specify which "
 						 "index.")));
 
-	if (index_count == 0 && partial_skipped > 0)
+	if (res.index_count == 0 && res.partial_skipped > 0)
 		ereport(ERROR,
 				(errcode(ERRCODE_UNDEFINED_OBJECT),
 				 errmsg("no non-partial BM25 index found "
 						"for this expression "
 						"(%d partial index(es) skipped)",
-						partial_skipped),
+						res.partial_skipped),
 				 errhint("Use to_bm25query('query', "
 						 "'index_name') to specify which "
 						 "partial index to use.")));
 
-	return result;
+	return res.index_oid;
 }
 
 /*
@@ -664,8 +884,6 @@ transform_tpquery_opexpr(OpExpr *opexpr, ResolveIndexContext *context)
 		opexpr->opno != oids->textarray_tpquery_operator_oid)
 		return NULL;
 
-	/* Mark that we found a BM25 operator for later optimization */
-	context->found_bm25_operator = true;
 	if (list_length(opexpr->args) != 2)
 		return NULL;
 
@@ -806,8 +1024,6 @@ transform_text_text_opexpr(OpExpr *opexpr, ResolveIndexContext *context)
 	if (opexpr->opno != oids->text_text_operator_oid && !is_text_array_op)
 		return NULL;
 
-	/* Mark that we found a BM25 operator for later optimization */
-	context->found_bm25_operator = true;
 	if (list_length(opexpr->args) != 2)
 		return NULL;
 
@@ -979,9 +1195,8 @@ resolve_indexes_in_query(Query *query)
 	if (!get_bm25_oids(&oid_cache))
 		return;
 
-	context.query				= query;
-	context.oid_cache			= &oid_cache;
-	context.found_bm25_operator = false;
+	context.query	  = query;
+	context.oid_cache = &oid_cache;
 
 	/* Process target list */
 	resolve_indexes_in_targetlist(query, &context);
@@ -997,22 +1212,55 @@ resolve_indexes_in_query(Query *query)
 
 	/* Process subqueries */
 	resolve_indexes_in_subqueries(query);
+}
 
-	/*
-	 * Track if this query has BM25 operators for the planner hook.
-	 * This avoids expensive plan tree walks for non-BM25 queries.
-	 */
-	if (context.found_bm25_operator)
-		query_has_bm25_operators = true;
+/*
+ * Walker for query_has_bm25_operators.
+ */
+static bool
+bm25_operator_walker(Node *node, BM25OidCache *oids)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, OpExpr))
+	{
+		Oid opno = ((OpExpr *)node)->opno;
+
+		if (opno == oids->text_tpquery_operator_oid ||
+			opno == oids->text_text_operator_oid ||
+			opno == oids->textarray_tpquery_operator_oid ||
+			opno == oids->textarray_text_operator_oid)
+			return true;
+	}
+
+	/* Subqueries: sublinks, FROM subqueries and CTEs */
+	if (IsA(node, Query))
+		return query_tree_walker(
+				(Query *)node, bm25_operator_walker, oids, 0);
+
+	return expression_tree_walker(node, bm25_operator_walker, oids);
+}
+
+/*
+ * Does a query use <@> anywhere?  A read-only walk comparing operator
+ * OIDs, so statements without BM25 scoring skip index resolution
+ * (which copies the whole tree) and the planner's plan walks.
+ */
+static bool
+query_has_bm25_operators(Query *query, BM25OidCache *oids)
+{
+	return query_tree_walker(query, bm25_operator_walker, oids, 0);
 }
 
 /*
  * Post parse analysis hook function.
  *
  * Performance note: For non-BM25 queries, this does minimal work - just a
- * cached OID lookup and a quick walk of expressions to check operator OIDs.
- * Expensive operations (syscache lookups, index resolution) only happen
- * for actual BM25 operator expressions.
+ * cached OID lookup and a read-only walk of expressions to check operator
+ * OIDs.  Expensive operations (syscache lookups, index resolution) only
+ * happen for queries using a BM25 operator, and index resolution is
+ * cached across queries.
  */
 static void
 tp_post_parse_analyze_hook(
@@ -1020,8 +1268,7 @@ tp_post_parse_analyze_hook(
 		Query			   *query,
 		JumbleState *jstate pg_attribute_unused())
 {
-	/* Reset flag for this query - will be set if BM25 operators found */
-	query_has_bm25_operators = false;
+	BM25OidCache oid_cache;
 
 	/*
 	 * Skip index resolution if we're not in a valid transaction state.
@@ -1029,7 +1276,8 @@ tp_post_parse_analyze_hook(
 	 * transaction block (e.g., ROLLBACK after a failed query). In that
 	 * state, catalog lookups are forbidden.
 	 */
-	if (IsTransactionState())
+	if (IsTransactionState() && get_bm25_oids(&oid_cache) &&
+		query_has_bm25_operators(query, &oid_cache))
 		resolve_indexes_in_query(query);
 
 	if (prev_post_parse_analyze_hook)
@@ -1214,6 +1462,148 @@ plan_has_bm25_indexscan(Plan *plan, BM25OidCache *oids)
 	return false;
 }
 
+/*
+ * Score operand of a constant upper bound on `score_expr`: one of
+ * score < c, score <= c, c > score or c >= score.  Returns the list
+ * cell holding the score, with c in *bound and whether c itself passes
+ * in *inclusive, or NULL for any other clause.
+ */
+static ListCell *
+score_bound_clause(
+		Node *clause, Node *score_expr, float8 *bound, bool *inclusive)
+{
+	OpExpr	 *opexpr;
+	Oid		  opfunc;
+	ListCell *score_cell;
+	Node	 *other;
+
+	if (!IsA(clause, OpExpr) || list_length(((OpExpr *)clause)->args) != 2)
+		return NULL;
+
+	opexpr = (OpExpr *)clause;
+	opfunc = get_opcode(opexpr->opno);
+	if (opfunc == F_FLOAT8LT || opfunc == F_FLOAT8LE)
+	{
+		score_cell = list_nth_cell(opexpr->args, 0);
+		other	   = (Node *)lsecond(opexpr->args);
+	}
+	else if (opfunc == F_FLOAT8GT || opfunc == F_FLOAT8GE)
+	{
+		score_cell = list_nth_cell(opexpr->args, 1);
+		other	   = (Node *)linitial(opexpr->args);
+	}
+	else
+		return NULL;
+
+	if (!IsA(other, Const) || ((Const *)other)->constisnull ||
+		!equal(lfirst(score_cell), score_expr))
+		return NULL;
+
+	*bound	   = DatumGetFloat8(((Const *)other)->constvalue);
+	*inclusive = opfunc == F_FLOAT8LE || opfunc == F_FLOAT8GE;
+	return score_cell;
+}
+
+/*
+ * Push the constant score bounds of a BM25 index scan's filter into
+ * the scan.
+ *
+ * <@> is the negated BM25 score, so a filter of score < c passes no
+ * row scoring below -c.  The scan's bm25query then carries -c as its
+ * score floor: BMW skips what cannot reach it from the first block
+ * on, and a batch that stops short of its limit ends the scan rather
+ * than having it rank rows the filter would discard.
+ *
+ * The filter's score becomes the bm25_get_current_score() stub, as in
+ * the target list, so the filter compares the very score the scan
+ * pruned with instead of recomputing it.
+ */
+static void
+push_score_floor(IndexScan *indexscan, BM25OidCache *oids)
+{
+	Node	 *score_expr;
+	OpExpr	 *orderby;
+	Const	 *query;
+	TpQuery	 *tpquery;
+	FuncExpr *stub = NULL;
+	float8	  min_score = 0.0;
+	bool	  min_inclusive = false;
+	float4	  score_floor;
+	ListCell *lc;
+
+	if (!tp_score_pushdown || indexscan->scan.plan.qual == NIL ||
+		list_length(indexscan->indexorderbyorig) != 1 ||
+		list_length(indexscan->indexorderby) != 1)
+		return;
+
+	score_expr = (Node *)linitial(indexscan->indexorderbyorig);
+	if (!is_bm25_score_opexpr(score_expr, oids))
+		return;
+
+	/* The floor travels in the query, so it must be a constant */
+	orderby = (OpExpr *)linitial(indexscan->indexorderby);
+	if (!IsA(orderby, OpExpr) || list_length(orderby->args) != 2 ||
+		!IsA(lsecond(orderby->args), Const))
+		return;
+	query = (Const *)lsecond(orderby->args);
+	if (query->constisnull || query->consttype != oids->tpquery_type_oid)
+		return;
+
+	foreach (lc, indexscan->scan.plan.qual)
+	{
+		ListCell *score_cell;
+		float8	  bound;
+		bool	  inclusive;
+
+		/* Bounds of zero and up (or NaN) pass every row */
+		score_cell = score_bound_clause(
+				lfirst(lc), score_expr, &bound, &inclusive);
+		if (score_cell == NULL || !(bound < 0.0))
+			continue;
+
+		if (stub == NULL)
+		{
+			stub = make_stub_funcexpr();
+			if (stub == NULL)
+				return;
+		}
+		lfirst(score_cell) = copyObject(stub);
+
+		/* Of equal bounds, a strict one passes fewer rows */
+		if (-bound > min_score)
+		{
+			min_score	  = -bound;
+			min_inclusive = inclusive;
+		}
+		else if (-bound == min_score)
+			min_inclusive = min_inclusive && inclusive;
+	}
+
+	if (min_score <= 0.0)
+		return;
+
+	/*
+	 * Rounded down, so every score the filter passes is at or above it.
+	 * BMW skips what can only tie its floor, so a bound the filter
+	 * passes at equality is stepped below as well.
+	 */
+	score_floor = (float4)Min(min_score, (float8)FLT_MAX);
+	if ((float8)score_floor > min_score ||
+		(min_inclusive && (float8)score_floor == min_score))
+		score_floor = nextafterf(score_floor, 0.0f);
+
+	tpquery = (TpQuery *)PG_DETOAST_DATUM(query->constvalue);
+
+	lsecond(orderby->args) = makeConst(
+			query->consttype,
+			query->consttypmod,
+			query->constcollid,
+			-1,
+			PointerGetDatum(tpquery_with_score_floor(tpquery, score_floor)),
+			false,
+			false);
+}
+
 /*
  * Recursively walk the plan tree and replace BM25 score expressions.
  */
@@ -1226,6 +1616,10 @@ replace_scores_in_plan(Plan *plan, BM25OidCache *oids)
 	/* Process this node's targetlist */
 	replace_scores_in_targetlist(plan->targetlist, oids);
 
+	/* And the score bounds of a BM25 scan's filter */
+	if (IsA(plan, IndexScan))
+		push_score_floor((IndexScan *)plan, oids);
+
 	/* Recurse into child plans */
 	replace_scores_in_plan(plan->lefttree, oids);
 	replace_scores_in_plan(plan->righttree, oids);
@@ -1925,8 +2319,14 @@ tp_planner_hook(
 	PlanningContext *saved_context;
 	List			*explicit_indexes;
 
-	/* Get BM25 OIDs - if extension not installed, just pass through */
-	if (!get_bm25_oids(&oid_cache))
+	/*
+	 * Get BM25 OIDs - if extension not installed, or the query does not
+	 * score with <@>, just pass through.  The check walks the query
+	 * being planned rather than relying on parse analysis, which does
+	 * not run again when a prepared statement is re-planned.
+	 */
+	if (!get_bm25_oids(&oid_cache) ||
+		!query_has_bm25_operators(parse, &oid_cache))
 	{
 		if (prev_planner_hook)
 			return prev_planner_hook(
@@ -1982,14 +2382,8 @@ tp_planner_hook(
 	}
 	PG_END_TRY();
 
-	/*
-	 * Post-process the plan if it may have BM25 index scans.
-	 *
-	 * Performance optimization: Only check for BM25 IndexScans if the
-	 * post_parse_analyze hook found BM25 operators. This avoids expensive
-	 * syscache lookups in plan_has_bm25_indexscan() for non-BM25 queries.
-	 */
-	if (query_has_bm25_operators && result->planTree != NULL &&
+	/* Post-process the plan if it may have BM25 index scans */
+	if (result->planTree != NULL &&
 		plan_has_bm25_indexscan(result->planTree, &oid_cache))
 	{
 		/*
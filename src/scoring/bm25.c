@@ -6,19 +6,30 @@
  */
 #include <postgres.h>
 
+#include <access/htup_details.h>
+#include <fmgr.h>
+#include <funcapi.h>
 #include <math.h>
 #include <storage/itemptr.h>
 #include <utils/memutils.h>
 
-#include "index/metapage.h"
+#include "index/snapshot.h"
 #include "index/source.h"
 #include "index/state.h"
-#include "memtable/cache_source.h"
-#include "memtable/chain_source.h"
 #include "scoring/bm25.h"
 #include "scoring/bmw.h"
 #include "segment/segment.h"
 
+/*
+ * This backend's scoring work since it started, reported by
+ * bm25_scoring_stats: tp_score_documents calls that reached an index
+ * with documents, those that skipped it because its best possible
+ * score was below min_score, and the documents BMW scored.
+ */
+static uint64 tp_scoring_passes	 = 0;
+static uint64 tp_scoring_skipped = 0;
+static uint64 tp_scoring_docs	 = 0;
+
 /*
  * Centralized IDF calculation (basic version)
  * Calculates IDF using BM25 formula: log(1 + (N - df + 0.5) / (df + 0.5))
@@ -38,7 +49,7 @@ tp_calculate_idf(int32 doc_freq, int32 total_docs)
  * Get unified doc_freq for a term (memtable + all segments).
  * Returns 0 if term not found in any source.
  *
- * Per issue #374: `memtable_src` is a (possibly NULL) chain
+ * Per issue #374: `memtable_src` is a (possibly NULL) memtable
  * source; we read the per-term doc_freq via the source op without
  * materializing the full posting list (which would be O(count) and
  * is wasteful for IDF lookup).
@@ -75,7 +86,7 @@ tp_get_unified_doc_freq(
  * Much faster than calling tp_get_unified_doc_freq in a loop because
  * it opens each segment only once instead of once per term.
  *
- * Per issue #374: `memtable_src` is a (possibly NULL) chain
+ * Per issue #374: `memtable_src` is a (possibly NULL) memtable
  * source; we read each term's doc_freq via the source op without
  * materializing posting lists.
  */
@@ -113,32 +124,45 @@ tp_batch_get_unified_doc_freq(
 /*
  * Score documents using BM25 algorithm
  * Returns number of documents scored
+ *
+ * Runs entirely against `snapshot` and takes no per-index lock:
+ * corpus totals, segment level heads and the (materialized)
+ * memtable contribution were all captured by
+ * tp_index_snapshot_capture.
+ *
+ * `filter`, when not NULL, restricts the results to the documents of
+ * the scan's match quals; it must be built from `snapshot`.  See
+ * tp_score_single_term_bmw.
+ *
+ * `min_score` drops results scoring below it (0 for none).  An index
+ * whose best possible score falls short returns nothing unscored.
  */
 int
 tp_score_documents(
 		TpLocalIndexState *local_state,
 		Relation		   index_relation,
+		TpIndexSnapshot	  *snapshot,
 		char			 **query_terms,
 		int32			  *query_frequencies,
 		int				   query_term_count,
 		float4			   k1,
 		float4			   b,
 		int				   max_results,
+		float4			   min_score,
+		TpMatchFilter	  *filter,
 		ItemPointer		   result_ctids,
 		float4			 **result_scores)
 {
-	float4			avg_doc_len;
-	int64			total_docs64;
-	int64			total_len64;
-	int32			total_docs;
-	TpIndexMetaPage metap;
-	BlockNumber		level_heads[TP_MAX_LEVELS];
-	TpDataSource   *memtable_src = NULL;
-	int				i;
-	int				result_count = 0;
+	float4		  avg_doc_len;
+	int32		  total_docs;
+	BlockNumber	 *level_heads;
+	TpDataSource *memtable_src;
+	int			  i;
+	int			  result_count = 0;
 
 	/* Basic sanity checks */
 	Assert(local_state != NULL);
+	Assert(snapshot != NULL);
 	Assert(query_terms != NULL);
 	Assert(result_ctids != NULL);
 	Assert(result_scores != NULL);
@@ -154,41 +178,26 @@ tp_score_documents(
 
 	/*
 	 * Per issue #374: totals come from `metap` (persisted
-	 * segments) + the chain source (active memtable on disk).
+	 * segments) + the memtable source (active memtable on disk),
+	 * both read by the snapshot under one per-index lock hold.
 	 * The shmem atomic is still bumped on the primary for vacuum's
 	 * shrinkage protocol but is not authoritative for queries (it
 	 * would drift on standbys and freshly-opened backends).
 	 */
-	metap = tp_get_metapage(index_relation);
-	for (i = 0; i < TP_MAX_LEVELS; i++)
-		level_heads[i] = metap->level_heads[i];
-	total_docs64 = (int64)metap->total_docs;
-	total_len64	 = (int64)metap->total_len;
-	pfree(metap);
-
-	memtable_src = tp_memtable_source_create_for_read(
-			local_state,
-			index_relation,
-			(const char *const *)query_terms,
-			query_term_count);
-	if (memtable_src != NULL)
-	{
-		total_docs64 += memtable_src->total_docs;
-		total_len64 += memtable_src->total_len;
-	}
+	level_heads	 = snapshot->level_heads;
+	memtable_src = snapshot->memtable;
 
-	total_docs	= (total_docs64 > PG_INT32_MAX) ? PG_INT32_MAX
-												: (int32)total_docs64;
-	avg_doc_len = total_docs > 0
-						? (float4)((double)total_len64 / (double)total_docs)
-						: 0.0f;
+	total_docs	= (snapshot->total_docs > PG_INT32_MAX)
+						? PG_INT32_MAX
+						: (int32)snapshot->total_docs;
+	avg_doc_len = total_docs > 0 ? (float4)((double)snapshot->total_len /
+											(double)total_docs)
+								 : 0.0f;
 
 	if (total_docs <= 0 || avg_doc_len <= 0.0f)
-	{
-		if (memtable_src != NULL)
-			tp_source_close(memtable_src);
 		return 0;
-	}
+
+	tp_scoring_passes++;
 
 	/*
 	 * BMW fast path for single-term queries.
@@ -206,15 +215,18 @@ tp_score_documents(
 		doc_freq = tp_get_unified_doc_freq(
 				memtable_src, index_relation, term, level_heads);
 		if (doc_freq == 0)
-		{
-			if (memtable_src != NULL)
-				tp_source_close(memtable_src);
 			return 0;
-		}
 
 		/* Calculate IDF */
 		idf = tp_calculate_idf(doc_freq, total_docs);
 
+		/* Term frequency saturates below k1 + 1 */
+		if (idf * (k1 + 1.0f) < min_score)
+		{
+			tp_scoring_skipped++;
+			return 0;
+		}
+
 		/* Allocate scores array */
 		scores = (float4 *)palloc(max_results * sizeof(float4));
 
@@ -223,15 +235,19 @@ tp_score_documents(
 				local_state,
 				index_relation,
 				memtable_src,
+				level_heads,
 				term,
 				idf,
 				k1,
 				b,
 				avg_doc_len,
 				max_results,
+				min_score,
+				filter,
 				result_ctids,
 				scores,
 				&stats);
+		tp_scoring_docs += stats.memtable_docs + stats.segment_docs_scored;
 
 		/* Log BMW stats if enabled */
 		if (tp_log_bmw_stats)
@@ -254,8 +270,6 @@ tp_score_documents(
 		}
 
 		*result_scores = scores;
-		if (memtable_src != NULL)
-			tp_source_close(memtable_src);
 		return result_count;
 	}
 
@@ -266,6 +280,7 @@ tp_score_documents(
 	{
 		uint32	  *doc_freqs;
 		float4	  *idfs;
+		float4	   max_score;
 		float4	  *scores;
 		TpBMWStats stats;
 
@@ -280,15 +295,24 @@ tp_score_documents(
 				doc_freqs);
 
 		/* Convert doc_freqs to IDFs */
-		idfs = palloc(query_term_count * sizeof(float4));
+		idfs	  = palloc(query_term_count * sizeof(float4));
+		max_score = 0.0f;
 		for (i = 0; i < query_term_count; i++)
 		{
 			idfs[i] = (doc_freqs[i] > 0)
 							? tp_calculate_idf(doc_freqs[i], total_docs)
 							: 0.0f;
+			max_score += idfs[i] * (k1 + 1.0f) * query_frequencies[i];
 		}
 		pfree(doc_freqs);
 
+		if (max_score < min_score)
+		{
+			tp_scoring_skipped++;
+			pfree(idfs);
+			return 0;
+		}
+
 		/* Allocate scores array */
 		scores = (float4 *)palloc(max_results * sizeof(float4));
 
@@ -297,6 +321,7 @@ tp_score_documents(
 				local_state,
 				index_relation,
 				memtable_src,
+				level_heads,
 				query_terms,
 				query_term_count,
 				query_frequencies,
@@ -305,9 +330,12 @@ tp_score_documents(
 				b,
 				avg_doc_len,
 				max_results,
+				min_score,
+				filter,
 				result_ctids,
 				scores,
 				&stats);
+		tp_scoring_docs += stats.memtable_docs + stats.segment_docs_scored;
 
 		pfree(idfs);
 
@@ -332,8 +360,33 @@ tp_score_documents(
 		}
 
 		*result_scores = scores;
-		if (memtable_src != NULL)
-			tp_source_close(memtable_src);
 		return result_count;
 	}
 }
+
+PG_FUNCTION_INFO_V1(tp_scoring_stats);
+
+/*
+ * SQL-callable: bm25_scoring_stats() → record
+ *
+ * This backend's scoring passes, the passes that skipped an index
+ * whose best possible score was below their threshold, and the
+ * documents scored, since the backend started.
+ */
+Datum
+tp_scoring_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc tupdesc;
+	Datum	  values[3];
+	bool	  nulls[3] = {false, false, false};
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	values[0] = Int64GetDatum((int64)tp_scoring_passes);
+	values[1] = Int64GetDatum((int64)tp_scoring_skipped);
+	values[2] = Int64GetDatum((int64)tp_scoring_docs);
+
+	PG_RETURN_DATUM(
+			HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
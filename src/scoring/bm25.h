@@ -11,6 +11,8 @@
 #include <storage/itemptr.h>
 
 typedef struct TpLocalIndexState TpLocalIndexState;
+typedef struct TpIndexSnapshot TpIndexSnapshot;
+typedef struct TpMatchFilter TpMatchFilter;
 
 /*
  * Document score entry for query result accumulation.
@@ -26,12 +28,15 @@ typedef struct DocumentScoreEntry
 extern int tp_score_documents(
 		TpLocalIndexState *local_state,
 		Relation		   index_relation,
+		TpIndexSnapshot	  *snapshot,
 		char			 **query_terms,
 		int32			  *query_frequencies,
 		int				   query_term_count,
 		float4			   k1,
 		float4			   b,
 		int				   max_results,
+		float4			   min_score,
+		TpMatchFilter	  *filter,
 		ItemPointer		   result_ctids,
 		float4			 **result_scores);
 
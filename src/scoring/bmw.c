@@ -39,6 +39,7 @@ tp_topk_init(TpTopKHeap *heap, int k, MemoryContext ctx)
 	heap->scores	 = palloc(k * sizeof(float4));
 	heap->capacity	 = k;
 	heap->size		 = 0;
+	heap->floor		 = 0.0f;
 
 	MemoryContextSwitchTo(old_ctx);
 }
@@ -200,6 +201,9 @@ heap_beats_root(
 void
 tp_topk_add_memtable(TpTopKHeap *heap, ItemPointerData ctid, float4 score)
 {
+	if (score < heap->floor)
+		return;
+
 	if (heap->size < heap->capacity)
 	{
 		/* Heap not full - just add */
@@ -230,6 +234,9 @@ void
 tp_topk_add_segment(
 		TpTopKHeap *heap, BlockNumber seg_block, uint32 doc_id, float4 score)
 {
+	if (score < heap->floor)
+		return;
+
 	if (heap->size < heap->capacity)
 	{
 		/* Heap not full - just add */
@@ -411,14 +418,15 @@ compute_bm25_score(
  */
 static void
 score_memtable_single_term(
-		TpTopKHeap	 *heap,
-		TpDataSource *source,
-		const char	 *term,
-		float4		  idf,
-		float4		  k1,
-		float4		  b,
-		float4		  avg_doc_len,
-		TpBMWStats	 *stats)
+		TpTopKHeap	  *heap,
+		TpDataSource  *source,
+		const char	  *term,
+		float4		   idf,
+		float4		   k1,
+		float4		   b,
+		float4		   avg_doc_len,
+		TpMatchFilter *filter,
+		TpBMWStats	  *stats)
 {
 	TpPostingData *postings;
 	int			   i;
@@ -446,8 +454,18 @@ score_memtable_single_term(
 		if ((i & 0xFFF) == 0)
 			CHECK_FOR_INTERRUPTS();
 
-		/* Get document length */
-		doc_len = tp_source_get_doc_length(source, ctid);
+		/* Skip docs the candidate filter rules out */
+		if (filter && !tp_match_filter_has_ctid(filter, ctid))
+		{
+			if (stats)
+				stats->filtered_docs_skipped++;
+			continue;
+		}
+
+		/* Get document length, from the postings when carried */
+		doc_len = postings->doc_lengths != NULL
+						? postings->doc_lengths[i]
+						: tp_source_get_doc_length(source, ctid);
 		if (doc_len <= 0)
 			doc_len = 1; /* Fallback for missing entries */
 
@@ -475,15 +493,25 @@ score_segment_single_term_bmw(
 		float4			 k1,
 		float4			 b,
 		float4			 avg_doc_len,
+		TpMatchFilter	*filter,
 		TpBMWStats		*stats)
 {
 	TpSegmentPostingIterator iter;
 	TpSegmentPosting		*posting;
 	TpDictEntry				*dict_entry;
+	TpMatchSegment			*candidates = NULL;
 	uint32					 block_count;
 	float4					*block_max_scores;
 	uint32					 i;
 
+	/* No candidate in this segment: nothing to score */
+	if (filter)
+	{
+		candidates = tp_match_filter_segment(filter, reader->root_block);
+		if (candidates->count == 0)
+			return;
+	}
+
 	/* Initialize iterator for this term */
 	if (!tp_segment_posting_iterator_init(&iter, reader, term))
 		return; /* Term not found in segment */
@@ -547,6 +575,15 @@ score_segment_single_term_bmw(
 				continue;
 			}
 
+			/* Skip docs the candidate filter rules out */
+			if (filter &&
+				!tp_match_filter_has_doc(candidates, posting->doc_id))
+			{
+				if (stats)
+					stats->filtered_docs_skipped++;
+				continue;
+			}
+
 			score = compute_bm25_score(
 					idf,
 					posting->frequency,
@@ -575,21 +612,22 @@ tp_score_single_term_bmw(
 		TpLocalIndexState *local_state,
 		Relation		   index,
 		TpDataSource	  *memtable_src,
+		const BlockNumber *level_heads,
 		const char		  *term,
 		float4			   idf,
 		float4			   k1,
 		float4			   b,
 		float4			   avg_doc_len,
 		int				   max_results,
+		float4			   min_score,
+		TpMatchFilter	  *filter,
 		ItemPointerData	  *result_ctids,
 		float4			  *result_scores,
 		TpBMWStats		  *stats)
 {
-	TpTopKHeap		heap;
-	TpIndexMetaPage metap;
-	BlockNumber		level_heads[TP_MAX_LEVELS];
-	int				level;
-	int				result_count;
+	TpTopKHeap heap;
+	int		   level;
+	int		   result_count;
 
 	(void)local_state; /* reserved for future use */
 
@@ -599,16 +637,19 @@ tp_score_single_term_bmw(
 
 	/* Initialize top-k heap */
 	tp_topk_init(&heap, max_results, CurrentMemoryContext);
+	heap.floor = min_score;
 
 	/* Score memtable (exhaustive - no skip index) */
 	score_memtable_single_term(
-			&heap, memtable_src, term, idf, k1, b, avg_doc_len, stats);
-
-	/* Get segment level heads from metapage */
-	metap = tp_get_metapage(index);
-	for (level = 0; level < TP_MAX_LEVELS; level++)
-		level_heads[level] = metap->level_heads[level];
-	pfree(metap);
+			&heap,
+			memtable_src,
+			term,
+			idf,
+			k1,
+			b,
+			avg_doc_len,
+			filter,
+			stats);
 
 	/* Score each segment level with BMW */
 	for (level = 0; level < TP_MAX_LEVELS; level++)
@@ -622,7 +663,15 @@ tp_score_single_term_bmw(
 			CHECK_FOR_INTERRUPTS();
 
 			score_segment_single_term_bmw(
-					&heap, reader, term, idf, k1, b, avg_doc_len, stats);
+					&heap,
+					reader,
+					term,
+					idf,
+					k1,
+					b,
+					avg_doc_len,
+					filter,
+					stats);
 
 			seg_head = reader->header->next_segment;
 			tp_segment_close(reader);
@@ -695,14 +744,15 @@ term_current_doc_id(TpTermState *ts)
  */
 static void
 score_memtable_multi_term(
-		TpTopKHeap	 *heap,
-		TpDataSource *source,
-		TpTermState **terms,
-		int			  term_count,
-		float4		  k1,
-		float4		  b,
-		float4		  avg_doc_len,
-		TpBMWStats	 *stats)
+		TpTopKHeap	  *heap,
+		TpDataSource  *source,
+		TpTermState	 **terms,
+		int			   term_count,
+		float4		   k1,
+		float4		   b,
+		float4		   avg_doc_len,
+		TpMatchFilter *filter,
+		TpBMWStats	  *stats)
 {
 	HTAB   *doc_accum;
 	HASHCTL hash_ctl;
@@ -750,8 +800,10 @@ score_memtable_multi_term(
 			if ((i & 0xFFF) == 0)
 				CHECK_FOR_INTERRUPTS();
 
-			/* Get document length */
-			doc_len = tp_source_get_doc_length(source, ctid);
+			/* Get document length, from the postings when carried */
+			doc_len = postings->doc_lengths != NULL
+							? postings->doc_lengths[i]
+							: tp_source_get_doc_length(source, ctid);
 			if (doc_len <= 0)
 				doc_len = 1;
 
@@ -787,6 +839,14 @@ score_memtable_multi_term(
 		hash_seq_init(&seq, doc_accum);
 		while ((entry = hash_seq_search(&seq)) != NULL)
 		{
+			/* Skip docs the candidate filter rules out */
+			if (filter && !tp_match_filter_has_ctid(filter, &entry->ctid))
+			{
+				if (stats)
+					stats->filtered_docs_skipped++;
+				continue;
+			}
+
 			if (!tp_topk_dominated(heap, entry->score))
 				tp_topk_add_memtable(heap, entry->ctid, entry->score);
 
@@ -1482,9 +1542,19 @@ score_segment_multi_term_bmw(
 		float4			 k1,
 		float4			 b,
 		float4			 avg_doc_len,
+		TpMatchFilter	*filter,
 		TpBMWStats		*stats)
 {
-	int active_count;
+	TpMatchSegment *candidates = NULL;
+	int				active_count;
+
+	/* No candidate in this segment: nothing to score */
+	if (filter)
+	{
+		candidates = tp_match_filter_segment(filter, reader->root_block);
+		if (candidates->count == 0)
+			return;
+	}
 
 	active_count = init_segment_term_states(
 			terms, term_count, reader, k1, b, avg_doc_len);
@@ -1577,12 +1647,17 @@ score_segment_multi_term_bmw(
 		if (!verify_pivot_alignment(terms, pivot_len, pivot_doc_id))
 			continue; /* Re-pivot with new positions */
 
-		/* Skip dead docs */
+		/* Skip dead docs, and docs the candidate filter rules out */
 		if (!tp_segment_is_alive(reader, pivot_doc_id))
 		{
 			if (stats)
 				stats->dead_docs_skipped++;
 		}
+		else if (filter && !tp_match_filter_has_doc(candidates, pivot_doc_id))
+		{
+			if (stats)
+				stats->filtered_docs_skipped++;
+		}
 		else
 		{
 			/* Step 5: Score the pivot document */
@@ -1624,6 +1699,7 @@ tp_score_multi_term_bmw(
 		TpLocalIndexState *local_state,
 		Relation		   index,
 		TpDataSource	  *memtable_src,
+		const BlockNumber *level_heads,
 		char			 **query_terms,
 		int				   term_count,
 		int32			  *query_freqs,
@@ -1632,17 +1708,17 @@ tp_score_multi_term_bmw(
 		float4			   b,
 		float4			   avg_doc_len,
 		int				   max_results,
+		float4			   min_score,
+		TpMatchFilter	  *filter,
 		ItemPointerData	  *result_ctids,
 		float4			  *result_scores,
 		TpBMWStats		  *stats)
 {
-	TpTopKHeap		heap;
-	TpIndexMetaPage metap;
-	BlockNumber		level_heads[TP_MAX_LEVELS];
-	TpTermState	  **terms;
-	int				level;
-	int				result_count;
-	int				i;
+	TpTopKHeap	  heap;
+	TpTermState **terms;
+	int			  level;
+	int			  result_count;
+	int			  i;
 
 	(void)local_state; /* reserved for future use */
 
@@ -1652,6 +1728,7 @@ tp_score_multi_term_bmw(
 
 	/* Initialize top-k heap */
 	tp_topk_init(&heap, max_results, CurrentMemoryContext);
+	heap.floor = min_score;
 
 	/* Initialize term states */
 	terms = palloc(term_count * sizeof(TpTermState *));
@@ -1665,13 +1742,15 @@ tp_score_multi_term_bmw(
 
 	/* Score memtable (exhaustive - no skip index) */
 	score_memtable_multi_term(
-			&heap, memtable_src, terms, term_count, k1, b, avg_doc_len, stats);
-
-	/* Get segment level heads from metapage */
-	metap = tp_get_metapage(index);
-	for (level = 0; level < TP_MAX_LEVELS; level++)
-		level_heads[level] = metap->level_heads[level];
-	pfree(metap);
+			&heap,
+			memtable_src,
+			terms,
+			term_count,
+			k1,
+			b,
+			avg_doc_len,
+			filter,
+			stats);
 
 	/* Score each segment with block-based BMW */
 	for (level = 0; level < TP_MAX_LEVELS; level++)
@@ -1692,6 +1771,7 @@ tp_score_multi_term_bmw(
 					k1,
 					b,
 					avg_doc_len,
+					filter,
 					stats);
 
 			seg_head = reader->header->next_segment;
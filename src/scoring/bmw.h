@@ -16,6 +16,7 @@
 
 #include "index/source.h"
 #include "index/state.h"
+#include "scoring/match.h"
 #include "segment/segment.h"
 
 /*
@@ -38,6 +39,7 @@ typedef struct TpTopKHeap
 	float4 *scores;				 /* Parallel array of scores */
 	int		capacity;			 /* k - maximum results */
 	int		size;				 /* Current entries (0 to k) */
+	float4	floor;				 /* Scores below never enter (0 = none) */
 } TpTopKHeap;
 
 /*
@@ -53,12 +55,14 @@ extern void tp_topk_free(TpTopKHeap *heap);
 
 /*
  * Get current threshold (minimum score to enter top-k).
- * Returns 0 if heap not yet full.
+ * Returns the floor if heap not yet full.
  */
 static inline float4
 tp_topk_threshold(TpTopKHeap *heap)
 {
-	return (heap->size >= heap->capacity) ? heap->scores[0] : 0.0f;
+	if (heap->size >= heap->capacity && heap->scores[0] > heap->floor)
+		return heap->scores[0];
+	return heap->floor;
 }
 
 /*
@@ -69,7 +73,8 @@ tp_topk_threshold(TpTopKHeap *heap)
 static inline bool
 tp_topk_dominated(TpTopKHeap *heap, float4 score)
 {
-	return heap->size >= heap->capacity && score < heap->scores[0];
+	return score < heap->floor ||
+		   (heap->size >= heap->capacity && score < heap->scores[0]);
 }
 
 /*
@@ -113,8 +118,9 @@ typedef struct TpBMWStats
 	uint64 segment_docs_scored; /* Documents scored from segments */
 	uint64 docs_in_results;		/* Documents in final results */
 
-	uint64 seeks_performed;	  /* Binary search seeks executed */
-	uint64 dead_docs_skipped; /* Dead docs filtered by alive bitset */
+	uint64 seeks_performed;		  /* Binary search seeks executed */
+	uint64 dead_docs_skipped;	  /* Dead docs filtered by alive bitset */
+	uint64 filtered_docs_skipped; /* Docs rejected by the candidate filter */
 } TpBMWStats;
 
 /*
@@ -129,18 +135,35 @@ typedef struct TpBMWStats
  * returns.  Threading the source in (instead of re-creating it
  * here) avoids a second full chain walk on every query.
  *
+ * `level_heads` are the segment level heads of the same index
+ * snapshot the memtable source and IDFs came from; the metapage is
+ * not re-read, so a spill or merge after the snapshot cannot make a
+ * document count twice or go missing.
+ *
+ * `filter`, when not NULL, holds the only documents that may be
+ * returned (the scan's match quals); others are skipped alongside
+ * dead documents, before scoring, so they never take a top-k slot.
+ *
+ * `min_score`, when positive, is a score no result may fall below
+ * (a sibling partition's kth score): it seeds the skip threshold, so
+ * fewer than max_results may be returned even when more documents
+ * match.
+ *
  * Returns number of results (up to max_results).
  */
 extern int tp_score_single_term_bmw(
 		TpLocalIndexState *local_state,
 		Relation		   index,
 		TpDataSource	  *memtable_src,
+		const BlockNumber *level_heads,
 		const char		  *term,
 		float4			   idf,
 		float4			   k1,
 		float4			   b,
 		float4			   avg_doc_len,
 		int				   max_results,
+		float4			   min_score,
+		TpMatchFilter	  *filter,
 		ItemPointerData	  *result_ctids,
 		float4			  *result_scores,
 		TpBMWStats		  *stats);
@@ -153,7 +176,8 @@ extern int tp_score_single_term_bmw(
  *
  * `memtable_src` is the already-built chain source over the on-disk
  * memtable chain (may be NULL when the chain is empty).  The caller
- * retains ownership.
+ * retains ownership.  `min_score` and `filter` are as for
+ * tp_score_single_term_bmw.
  *
  * Returns number of results (up to max_results).
  */
@@ -161,6 +185,7 @@ extern int tp_score_multi_term_bmw(
 		TpLocalIndexState *local_state,
 		Relation		   index,
 		TpDataSource	  *memtable_src,
+		const BlockNumber *level_heads,
 		char			 **terms,
 		int				   term_count,
 		int32			  *query_freqs,
@@ -169,6 +194,8 @@ extern int tp_score_multi_term_bmw(
 		float4			   b,
 		float4			   avg_doc_len,
 		int				   max_results,
+		float4			   min_score,
+		TpMatchFilter	  *filter,
 		ItemPointerData	  *result_ctids,
 		float4			  *result_scores,
 		TpBMWStats		  *stats);
@@ -0,0 +1,638 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * match.c - Unscored term matching for bitmap and filter scans
+ *
+ * A match predicate only asks which documents contain the query's
+ * terms, so it reads posting lists without scoring them.  Every
+ * document lives in exactly one source -- the memtable or a single
+ * segment -- so each source is matched on its own: the postings of
+ * all terms are gathered and sorted, and a document is kept when it
+ * occurs for at least one term (any) or for every term (all).  The
+ * quals of a scan are then intersected per source.
+ *
+ * Segment matches stay as doc IDs, which is what block-max WAND sees
+ * when it consults the filter; they are resolved to CTIDs only for
+ * bitmap and unranked scans.  Counting needs neither: a segment's
+ * postings are unioned straight into its alive bitset.
+ */
+#include <postgres.h>
+
+#include <miscadmin.h>
+
+#include "constants.h"
+#include "index/snapshot.h"
+#include "index/source.h"
+#include "scoring/match.h"
+#include "segment/alive_bitset.h"
+#include "segment/io.h"
+
+/* Growable CTID array */
+typedef struct TpMatchResult
+{
+	ItemPointer ctids;
+	int			count;
+	int			capacity;
+} TpMatchResult;
+
+/* Growable doc ID array */
+typedef struct TpMatchDocIds
+{
+	uint32 *ids;
+	int		count;
+	int		capacity;
+} TpMatchDocIds;
+
+static void
+match_append(TpMatchResult *result, ItemPointer ctid)
+{
+	if (result->count == result->capacity)
+	{
+		result->capacity = Max(64, result->capacity * 2);
+		if (result->ctids == NULL)
+			result->ctids = palloc(result->capacity * sizeof(ItemPointerData));
+		else
+			result->ctids = repalloc(
+					result->ctids, result->capacity * sizeof(ItemPointerData));
+	}
+	result->ctids[result->count++] = *ctid;
+}
+
+static void
+match_append_doc_id(TpMatchDocIds *result, uint32 doc_id)
+{
+	if (result->count == result->capacity)
+	{
+		result->capacity = Max(64, result->capacity * 2);
+		if (result->ids == NULL)
+			result->ids = palloc(result->capacity * sizeof(uint32));
+		else
+			result->ids = repalloc(
+					result->ids, result->capacity * sizeof(uint32));
+	}
+	result->ids[result->count++] = doc_id;
+}
+
+static int
+compare_doc_id(const void *a, const void *b)
+{
+	uint32 x = *(const uint32 *)a;
+	uint32 y = *(const uint32 *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int
+compare_ctid(const void *a, const void *b)
+{
+	return ItemPointerCompare((ItemPointer)a, (ItemPointer)b);
+}
+
+/*
+ * Keep one entry of each run of equal doc IDs at least `need` long.
+ * `ids` must be sorted.  Returns the new count.
+ */
+static int
+match_select_doc_ids(uint32 *ids, int count, int need)
+{
+	int out = 0;
+	int i	= 0;
+
+	while (i < count)
+	{
+		int run = 1;
+
+		while (i + run < count && ids[i + run] == ids[i])
+			run++;
+		if (run >= need)
+			ids[out++] = ids[i];
+		i += run;
+	}
+	return out;
+}
+
+/* As match_select_doc_ids, for sorted CTIDs */
+static int
+match_select_ctids(ItemPointer ids, int count, int need)
+{
+	int out = 0;
+	int i	= 0;
+
+	while (i < count)
+	{
+		int run = 1;
+
+		while (i + run < count && ItemPointerEquals(&ids[i + run], &ids[i]))
+			run++;
+		if (run >= need)
+			ids[out++] = ids[i];
+		i += run;
+	}
+	return out;
+}
+
+/*
+ * Match one qual against the memtable.  Its postings carry CTIDs
+ * directly.  Returns the sorted matches.
+ */
+static int
+match_memtable(
+		TpDataSource *src,
+		char		**terms,
+		int			  term_count,
+		bool		  require_all,
+		ItemPointer	 *ctids_out)
+{
+	TpMatchResult postings_all = {0};
+	int			  i;
+
+	*ctids_out = NULL;
+	for (i = 0; i < term_count; i++)
+	{
+		TpPostingData *postings = tp_source_get_postings(src, terms[i]);
+
+		if (postings == NULL || postings->count == 0)
+		{
+			if (postings != NULL)
+				tp_source_free_postings(src, postings);
+			if (require_all)
+			{
+				if (postings_all.ctids)
+					pfree(postings_all.ctids);
+				return 0;
+			}
+			continue;
+		}
+
+		for (int j = 0; j < postings->count; j++)
+			match_append(&postings_all, &postings->ctids[j]);
+		tp_source_free_postings(src, postings);
+	}
+
+	if (postings_all.count == 0)
+		return 0;
+
+	qsort(postings_all.ctids,
+		  postings_all.count,
+		  sizeof(ItemPointerData),
+		  compare_ctid);
+
+	*ctids_out = postings_all.ctids;
+	return match_select_ctids(
+			postings_all.ctids,
+			postings_all.count,
+			require_all ? term_count : 1);
+}
+
+/*
+ * Match one qual against a segment.  Postings are gathered as
+ * segment-local doc IDs, skipping dead documents.  Returns the sorted
+ * matches.
+ */
+static int
+match_segment(
+		TpSegmentReader *reader,
+		char		   **terms,
+		int				 term_count,
+		bool			 require_all,
+		uint32		   **ids_out)
+{
+	TpMatchDocIds ids = {0};
+	int			  i;
+
+	*ids_out = NULL;
+	for (i = 0; i < term_count; i++)
+	{
+		TpSegmentPostingIterator iter;
+		TpSegmentPosting		*posting;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (!tp_segment_posting_iterator_init(&iter, reader, terms[i]))
+		{
+			if (require_all)
+			{
+				if (ids.ids)
+					pfree(ids.ids);
+				return 0;
+			}
+			continue;
+		}
+
+		while (tp_segment_posting_iterator_next(&iter, &posting))
+		{
+			if (tp_segment_is_alive(reader, posting->doc_id))
+				match_append_doc_id(&ids, posting->doc_id);
+		}
+		tp_segment_posting_iterator_free(&iter);
+	}
+
+	if (ids.count == 0)
+		return 0;
+
+	qsort(ids.ids, ids.count, sizeof(uint32), compare_doc_id);
+
+	*ids_out = ids.ids;
+	return match_select_doc_ids(
+			ids.ids, ids.count, require_all ? term_count : 1);
+}
+
+/* Intersect two sorted, duplicate-free CTID arrays into `a` */
+static int
+match_intersect_ctids(ItemPointer a, int a_count, ItemPointer b, int b_count)
+{
+	int i	= 0;
+	int j	= 0;
+	int out = 0;
+
+	while (i < a_count && j < b_count)
+	{
+		int cmp = ItemPointerCompare(&a[i], &b[j]);
+
+		if (cmp < 0)
+			i++;
+		else if (cmp > 0)
+			j++;
+		else
+		{
+			a[out++] = a[i];
+			i++;
+			j++;
+		}
+	}
+	return out;
+}
+
+/* As match_intersect_ctids, for doc IDs */
+static int
+match_intersect_doc_ids(uint32 *a, int a_count, uint32 *b, int b_count)
+{
+	int i	= 0;
+	int j	= 0;
+	int out = 0;
+
+	while (i < a_count && j < b_count)
+	{
+		if (a[i] < b[j])
+			i++;
+		else if (a[i] > b[j])
+			j++;
+		else
+		{
+			a[out++] = a[i];
+			i++;
+			j++;
+		}
+	}
+	return out;
+}
+
+/* Matches of every qual in the memtable */
+static void
+match_filter_memtable(
+		TpMatchFilter *filter, TpDataSource *src, TpMatchQuals *quals)
+{
+	for (int q = 0; q < quals->nqual; q++)
+	{
+		ItemPointer ctids;
+		int			count;
+
+		count = match_memtable(
+				src,
+				quals->terms[q],
+				quals->term_counts[q],
+				quals->require_all[q],
+				&ctids);
+
+		if (q == 0)
+		{
+			filter->memtable_ctids = ctids;
+			filter->memtable_count = count;
+		}
+		else
+		{
+			filter->memtable_count = match_intersect_ctids(
+					filter->memtable_ctids,
+					filter->memtable_count,
+					ctids,
+					count);
+			if (ctids)
+				pfree(ctids);
+		}
+
+		if (filter->memtable_count == 0)
+			break;
+	}
+}
+
+/* Matches of every qual in one segment */
+static void
+match_filter_segment(
+		TpMatchFilter *filter, TpSegmentReader *reader, TpMatchQuals *quals)
+{
+	TpMatchSegment *segment;
+
+	if (filter->segment_count == filter->segment_capacity)
+	{
+		filter->segment_capacity = Max(8, filter->segment_capacity * 2);
+		if (filter->segments == NULL)
+			filter->segments = palloc(
+					filter->segment_capacity * sizeof(TpMatchSegment));
+		else
+			filter->segments = repalloc(
+					filter->segments,
+					filter->segment_capacity * sizeof(TpMatchSegment));
+	}
+	segment = &filter->segments[filter->segment_count++];
+
+	/* Recorded even without matches, so the scorer can skip it */
+	segment->root	 = reader->root_block;
+	segment->doc_ids = NULL;
+	segment->count	 = 0;
+
+	for (int q = 0; q < quals->nqual; q++)
+	{
+		uint32 *ids;
+		int		count;
+
+		count = match_segment(
+				reader,
+				quals->terms[q],
+				quals->term_counts[q],
+				quals->require_all[q],
+				&ids);
+
+		if (q == 0)
+		{
+			segment->doc_ids = ids;
+			segment->count	 = count;
+		}
+		else
+		{
+			segment->count = match_intersect_doc_ids(
+					segment->doc_ids, segment->count, ids, count);
+			if (ids)
+				pfree(ids);
+		}
+
+		if (segment->count == 0)
+			break;
+	}
+}
+
+int
+tp_match_quals_terms(TpMatchQuals *quals, char ***terms_out)
+{
+	char **terms;
+	int	   count = 0;
+
+	for (int q = 0; q < quals->nqual; q++)
+		count += quals->term_counts[q];
+
+	terms = palloc(Max(count, 1) * sizeof(char *));
+	count = 0;
+	for (int q = 0; q < quals->nqual; q++)
+	{
+		memcpy(terms + count,
+			   quals->terms[q],
+			   quals->term_counts[q] * sizeof(char *));
+		count += quals->term_counts[q];
+	}
+
+	*terms_out = terms;
+	return count;
+}
+
+TpMatchFilter *
+tp_match_filter_build(
+		Relation index, TpIndexSnapshot *snapshot, TpMatchQuals *quals)
+{
+	TpMatchFilter *filter = palloc0(sizeof(TpMatchFilter));
+	int			   level;
+
+	Assert(quals->nqual > 0);
+	filter->index = index;
+
+	if (snapshot->memtable != NULL)
+		match_filter_memtable(filter, snapshot->memtable, quals);
+
+	for (level = 0; level < TP_MAX_LEVELS; level++)
+	{
+		BlockNumber seg_head = snapshot->level_heads[level];
+
+		while (seg_head != InvalidBlockNumber)
+		{
+			TpSegmentReader *reader = tp_segment_open(index, seg_head);
+
+			match_filter_segment(filter, reader, quals);
+
+			seg_head = reader->header->next_segment;
+			tp_segment_close(reader);
+		}
+	}
+
+	return filter;
+}
+
+void
+tp_match_filter_free(TpMatchFilter *filter)
+{
+	if (filter->memtable_ctids)
+		pfree(filter->memtable_ctids);
+	for (int i = 0; i < filter->segment_count; i++)
+	{
+		if (filter->segments[i].doc_ids)
+			pfree(filter->segments[i].doc_ids);
+	}
+	if (filter->segments)
+		pfree(filter->segments);
+	if (filter->all_ctids)
+		pfree(filter->all_ctids);
+	pfree(filter);
+}
+
+int
+tp_match_filter_ctids(TpMatchFilter *filter, ItemPointer *ctids_out)
+{
+	TpMatchResult result = {0};
+
+	if (!filter->all_resolved)
+	{
+		for (int i = 0; i < filter->memtable_count; i++)
+			match_append(&result, &filter->memtable_ctids[i]);
+
+		for (int s = 0; s < filter->segment_count; s++)
+		{
+			TpMatchSegment	*segment = &filter->segments[s];
+			TpSegmentReader *reader;
+
+			if (segment->count == 0)
+				continue;
+
+			reader = tp_segment_open(filter->index, segment->root);
+			for (int i = 0; i < segment->count; i++)
+			{
+				ItemPointerData ctid;
+
+				tp_segment_lookup_ctid(reader, segment->doc_ids[i], &ctid);
+				if (ItemPointerIsValid(&ctid))
+					match_append(&result, &ctid);
+			}
+			tp_segment_close(reader);
+		}
+
+		/* Sources are disjoint; the dedup only guards the sort contract */
+		if (result.count > 0)
+		{
+			qsort(result.ctids,
+				  result.count,
+				  sizeof(ItemPointerData),
+				  compare_ctid);
+			result.count =
+					match_select_ctids(result.ctids, result.count, 1);
+		}
+
+		filter->all_ctids	 = result.ctids;
+		filter->all_count	 = result.count;
+		filter->all_resolved = true;
+	}
+
+	*ctids_out = filter->all_ctids;
+	return filter->all_count;
+}
+
+bool
+tp_match_filter_has_ctid(TpMatchFilter *filter, ItemPointer ctid)
+{
+	return filter->memtable_count > 0 &&
+		   bsearch(ctid,
+				   filter->memtable_ctids,
+				   filter->memtable_count,
+				   sizeof(ItemPointerData),
+				   compare_ctid) != NULL;
+}
+
+TpMatchSegment *
+tp_match_filter_segment(TpMatchFilter *filter, BlockNumber root)
+{
+	for (int i = 0; i < filter->segment_count; i++)
+	{
+		if (filter->segments[i].root == root)
+			return &filter->segments[i];
+	}
+	elog(ERROR, "segment at block %u is not in the match filter", root);
+	return NULL;
+}
+
+bool
+tp_match_filter_has_doc(TpMatchSegment *segment, uint32 doc_id)
+{
+	return segment->count > 0 &&
+		   bsearch(&doc_id,
+				   segment->doc_ids,
+				   segment->count,
+				   sizeof(uint32),
+				   compare_doc_id) != NULL;
+}
+
+/*
+ * Count one segment's live documents containing any of `terms`.  The
+ * postings are unioned into a copy of the segment's alive bitset,
+ * clearing each document's bit as it is counted, so every document
+ * counts once and only while alive.  A single term in a segment with
+ * no dead documents is just its dictionary entry's doc_freq.
+ */
+static int64
+match_count_segment(TpSegmentReader *reader, char **terms, int term_count)
+{
+	TpSegmentHeader *header = reader->header;
+	TpAliveBitset	*remaining;
+	int64			 count = 0;
+
+	if (term_count == 1 && (header->alive_bitset_offset == 0 ||
+							header->alive_count == header->num_docs))
+	{
+		TpSegmentPostingIterator iter;
+
+		if (tp_segment_posting_iterator_init(&iter, reader, terms[0]))
+		{
+			count = iter.dict_entry.doc_freq;
+			tp_segment_posting_iterator_free(&iter);
+		}
+		return count;
+	}
+
+	remaining = tp_alive_bitset_load(reader);
+	if (remaining == NULL)
+		remaining = tp_alive_bitset_create(header->num_docs);
+
+	for (int i = 0; i < term_count; i++)
+	{
+		TpSegmentPostingIterator iter;
+		TpSegmentPosting		*posting;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (!tp_segment_posting_iterator_init(&iter, reader, terms[i]))
+			continue;
+
+		while (tp_segment_posting_iterator_next(&iter, &posting))
+		{
+			uint32 doc_id = posting->doc_id;
+			uint8  mask	  = (uint8)(1 << (doc_id & 7));
+
+			if (doc_id < remaining->num_docs &&
+				(remaining->bits[doc_id >> 3] & mask) != 0)
+			{
+				remaining->bits[doc_id >> 3] &= ~mask;
+				count++;
+			}
+		}
+		tp_segment_posting_iterator_free(&iter);
+	}
+
+	tp_alive_bitset_free(remaining);
+	return count;
+}
+
+int64
+tp_match_count(
+		Relation		 index,
+		TpIndexSnapshot *snapshot,
+		char		   **terms,
+		int				 term_count)
+{
+	int64 count = 0;
+
+	if (term_count == 0)
+		return 0;
+
+	/* Memtable documents are never dead: VACUUM spills them first */
+	if (snapshot->memtable != NULL)
+	{
+		ItemPointer ctids;
+
+		count += match_memtable(
+				snapshot->memtable, terms, term_count, false, &ctids);
+		if (ctids)
+			pfree(ctids);
+	}
+
+	for (int level = 0; level < TP_MAX_LEVELS; level++)
+	{
+		BlockNumber seg_head = snapshot->level_heads[level];
+
+		while (seg_head != InvalidBlockNumber)
+		{
+			TpSegmentReader *reader = tp_segment_open(index, seg_head);
+
+			count += match_count_segment(reader, terms, term_count);
+
+			seg_head = reader->header->next_segment;
+			tp_segment_close(reader);
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * match.h - Unscored term matching for bitmap and filter scans
+ */
+#pragma once
+
+#include <postgres.h>
+
+#include <storage/block.h>
+#include <storage/itemptr.h>
+#include <utils/rel.h>
+
+typedef struct TpIndexSnapshot TpIndexSnapshot;
+typedef struct TpSegmentReader TpSegmentReader;
+
+/*
+ * Tokenized WHERE match quals of a scan (@@@ / @@&), ANDed together.
+ * A qual with no terms matches nothing.
+ */
+typedef struct TpMatchQuals
+{
+	int		nqual;
+	char ***terms;		 /* Terms of each qual */
+	int	   *term_counts; /* Number of terms of each qual */
+	bool   *require_all; /* @@& (all terms) rather than @@@ (any) */
+} TpMatchQuals;
+
+/*
+ * Every term of `quals`, for capturing an index snapshot that covers
+ * them.  The array is palloc'd; the strings are the quals' own.
+ * Returns its length.
+ */
+extern int tp_match_quals_terms(TpMatchQuals *quals, char ***terms_out);
+
+/* Documents of one segment satisfying every qual */
+typedef struct TpMatchSegment
+{
+	BlockNumber root;	 /* Segment root block */
+	uint32	   *doc_ids; /* Sorted segment-local doc IDs */
+	int			count;
+} TpMatchSegment;
+
+/*
+ * The documents satisfying a scan's match quals, kept per source as
+ * the scorer sees them: CTIDs for the memtable and doc IDs for each
+ * segment.  Lets block-max WAND reject non-matching documents before
+ * they are scored or enter the top-k heap.
+ */
+typedef struct TpMatchFilter
+{
+	Relation		index;
+	ItemPointer		memtable_ctids; /* Sorted */
+	int				memtable_count;
+	TpMatchSegment *segments;
+	int				segment_count;
+	int				segment_capacity;
+
+	/* Every match as a CTID, resolved on demand */
+	ItemPointer all_ctids;
+	int			all_count;
+	bool		all_resolved;
+} TpMatchFilter;
+
+/*
+ * Match `quals` against the memtable and every segment in `snapshot`,
+ * whose terms must cover all of the quals' terms.  Nothing is scored.
+ */
+extern TpMatchFilter *tp_match_filter_build(
+		Relation index, TpIndexSnapshot *snapshot, TpMatchQuals *quals);
+
+extern void tp_match_filter_free(TpMatchFilter *filter);
+
+/*
+ * All matching CTIDs, sorted and free of duplicates.  The array is
+ * owned by the filter; returns its length.
+ */
+extern int
+tp_match_filter_ctids(TpMatchFilter *filter, ItemPointer *ctids_out);
+
+/* Does a memtable document match? */
+extern bool tp_match_filter_has_ctid(TpMatchFilter *filter, ItemPointer ctid);
+
+/*
+ * The filter's entry for the segment rooted at `root`.  The filter is
+ * built from the snapshot the scorer reads, so it has an entry for
+ * every segment the scorer opens; a missing one is an error.
+ */
+extern TpMatchSegment *
+tp_match_filter_segment(TpMatchFilter *filter, BlockNumber root);
+
+/*
+ * Does a segment document match?  `segment` is the result of
+ * tp_match_filter_segment for the document's segment.
+ */
+extern bool tp_match_filter_has_doc(TpMatchSegment *segment, uint32 doc_id);
+
+/*
+ * Number of documents in `snapshot` containing any of `terms`, whose
+ * terms it must cover.  Nothing is scored and no CTID is resolved.
+ * Documents VACUUM marked dead are left out; whether the rest are
+ * visible to any snapshot is not checked.
+ */
+extern int64 tp_match_count(
+		Relation		 index,
+		TpIndexSnapshot *snapshot,
+		char		   **terms,
+		int				 term_count);
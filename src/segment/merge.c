@@ -17,6 +17,7 @@
 #include "access/am.h"
 #include "constants.h"
 #include "index/metapage.h"
+#include "index/result_cache.h"
 #include "index/state.h"
 #include "segment/alive_bitset.h"
 #include "segment/compression.h"
@@ -26,6 +27,7 @@
 #include "segment/io.h"
 #include "segment/merge.h"
 #include "segment/merge_internal.h"
+#include "segment/merge_throttle.h"
 #include "segment/pagemapper.h"
 #include "segment/segment.h"
 #include "segment/tombstone.h"
@@ -48,20 +50,45 @@ extern bool tp_compress_segments;
  */
 
 void
-merge_sink_init_pages(TpMergeSink *sink, Relation index)
+merge_sink_init_pages(TpMergeSink *sink, Relation index, bool index_locked)
 {
 	memset(sink, 0, sizeof(TpMergeSink));
-	sink->index = index;
+	sink->index		   = index;
+	sink->index_locked = index_locked;
 	tp_segment_writer_init(&sink->writer, index);
 	sink->current_offset = sink->writer.current_offset;
 }
 
 /*
- * Sequential append to sink.
+ * Sink over a BufFile; offsets are file-relative.  The parallel merge
+ * appends posting streams to it; the parallel build's merge rounds
+ * write whole segments, one per file, which need merge_sink_write_at
+ * too.
  */
-static void
+void
+merge_sink_init_buffile(TpMergeSink *sink, BufFile *file, bool index_locked)
+{
+	memset(sink, 0, sizeof(TpMergeSink));
+	sink->file		   = file;
+	sink->index_locked = index_locked;
+}
+
+/*
+ * Sequential append to sink.  Every merge write passes through here,
+ * so this is where merges are throttled.
+ */
+void
 merge_sink_write(TpMergeSink *sink, const void *data, Size size)
 {
+	tp_io_throttle_point(sink->index_locked);
+
+	if (sink->file != NULL)
+	{
+		BufFileWrite(sink->file, data, size);
+		sink->current_offset += size;
+		return;
+	}
+
 	tp_segment_writer_write(&sink->writer, data, size);
 	sink->current_offset = sink->writer.current_offset;
 }
@@ -83,6 +110,22 @@ merge_sink_write_at(
 	uint32		remaining = size;
 	uint64		pos		  = offset;
 
+	/* BufFile: seek back, write, and return to the end */
+	if (sink->file != NULL)
+	{
+		int	  fileno;
+		off_t file_offset;
+
+		tp_buffile_decompose_offset(offset, &fileno, &file_offset);
+		BufFileSeek(sink->file, fileno, file_offset, SEEK_SET);
+		BufFileWrite(sink->file, data, size);
+
+		tp_buffile_decompose_offset(
+				sink->current_offset, &fileno, &file_offset);
+		BufFileSeek(sink->file, fileno, file_offset, SEEK_SET);
+		return;
+	}
+
 	while (remaining > 0)
 	{
 		uint32			  logical_pg = tp_logical_page(pos);
@@ -305,6 +348,45 @@ merge_source_close(TpMergeSource *source)
 	}
 }
 
+/*
+ * Position a source on its first term >= `term`, or mark it exhausted
+ * if there is none.  Binary search over the cached string offsets.
+ */
+void
+merge_source_seek(TpMergeSource *source, const char *term)
+{
+	uint32 lo = 0;
+	uint32 hi = source->num_terms;
+
+	if (source->reader == NULL)
+		return;
+
+	while (lo < hi)
+	{
+		uint32 mid = lo + (hi - lo) / 2;
+		char  *mid_term;
+		int	   cmp;
+
+		mid_term = tp_segment_read_term_at_index(
+				source->reader,
+				source->reader->header,
+				source->string_offsets,
+				mid);
+		cmp = strcmp(mid_term, term);
+		pfree(mid_term);
+
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* merge_source_advance moves to lo; UINT32_MAX wraps to 0 */
+	source->exhausted	= false;
+	source->current_idx = lo - 1;
+	merge_source_advance(source);
+}
+
 /*
  * Find the source with the lexicographically smallest current term.
  * Returns -1 if all sources are exhausted.
@@ -360,6 +442,95 @@ merged_term_add_segment_ref(
 	term->num_segment_refs++;
 }
 
+/*
+ * N-way merge of the sources' term dictionaries: collect up to
+ * max_terms terms in order, each with the segments that hold it,
+ * advancing the sources past them.  Returns a palloc'd array (NULL
+ * when no term remains) and its length in *num_terms.
+ */
+TpMergedTerm *
+merge_collect_terms(
+		TpMergeSource *sources,
+		int			   num_sources,
+		uint32		   max_terms,
+		uint32		  *num_terms)
+{
+	TpMergedTerm *merged_terms	   = NULL;
+	uint32		  num_merged_terms = 0;
+	uint32		  merged_capacity  = 0;
+	int			  i;
+
+	while (num_merged_terms < max_terms)
+	{
+		int			  min_idx;
+		const char	 *min_term;
+		TpMergedTerm *current_merged;
+
+		/* Find source with smallest term */
+		min_idx = merge_find_min_source(sources, num_sources);
+		if (min_idx < 0)
+			break; /* All sources exhausted */
+
+		min_term = sources[min_idx].current_term;
+
+		/* Grow merged terms array if needed (may exceed 1GB for large
+		 * corpora) */
+		if (num_merged_terms >= merged_capacity)
+		{
+			merged_capacity = merged_capacity == 0 ? 1024
+												   : merged_capacity * 2;
+			if (merged_terms == NULL)
+				merged_terms = palloc_extended(
+						merged_capacity * sizeof(TpMergedTerm),
+						MCXT_ALLOC_HUGE);
+			else
+				merged_terms = repalloc_huge(
+						merged_terms, merged_capacity * sizeof(TpMergedTerm));
+		}
+
+		/* Initialize new merged term */
+		current_merged					 = &merged_terms[num_merged_terms];
+		current_merged->term_len		 = strlen(min_term);
+		current_merged->term			 = pstrdup(min_term);
+		current_merged->segment_refs	 = NULL;
+		current_merged->num_segment_refs = 0;
+		current_merged->segment_refs_capacity = 0;
+		current_merged->posting_offset		  = 0; /* Set during write */
+		current_merged->posting_count		  = 0; /* Set during write */
+		num_merged_terms++;
+
+		/*
+		 * Record which segments have this term (don't load postings yet).
+		 * IMPORTANT: Use current_merged->term (the pstrdup'd copy) for
+		 * comparison, NOT min_term. When we advance sources[min_idx],
+		 * merge_source_advance() frees sources[min_idx].current_term, which
+		 * min_term points to. Using min_term after that would be
+		 * use-after-free undefined behavior.
+		 */
+		for (i = 0; i < num_sources; i++)
+		{
+			if (sources[i].exhausted)
+				continue;
+
+			if (strcmp(sources[i].current_term, current_merged->term) == 0)
+			{
+				/* Record segment ref for later streaming merge */
+				merged_term_add_segment_ref(
+						current_merged, i, &sources[i].current_entry);
+
+				/* Advance this source to next term */
+				merge_source_advance(&sources[i]);
+			}
+		}
+
+		/* Check for interrupt */
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	*num_terms = num_merged_terms;
+	return merged_terms;
+}
+
 /*
  * Load the next block of postings for merge source.
  * Returns true if a block was loaded, false if no more blocks remain.
@@ -648,6 +819,103 @@ typedef struct TpDocmapMergeSource
 	bool		  owns_arrays;	/* True if we allocated the arrays */
 } TpDocmapMergeSource;
 
+/*
+ * Docs [lo, hi) of one disjoint source, with no other source's docs
+ * between them in CTID order.
+ */
+typedef struct TpDocmapPiece
+{
+	int			 source;
+	uint32		 lo;
+	uint32		 hi;
+	BlockNumber	 page; /* CTID of doc lo */
+	OffsetNumber offset;
+} TpDocmapPiece;
+
+static int
+docmap_piece_cmp(const void *a, const void *b)
+{
+	const TpDocmapPiece *pa = (const TpDocmapPiece *)a;
+	const TpDocmapPiece *pb = (const TpDocmapPiece *)b;
+
+	if (pa->page != pb->page)
+		return pa->page < pb->page ? -1 : 1;
+	if (pa->offset != pb->offset)
+		return pa->offset < pb->offset ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Split disjoint sources into the pieces their docs are concatenated
+ * from: one per source, in source order, or with `chunks`, one per
+ * chunk a source has docs in, in CTID order.  A chunk was scanned by
+ * a single worker, whose segments split it into consecutive CTID
+ * ranges, so its docs in any one source never interleave with another
+ * source's.
+ */
+static TpDocmapPiece *
+docmap_collect_pieces(
+		TpDocmapMergeSource *msources,
+		int					 num_sources,
+		const TpMergeChunks *chunks,
+		uint32				*num_pieces)
+{
+	TpDocmapPiece *pieces;
+	uint32		   count	= 0;
+	uint32		   capacity = Max(num_sources, 1);
+	int			   i;
+
+	pieces = palloc(capacity * sizeof(TpDocmapPiece));
+	for (i = 0; i < num_sources; i++)
+	{
+		TpDocmapMergeSource *ms	   = &msources[i];
+		uint32				 lo	   = 0;
+		uint32				 chunk = 0;
+
+		while (lo < ms->num_docs)
+		{
+			uint32 hi = ms->num_docs;
+
+			if (chunks != NULL)
+			{
+				/* The piece ends where the next chunk starts */
+				while (chunk + 1 < chunks->count &&
+					   chunks->starts[chunk + 1] <= ms->ctid_pages[lo])
+					chunk++;
+				if (chunk + 1 < chunks->count)
+				{
+					BlockNumber end = chunks->starts[chunk + 1];
+
+					hi = lo + 1;
+					while (hi < ms->num_docs && ms->ctid_pages[hi] < end)
+						hi++;
+				}
+			}
+
+			if (count >= capacity)
+			{
+				capacity *= 2;
+				pieces = repalloc_huge(
+						pieces, capacity * sizeof(TpDocmapPiece));
+			}
+			pieces[count].source = i;
+			pieces[count].lo	 = lo;
+			pieces[count].hi	 = hi;
+			pieces[count].page	 = ms->ctid_pages[lo];
+			pieces[count].offset = ms->ctid_offsets[lo];
+			count++;
+
+			lo = hi;
+		}
+	}
+
+	if (chunks != NULL)
+		qsort(pieces, count, sizeof(TpDocmapPiece), docmap_piece_cmp);
+
+	*num_pieces = count;
+	return pieces;
+}
+
 /*
  * Build merged docmap using streaming N-way merge of sorted CTID arrays.
  * Also builds direct mapping arrays for fast old->new doc_id lookup.
@@ -659,10 +927,11 @@ typedef struct TpDocmapMergeSource
  */
 TpDocMapBuilder *
 build_merged_docmap(
-		TpMergeSource	  *sources,
-		int				   num_sources,
-		TpMergeDocMapping *mapping,
-		bool			   disjoint_sources)
+		TpMergeSource		*sources,
+		int					 num_sources,
+		TpMergeDocMapping	*mapping,
+		bool				 disjoint_sources,
+		const TpMergeChunks *chunks)
 {
 	TpDocMapBuilder		*docmap;
 	TpDocmapMergeSource *msources;
@@ -750,31 +1019,48 @@ build_merged_docmap(
 	 * Step 3: Merge docmaps.
 	 *
 	 * When disjoint_sources is true, sources have non-overlapping
-	 * CTID ranges in source order, so we concatenate sequentially
-	 * instead of doing an N-way comparison. This eliminates the
-	 * per-doc CTID comparison overhead.
+	 * CTID ranges in source order, or within each of `chunks`, so we
+	 * concatenate pieces sequentially instead of doing an N-way
+	 * comparison. This eliminates the per-doc CTID comparison
+	 * overhead.
 	 */
 	if (disjoint_sources)
 	{
-		for (i = 0; i < num_sources; i++)
+		TpDocmapPiece *pieces;
+		uint32		   num_pieces;
+		uint32		   p;
+
+		pieces = docmap_collect_pieces(
+				msources, num_sources, chunks, &num_pieces);
+
+		for (p = 0; p < num_pieces; p++)
 		{
-			TpDocmapMergeSource *ms = &msources[i];
+			int					 src = pieces[p].source;
+			TpDocmapMergeSource *ms	 = &msources[src];
 			uint32				 j;
 
-			for (j = 0; j < ms->num_docs; j++)
+			for (j = pieces[p].lo; j < pieces[p].hi; j++)
 			{
-				if (!tp_segment_is_alive(sources[i].reader, j))
+				if (!tp_segment_is_alive(sources[src].reader, j))
 				{
-					mapping->old_to_new[i][j] = TP_MERGE_DOC_DEAD;
+					mapping->old_to_new[src][j] = TP_MERGE_DOC_DEAD;
 					continue;
 				}
-				mapping->old_to_new[i][j]  = new_doc_id;
-				out_pages[new_doc_id]	   = ms->ctid_pages[j];
-				out_offsets[new_doc_id]	   = ms->ctid_offsets[j];
-				out_fieldnorms[new_doc_id] = ms->fieldnorms[j];
+
+				/* Pieces of chunks must not overlap */
+				Assert(chunks == NULL || new_doc_id == 0 ||
+					   out_pages[new_doc_id - 1] < ms->ctid_pages[j] ||
+					   (out_pages[new_doc_id - 1] == ms->ctid_pages[j] &&
+						out_offsets[new_doc_id - 1] < ms->ctid_offsets[j]));
+
+				mapping->old_to_new[src][j] = new_doc_id;
+				out_pages[new_doc_id]		= ms->ctid_pages[j];
+				out_offsets[new_doc_id]		= ms->ctid_offsets[j];
+				out_fieldnorms[new_doc_id]	= ms->fieldnorms[j];
 				new_doc_id++;
 			}
 		}
+		pfree(pieces);
 	}
 	else
 	{
@@ -971,237 +1257,130 @@ free_term_posting_sources(TpPostingMergeSource *psources, int num_psources)
 /* MergeTermBlockInfo is defined in merge_internal.h */
 
 /* ----------------------------------------------------------------
- * Unified merged segment writer
+ * Posting streams
  * ----------------------------------------------------------------
  */
 
 /*
- * Write a merged segment to pages via sink.
+ * New doc ID of a fast posting source's current posting, first
+ * skipping postings of dead docs; TP_MERGE_DOC_DEAD once the source
+ * is exhausted.
+ */
+static uint32
+posting_source_next_live(TpPostingMergeSource *ps, const uint32 *old_to_new)
+{
+	while (!ps->exhausted)
+	{
+		uint32 new_id =
+				old_to_new[ps->block_postings[ps->current_in_block].doc_id];
+
+		if (new_id != TP_MERGE_DOC_DEAD)
+			return new_id;
+		posting_source_advance_fast(ps);
+	}
+	return TP_MERGE_DOC_DEAD;
+}
+
+/*
+ * Stream the postings of terms[0..num_terms) to the sink, remapping
+ * doc IDs through doc_mapping and dropping dead docs.
  *
- * Layout: [header] -> [dictionary] -> [postings] -> [skip index] ->
- *         [fieldnorm] -> [ctid map]
+ * term_blocks[i] receives term i's posting offset, doc_freq, block
+ * count, and the index of its first skip entry in `skips`; offsets
+ * are sink offsets, so a BufFile sink yields file-relative offsets
+ * for the parallel merge to rebase.
  *
- * Also writes page index and backpatches header with
- * num_pages/page_index. Caller reads sink->writer.pages[0] for root.
+ * When disjoint_sources is true, drain runs of consecutive docs
+ * source by source without CTID lookups.  Otherwise, use N-way
+ * CTID-comparison merge.
  */
 void
-write_merged_segment_to_sink(
-		TpMergeSink	  *sink,
-		TpMergedTerm  *terms,
-		uint32		   num_terms,
-		TpMergeSource *sources,
-		int			   num_sources,
-		uint32		   target_level,
-		uint64		   total_tokens,
-		bool		   disjoint_sources)
+merge_write_term_postings(
+		TpMergeSink		   *sink,
+		TpMergedTerm	   *terms,
+		uint32				num_terms,
+		TpMergeSource	   *sources,
+		TpMergeDocMapping  *doc_mapping,
+		bool				disjoint_sources,
+		MergeTermBlockInfo *term_blocks,
+		MergeSkipAccum	   *skips)
 {
-	TpSegmentHeader		header;
-	TpDictionary		dict;
-	TpDocMapBuilder	   *docmap;
-	TpMergeDocMapping	doc_mapping;
-	MergeTermBlockInfo *term_blocks;
-	uint32			   *string_offsets;
-	uint64				string_pos;
-	uint32				i;
-
-	/* Accumulated skip entries for all terms */
-	TpSkipEntry *all_skip_entries;
-	uint32		 skip_entries_count;
-	uint32		 skip_entries_capacity;
-
-	if (num_terms == 0)
-		return;
-
-	/* Build docmap and direct mapping arrays from source segments */
-	docmap = build_merged_docmap(
-			sources, num_sources, &doc_mapping, disjoint_sources);
-
 	/*
-	 * build_merged_docmap sets docmap->total_tokens from source
-	 * header.total_tokens minus dead-doc fieldnorm approximations;
-	 * see its comment for the exact-vs-approximate trade-off.  The
-	 * caller's total_tokens parameter is ignored.
+	 * Helper macro: flush a full or partial block_buf to the sink.
+	 * Computes skip entry, optionally compresses, writes data,
+	 * and accumulates the skip entry.
 	 */
-	total_tokens = docmap->total_tokens;
+#define FLUSH_BLOCK(block_buf, block_count, num_blocks)                         \
+	do                                                                          \
+	{                                                                           \
+		TpSkipEntry skip_;                                                      \
+		uint16		max_tf_	  = 0;                                              \
+		uint8		min_norm_ = 255;                                            \
+		uint32		last_did_ = 0;                                              \
+		uint32		j_;                                                         \
+                                                                                \
+		for (j_ = 0; j_ < (block_count); j_++)                                  \
+		{                                                                       \
+			if ((block_buf)[j_].doc_id > last_did_)                             \
+				last_did_ = (block_buf)[j_].doc_id;                             \
+			if ((block_buf)[j_].frequency > max_tf_)                            \
+				max_tf_ = (block_buf)[j_].frequency;                            \
+			if ((block_buf)[j_].fieldnorm < min_norm_)                          \
+				min_norm_ = (block_buf)[j_].fieldnorm;                          \
+		}                                                                       \
+                                                                                \
+		skip_.last_doc_id	 = last_did_;                                       \
+		skip_.doc_count		 = (uint8)(block_count);                            \
+		skip_.block_max_tf	 = max_tf_;                                         \
+		skip_.block_max_norm = min_norm_;                                       \
+		skip_.posting_offset = sink->current_offset;                            \
+		memset(skip_.reserved, 0, sizeof(skip_.reserved));                      \
+                                                                                \
+		if (tp_compress_segments)                                               \
+		{                                                                       \
+			uint8  cbuf_[TP_MAX_COMPRESSED_BLOCK_SIZE];                         \
+			uint32 csize_;                                                      \
+                                                                                \
+			csize_		= tp_compress_block((block_buf), (block_count), cbuf_); \
+			skip_.flags = TP_BLOCK_FLAG_DELTA;                                  \
+			merge_sink_write(sink, cbuf_, csize_);                              \
+		}                                                                       \
+		else                                                                    \
+		{                                                                       \
+			skip_.flags = TP_BLOCK_FLAG_UNCOMPRESSED;                           \
+			merge_sink_write(                                                   \
+					sink,                                                       \
+					(block_buf),                                                \
+					(block_count) * sizeof(TpBlockPosting));                    \
+		}                                                                       \
+                                                                                \
+		if (skips->count >= skips->capacity)                                    \
+		{                                                                       \
+			skips->capacity *= 2;                                               \
+			skips->entries = repalloc_huge(                                     \
+					skips->entries,                                             \
+					skips->capacity * sizeof(TpSkipEntry));                     \
+		}                                                                       \
+		skips->entries[skips->count++] = skip_;                                 \
+		(num_blocks)++;                                                         \
+	} while (0)
 
 	/*
-	 * If all docs are dead, nothing to write. Clean up and return.
+	 * Streaming pass: for each term, stream postings one block at a
+	 * time and write immediately.
 	 */
-	if (docmap->num_docs == 0)
+	for (uint32 i = 0; i < num_terms; i++)
 	{
-		free_merge_doc_mapping(&doc_mapping);
-		tp_docmap_destroy(docmap);
-		return;
-	}
+		TpPostingMergeSource *psources;
+		int					  num_psources;
+		TpBlockPosting		  block_buf[TP_BLOCK_SIZE];
+		uint32				  block_count = 0;
+		uint32				  doc_count	  = 0;
+		uint32				  num_blocks  = 0;
 
-	/* Prepare header placeholder */
-	memset(&header, 0, sizeof(TpSegmentHeader));
-	header.magic		= TP_SEGMENT_MAGIC;
-	header.version		= TP_SEGMENT_FORMAT_VERSION;
-	header.created_at	= GetCurrentTimestamp();
-	header.num_pages	= 0;
-	header.num_terms	= num_terms;
-	header.level		= target_level;
-	header.next_segment = InvalidBlockNumber;
-	header.num_docs		= docmap->num_docs;
-	header.total_tokens = total_tokens;
-	header.page_index	= InvalidBlockNumber;
-
-	/* Write placeholder header */
-	merge_sink_write(sink, &header, sizeof(TpSegmentHeader));
-
-	/* Dictionary immediately follows header */
-	header.dictionary_offset = sink->current_offset;
-
-	/* Write dictionary header */
-	memset(&dict, 0, sizeof(dict));
-	dict.num_terms = num_terms;
-	merge_sink_write(sink, &dict, offsetof(TpDictionary, string_offsets));
-
-	/* Calculate string offsets */
-	string_offsets = palloc_extended(
-			num_terms * sizeof(uint32), MCXT_ALLOC_HUGE | MCXT_ALLOC_ZERO);
-	string_pos = 0;
-	for (i = 0; i < num_terms; i++)
-	{
-		/*
-		 * String-pool offsets are stored as uint32 in the segment
-		 * format.  Fail loudly before writing rather than silently
-		 * wrapping and producing a segment that reads from the wrong
-		 * place (issue #432).
-		 */
-		if (string_pos > PG_UINT32_MAX)
-			ereport(ERROR,
-					(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
-					 errmsg("pg_textsearch: merged segment string pool "
-							"exceeds the %u-byte format limit",
-							PG_UINT32_MAX),
-					 errhint("The corpus vocabulary is too large for a "
-							 "single segment.")));
-
-		string_offsets[i] = (uint32)string_pos;
-		string_pos += (uint64)sizeof(uint32) + terms[i].term_len +
-					  sizeof(uint32);
-	}
-
-	/* Write string offsets array */
-	merge_sink_write(sink, string_offsets, num_terms * sizeof(uint32));
-
-	/* Write string pool */
-	header.strings_offset = sink->current_offset;
-	for (i = 0; i < num_terms; i++)
-	{
-		uint32 length	   = terms[i].term_len;
-		uint32 dict_offset = i * sizeof(TpDictEntry);
-
-		merge_sink_write(sink, &length, sizeof(uint32));
-		merge_sink_write(sink, terms[i].term, length);
-		merge_sink_write(sink, &dict_offset, sizeof(uint32));
-	}
-
-	/* Record entries offset - dict entries written after postings */
-	header.entries_offset = sink->current_offset;
-
-	/* Write placeholder dict entries */
-	{
-		TpDictEntry placeholder;
-		memset(&placeholder, 0, sizeof(TpDictEntry));
-		for (i = 0; i < num_terms; i++)
-			merge_sink_write(sink, &placeholder, sizeof(TpDictEntry));
-	}
-
-	/* Postings start here */
-	header.postings_offset = sink->current_offset;
-
-	/* Initialize per-term tracking and skip entry accumulator */
-	term_blocks = palloc_extended(
-			num_terms * sizeof(MergeTermBlockInfo),
-			MCXT_ALLOC_HUGE | MCXT_ALLOC_ZERO);
-
-	skip_entries_capacity = 1024;
-	skip_entries_count	  = 0;
-	all_skip_entries = palloc(skip_entries_capacity * sizeof(TpSkipEntry));
-
-	/*
-	 * Helper macro: flush a full or partial block_buf to the sink.
-	 * Computes skip entry, optionally compresses, writes data,
-	 * and accumulates the skip entry.
-	 */
-#define FLUSH_BLOCK(block_buf, block_count, num_blocks)                         \
-	do                                                                          \
-	{                                                                           \
-		TpSkipEntry skip_;                                                      \
-		uint16		max_tf_	  = 0;                                              \
-		uint8		min_norm_ = 255;                                            \
-		uint32		last_did_ = 0;                                              \
-		uint32		j_;                                                         \
-                                                                                \
-		for (j_ = 0; j_ < (block_count); j_++)                                  \
-		{                                                                       \
-			if ((block_buf)[j_].doc_id > last_did_)                             \
-				last_did_ = (block_buf)[j_].doc_id;                             \
-			if ((block_buf)[j_].frequency > max_tf_)                            \
-				max_tf_ = (block_buf)[j_].frequency;                            \
-			if ((block_buf)[j_].fieldnorm < min_norm_)                          \
-				min_norm_ = (block_buf)[j_].fieldnorm;                          \
-		}                                                                       \
-                                                                                \
-		skip_.last_doc_id	 = last_did_;                                       \
-		skip_.doc_count		 = (uint8)(block_count);                            \
-		skip_.block_max_tf	 = max_tf_;                                         \
-		skip_.block_max_norm = min_norm_;                                       \
-		skip_.posting_offset = sink->current_offset;                            \
-		memset(skip_.reserved, 0, sizeof(skip_.reserved));                      \
-                                                                                \
-		if (tp_compress_segments)                                               \
-		{                                                                       \
-			uint8  cbuf_[TP_MAX_COMPRESSED_BLOCK_SIZE];                         \
-			uint32 csize_;                                                      \
-                                                                                \
-			csize_		= tp_compress_block((block_buf), (block_count), cbuf_); \
-			skip_.flags = TP_BLOCK_FLAG_DELTA;                                  \
-			merge_sink_write(sink, cbuf_, csize_);                              \
-		}                                                                       \
-		else                                                                    \
-		{                                                                       \
-			skip_.flags = TP_BLOCK_FLAG_UNCOMPRESSED;                           \
-			merge_sink_write(                                                   \
-					sink,                                                       \
-					(block_buf),                                                \
-					(block_count) * sizeof(TpBlockPosting));                    \
-		}                                                                       \
-                                                                                \
-		if (skip_entries_count >= skip_entries_capacity)                        \
-		{                                                                       \
-			skip_entries_capacity *= 2;                                         \
-			all_skip_entries = repalloc_huge(                                   \
-					all_skip_entries,                                           \
-					skip_entries_capacity * sizeof(TpSkipEntry));               \
-		}                                                                       \
-		all_skip_entries[skip_entries_count++] = skip_;                         \
-		(num_blocks)++;                                                         \
-	} while (0)
-
-	/*
-	 * Streaming pass: for each term, stream postings one block at a
-	 * time and write immediately.
-	 *
-	 * When disjoint_sources is true, drain sources sequentially
-	 * (source 0 fully, then source 1, etc.) without CTID lookups.
-	 * Otherwise, use N-way CTID-comparison merge.
-	 */
-	for (i = 0; i < num_terms; i++)
-	{
-		TpPostingMergeSource *psources;
-		int					  num_psources;
-		TpBlockPosting		  block_buf[TP_BLOCK_SIZE];
-		uint32				  block_count = 0;
-		uint32				  doc_count	  = 0;
-		uint32				  num_blocks  = 0;
-
-		/* Record where this term's postings start */
-		term_blocks[i].posting_offset	= sink->current_offset;
-		term_blocks[i].skip_entry_start = skip_entries_count;
+		/* Record where this term's postings start */
+		term_blocks[i].posting_offset	= sink->current_offset;
+		term_blocks[i].skip_entry_start = skips->count;
 
 		if (terms[i].num_segment_refs == 0)
 		{
@@ -1213,31 +1392,57 @@ write_merged_segment_to_sink(
 		if (disjoint_sources)
 		{
 			/*
-			 * Fast path: sequential drain. Sources have disjoint
-			 * CTID ranges, so drain source 0, then 1, etc.
-			 * Reads doc_id/frequency/fieldnorm directly from
+			 * Fast path: drain runs.  Sources are disjoint as a whole
+			 * or per chunk, so each holds long runs of consecutive new
+			 * doc IDs.  Drain the source with the lowest next doc
+			 * until it passes the lowest next doc of any other, then
+			 * pick again; wholly disjoint sources drain one after the
+			 * other.  Reads doc_id/frequency/fieldnorm directly from
 			 * the block posting array, skipping CTID lookups.
 			 */
 			psources = init_term_posting_sources_fast(
 					&terms[i], sources, &num_psources);
 
-			for (int src = 0; src < num_psources; src++)
+			for (;;)
 			{
-				while (!psources[src].exhausted)
+				int			  src	= -1;
+				uint32		  low	= TP_MERGE_DOC_DEAD;
+				uint32		  bound = TP_MERGE_DOC_DEAD;
+				const uint32 *map;
+
+				for (int k = 0; k < num_psources; k++)
 				{
-					TpBlockPosting *bp =
-							&psources[src].block_postings
-									 [psources[src].current_in_block];
-					int	   seg_idx = terms[i].segment_refs[src].segment_idx;
-					uint32 new_id =
-							doc_mapping.old_to_new[seg_idx][bp->doc_id];
+					uint32 id = posting_source_next_live(
+							&psources[k],
+							doc_mapping->old_to_new
+									[terms[i].segment_refs[k].segment_idx]);
 
-					if (new_id == TP_MERGE_DOC_DEAD)
+					if (id < low)
 					{
-						posting_source_advance_fast(&psources[src]);
-						continue;
+						bound = low;
+						low	  = id;
+						src	  = k;
 					}
+					else if (id < bound)
+						bound = id;
+				}
+
+				if (src < 0)
+					break;
 
+				map = doc_mapping->old_to_new
+							  [terms[i].segment_refs[src].segment_idx];
+				for (;;)
+				{
+					uint32			new_id;
+					TpBlockPosting *bp;
+
+					new_id = posting_source_next_live(&psources[src], map);
+					if (new_id == TP_MERGE_DOC_DEAD || new_id > bound)
+						break;
+
+					bp = &psources[src].block_postings
+								  [psources[src].current_in_block];
 					block_buf[block_count].doc_id	 = new_id;
 					block_buf[block_count].frequency = bp->frequency;
 					block_buf[block_count].fieldnorm = bp->fieldnorm;
@@ -1273,7 +1478,7 @@ write_merged_segment_to_sink(
 					int src_idx = terms[i].segment_refs[min_idx].segment_idx;
 					uint32 old_doc_id = psources[min_idx].current.old_doc_id;
 					uint32 new_id =
-							doc_mapping.old_to_new[src_idx][old_doc_id];
+							doc_mapping->old_to_new[src_idx][old_doc_id];
 
 					if (new_id == TP_MERGE_DOC_DEAD)
 					{
@@ -1316,20 +1521,202 @@ write_merged_segment_to_sink(
 	}
 
 #undef FLUSH_BLOCK
+}
+
+/* ----------------------------------------------------------------
+ * Unified merged segment writer
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Write a merged segment via sink.
+ *
+ * Layout: [header] -> [dictionary] -> [postings] -> [skip index] ->
+ *         [fieldnorm] -> [ctid map]
+ *
+ * For a pages sink, also writes the page index and backpatches the
+ * header with num_pages/page_index; caller reads
+ * sink->writer.pages[0] for root.  A BufFile sink gets the flat
+ * layout tp_segment_open_from_buffile reads, starting at offset 0;
+ * sink->current_offset is its size afterwards.
+ */
+void
+write_merged_segment_to_sink(
+		TpMergeSink			*sink,
+		TpMergedTerm		*terms,
+		uint32				 num_terms,
+		TpMergeSource		*sources,
+		int					 num_sources,
+		uint32				 target_level,
+		uint64				 total_tokens,
+		bool				 disjoint_sources,
+		const TpMergeChunks *chunks)
+{
+	TpSegmentHeader		header;
+	TpDictionary		dict;
+	TpDocMapBuilder	   *docmap;
+	TpMergeDocMapping	doc_mapping;
+	MergeTermBlockInfo *term_blocks;
+	uint32			   *string_offsets;
+	uint64				string_pos;
+	uint32				i;
+	MergeSkipAccum		skips; /* skip entries for all terms */
+	TpParallelMerge	   *pmerge;
+
+	if (num_terms == 0)
+		return;
+
+	/* Build docmap and direct mapping arrays from source segments */
+	docmap = build_merged_docmap(
+			sources, num_sources, &doc_mapping, disjoint_sources, chunks);
+
+	/*
+	 * build_merged_docmap sets docmap->total_tokens from source
+	 * header.total_tokens minus dead-doc fieldnorm approximations;
+	 * see its comment for the exact-vs-approximate trade-off.  The
+	 * caller's total_tokens parameter is ignored.
+	 */
+	total_tokens = docmap->total_tokens;
+
+	/*
+	 * If all docs are dead, nothing to write. Clean up and return.
+	 */
+	if (docmap->num_docs == 0)
+	{
+		free_merge_doc_mapping(&doc_mapping);
+		tp_docmap_destroy(docmap);
+		return;
+	}
+
+	/*
+	 * Large merges of on-disk segments hand the posting streams to
+	 * parallel workers, partitioned by term range.  They start now
+	 * and run while the leader writes the dictionary below.
+	 */
+	pmerge = NULL;
+	if (sink->file == NULL)
+		pmerge = tp_parallel_merge_begin(
+				sink->index,
+				terms,
+				num_terms,
+				sources,
+				num_sources,
+				&doc_mapping,
+				disjoint_sources,
+				sink->index_locked);
+
+	/* Prepare header placeholder */
+	memset(&header, 0, sizeof(TpSegmentHeader));
+	header.magic		= TP_SEGMENT_MAGIC;
+	header.version		= TP_SEGMENT_FORMAT_VERSION;
+	header.created_at	= GetCurrentTimestamp();
+	header.num_pages	= 0;
+	header.num_terms	= num_terms;
+	header.level		= target_level;
+	header.next_segment = InvalidBlockNumber;
+	header.num_docs		= docmap->num_docs;
+	header.total_tokens = total_tokens;
+	header.page_index	= InvalidBlockNumber;
+
+	/* Write placeholder header */
+	merge_sink_write(sink, &header, sizeof(TpSegmentHeader));
+
+	/* Dictionary immediately follows header */
+	header.dictionary_offset = sink->current_offset;
+
+	/* Write dictionary header */
+	memset(&dict, 0, sizeof(dict));
+	dict.num_terms = num_terms;
+	merge_sink_write(sink, &dict, offsetof(TpDictionary, string_offsets));
+
+	/* Calculate string offsets */
+	string_offsets = palloc_extended(
+			num_terms * sizeof(uint32), MCXT_ALLOC_HUGE | MCXT_ALLOC_ZERO);
+	string_pos = 0;
+	for (i = 0; i < num_terms; i++)
+	{
+		/*
+		 * String-pool offsets are stored as uint32 in the segment
+		 * format.  Fail loudly before writing rather than silently
+		 * wrapping and producing a segment that reads from the wrong
+		 * place (issue #432).
+		 */
+		if (string_pos > PG_UINT32_MAX)
+			ereport(ERROR,
+					(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+					 errmsg("pg_textsearch: merged segment string pool "
+							"exceeds the %u-byte format limit",
+							PG_UINT32_MAX),
+					 errhint("The corpus vocabulary is too large for a "
+							 "single segment.")));
+
+		string_offsets[i] = (uint32)string_pos;
+		string_pos += (uint64)sizeof(uint32) + terms[i].term_len +
+					  sizeof(uint32);
+	}
+
+	/* Write string offsets array */
+	merge_sink_write(sink, string_offsets, num_terms * sizeof(uint32));
+
+	/* Write string pool */
+	header.strings_offset = sink->current_offset;
+	for (i = 0; i < num_terms; i++)
+	{
+		uint32 length	   = terms[i].term_len;
+		uint32 dict_offset = i * sizeof(TpDictEntry);
+
+		merge_sink_write(sink, &length, sizeof(uint32));
+		merge_sink_write(sink, terms[i].term, length);
+		merge_sink_write(sink, &dict_offset, sizeof(uint32));
+	}
+
+	/* Record entries offset - dict entries written after postings */
+	header.entries_offset = sink->current_offset;
+
+	/* Write placeholder dict entries */
+	{
+		TpDictEntry placeholder;
+		memset(&placeholder, 0, sizeof(TpDictEntry));
+		for (i = 0; i < num_terms; i++)
+			merge_sink_write(sink, &placeholder, sizeof(TpDictEntry));
+	}
+
+	/* Postings start here */
+	header.postings_offset = sink->current_offset;
+
+	/* Initialize per-term tracking and skip entry accumulator */
+	term_blocks = palloc_extended(
+			num_terms * sizeof(MergeTermBlockInfo),
+			MCXT_ALLOC_HUGE | MCXT_ALLOC_ZERO);
+
+	skips.capacity = 1024;
+	skips.count	   = 0;
+	skips.entries  = palloc(skips.capacity * sizeof(TpSkipEntry));
+
+	if (pmerge != NULL)
+		tp_parallel_merge_finish(pmerge, sink, term_blocks, &skips);
+	else
+		merge_write_term_postings(
+				sink,
+				terms,
+				num_terms,
+				sources,
+				&doc_mapping,
+				disjoint_sources,
+				term_blocks,
+				&skips);
 
 	/* Skip index starts here - after all postings */
 	header.skip_index_offset = sink->current_offset;
 
 	/* Write all accumulated skip entries */
-	if (skip_entries_count > 0)
+	if (skips.count > 0)
 	{
 		merge_sink_write(
-				sink,
-				all_skip_entries,
-				skip_entries_count * sizeof(TpSkipEntry));
+				sink, skips.entries, skips.count * sizeof(TpSkipEntry));
 	}
 
-	pfree(all_skip_entries);
+	pfree(skips.entries);
 
 	/* Write fieldnorm table */
 	header.fieldnorm_offset = sink->current_offset;
@@ -1376,6 +1763,7 @@ write_merged_segment_to_sink(
 	header.data_size = sink->current_offset;
 
 	/* Flush writer and write page index */
+	if (sink->file == NULL)
 	{
 		BlockNumber page_index_root;
 
@@ -1416,7 +1804,8 @@ write_merged_segment_to_sink(
 	merge_sink_write_at(sink, 0, &header, sizeof(TpSegmentHeader));
 
 	/* Finish writer */
-	tp_segment_writer_finish(&sink->writer);
+	if (sink->file == NULL)
+		tp_segment_writer_finish(&sink->writer);
 
 	/* Cleanup */
 	pfree(string_offsets);
@@ -1437,6 +1826,16 @@ write_merged_segment_to_sink(
  */
 BlockNumber
 tp_merge_level_segments(Relation index, uint32 level, uint32 max_merge)
+{
+	return tp_merge_level_segments_to(index, level, max_merge, level + 1);
+}
+
+/*
+ * Body of tp_merge_level_segments_to, run while holding a merge slot.
+ */
+static BlockNumber
+merge_level_segments(
+		Relation index, uint32 level, uint32 max_merge, uint32 target_level)
 {
 	TpIndexMetaPage metap;
 	Buffer			metabuf;
@@ -1451,7 +1850,6 @@ tp_merge_level_segments(Relation index, uint32 level, uint32 max_merge)
 	BlockNumber		remainder_head; /* First unmerged segment */
 	TpMergedTerm   *merged_terms	 = NULL;
 	uint32			num_merged_terms = 0;
-	uint32			merged_capacity	 = 0;
 	uint64			total_tokens	 = 0;
 	uint64			src_num_docs_sum = 0; /* Σ source header.num_docs */
 	BlockNumber		new_segment;
@@ -1464,11 +1862,14 @@ tp_merge_level_segments(Relation index, uint32 level, uint32 max_merge)
 	uint32		  num_segments_tracked = 0;
 	uint32		  total_pages_to_free  = 0;
 
-	if (level >= TP_MAX_LEVELS - 1)
+	if (level >= TP_MAX_LEVELS - 1 || target_level <= level ||
+		target_level >= TP_MAX_LEVELS)
 	{
 		elog(WARNING,
-			 "Cannot merge level %u - would exceed TP_MAX_LEVELS",
-			 level);
+			 "Cannot merge level %u into level %u - must be above the "
+			 "source and below TP_MAX_LEVELS",
+			 level,
+			 target_level);
 		return InvalidBlockNumber;
 	}
 
@@ -1616,80 +2017,17 @@ tp_merge_level_segments(Relation index, uint32 level, uint32 max_merge)
 		return InvalidBlockNumber;
 	}
 
-	/* Perform N-way merge */
-	while (true)
-	{
-		int			  min_idx;
-		const char	 *min_term;
-		TpMergedTerm *current_merged;
-
-		/* Find source with smallest term */
-		min_idx = merge_find_min_source(sources, num_sources);
-		if (min_idx < 0)
-			break; /* All sources exhausted */
-
-		min_term = sources[min_idx].current_term;
-
-		/* Grow merged terms array if needed (may exceed 1GB for large
-		 * corpora) */
-		if (num_merged_terms >= merged_capacity)
-		{
-			merged_capacity = merged_capacity == 0 ? 1024
-												   : merged_capacity * 2;
-			if (merged_terms == NULL)
-				merged_terms = palloc_extended(
-						merged_capacity * sizeof(TpMergedTerm),
-						MCXT_ALLOC_HUGE);
-			else
-				merged_terms = repalloc_huge(
-						merged_terms, merged_capacity * sizeof(TpMergedTerm));
-		}
-
-		/* Initialize new merged term */
-		current_merged					 = &merged_terms[num_merged_terms];
-		current_merged->term_len		 = strlen(min_term);
-		current_merged->term			 = pstrdup(min_term);
-		current_merged->segment_refs	 = NULL;
-		current_merged->num_segment_refs = 0;
-		current_merged->segment_refs_capacity = 0;
-		current_merged->posting_offset		  = 0; /* Set during write */
-		current_merged->posting_count		  = 0; /* Set during write */
-		num_merged_terms++;
-
-		/*
-		 * Record which segments have this term (don't load postings yet).
-		 * IMPORTANT: Use current_merged->term (the pstrdup'd copy) for
-		 * comparison, NOT min_term. When we advance sources[min_idx],
-		 * merge_source_advance() frees sources[min_idx].current_term, which
-		 * min_term points to. Using min_term after that would be
-		 * use-after-free undefined behavior.
-		 */
-		for (i = 0; i < num_sources; i++)
-		{
-			if (sources[i].exhausted)
-				continue;
-
-			if (strcmp(sources[i].current_term, current_merged->term) == 0)
-			{
-				/* Record segment ref for later streaming merge */
-				merged_term_add_segment_ref(
-						current_merged, i, &sources[i].current_entry);
-
-				/* Advance this source to next term */
-				merge_source_advance(&sources[i]);
-			}
-		}
-
-		/* Check for interrupt */
-		CHECK_FOR_INTERRUPTS();
-	}
+	/* Perform N-way merge of the term dictionaries */
+	merged_terms = merge_collect_terms(
+			sources, num_sources, UINT32_MAX, &num_merged_terms);
 
 	/* Write merged segment using pages sink */
 	if (num_merged_terms > 0)
 	{
 		TpMergeSink sink;
 
-		merge_sink_init_pages(&sink, index);
+		/* Caller holds the per-index lock exclusively */
+		merge_sink_init_pages(&sink, index, true);
 		if (sink.writer.pages_allocated == 0)
 			elog(ERROR, "merge: failed to allocate segment pages");
 		new_segment = sink.writer.pages[0];
@@ -1700,9 +2038,10 @@ tp_merge_level_segments(Relation index, uint32 level, uint32 max_merge)
 				num_merged_terms,
 				sources,
 				num_sources,
-				level + 1,
+				target_level,
 				total_tokens,
-				false);
+				false,
+				NULL);
 
 		/* Free writer pages array */
 		if (sink.writer.pages)
@@ -1846,7 +2185,7 @@ tp_merge_level_segments(Relation index, uint32 level, uint32 max_merge)
 			meta_ptr->level_heads[level]  = remainder_head;
 			meta_ptr->level_counts[level] = total_at_level - segment_count;
 
-			if (meta_ptr->level_heads[level + 1] != InvalidBlockNumber)
+			if (meta_ptr->level_heads[target_level] != InvalidBlockNumber)
 			{
 				Page			 seg_page;
 				TpSegmentHeader *seg_header;
@@ -1856,11 +2195,11 @@ tp_merge_level_segments(Relation index, uint32 level, uint32 max_merge)
 				seg_page = GenericXLogRegisterBuffer(xlog_state, seg_buf, 0);
 				((PageHeader)seg_page)->pd_lower = BLCKSZ;
 				seg_header = (TpSegmentHeader *)PageGetContents(seg_page);
-				seg_header->next_segment = meta_ptr->level_heads[level + 1];
+				seg_header->next_segment = meta_ptr->level_heads[target_level];
 			}
 
-			meta_ptr->level_heads[level + 1] = new_segment;
-			meta_ptr->level_counts[level + 1]++;
+			meta_ptr->level_heads[target_level] = new_segment;
+			meta_ptr->level_counts[target_level]++;
 
 			meta_ptr->total_docs = (meta_ptr->total_docs >= docs_shrinkage)
 										 ? meta_ptr->total_docs -
@@ -1887,6 +2226,9 @@ tp_merge_level_segments(Relation index, uint32 level, uint32 max_merge)
 			if (BufferIsValid(seg_buf))
 				UnlockReleaseBuffer(seg_buf);
 			UnlockReleaseBuffer(metabuf);
+
+			/* The corpus statistics moved with the level swap */
+			tp_result_cache_invalidate_rel(index, false);
 		}
 	}
 
@@ -1897,12 +2239,14 @@ tp_merge_level_segments(Relation index, uint32 level, uint32 max_merge)
 	 * merge horizon is past every standby snapshot.
 	 */
 
+	tp_merge_account_write(index, new_segment, true);
+
 	elog(DEBUG1,
 		 "Merged %u segments from L%u into L%u segment at block %u "
 		 "(%u terms, parked %u pages)",
 		 segment_count,
 		 level,
-		 level + 1,
+		 target_level,
 		 new_segment,
 		 num_merged_terms,
 		 total_pages_to_free);
@@ -1919,57 +2263,103 @@ tp_merge_level_segments(Relation index, uint32 level, uint32 max_merge)
 	return new_segment;
 }
 
+/*
+ * As tp_merge_level_segments, but the merged segment is linked at
+ * target_level, which must lie strictly above `level` (merge
+ * policies may place a large output more than one level up).
+ *
+ * When max_concurrent_merges merges are already running elsewhere,
+ * the merge is skipped and InvalidBlockNumber returned; the level
+ * stays over its threshold and the next spill tries again.
+ */
+BlockNumber
+tp_merge_level_segments_to(
+		Relation index, uint32 level, uint32 max_merge, uint32 target_level)
+{
+	BlockNumber new_segment;
+
+	if (!tp_merge_slot_try_acquire())
+	{
+		elog(DEBUG1,
+			 "Deferring merge of L%u in index \"%s\": "
+			 "max_concurrent_merges reached",
+			 level,
+			 RelationGetRelationName(index));
+		return InvalidBlockNumber;
+	}
+
+	new_segment = merge_level_segments(index, level, max_merge, target_level);
+	tp_merge_slot_release();
+
+	return new_segment;
+}
+
 /*
  * Check if a level needs compaction and trigger merge if so.
  */
 void
 tp_maybe_compact_level(Relation index, uint32 level)
 {
-	TpIndexMetaPage metap;
-	Buffer			metabuf;
-	Page			metapage;
-	uint16			level_count;
+	const TpMergePolicy *policy;
+	TpMergePlan			 plan;
+	uint32				 highest_target = level;
 
 	if (level >= TP_MAX_LEVELS - 1)
 		return;
 
-	/* Check if level needs compaction */
-	metabuf = ReadBuffer(index, 0);
-	LockBuffer(metabuf, BUFFER_LOCK_SHARE);
-	metapage = BufferGetPage(metabuf);
-	metap	 = (TpIndexMetaPage)PageGetContents(metapage);
-
-	level_count = metap->level_counts[level];
-
-	UnlockReleaseBuffer(metabuf);
-
-	if (level_count < (uint16)tp_segments_per_level)
-		return; /* Level not full */
-
 	/*
-	 * Merge batches of segments_per_level until the level is
-	 * below threshold.  Each batch produces one segment at
-	 * level+1; after the loop we check if that level also needs
-	 * compaction.
+	 * Merge the batches the policy asks for until it reports the
+	 * level settled.  Each batch removes at least one segment from
+	 * the level, so this terminates.
 	 */
-	while (level_count >= (uint16)tp_segments_per_level)
+	policy = tp_merge_policy_for(index);
+	while (policy->plan_merge(index, level, &plan))
 	{
-		if (tp_merge_level_segments(
-					index, level, (uint32)tp_segments_per_level) ==
+		if (tp_merge_level_segments_to(
+					index, level, plan.count, plan.target_level) ==
 			InvalidBlockNumber)
 			break;
 
-		/* Re-read the level count after merge */
-		metabuf = ReadBuffer(index, 0);
-		LockBuffer(metabuf, BUFFER_LOCK_SHARE);
-		metapage	= BufferGetPage(metabuf);
-		metap		= (TpIndexMetaPage)PageGetContents(metapage);
-		level_count = metap->level_counts[level];
-		UnlockReleaseBuffer(metabuf);
+		highest_target = Max(highest_target, plan.target_level);
 	}
 
-	/* Check if next level now needs compaction */
-	tp_maybe_compact_level(index, level + 1);
+	/* Check whether the levels that received segments now need it */
+	for (uint32 next = level + 1; next <= highest_target; next++)
+		tp_maybe_compact_level(index, next);
+}
+
+/*
+ * Merge away segments with too many dead docs; see merge.h.  Levels
+ * are visited bottom-up, and merged output always lands higher with
+ * no dead docs, so each level is settled once its turn has passed.
+ */
+uint32
+tp_compact_deleted_segments(Relation index)
+{
+	const TpMergePolicy *policy = tp_merge_policy_for(index);
+	TpMergePlan			 plan;
+	uint32				 merges			= 0;
+	uint32				 highest_target = 0;
+
+	for (uint32 level = 0; level < TP_MAX_LEVELS - 1; level++)
+	{
+		while (policy->plan_deletes(index, level, &plan))
+		{
+			if (tp_merge_level_segments_to(
+						index, level, plan.count, plan.target_level) ==
+				InvalidBlockNumber)
+				break;
+
+			merges++;
+			highest_target = Max(highest_target, plan.target_level);
+		}
+	}
+
+	/* The receiving levels may now be due a regular merge */
+	for (uint32 level = 1; level <= highest_target; level++)
+		tp_maybe_compact_level(index, level);
+
+	return merges;
 }
 
 /*
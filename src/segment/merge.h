@@ -10,40 +10,60 @@
 #include "segment/io.h"
 #include "segment/segment.h"
 #include "storage/block.h"
+#include "storage/buffile.h"
 #include "utils/rel.h"
 
 /* Forward declarations */
 struct TpLocalIndexState;
+struct TpMergeChunks;
 struct TpMergeSource;
 struct TpMergedTerm;
 
 /*
- * Merge sink: writes merged segment data to index pages.
+ * Merge sink: writes merged segment data to index pages, or to a
+ * BufFile (file != NULL): posting streams for parallel merge chunks,
+ * or whole segments for the parallel build's merge rounds.
+ *
+ * index_locked says the merge runs under the per-index lock, or is
+ * waited on by a backend holding it; its writes are then never
+ * throttled (see merge_throttle.h).
  */
 typedef struct TpMergeSink
 {
 	uint64			current_offset;
 	TpSegmentWriter writer;
 	Relation		index;
+	BufFile		   *file;
+	bool			index_locked;
 } TpMergeSink;
 
 /* Sink initialization */
-extern void merge_sink_init_pages(TpMergeSink *sink, Relation index);
+extern void merge_sink_init_pages(
+		TpMergeSink *sink, Relation index, bool index_locked);
+extern void merge_sink_init_buffile(
+		TpMergeSink *sink, BufFile *file, bool index_locked);
+extern void
+merge_sink_write(TpMergeSink *sink, const void *data, Size size);
 
 /*
  * Write a merged segment to sink (pages or BufFile).
  * Unified function that replaces both write_merged_segment() and
  * write_merged_segment_to_buffile().
+ *
+ * disjoint_sources says the sources' CTID ranges do not overlap: as
+ * a whole, in source order, when chunks is NULL, or else within each
+ * of the heap block chunks (see TpMergeChunks).
  */
 extern void write_merged_segment_to_sink(
-		TpMergeSink			 *sink,
-		struct TpMergedTerm	 *terms,
-		uint32				  num_terms,
-		struct TpMergeSource *sources,
-		int					  num_sources,
-		uint32				  target_level,
-		uint64				  total_tokens,
-		bool				  disjoint_sources);
+		TpMergeSink					*sink,
+		struct TpMergedTerm			*terms,
+		uint32						 num_terms,
+		struct TpMergeSource		*sources,
+		int							 num_sources,
+		uint32						 target_level,
+		uint64						 total_tokens,
+		bool						 disjoint_sources,
+		const struct TpMergeChunks *chunks);
 
 /*
  * Merge all segments at the specified level into a single segment
@@ -71,12 +91,99 @@ extern void write_merged_segment_to_sink(
 extern BlockNumber
 tp_merge_level_segments(Relation index, uint32 level, uint32 max_merge);
 
+/*
+ * As tp_merge_level_segments, but link the merged segment at
+ * target_level (level < target_level < TP_MAX_LEVELS).
+ */
+extern BlockNumber tp_merge_level_segments_to(
+		Relation index, uint32 level, uint32 max_merge, uint32 target_level);
+
+/*
+ * Merge policies (merge_policy reloption).
+ *
+ * A policy decides, for one level, whether a merge is due and which
+ * batch to take.  Batches are always a prefix of the level chain (the
+ * newest `count` segments), since that is what the merge can unlink
+ * in a single metapage update; the policy chooses how long the prefix
+ * is and which level receives the output.
+ *
+ *   level   merge segments_per_level segments into level+1 once the
+ *           level holds that many (the historical behavior).
+ *
+ *   tiered  size-tiered: merge when the level is full or a segment's
+ *           dead-doc ratio reaches merge_deletes_pct, stop growing
+ *           the batch at max_merged_segment_mb, and place the output
+ *           at the level matching its size.  Outputs of at least
+ *           max_merged_segment_mb go to the top level, where no
+ *           further merges pick them up.
+ *
+ * VACUUM also asks each policy for deletion merges (plan_deletes):
+ * a batch reaching the first segment whose dead-doc ratio is at
+ * least merge_deletes_pct, so that segment is merged together with
+ * the segments ahead of it rather than rewritten alone.  A segment
+ * alone on its level is left until another one joins it.
+ */
+typedef enum TpMergePolicyKind
+{
+	TP_MERGE_POLICY_LEVEL,
+	TP_MERGE_POLICY_TIERED,
+} TpMergePolicyKind;
+
+typedef struct TpMergePlan
+{
+	uint32 count;		 /* segments to take from the level head */
+	uint32 target_level; /* level receiving the merged segment */
+} TpMergePlan;
+
+typedef struct TpMergePolicy
+{
+	const char *name;
+
+	/* Fill *plan and return true if `level` should be merged now. */
+	bool (*plan_merge)(Relation index, uint32 level, TpMergePlan *plan);
+
+	/* As plan_merge, for a batch that drops dead docs (VACUUM). */
+	bool (*plan_deletes)(Relation index, uint32 level, TpMergePlan *plan);
+} TpMergePolicy;
+
+extern const TpMergePolicy *tp_merge_policy_for(Relation index);
+
+/*
+ * Write-amplification accounting.  Adds the size of the segment at
+ * `root` to the index's bytes_ingested (spill / build output) or
+ * bytes_merged (merge output) counter, and counts a merge output as
+ * one merge.  No-op for an invalid root or an index without shared
+ * state.
+ */
+extern void
+tp_merge_account_write(Relation index, BlockNumber root, bool merged);
+
+/*
+ * Add `nworkers` to the parallel workers launched for the index's
+ * merges and VACUUM bulk-deletes.  No-op for an index without shared
+ * state.
+ */
+extern void tp_merge_account_workers(Relation index, int nworkers);
+
+/*
+ * Add `rounds` to the rounds in which builds of the index merged
+ * their temporary segments.  No-op for an index without shared
+ * state.
+ */
+extern void tp_merge_account_rounds(Relation index, uint32 rounds);
+
+/*
+ * Add `sleeps` to the merge_cost_delay sleeps taken by builds of the
+ * index while merging.  No-op for an index without shared state.
+ */
+extern void tp_merge_account_throttle(Relation index, uint64 sleeps);
+
 /*
  * Check if a level needs compaction and trigger merge if so.
  *
- * Called after adding a segment to check if the level has reached
- * tp_segments_per_level. If so, merges up to segments_per_level
- * segments per batch, then recursively checks the next level.
+ * Called after adding a segment.  Asks the index's merge policy for
+ * batches until it reports the level settled, then recursively
+ * checks every level that received a merged segment.
  *
  * Parameters:
  *   index - The index relation (must be opened with appropriate lock)
@@ -95,3 +202,14 @@ extern void tp_maybe_compact_level(Relation index, uint32 level);
  *   index - The index relation (must be opened with appropriate lock)
  */
 extern void tp_force_merge_all(Relation index);
+
+/*
+ * Merge away segments whose share of dead docs has reached the
+ * index's merge_deletes_pct, using the policy's plan_deletes, then
+ * run the regular compaction check on the levels that received the
+ * output.  Called from VACUUM cleanup once bulk-delete has updated
+ * the alive bitsets.  Caller holds the per-index LWLock EXCLUSIVE.
+ *
+ * Returns the number of merges run.
+ */
+extern uint32 tp_compact_deleted_segments(Relation index);
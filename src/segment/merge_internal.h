@@ -5,12 +5,14 @@
  * merge_internal.h - Internal merge types and helpers
  *
  * Exposes merge internals needed by build_parallel.c for BufFile
- * merge. These types and functions are not part of the public API.
+ * merge and by merge_parallel.c for the parallel posting merge.
+ * These types and functions are not part of the public API.
  */
 #pragma once
 
 #include <postgres.h>
 
+#include <access/parallel.h>
 #include <storage/buffile.h>
 
 #include "segment/io.h"
@@ -84,6 +86,19 @@ typedef struct TpPostingMergeSource
 	uint32			block_capacity;	   /* Allocated size */
 } TpPostingMergeSource;
 
+/*
+ * Heap block chunks claimed by a parallel build's workers, ascending.
+ * Each chunk was scanned by one worker, so the merge sources'
+ * docs in a chunk are consecutive CTID ranges of one source at a
+ * time, and the sources are disjoint within every chunk even though
+ * a worker's chunks interleave with the others'.
+ */
+typedef struct TpMergeChunks
+{
+	BlockNumber *starts; /* First block of each chunk */
+	uint32		 count;
+} TpMergeChunks;
+
 /*
  * Mapping from (source_idx, old_doc_id) -> new_doc_id.
  */
@@ -104,8 +119,19 @@ typedef struct MergeTermBlockInfo
 	uint32 skip_entry_start; /* Index into skip entries array */
 } MergeTermBlockInfo;
 
-/* Forward declaration */
+/*
+ * Growable array of skip entries accumulated across terms.
+ */
+typedef struct MergeSkipAccum
+{
+	TpSkipEntry *entries;
+	uint32		 count;
+	uint32		 capacity;
+} MergeSkipAccum;
+
+/* Forward declarations */
 struct TpDocMapBuilder;
+struct TpMergeSink;
 
 /*
  * Merge source operations
@@ -116,6 +142,7 @@ merge_source_init(TpMergeSource *source, Relation index, BlockNumber root);
 extern bool
 merge_source_init_from_reader(TpMergeSource *source, TpSegmentReader *reader);
 extern void merge_source_close(TpMergeSource *source);
+extern void merge_source_seek(TpMergeSource *source, const char *term);
 
 /*
  * Term merge operations
@@ -123,6 +150,11 @@ extern void merge_source_close(TpMergeSource *source);
 extern int	merge_find_min_source(TpMergeSource *sources, int num_sources);
 extern void merged_term_add_segment_ref(
 		TpMergedTerm *term, int segment_idx, TpDictEntry *entry);
+extern TpMergedTerm *merge_collect_terms(
+		TpMergeSource *sources,
+		int			   num_sources,
+		uint32		   max_terms,
+		uint32		  *num_terms);
 
 /*
  * Posting merge operations
@@ -141,10 +173,11 @@ find_min_posting_source(TpPostingMergeSource *sources, int num_sources);
  * Docmap merge operations
  */
 extern struct TpDocMapBuilder *build_merged_docmap(
-		TpMergeSource	  *sources,
-		int				   num_sources,
-		TpMergeDocMapping *mapping,
-		bool			   disjoint_sources);
+		TpMergeSource		*sources,
+		int					 num_sources,
+		TpMergeDocMapping	*mapping,
+		bool				 disjoint_sources,
+		const TpMergeChunks *chunks);
 extern void free_merge_doc_mapping(TpMergeDocMapping *mapping);
 
 /*
@@ -154,3 +187,46 @@ extern TpPostingMergeSource *init_term_posting_sources(
 		TpMergedTerm *term, TpMergeSource *sources, int *num_psources);
 extern TpPostingMergeSource *init_term_posting_sources_fast(
 		TpMergedTerm *term, TpMergeSource *sources, int *num_psources);
+
+/*
+ * Stream the postings of terms[0..num_terms) to the sink
+ */
+extern void merge_write_term_postings(
+		struct TpMergeSink *sink,
+		TpMergedTerm	   *terms,
+		uint32				num_terms,
+		TpMergeSource	   *sources,
+		TpMergeDocMapping  *doc_mapping,
+		bool				disjoint_sources,
+		MergeTermBlockInfo *term_blocks,
+		MergeSkipAccum	   *skips);
+
+/*
+ * Parallel posting merge (merge_parallel.c).
+ *
+ * tp_parallel_merge_begin launches workers that write the posting
+ * streams of disjoint term ranges to temp files; it returns NULL when
+ * the merge should stay serial.  tp_parallel_merge_finish has the
+ * leader merge ranges too, then appends every range's postings and
+ * skip entries to the sink in term order and fills term_blocks.
+ */
+typedef struct TpParallelMerge TpParallelMerge;
+
+extern TpParallelMerge *tp_parallel_merge_begin(
+		Relation		   index,
+		TpMergedTerm	  *terms,
+		uint32			   num_terms,
+		TpMergeSource	  *sources,
+		int				   num_sources,
+		TpMergeDocMapping *doc_mapping,
+		bool			   disjoint_sources,
+		bool			   index_locked);
+extern void tp_parallel_merge_finish(
+		TpParallelMerge	   *pm,
+		struct TpMergeSink *sink,
+		MergeTermBlockInfo *term_blocks,
+		MergeSkipAccum	   *skips);
+
+/* Worker entry point (called by parallel infrastructure) */
+extern PGDLLEXPORT void
+tp_parallel_merge_worker_main(dsm_segment *seg, shm_toc *toc);
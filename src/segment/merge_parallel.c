@@ -0,0 +1,701 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * merge_parallel.c - Parallel posting merge partitioned by term range
+ *
+ * Most of a large merge is spent streaming posting lists: each term's
+ * postings are read from every source that has it, remapped through
+ * the merged docmap, and re-encoded into blocks.  Terms are
+ * independent, so the merged term array is cut into contiguous chunks
+ * of roughly equal posting volume, and the leader and parallel
+ * workers claim chunks from an atomic counter.
+ *
+ * For each chunk a participant seeks its source segments to the
+ * chunk's first term, rebuilds the chunk's segment refs with the same
+ * N-way dictionary merge the leader ran (merge_collect_terms), and
+ * streams the postings to a temp file in a SharedFileSet, followed by
+ * the chunk's skip entries.  The docmap, and with it the alive-bitset
+ * filtering, is computed once by the leader and shipped to workers as
+ * flat old-to-new doc ID arrays.
+ *
+ * The leader writes the header and dictionary while workers run, then
+ * appends the chunk files in term order, rebasing posting and skip
+ * offsets, so the merged segment is the one a serial merge writes.
+ *
+ * Merges run under the per-index LWLock, which holds off interrupts;
+ * the leader therefore pumps worker messages itself rather than
+ * relying on CHECK_FOR_INTERRUPTS.
+ */
+#include <postgres.h>
+
+#include <access/genam.h>
+#include <access/parallel.h>
+#include <access/xact.h>
+#include <miscadmin.h>
+#include <port/atomics.h>
+#include <postmaster/bgworker.h>
+#include <storage/buffile.h>
+#include <storage/condition_variable.h>
+#include <storage/latch.h>
+#include <storage/sharedfileset.h>
+#include <storage/shm_mq.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+#include <utils/snapmgr.h>
+#include <utils/wait_event.h>
+
+#include "access/build_parallel.h"
+#include "constants.h"
+#include "segment/merge.h"
+#include "segment/merge_internal.h"
+#include "segment/merge_throttle.h"
+
+/*
+ * Shared memory keys for parallel merge TOC
+ */
+#define TP_MERGE_KEY_SHARED	 UINT64CONST(0xB175DA7A00000101)
+#define TP_MERGE_KEY_SOURCES UINT64CONST(0xB175DA7A00000102)
+#define TP_MERGE_KEY_MAPPING UINT64CONST(0xB175DA7A00000103)
+#define TP_MERGE_KEY_TERMS	 UINT64CONST(0xB175DA7A00000104)
+#define TP_MERGE_KEY_BLOCKS	 UINT64CONST(0xB175DA7A00000105)
+
+/*
+ * A contiguous range of merged terms, and what its participant wrote.
+ */
+typedef struct TpParallelMergeChunk
+{
+	uint32 term_start;		 /* First term (index into merged terms) */
+	uint32 term_count;		 /* Terms in this chunk */
+	uint64 start_term_off;	 /* First term's text in the TERMS key */
+	uint64 posting_bytes;	 /* Postings written to the chunk file */
+	uint32 num_skip_entries; /* Skip entries following the postings */
+} TpParallelMergeChunk;
+
+/*
+ * Per-source info: where workers reopen it and its slice of the
+ * flattened old_to_new mapping.
+ */
+typedef struct TpParallelMergeSourceInfo
+{
+	BlockNumber root;			/* Segment header block */
+	uint32		num_docs;		/* Mapping entries (0 = no mapping) */
+	uint64		mapping_offset; /* Index into the MAPPING key */
+} TpParallelMergeSourceInfo;
+
+/*
+ * Shared state for parallel merge
+ *
+ * Stored in DSM segment, accessible to all workers and leader.
+ */
+typedef struct TpParallelMergeShared
+{
+	/* Immutable configuration (set before workers launch) */
+	Oid	   indexrelid;		 /* Index relation OID */
+	int32  num_sources;		 /* Source segments */
+	uint32 num_terms;		 /* Merged terms */
+	bool   disjoint_sources; /* Sources have disjoint CTID ranges */
+	bool   index_locked;	 /* Leader holds the per-index lock */
+	uint32 nchunks;			 /* Term-range chunks */
+
+	/* Temp files for chunk postings */
+	SharedFileSet fileset;
+
+	/* Coordination */
+	pg_atomic_uint32  next_chunk;	  /* Next chunk to claim */
+	pg_atomic_uint32  chunks_done;	  /* Chunks fully written */
+	ConditionVariable chunks_done_cv; /* Signaled per finished chunk */
+
+	/*
+	 * Per-chunk array (variable-length array follows).
+	 * The claiming participant writes its chunk's results.
+	 */
+} TpParallelMergeShared;
+
+static inline TpParallelMergeChunk *
+TpParallelMergeChunks(TpParallelMergeShared *shared)
+{
+	return (TpParallelMergeChunk *)((char *)shared +
+									MAXALIGN(sizeof(TpParallelMergeShared)));
+}
+
+/*
+ * A participant's view of the shared state.
+ */
+typedef struct ParallelMergeView
+{
+	TpParallelMergeShared *shared;
+	TpParallelMergeChunk  *chunks;
+	const char			  *start_terms;
+	MergeTermBlockInfo	  *blocks; /* Chunk-relative, indexed by term */
+	TpMergeDocMapping	   doc_mapping;
+} ParallelMergeView;
+
+/*
+ * Leader-side handle between tp_parallel_merge_begin and _finish.
+ */
+struct TpParallelMerge
+{
+	ParallelContext	 *pcxt;
+	ParallelMergeView view;
+	TpMergeSource	 *sources; /* Leader's sources, reused for its chunks */
+	int				  num_sources;
+};
+
+static void
+chunk_file_name(char *name, Size len, uint32 chunk)
+{
+	snprintf(name, len, "tp_merge_chunk_%u", chunk);
+}
+
+/* ----------------------------------------------------------------
+ * Chunk processing (leader and workers)
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Merge one chunk's postings into its temp file: postings first,
+ * then the chunk's skip entries.  `sources` may sit anywhere; each
+ * is re-seeked to the chunk's first term.
+ */
+static void
+parallel_merge_run_chunk(
+		ParallelMergeView *view,
+		TpMergeSource	  *sources,
+		int				   num_sources,
+		uint32			   chunk_idx)
+{
+	TpParallelMergeChunk *chunk		 = &view->chunks[chunk_idx];
+	const char			 *start_term = view->start_terms +
+							   chunk->start_term_off;
+	MemoryContext		  chunk_ctx;
+	MemoryContext		  old_ctx;
+	TpMergedTerm		 *terms;
+	uint32				  num_terms;
+	MergeSkipAccum		  skips;
+	TpMergeSink			  sink;
+	BufFile				 *file;
+	char				  file_name[64];
+	int					  i;
+
+	chunk_ctx = AllocSetContextCreate(
+			CurrentMemoryContext,
+			"Parallel Merge Chunk",
+			ALLOCSET_DEFAULT_SIZES);
+	old_ctx = MemoryContextSwitchTo(chunk_ctx);
+
+	for (i = 0; i < num_sources; i++)
+		merge_source_seek(&sources[i], start_term);
+
+	terms = merge_collect_terms(
+			sources, num_sources, chunk->term_count, &num_terms);
+	if (num_terms != chunk->term_count ||
+		strcmp(terms[0].term, start_term) != 0)
+		elog(ERROR,
+			 "parallel merge: chunk %u does not match the merged "
+			 "dictionary",
+			 chunk_idx);
+
+	chunk_file_name(file_name, sizeof(file_name), chunk_idx);
+	file = BufFileCreateFileSet(&view->shared->fileset.fs, file_name);
+	merge_sink_init_buffile(&sink, file, view->shared->index_locked);
+
+	skips.capacity = 1024;
+	skips.count	   = 0;
+	skips.entries  = palloc(skips.capacity * sizeof(TpSkipEntry));
+
+	merge_write_term_postings(
+			&sink,
+			terms,
+			num_terms,
+			sources,
+			&view->doc_mapping,
+			view->shared->disjoint_sources,
+			&view->blocks[chunk->term_start],
+			&skips);
+
+	chunk->posting_bytes	= sink.current_offset;
+	chunk->num_skip_entries = skips.count;
+	if (skips.count > 0)
+		BufFileWrite(file, skips.entries, skips.count * sizeof(TpSkipEntry));
+
+	/* Export BufFile so leader can reopen */
+	BufFileExportFileSet(file);
+	BufFileClose(file);
+
+	/*
+	 * The sources' current terms live in chunk_ctx; drop them so the
+	 * next seek does not free them again.
+	 */
+	for (i = 0; i < num_sources; i++)
+	{
+		sources[i].current_term = NULL;
+		sources[i].exhausted	= true;
+	}
+
+	MemoryContextSwitchTo(old_ctx);
+	MemoryContextDelete(chunk_ctx);
+}
+
+/*
+ * Claim and merge chunks until none are left.
+ */
+static void
+parallel_merge_participate(
+		ParallelMergeView *view, TpMergeSource *sources, int num_sources)
+{
+	TpParallelMergeShared *shared = view->shared;
+
+	for (;;)
+	{
+		uint32 chunk_idx = pg_atomic_fetch_add_u32(&shared->next_chunk, 1);
+
+		if (chunk_idx >= shared->nchunks)
+			break;
+
+		parallel_merge_run_chunk(view, sources, num_sources, chunk_idx);
+
+		pg_atomic_fetch_add_u32(&shared->chunks_done, 1);
+		ConditionVariableBroadcast(&shared->chunks_done_cv);
+	}
+}
+
+/* ----------------------------------------------------------------
+ * Worker entry point
+ * ----------------------------------------------------------------
+ */
+PGDLLEXPORT void
+tp_parallel_merge_worker_main(dsm_segment *seg, shm_toc *toc)
+{
+	ParallelMergeView		   view;
+	TpParallelMergeSourceInfo *source_info;
+	uint32					  *mapping;
+	TpMergeSource			  *sources;
+	Relation				   index;
+	int						   num_sources;
+	int						   i;
+
+	/* Attach to shared memory */
+	view.shared = (TpParallelMergeShared *)
+			shm_toc_lookup(toc, TP_MERGE_KEY_SHARED, false);
+	view.chunks		 = TpParallelMergeChunks(view.shared);
+	view.start_terms = shm_toc_lookup(toc, TP_MERGE_KEY_TERMS, false);
+	view.blocks		 = shm_toc_lookup(toc, TP_MERGE_KEY_BLOCKS, false);
+	source_info		 = shm_toc_lookup(toc, TP_MERGE_KEY_SOURCES, false);
+	mapping			 = shm_toc_lookup(toc, TP_MERGE_KEY_MAPPING, false);
+	num_sources		 = view.shared->num_sources;
+
+	/* Rebuild the docmap's old_to_new arrays over the shared copy */
+	view.doc_mapping.num_sources = num_sources;
+	view.doc_mapping.old_to_new	 = palloc0(num_sources * sizeof(uint32 *));
+	for (i = 0; i < num_sources; i++)
+	{
+		if (source_info[i].num_docs > 0)
+			view.doc_mapping.old_to_new[i] = mapping +
+											 source_info[i].mapping_offset;
+	}
+
+	index = index_open(view.shared->indexrelid, AccessShareLock);
+
+	/* Attach to SharedFileSet for chunk files */
+	SharedFileSetAttach(&view.shared->fileset, seg);
+
+	/*
+	 * Each worker throttles its own I/O against merge_cost_limit,
+	 * unless the leader waits on it under the index lock.
+	 */
+	tp_io_throttle_reset();
+
+	sources = palloc0(num_sources * sizeof(TpMergeSource));
+	for (i = 0; i < num_sources; i++)
+	{
+		if (!merge_source_init(&sources[i], index, source_info[i].root))
+			elog(ERROR,
+				 "parallel merge: could not open source segment at "
+				 "block %u",
+				 source_info[i].root);
+	}
+
+	parallel_merge_participate(&view, sources, num_sources);
+
+	for (i = 0; i < num_sources; i++)
+		merge_source_close(&sources[i]);
+	pfree(sources);
+	pfree((void *)view.doc_mapping.old_to_new);
+
+	index_close(index, AccessShareLock);
+}
+
+/* ----------------------------------------------------------------
+ * Leader
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Cut terms[0..num_terms) into at most max_chunks contiguous chunks
+ * of about equal weight, where a term weighs its total doc_freq
+ * across sources plus one for its dictionary work.  Fills
+ * starts[0..n] with chunk boundaries and returns n.
+ */
+static uint32
+parallel_merge_plan_chunks(
+		TpMergedTerm *terms,
+		uint32		  num_terms,
+		uint32		  max_chunks,
+		uint32		 *starts)
+{
+	uint64 total   = 0;
+	uint64 running = 0;
+	uint32 nchunks = 0;
+	uint32 t;
+
+	for (t = 0; t < num_terms; t++)
+	{
+		total += 1;
+		for (uint32 r = 0; r < terms[t].num_segment_refs; r++)
+			total += terms[t].segment_refs[r].entry.doc_freq;
+	}
+
+	starts[nchunks++] = 0;
+	for (t = 0; t < num_terms - 1 && nchunks < max_chunks; t++)
+	{
+		running += 1;
+		for (uint32 r = 0; r < terms[t].num_segment_refs; r++)
+			running += terms[t].segment_refs[r].entry.doc_freq;
+
+		/* Close the current chunk once it reaches its share */
+		if (running * max_chunks >= total * nchunks)
+			starts[nchunks++] = t + 1;
+	}
+	starts[nchunks] = num_terms;
+
+	return nchunks;
+}
+
+/*
+ * Start a parallel posting merge for terms[], or return NULL when the
+ * merge should stay serial: parallel_merge_workers is 0, the merge is
+ * small, the sources are not reopenable by workers (BufFile-backed
+ * sources of a parallel build, temp indexes), no workers could be
+ * launched, or we cannot enter parallel mode here.  index_locked is
+ * the leader's sink's: participants never throttle while the leader
+ * holds the per-index lock.
+ */
+TpParallelMerge *
+tp_parallel_merge_begin(
+		Relation		   index,
+		TpMergedTerm	  *terms,
+		uint32			   num_terms,
+		TpMergeSource	  *sources,
+		int				   num_sources,
+		TpMergeDocMapping *doc_mapping,
+		bool			   disjoint_sources,
+		bool			   index_locked)
+{
+	TpParallelMerge			  *pm;
+	ParallelContext			  *pcxt;
+	TpParallelMergeShared	  *shared;
+	TpParallelMergeChunk	  *chunks;
+	TpParallelMergeSourceInfo *source_info;
+	uint32					  *mapping;
+	char					  *start_terms;
+	MergeTermBlockInfo		  *blocks;
+	uint32					  *starts;
+	uint32					   nchunks;
+	int						   nworkers;
+	Size					   shared_size;
+	Size					   mapping_size;
+	Size					   terms_size;
+	Size					   blocks_size;
+	uint64					   mapping_len = 0;
+	uint64					   terms_off   = 0;
+	int						   i;
+
+	nworkers = Min(tp_parallel_merge_workers,
+				   max_parallel_maintenance_workers);
+	if (nworkers <= 0 || num_terms < TP_PARALLEL_MERGE_MIN_TERMS)
+		return NULL;
+
+	/* Workers need a snapshot to restore and a shared buffer pool */
+	if (IsInParallelMode() || !ActiveSnapshotSet() ||
+		RelationUsesLocalBuffers(index))
+		return NULL;
+
+	for (i = 0; i < num_sources; i++)
+	{
+		if (sources[i].reader == NULL || sources[i].reader->buffile != NULL)
+			return NULL;
+		if (doc_mapping->old_to_new[i] != NULL)
+			mapping_len += sources[i].reader->header->num_docs;
+	}
+
+	/* Plan chunks: several per participant (workers plus leader) */
+	starts	= palloc(((nworkers + 1) * TP_PARALLEL_MERGE_CHUNKS_PER_WORKER +
+					  1) * sizeof(uint32));
+	nchunks = parallel_merge_plan_chunks(
+			terms,
+			num_terms,
+			(nworkers + 1) * TP_PARALLEL_MERGE_CHUNKS_PER_WORKER,
+			starts);
+
+	shared_size = add_size(
+			MAXALIGN(sizeof(TpParallelMergeShared)),
+			mul_size(nchunks, sizeof(TpParallelMergeChunk)));
+	mapping_size = mul_size(Max(mapping_len, 1), sizeof(uint32));
+	terms_size	 = 0;
+	for (uint32 c = 0; c < nchunks; c++)
+		terms_size = add_size(terms_size, terms[starts[c]].term_len + 1);
+	blocks_size = mul_size(num_terms, sizeof(MergeTermBlockInfo));
+
+	/* Enter parallel mode and create context */
+	EnterParallelMode();
+	pcxt = CreateParallelContext(
+			"pg_textsearch", "tp_parallel_merge_worker_main", nworkers);
+
+	/* Estimate and allocate shared memory */
+	shm_toc_estimate_chunk(&pcxt->estimator, shared_size);
+	shm_toc_estimate_chunk(
+			&pcxt->estimator,
+			mul_size(num_sources, sizeof(TpParallelMergeSourceInfo)));
+	shm_toc_estimate_chunk(&pcxt->estimator, mapping_size);
+	shm_toc_estimate_chunk(&pcxt->estimator, terms_size);
+	shm_toc_estimate_chunk(&pcxt->estimator, blocks_size);
+	shm_toc_estimate_keys(&pcxt->estimator, 5);
+
+	InitializeParallelDSM(pcxt);
+
+	/* No DSM segment (e.g. out of slots): workers cannot attach */
+	if (pcxt->nworkers == 0)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		pfree(starts);
+		return NULL;
+	}
+
+	/* Shared state and chunk boundaries */
+	shared = (TpParallelMergeShared *)
+			shm_toc_allocate(pcxt->toc, shared_size);
+	memset(shared, 0, sizeof(TpParallelMergeShared));
+	shared->indexrelid		 = RelationGetRelid(index);
+	shared->num_sources		 = num_sources;
+	shared->num_terms		 = num_terms;
+	shared->disjoint_sources = disjoint_sources;
+	shared->index_locked	 = index_locked;
+	shared->nchunks			 = nchunks;
+	pg_atomic_init_u32(&shared->next_chunk, 0);
+	pg_atomic_init_u32(&shared->chunks_done, 0);
+	ConditionVariableInit(&shared->chunks_done_cv);
+	SharedFileSetInit(&shared->fileset, pcxt->seg);
+
+	start_terms = shm_toc_allocate(pcxt->toc, terms_size);
+	chunks		= TpParallelMergeChunks(shared);
+	for (uint32 c = 0; c < nchunks; c++)
+	{
+		TpMergedTerm *first = &terms[starts[c]];
+
+		memset(&chunks[c], 0, sizeof(TpParallelMergeChunk));
+		chunks[c].term_start	 = starts[c];
+		chunks[c].term_count	 = starts[c + 1] - starts[c];
+		chunks[c].start_term_off = terms_off;
+		memcpy(start_terms + terms_off, first->term, first->term_len);
+		start_terms[terms_off + first->term_len] = '\0';
+		terms_off += first->term_len + 1;
+	}
+
+	/* Source roots and the flattened old_to_new mapping */
+	source_info = shm_toc_allocate(
+			pcxt->toc,
+			mul_size(num_sources, sizeof(TpParallelMergeSourceInfo)));
+	mapping		= shm_toc_allocate(pcxt->toc, mapping_size);
+	mapping_len = 0;
+	for (i = 0; i < num_sources; i++)
+	{
+		source_info[i].root			  = sources[i].reader->root_block;
+		source_info[i].mapping_offset = mapping_len;
+		source_info[i].num_docs		  = 0;
+		if (doc_mapping->old_to_new[i] != NULL)
+		{
+			source_info[i].num_docs = sources[i].reader->header->num_docs;
+			memcpy(mapping + mapping_len,
+				   doc_mapping->old_to_new[i],
+				   source_info[i].num_docs * sizeof(uint32));
+			mapping_len += source_info[i].num_docs;
+		}
+	}
+
+	blocks = shm_toc_allocate(pcxt->toc, blocks_size);
+
+	/* Insert shared state into TOC */
+	shm_toc_insert(pcxt->toc, TP_MERGE_KEY_SHARED, shared);
+	shm_toc_insert(pcxt->toc, TP_MERGE_KEY_SOURCES, source_info);
+	shm_toc_insert(pcxt->toc, TP_MERGE_KEY_MAPPING, mapping);
+	shm_toc_insert(pcxt->toc, TP_MERGE_KEY_TERMS, start_terms);
+	shm_toc_insert(pcxt->toc, TP_MERGE_KEY_BLOCKS, blocks);
+
+	/* Launch workers */
+	LaunchParallelWorkers(pcxt);
+	if (pcxt->nworkers_launched == 0)
+	{
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		pfree(starts);
+		return NULL;
+	}
+
+	tp_merge_account_workers(index, pcxt->nworkers_launched);
+
+	elog(DEBUG1,
+		 "parallel merge: %u terms in %u chunks, %d of %d workers",
+		 num_terms,
+		 nchunks,
+		 pcxt->nworkers_launched,
+		 nworkers);
+
+	pm					 = palloc0(sizeof(TpParallelMerge));
+	pm->pcxt			 = pcxt;
+	pm->view.shared		 = shared;
+	pm->view.chunks		 = chunks;
+	pm->view.start_terms = start_terms;
+	pm->view.blocks		 = blocks;
+	pm->view.doc_mapping = *doc_mapping;
+	pm->sources			 = sources;
+	pm->num_sources		 = num_sources;
+
+	pfree(starts);
+	return pm;
+}
+
+/*
+ * Wait until every launched worker has exited, relaying their
+ * messages (and rethrowing their errors) as we go.  Stands in for
+ * WaitForParallelWorkersToFinish, whose CHECK_FOR_INTERRUPTS cannot
+ * process messages while the caller holds interrupts off.
+ */
+static void
+parallel_merge_wait_for_workers(ParallelContext *pcxt)
+{
+	for (;;)
+	{
+		bool all_exited = true;
+		int	 i;
+
+		HandleParallelMessages();
+
+		for (i = 0; i < pcxt->nworkers_launched; i++)
+		{
+			pid_t pid;
+
+			if (pcxt->worker[i].error_mqh == NULL)
+				continue;
+
+			/* A worker that never started will send nothing */
+			if (shm_mq_get_sender(shm_mq_get_queue(
+						pcxt->worker[i].error_mqh)) == NULL &&
+				GetBackgroundWorkerPid(pcxt->worker[i].bgwhandle, &pid) ==
+						BGWH_STOPPED)
+				continue;
+
+			all_exited = false;
+		}
+
+		if (all_exited)
+			break;
+
+		(void)WaitLatch(
+				MyLatch,
+				WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+				100 /* ms */,
+				PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+	}
+}
+
+/*
+ * Merge chunks alongside the workers until all are written, then
+ * append them to the sink in term order.  term_blocks and skips get
+ * the same contents a serial merge_write_term_postings would produce.
+ */
+void
+tp_parallel_merge_finish(
+		TpParallelMerge	   *pm,
+		TpMergeSink		   *sink,
+		MergeTermBlockInfo *term_blocks,
+		MergeSkipAccum	   *skips)
+{
+	TpParallelMergeShared *shared = pm->view.shared;
+	PGAlignedBlock		   buf;
+
+	/* The leader takes chunks too */
+	parallel_merge_participate(&pm->view, pm->sources, pm->num_sources);
+
+	/* Wait for the workers' chunks, relaying any worker error */
+	ConditionVariablePrepareToSleep(&shared->chunks_done_cv);
+	while (pg_atomic_read_u32(&shared->chunks_done) < shared->nchunks)
+	{
+		HandleParallelMessages();
+		ConditionVariableTimedSleep(
+				&shared->chunks_done_cv, 100 /* ms */, PG_WAIT_EXTENSION);
+	}
+	ConditionVariableCancelSleep();
+	pg_read_barrier();
+
+	parallel_merge_wait_for_workers(pm->pcxt);
+
+	/* Stitch the chunks together in term order */
+	for (uint32 c = 0; c < shared->nchunks; c++)
+	{
+		TpParallelMergeChunk *chunk		= &pm->view.chunks[c];
+		uint64				  base		= sink->current_offset;
+		uint32				  skip_base = skips->count;
+		uint64				  remaining = chunk->posting_bytes;
+		BufFile				 *file;
+		char				  file_name[64];
+
+		chunk_file_name(file_name, sizeof(file_name), c);
+		file = BufFileOpenFileSet(
+				&shared->fileset.fs, file_name, O_RDONLY, false);
+
+		while (remaining > 0)
+		{
+			Size n = Min(remaining, (uint64)BLCKSZ);
+
+			BufFileReadExact(file, buf.data, n);
+			merge_sink_write(sink, buf.data, n);
+			remaining -= n;
+		}
+
+		if (chunk->num_skip_entries > 0)
+		{
+			while (skips->count + chunk->num_skip_entries > skips->capacity)
+				skips->capacity *= 2;
+			skips->entries = repalloc_huge(
+					skips->entries, skips->capacity * sizeof(TpSkipEntry));
+
+			BufFileReadExact(
+					file,
+					&skips->entries[skips->count],
+					chunk->num_skip_entries * sizeof(TpSkipEntry));
+			for (uint32 k = 0; k < chunk->num_skip_entries; k++)
+				skips->entries[skips->count + k].posting_offset += base;
+			skips->count += chunk->num_skip_entries;
+		}
+		BufFileClose(file);
+
+		for (uint32 t = chunk->term_start;
+			 t < chunk->term_start + chunk->term_count;
+			 t++)
+		{
+			term_blocks[t] = pm->view.blocks[t];
+			term_blocks[t].posting_offset += base;
+			term_blocks[t].skip_entry_start += skip_base;
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	/* Cleanup */
+	DestroyParallelContext(pm->pcxt);
+	ExitParallelMode();
+	pfree(pm);
+}
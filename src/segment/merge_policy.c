@@ -0,0 +1,483 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * merge_policy.c - Merge policies and write-amplification accounting
+ *
+ * tp_maybe_compact_level asks the index's policy (merge_policy
+ * reloption) which batch of a level to merge next, and VACUUM asks
+ * it for batches that drop dead docs; see merge.h for the two
+ * policies.  Batches are prefixes of the level chain, so the
+ * policy only decides how many segments to take from the head and
+ * where the output goes.
+ */
+#include <postgres.h>
+
+#include <access/genam.h>
+#include <access/htup_details.h>
+#include <catalog/pg_type.h>
+#include <fmgr.h>
+#include <funcapi.h>
+#include <utils/array.h>
+#include <utils/builtins.h>
+#include <utils/rel.h>
+
+#include "access/am.h"
+#include "constants.h"
+#include "index/metapage.h"
+#include "index/registry.h"
+#include "index/resolve.h"
+#include "index/state.h"
+#include "segment/io.h"
+#include "segment/merge.h"
+#include "segment/segment.h"
+
+/* Per-segment facts the policies plan with */
+typedef struct LevelSegment
+{
+	uint64 bytes;
+	uint32 num_docs;
+	uint32 alive_count;
+} LevelSegment;
+
+static TpMergePolicyKind
+merge_policy_kind(Relation index)
+{
+	TpOptions *opts = (TpOptions *)index->rd_options;
+
+	if (opts == NULL)
+		return TP_MERGE_POLICY_LEVEL;
+	return (TpMergePolicyKind)opts->merge_policy;
+}
+
+static int
+merge_deletes_pct(Relation index)
+{
+	TpOptions *opts = (TpOptions *)index->rd_options;
+
+	if (opts == NULL)
+		return TP_DEFAULT_MERGE_DELETES_PCT;
+	return opts->merge_deletes_pct;
+}
+
+static void
+level_head_and_count(
+		Relation index, uint32 level, BlockNumber *head, uint32 *count)
+{
+	TpIndexMetaPage metap = tp_get_metapage(index);
+
+	*head  = metap->level_heads[level];
+	*count = metap->level_counts[level];
+	pfree(metap);
+}
+
+/*
+ * Read up to `max` segments of the level chain starting at `head`.
+ * Returns the number read.
+ */
+static uint32
+read_level(Relation index, BlockNumber head, uint32 max, LevelSegment *segs)
+{
+	BlockNumber seg = head;
+	uint32		n	= 0;
+
+	while (seg != InvalidBlockNumber && n < max)
+	{
+		TpSegmentReader *reader = tp_segment_open(index, seg);
+
+		if (reader == NULL || reader->header == NULL)
+		{
+			if (reader)
+				tp_segment_close(reader);
+			break;
+		}
+
+		segs[n].bytes		= (uint64)reader->header->num_pages * BLCKSZ;
+		segs[n].num_docs	= reader->header->num_docs;
+		segs[n].alive_count = reader->header->alive_count;
+		n++;
+
+		seg = reader->header->next_segment;
+		tp_segment_close(reader);
+	}
+
+	return n;
+}
+
+/*
+ * Number of segments, from the head of the level, a batch must take
+ * to reach the first one whose dead-doc share is at least
+ * deletes_pct; 0 if none is.
+ */
+static uint32
+first_deleted_segment(LevelSegment *segs, uint32 nsegs, int deletes_pct)
+{
+	if (deletes_pct <= 0)
+		return 0;
+
+	for (uint32 i = 0; i < nsegs; i++)
+	{
+		uint64 dead = segs[i].num_docs - segs[i].alive_count;
+
+		if (segs[i].num_docs > 0 &&
+			dead * 100 >= (uint64)deletes_pct * segs[i].num_docs)
+			return i + 1;
+	}
+	return 0;
+}
+
+/* ----------------------------------------------------------------
+ * level: merge segments_per_level segments into level+1
+ * ----------------------------------------------------------------
+ */
+
+static bool
+level_plan_merge(Relation index, uint32 level, TpMergePlan *plan)
+{
+	BlockNumber head;
+	uint32		count;
+
+	if (level >= TP_MAX_LEVELS - 1)
+		return false;
+
+	level_head_and_count(index, level, &head, &count);
+	if (count < (uint32)tp_segments_per_level)
+		return false;
+
+	plan->count		   = (uint32)tp_segments_per_level;
+	plan->target_level = level + 1;
+	return true;
+}
+
+/*
+ * Merge the level's head up to and including the first segment past
+ * merge_deletes_pct into level+1.  The batch takes at least two
+ * segments; a segment alone on its level waits for a neighbor.
+ */
+static bool
+level_plan_deletes(Relation index, uint32 level, TpMergePlan *plan)
+{
+	int			  deletes_pct = merge_deletes_pct(index);
+	BlockNumber	  head;
+	uint32		  count;
+	LevelSegment *segs;
+	uint32		  nsegs;
+	uint32		  want;
+
+	if (level >= TP_MAX_LEVELS - 1 || deletes_pct <= 0)
+		return false;
+
+	level_head_and_count(index, level, &head, &count);
+	if (count == 0)
+		return false;
+
+	segs  = palloc(count * sizeof(LevelSegment));
+	nsegs = read_level(index, head, count, segs);
+	want  = first_deleted_segment(segs, nsegs, deletes_pct);
+	pfree(segs);
+
+	if (want == 0 || nsegs < 2)
+		return false;
+
+	plan->count		   = Max(want, 2);
+	plan->target_level = level + 1;
+	return true;
+}
+
+/* ----------------------------------------------------------------
+ * tiered: size-tiered with a dead-doc trigger and a size cap
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * Tier of a segment of `bytes`: 0 below the floor, then one tier per
+ * factor of segments_per_level, so a full level's worth of tier-t
+ * segments merges into roughly one tier-(t+1) segment.
+ */
+static uint32
+tiered_tier_for_bytes(uint64 bytes)
+{
+	uint64 limit = TP_MERGE_TIER_FLOOR_BYTES;
+	uint32 tier	 = 0;
+
+	while (bytes >= limit && tier < TP_MAX_LEVELS - 1)
+	{
+		tier++;
+		limit *= (uint64)tp_segments_per_level;
+	}
+	return tier;
+}
+
+/*
+ * Plan a tiered batch.  With deletes_only, only the deletion trigger
+ * starts a merge (VACUUM); the count trigger still lengthens it.
+ */
+static bool
+tiered_plan(Relation index, uint32 level, TpMergePlan *plan, bool deletes_only)
+{
+	TpOptions	 *opts		  = (TpOptions *)index->rd_options;
+	uint64		  max_bytes	  = 0;
+	BlockNumber	  head;
+	uint32		  count;
+	LevelSegment *segs;
+	uint32		  nsegs;
+	uint32		  count_want  = 0;
+	uint32		  delete_want = 0;
+	uint32		  must;
+	uint32		  take;
+	uint64		  batch_bytes = 0;
+	double		  alive_bytes = 0.0;
+
+	if (level >= TP_MAX_LEVELS - 1)
+		return false;
+
+	if (opts != NULL)
+		max_bytes = (uint64)opts->max_merged_segment_mb * 1024 * 1024;
+
+	level_head_and_count(index, level, &head, &count);
+	if (count == 0)
+		return false;
+
+	segs  = palloc(count * sizeof(LevelSegment));
+	nsegs = read_level(index, head, count, segs);
+
+	/* Count trigger: the level is full */
+	if (nsegs >= (uint32)tp_segments_per_level)
+		count_want = (uint32)tp_segments_per_level;
+
+	/*
+	 * Deletion trigger: the batch must reach the first segment whose
+	 * dead-doc share has crossed merge_deletes_pct, since the merge
+	 * drops dead docs.
+	 */
+	delete_want = first_deleted_segment(
+			segs, nsegs, merge_deletes_pct(index));
+
+	/* At VACUUM the segment waits for a neighbor to merge with */
+	if (deletes_only && nsegs < 2)
+		delete_want = 0;
+
+	if (delete_want == 0 && (count_want == 0 || deletes_only))
+	{
+		pfree(segs);
+		return false;
+	}
+
+	/*
+	 * The batch must cover the deletion trigger and, when the level
+	 * has them, at least two segments so the merge shrinks the level.
+	 * Beyond that, stop before it outgrows max_merged_segment_mb.
+	 */
+	must = Min(Max(delete_want, 2), nsegs);
+	take = Max(must, Min(count_want, nsegs));
+	for (uint32 i = 0; i < take; i++)
+	{
+		if (i >= must && max_bytes > 0 &&
+			batch_bytes + segs[i].bytes > max_bytes)
+		{
+			take = i;
+			break;
+		}
+		batch_bytes += segs[i].bytes;
+		if (segs[i].num_docs > 0)
+			alive_bytes += (double)segs[i].bytes * segs[i].alive_count /
+						   segs[i].num_docs;
+	}
+	pfree(segs);
+
+	/* Outputs at the size cap go to the top level and stay there */
+	plan->count = take;
+	if (max_bytes > 0 && (uint64)alive_bytes >= max_bytes)
+		plan->target_level = TP_MAX_LEVELS - 1;
+	else
+		plan->target_level =
+				Min(Max(level + 1, tiered_tier_for_bytes((uint64)alive_bytes)),
+					TP_MAX_LEVELS - 1);
+	return true;
+}
+
+static bool
+tiered_plan_merge(Relation index, uint32 level, TpMergePlan *plan)
+{
+	return tiered_plan(index, level, plan, false);
+}
+
+static bool
+tiered_plan_deletes(Relation index, uint32 level, TpMergePlan *plan)
+{
+	return tiered_plan(index, level, plan, true);
+}
+
+static const TpMergePolicy tp_merge_policies[] = {
+		[TP_MERGE_POLICY_LEVEL] =
+				{"level", level_plan_merge, level_plan_deletes},
+		[TP_MERGE_POLICY_TIERED] =
+				{"tiered", tiered_plan_merge, tiered_plan_deletes},
+};
+
+const TpMergePolicy *
+tp_merge_policy_for(Relation index)
+{
+	TpMergePolicyKind kind = merge_policy_kind(index);
+
+	if ((int)kind < 0 || (int)kind >= (int)lengthof(tp_merge_policies))
+		kind = TP_MERGE_POLICY_LEVEL;
+	return &tp_merge_policies[kind];
+}
+
+/* ----------------------------------------------------------------
+ * Write-amplification accounting
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * The index's shared state, looked up in the registry so that it is
+ * found inside parallel workers and builds too; NULL if it has none.
+ */
+static TpSharedIndexState *
+account_shared_state(Relation index)
+{
+	dsa_pointer shared_dp = tp_registry_lookup_dsa(RelationGetRelid(index));
+
+	if (!DsaPointerIsValid(shared_dp))
+		return NULL;
+	return (TpSharedIndexState *)
+			dsa_get_address(tp_registry_get_dsa(), shared_dp);
+}
+
+void
+tp_merge_account_write(Relation index, BlockNumber root, bool merged)
+{
+	TpSharedIndexState *shared;
+	TpSegmentReader	   *reader;
+	uint64				bytes;
+
+	if (root == InvalidBlockNumber)
+		return;
+
+	shared = account_shared_state(index);
+	if (shared == NULL)
+		return;
+
+	reader = tp_segment_open(index, root);
+	if (reader == NULL)
+		return;
+	bytes = (uint64)reader->header->num_pages * BLCKSZ;
+	tp_segment_close(reader);
+
+	if (merged)
+	{
+		pg_atomic_fetch_add_u64(&shared->bytes_merged, bytes);
+		pg_atomic_fetch_add_u64(&shared->merges, 1);
+	}
+	else
+		pg_atomic_fetch_add_u64(&shared->bytes_ingested, bytes);
+}
+
+void
+tp_merge_account_workers(Relation index, int nworkers)
+{
+	TpSharedIndexState *shared = account_shared_state(index);
+
+	if (shared != NULL && nworkers > 0)
+		pg_atomic_fetch_add_u64(&shared->parallel_workers, (uint64)nworkers);
+}
+
+void
+tp_merge_account_rounds(Relation index, uint32 rounds)
+{
+	TpSharedIndexState *shared = account_shared_state(index);
+
+	if (shared != NULL && rounds > 0)
+		pg_atomic_fetch_add_u64(&shared->merge_rounds, rounds);
+}
+
+void
+tp_merge_account_throttle(Relation index, uint64 sleeps)
+{
+	TpSharedIndexState *shared = account_shared_state(index);
+
+	if (shared != NULL && sleeps > 0)
+		pg_atomic_fetch_add_u64(&shared->throttle_sleeps, sleeps);
+}
+
+PG_FUNCTION_INFO_V1(tp_merge_stats);
+
+/*
+ * SQL-callable: bm25_merge_stats(index_name text) → record
+ *
+ * Reports the index's merge policy, per-level segment counts, and
+ * the segment bytes written since server start: bytes_ingested by
+ * spills and builds, bytes_merged by merges and VACUUM rewrites.
+ * write_amplification is (ingested + merged) / ingested, NULL until
+ * something has been ingested.  merges counts the merges completed,
+ * parallel_workers the parallel workers launched by merges and by
+ * VACUUM's bulk-delete, merge_rounds the rounds in which builds
+ * merged their temporary segments, throttle_sleeps the times those
+ * merges slept for merge_cost_delay.
+ */
+Datum
+tp_merge_stats(PG_FUNCTION_ARGS)
+{
+	text			  *index_name_text = PG_GETARG_TEXT_PP(0);
+	char			  *index_name	   = text_to_cstring(index_name_text);
+	Oid				   index_oid;
+	Relation		   index_rel;
+	TpLocalIndexState *index_state;
+	TpIndexMetaPage	   metap;
+	TupleDesc		   tupdesc;
+	Datum			   counts[TP_MAX_LEVELS];
+	Datum			   values[9];
+	bool			   nulls[9] = {false};
+	uint64			   ingested = 0;
+	uint64			   merged	= 0;
+	uint64			   merges	= 0;
+	uint64			   workers	= 0;
+	uint64			   rounds	= 0;
+	uint64			   sleeps	= 0;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	index_oid = tp_resolve_index_name_shared(index_name);
+	if (!OidIsValid(index_oid))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("index \"%s\" not found", index_name)));
+
+	index_rel = index_open(index_oid, AccessShareLock);
+
+	metap = tp_get_metapage(index_rel);
+	for (int i = 0; i < TP_MAX_LEVELS; i++)
+		counts[i] = Int32GetDatum((int32)metap->level_counts[i]);
+	pfree(metap);
+
+	index_state = tp_get_local_index_state(index_oid);
+	if (index_state != NULL && index_state->shared != NULL)
+	{
+		ingested = pg_atomic_read_u64(&index_state->shared->bytes_ingested);
+		merged	 = pg_atomic_read_u64(&index_state->shared->bytes_merged);
+		merges	 = pg_atomic_read_u64(&index_state->shared->merges);
+		workers	 = pg_atomic_read_u64(&index_state->shared->parallel_workers);
+		rounds	 = pg_atomic_read_u64(&index_state->shared->merge_rounds);
+		sleeps	 = pg_atomic_read_u64(&index_state->shared->throttle_sleeps);
+	}
+
+	values[0] = CStringGetTextDatum(tp_merge_policy_for(index_rel)->name);
+	values[1] = PointerGetDatum(construct_array(
+			counts, TP_MAX_LEVELS, INT4OID, sizeof(int32), true, TYPALIGN_INT));
+	values[2] = Int64GetDatum((int64)ingested);
+	values[3] = Int64GetDatum((int64)merged);
+	if (ingested > 0)
+		values[4] = Float8GetDatum((double)(ingested + merged) / ingested);
+	else
+		nulls[4] = true;
+	values[5] = Int64GetDatum((int64)merges);
+	values[6] = Int64GetDatum((int64)workers);
+	values[7] = Int64GetDatum((int64)rounds);
+	values[8] = Int64GetDatum((int64)sleeps);
+
+	index_close(index_rel, AccessShareLock);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
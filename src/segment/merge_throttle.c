@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * merge_throttle.c - Merge I/O throttling and merge slots
+ *
+ * See merge_throttle.h.  Spills and in-place merges run under the
+ * per-index LWLock held exclusively, which blocks every reader and
+ * writer of that index, so a sleep there would stall the index rather
+ * than just slow the merge.  Their callers say so (index_locked), and
+ * points reached that way skip their usage instead of charging it,
+ * so it is not billed to a later unlocked merge either.  Nothing here
+ * holds state that an error must clean up except the merge slot,
+ * which the transaction abort callbacks give back.
+ */
+#include <postgres.h>
+
+#include <executor/instrument.h>
+#include <miscadmin.h>
+#include <port/atomics.h>
+#include <storage/latch.h>
+
+#include "constants.h"
+#include "index/registry.h"
+#include "segment/merge_throttle.h"
+
+/* Cost charged since the last sleep */
+static int64 throttle_balance = 0;
+
+/* Sleeps taken by this process */
+static uint64 throttle_sleeps = 0;
+
+/* pgBufferUsage totals as of the last charge */
+static int64 throttle_last_hit	   = 0;
+static int64 throttle_last_read	   = 0;
+static int64 throttle_last_dirtied = 0;
+
+/* Nesting depth of slot holders in this backend */
+static int merge_slot_depth = 0;
+
+/* Whether this backend's slot is counted in the registry */
+static bool merge_slot_counted = false;
+
+static void
+throttle_read_usage(int64 *hit, int64 *read, int64 *dirtied)
+{
+	*hit	 = pgBufferUsage.shared_blks_hit + pgBufferUsage.local_blks_hit;
+	*read	 = pgBufferUsage.shared_blks_read + pgBufferUsage.local_blks_read;
+	*dirtied = pgBufferUsage.shared_blks_dirtied +
+			   pgBufferUsage.local_blks_dirtied;
+}
+
+void
+tp_io_throttle_reset(void)
+{
+	throttle_read_usage(
+			&throttle_last_hit, &throttle_last_read, &throttle_last_dirtied);
+	throttle_balance = 0;
+}
+
+void
+tp_io_throttle_point(bool index_locked)
+{
+	int64  hit;
+	int64  read;
+	int64  dirtied;
+	double msec;
+
+	if (tp_merge_cost_delay <= 0)
+		return;
+
+	/* Never sleep under the index lock, nor bill its I/O later */
+	if (index_locked)
+	{
+		throttle_read_usage(
+				&throttle_last_hit,
+				&throttle_last_read,
+				&throttle_last_dirtied);
+		return;
+	}
+
+	throttle_read_usage(&hit, &read, &dirtied);
+	throttle_balance += (hit - throttle_last_hit) * VacuumCostPageHit +
+						(read - throttle_last_read) * VacuumCostPageMiss +
+						(dirtied - throttle_last_dirtied) *
+								VacuumCostPageDirty;
+	throttle_last_hit	  = hit;
+	throttle_last_read	  = read;
+	throttle_last_dirtied = dirtied;
+
+	if (throttle_balance < tp_merge_cost_limit)
+		return;
+
+	/* Sleep in proportion to the overshoot, capped as vacuum does */
+	msec = tp_merge_cost_delay * throttle_balance / tp_merge_cost_limit;
+	if (msec > tp_merge_cost_delay * TP_MERGE_COST_MAX_DELAY_FACTOR)
+		msec = tp_merge_cost_delay * TP_MERGE_COST_MAX_DELAY_FACTOR;
+
+	(void)WaitLatch(
+			MyLatch,
+			WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+			(long)msec,
+			PG_WAIT_EXTENSION);
+	ResetLatch(MyLatch);
+
+	throttle_balance = 0;
+	throttle_sleeps++;
+}
+
+uint64
+tp_io_throttle_sleeps(void)
+{
+	return throttle_sleeps;
+}
+
+bool
+tp_merge_slot_try_acquire(void)
+{
+	if (merge_slot_depth > 0)
+	{
+		merge_slot_depth++;
+		return true;
+	}
+
+	if (tp_max_concurrent_merges > 0)
+	{
+		pg_atomic_uint32 *active = tp_registry_active_merges();
+		uint32			  cur	 = pg_atomic_read_u32(active);
+
+		do
+		{
+			if (cur >= (uint32)tp_max_concurrent_merges)
+				return false;
+		} while (!pg_atomic_compare_exchange_u32(active, &cur, cur + 1));
+
+		merge_slot_counted = true;
+	}
+
+	merge_slot_depth = 1;
+	return true;
+}
+
+void
+tp_merge_slot_acquire(void)
+{
+	while (!tp_merge_slot_try_acquire())
+	{
+		(void)WaitLatch(
+				MyLatch,
+				WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+				TP_MERGE_SLOT_WAIT_MS,
+				PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+void
+tp_merge_slot_release(void)
+{
+	Assert(merge_slot_depth > 0);
+
+	if (--merge_slot_depth > 0)
+		return;
+
+	if (merge_slot_counted)
+	{
+		pg_atomic_fetch_sub_u32(tp_registry_active_merges(), 1);
+		merge_slot_counted = false;
+	}
+}
+
+void
+tp_merge_slot_release_all(void)
+{
+	if (merge_slot_depth == 0)
+		return;
+
+	merge_slot_depth = 1;
+	tp_merge_slot_release();
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * merge_throttle.h - Cost-based throttling of merge I/O outside the
+ * index lock, and the cluster-wide cap on concurrent merges.
+ *
+ * Throttling works like vacuum's cost delay: buffer hits, misses and
+ * dirtied pages are charged at vacuum_cost_page_hit/miss/dirty, and
+ * once pg_textsearch.merge_cost_limit is reached the process sleeps
+ * for pg_textsearch.merge_cost_delay.  The charge is taken from the
+ * process's pgBufferUsage counters, so it covers the source reads as
+ * well as the pages the writer fills.
+ *
+ * Only merges that run without the per-index lock are throttled,
+ * which today means those of a parallel CREATE INDEX.  Spills,
+ * in-place merges (bm25_force_merge, background and VACUUM
+ * compaction) and the parallel merge workers they start run under
+ * the exclusive lock, or with their leader waiting under it, so their
+ * I/O is neither charged nor slept for.
+ *
+ * Merge slots bound how many merges run at once across every bm25
+ * index in the cluster (pg_textsearch.max_concurrent_merges).  The
+ * count lives in the registry's shared memory.
+ */
+#pragma once
+
+#include <postgres.h>
+
+/*
+ * Start a new throttled operation: forget buffer usage so far and
+ * zero the balance.  Call at the top of a merge.
+ */
+extern void tp_io_throttle_reset(void);
+
+/*
+ * Charge the buffer usage since the last call and sleep once the
+ * balance reaches merge_cost_limit.  index_locked says the caller
+ * holds the per-index lock, or is waited on by a backend holding it:
+ * the usage is then dropped rather than charged, since a sleep would
+ * stall every reader and writer of the index.  Cheap enough to call
+ * per block written.  Does nothing while merge_cost_delay is 0.
+ */
+extern void tp_io_throttle_point(bool index_locked);
+
+/* Throttle sleeps this process has taken; callers take differences */
+extern uint64 tp_io_throttle_sleeps(void);
+
+/*
+ * Take a merge slot without waiting.  Returns false if
+ * max_concurrent_merges merges are already running.  Slots are
+ * reentrant: a merge started while this backend holds a slot (e.g.
+ * the cascade under bm25_force_merge) reuses it.
+ */
+extern bool tp_merge_slot_try_acquire(void);
+
+/* Take a merge slot, waiting for one to free up.  Interruptible. */
+extern void tp_merge_slot_acquire(void);
+
+/* Give back a slot taken by one of the above */
+extern void tp_merge_slot_release(void);
+
+/* Give back any slot this backend holds; transaction abort only */
+extern void tp_merge_slot_release_all(void);
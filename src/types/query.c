@@ -36,17 +36,20 @@
 #include "constants.h"
 #include "index/metapage.h"
 #include "index/resolve.h"
+#include "index/snapshot.h"
 #include "index/source.h"
 #include "index/state.h"
 #include "memtable/cache_source.h"
 #include "memtable/chain_source.h"
 #include "planner/hooks.h"
 #include "scoring/bm25.h"
+#include "scoring/match.h"
 #include "segment/fieldnorm.h"
 #include "segment/io.h"
 #include "segment/segment.h"
 #include "types/array.h"
 #include "types/query.h"
+#include "types/query_terms.h"
 #include "types/vector.h"
 
 /*
@@ -168,7 +171,12 @@ PG_FUNCTION_INFO_V1(bm25_text_text_score);
 PG_FUNCTION_INFO_V1(bm25_textarray_bm25query_score);
 PG_FUNCTION_INFO_V1(bm25_textarray_text_score);
 PG_FUNCTION_INFO_V1(tpquery_eq);
+PG_FUNCTION_INFO_V1(bm25_text_bm25query_match_any);
+PG_FUNCTION_INFO_V1(bm25_text_bm25query_match_all);
+PG_FUNCTION_INFO_V1(bm25_textarray_bm25query_match_any);
+PG_FUNCTION_INFO_V1(bm25_textarray_bm25query_match_all);
 PG_FUNCTION_INFO_V1(bm25_get_current_score);
+PG_FUNCTION_INFO_V1(bm25_count);
 
 /*
  * bm25_get_current_score - stub function for ORDER BY optimization
@@ -326,7 +334,7 @@ tpquery_send(PG_FUNCTION_ARGS)
 
 	pq_begintypsend(&buf);
 	pq_sendint8(&buf, TPQUERY_VERSION);
-	pq_sendint8(&buf, tpquery->flags);
+	pq_sendint8(&buf, tpquery->flags & ~TPQUERY_FLAG_SCORE_FLOOR);
 	pq_sendint32(&buf, tpquery->index_oid);
 	pq_sendint32(&buf, tpquery->query_text_len);
 
@@ -1271,6 +1279,47 @@ tpquery_is_explicit_index(TpQuery *tpquery)
 	return (tpquery->flags & TPQUERY_FLAG_EXPLICIT_INDEX) != 0;
 }
 
+/*
+ * Copy a tpquery, setting its score floor.  The floor is stored
+ * unaligned after the query text's terminator.
+ */
+TpQuery *
+tpquery_with_score_floor(TpQuery *tpquery, float4 score_floor)
+{
+	TpQuery *result;
+	int		 text_size;
+	int		 total_size;
+
+	text_size  = offsetof(TpQuery, data) + tpquery->query_text_len + 1;
+	total_size = text_size + sizeof(float4);
+
+	result = (TpQuery *)palloc0(total_size);
+	memcpy(result, tpquery, text_size);
+	SET_VARSIZE(result, total_size);
+	result->flags |= TPQUERY_FLAG_SCORE_FLOOR;
+	memcpy((char *)result + text_size, &score_floor, sizeof(float4));
+
+	return result;
+}
+
+/*
+ * Score floor of a tpquery, or 0 if it has none
+ */
+float4
+tpquery_score_floor(TpQuery *tpquery)
+{
+	float4 score_floor;
+
+	if (tpquery->version < 2 ||
+		(tpquery->flags & TPQUERY_FLAG_SCORE_FLOOR) == 0)
+		return 0.0f;
+
+	memcpy(&score_floor,
+		   tpquery->data + tpquery->query_text_len + 1,
+		   sizeof(float4));
+	return score_floor;
+}
+
 /*
  * Scoring function for text <@> text operations.
  *
@@ -1312,6 +1361,179 @@ bm25_textarray_bm25query_score(PG_FUNCTION_ARGS)
 	return bm25_text_bm25query_score(fcinfo);
 }
 
+/*
+ * Query terms of a match operator, cached in fn_extra.  The query is
+ * usually a constant, so it is tokenized once per query; a different
+ * query or index replaces the entry.
+ */
+typedef struct MatchQueryCache
+{
+	Oid	   index_oid;		/* index named by the query */
+	Oid	   text_config_oid; /* that index's text search configuration */
+	char  *query_text;		/* query the terms belong to */
+	char **terms;			/* query lexemes */
+	int	   term_count;		/* number of query lexemes */
+} MatchQueryCache;
+
+static MatchQueryCache *
+match_query_cache_get(
+		FunctionCallInfo fcinfo, TpQuery *query, const char *operator_name)
+{
+	MatchQueryCache *cache = (MatchQueryCache *)fcinfo->flinfo->fn_extra;
+	char			*query_text = get_tpquery_text(query);
+	Oid				 index_oid	= get_tpquery_index_oid(query);
+	Relation		 index_rel;
+	TpIndexMetaPage	 metap;
+	Oid				 text_config_oid;
+	int32			*frequencies;
+	MemoryContext	 oldcontext;
+
+	if (cache != NULL && cache->index_oid == index_oid &&
+		strcmp(cache->query_text, query_text) == 0)
+		return cache;
+
+	/*
+	 * The index's text search configuration tokenizes both sides, so
+	 * there is nothing to match against without one.
+	 */
+	if (!OidIsValid(index_oid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("%s operator requires index", operator_name),
+				 errhint("Use to_bm25query(text, index_name) to name the "
+						 "index whose configuration tokenizes the text")));
+
+	/* Checks privileges and picks a child of a partitioned index */
+	index_rel		= validate_and_open_index(query, &index_oid);
+	metap			= tp_get_metapage(index_rel);
+	text_config_oid = metap->text_config_oid;
+	pfree(metap);
+	index_close(index_rel, AccessShareLock);
+
+	oldcontext = MemoryContextSwitchTo(fcinfo->flinfo->fn_mcxt);
+	if (cache == NULL)
+		cache = palloc0(sizeof(MatchQueryCache));
+	else
+	{
+		for (int i = 0; i < cache->term_count; i++)
+			pfree(cache->terms[i]);
+		if (cache->terms)
+			pfree(cache->terms);
+		pfree(cache->query_text);
+	}
+	cache->index_oid	   = get_tpquery_index_oid(query);
+	cache->text_config_oid = text_config_oid;
+	cache->query_text	   = pstrdup(query_text);
+	cache->terms		   = NULL;
+	(void)tp_tokenize_text(
+			cstring_to_text(query_text),
+			text_config_oid,
+			&cache->terms,
+			&frequencies,
+			&cache->term_count);
+	if (frequencies)
+		pfree(frequencies);
+	MemoryContextSwitchTo(oldcontext);
+
+	fcinfo->flinfo->fn_extra = cache;
+	return cache;
+}
+
+/*
+ * text @@@ bm25query and text @@& bm25query: does the text contain any
+ * (or all) of the query's terms, tokenized with the index's text search
+ * configuration.  These are what a bm25 bitmap scan returns, evaluated
+ * row by row for rechecks and plans that do not use the index.  A query
+ * with no terms (only stopwords) matches nothing either way.
+ * `operator_name` names the operator in errors.
+ */
+static bool
+text_matches_query(
+		FunctionCallInfo fcinfo,
+		text			*doc,
+		TpQuery			*query,
+		bool			 require_all,
+		const char		*operator_name)
+{
+	MatchQueryCache *cache =
+			match_query_cache_get(fcinfo, query, operator_name);
+	char		   **doc_terms;
+	int32			*doc_frequencies;
+	int				 doc_term_count;
+	int				 found = 0;
+
+	if (cache->term_count == 0)
+		return false;
+
+	(void)tp_tokenize_text(
+			doc,
+			cache->text_config_oid,
+			&doc_terms,
+			&doc_frequencies,
+			&doc_term_count);
+
+	for (int i = 0; i < cache->term_count; i++)
+	{
+		if (find_term_frequency_in_arrays(
+					doc_terms,
+					doc_frequencies,
+					doc_term_count,
+					cache->terms[i]) > 0)
+			found++;
+		else if (require_all)
+			break;
+	}
+
+	for (int i = 0; i < doc_term_count; i++)
+		pfree(doc_terms[i]);
+	if (doc_terms)
+		pfree(doc_terms);
+	if (doc_frequencies)
+		pfree(doc_frequencies);
+
+	return require_all ? found == cache->term_count : found > 0;
+}
+
+Datum
+bm25_text_bm25query_match_any(PG_FUNCTION_ARGS)
+{
+	text	*doc   = PG_GETARG_TEXT_PP(0);
+	TpQuery *query = (TpQuery *)PG_DETOAST_DATUM(PG_GETARG_DATUM(1));
+
+	PG_RETURN_BOOL(text_matches_query(
+			fcinfo, doc, query, false, "text @@@ bm25query"));
+}
+
+Datum
+bm25_text_bm25query_match_all(PG_FUNCTION_ARGS)
+{
+	text	*doc   = PG_GETARG_TEXT_PP(0);
+	TpQuery *query = (TpQuery *)PG_DETOAST_DATUM(PG_GETARG_DATUM(1));
+
+	PG_RETURN_BOOL(text_matches_query(
+			fcinfo, doc, query, true, "text @@& bm25query"));
+}
+
+Datum
+bm25_textarray_bm25query_match_any(PG_FUNCTION_ARGS)
+{
+	text	*doc   = tp_flatten_text_array(PG_GETARG_DATUM(0));
+	TpQuery *query = (TpQuery *)PG_DETOAST_DATUM(PG_GETARG_DATUM(1));
+
+	PG_RETURN_BOOL(text_matches_query(
+			fcinfo, doc, query, false, "text[] @@@ bm25query"));
+}
+
+Datum
+bm25_textarray_bm25query_match_all(PG_FUNCTION_ARGS)
+{
+	text	*doc   = tp_flatten_text_array(PG_GETARG_DATUM(0));
+	TpQuery *query = (TpQuery *)PG_DETOAST_DATUM(PG_GETARG_DATUM(1));
+
+	PG_RETURN_BOOL(text_matches_query(
+			fcinfo, doc, query, true, "text[] @@& bm25query"));
+}
+
 /*
  * Error stub for text[] <@> text when planner rewrite fails.
  */
@@ -1330,3 +1552,100 @@ bm25_textarray_text_score(PG_FUNCTION_ARGS)
 
 	PG_RETURN_NULL(); /* never reached */
 }
+
+/*
+ * Documents of one bm25 index containing any term of `query_text`.
+ */
+static int64
+index_match_count(Oid index_oid, const char *query_text)
+{
+	Relation		   index_rel;
+	TpIndexMetaPage	   metap;
+	TpQueryTerms	  *terms;
+	TpLocalIndexState *index_state;
+	TpIndexSnapshot	  *snapshot;
+	int64			   count;
+
+	index_rel = index_open(index_oid, AccessShareLock);
+	if (index_rel->rd_rel->relam != get_am_oid("bm25", false))
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not a bm25 index",
+						RelationGetRelationName(index_rel))));
+
+	tp_warn_if_pending_docid(index_rel);
+
+	metap = tp_get_metapage(index_rel);
+	terms = tp_query_terms_get(metap->text_config_oid, query_text);
+	pfree(metap);
+
+	index_state = tp_get_local_index_state(index_oid);
+	if (!index_state)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not get index state for BM25 "
+						"search")));
+
+	snapshot = tp_index_snapshot_capture(
+			index_state,
+			index_rel,
+			(const char *const *)terms->terms,
+			terms->term_count);
+	count = tp_match_count(
+			index_rel, snapshot, terms->terms, terms->term_count);
+	tp_index_snapshot_release(snapshot);
+
+	pfree(terms);
+	index_close(index_rel, AccessShareLock);
+
+	return count;
+}
+
+/*
+ * bm25_count(index_name, query): how many indexed documents contain any
+ * of the query's terms, as text @@@ bm25query selects them.
+ *
+ * Counted from posting lists alone, without scoring and without heap
+ * access, for "N results" totals.  Like the index's own statistics, it
+ * includes rows deleted since the last VACUUM and rows of transactions
+ * still in progress.  A partitioned index sums its partitions.
+ */
+Datum
+bm25_count(PG_FUNCTION_ARGS)
+{
+	char	 *index_name = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	char	 *query_text = text_to_cstring(PG_GETARG_TEXT_PP(1));
+	Oid		  index_oid;
+	List	 *index_oids;
+	ListCell *lc;
+	int64	  count = 0;
+
+	index_oid = tp_resolve_index_name_shared(index_name);
+	if (!OidIsValid(index_oid))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("index \"%s\" does not exist", index_name)));
+
+	/* As for standalone scoring: no executor permission check ran */
+	tp_check_index_read_privilege(index_oid);
+
+	if (get_rel_relkind(index_oid) == RELKIND_PARTITIONED_INDEX)
+		index_oids = find_all_inheritors(index_oid, AccessShareLock, NULL);
+	else
+		index_oids = list_make1_oid(index_oid);
+
+	foreach (lc, index_oids)
+	{
+		Oid oid = lfirst_oid(lc);
+
+		/* Partitioned indexes have no storage; their leaves are listed */
+		if (get_rel_relkind(oid) == RELKIND_INDEX)
+			count += index_match_count(oid, query_text);
+	}
+
+	list_free(index_oids);
+	pfree(index_name);
+	pfree(query_text);
+
+	PG_RETURN_INT64(count);
+}
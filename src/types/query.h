@@ -24,6 +24,7 @@
  * Flags for TpQuery
  */
 #define TPQUERY_FLAG_EXPLICIT_INDEX 0x01 /* Index was explicitly specified */
+#define TPQUERY_FLAG_SCORE_FLOOR	0x02 /* Score floor follows the text */
 
 /*
  * tpquery data type structure
@@ -40,7 +41,8 @@ typedef struct TpQuery
 	Oid	  index_oid;				   /* resolved index OID (InvalidOid if
 										* unresolved) */
 	int32 query_text_len;			   /* length of query text */
-	char  data[FLEXIBLE_ARRAY_MEMBER]; /* payload: query text only */
+	char  data[FLEXIBLE_ARRAY_MEMBER]; /* payload: query text, then the
+										* score floor if flagged */
 } TpQuery;
 
 /* Macro for accessing query text */
@@ -62,6 +64,10 @@ PGDLLEXPORT Datum bm25_text_text_score(PG_FUNCTION_ARGS);
 PGDLLEXPORT Datum bm25_textarray_bm25query_score(PG_FUNCTION_ARGS);
 PGDLLEXPORT Datum bm25_textarray_text_score(PG_FUNCTION_ARGS);
 PGDLLEXPORT Datum tpquery_eq(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum bm25_text_bm25query_match_any(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum bm25_text_bm25query_match_all(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum bm25_textarray_bm25query_match_any(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum bm25_textarray_bm25query_match_all(PG_FUNCTION_ARGS);
 
 /* Utility functions */
 TpQuery *create_tpquery(const char *query_text, Oid index_oid);
@@ -73,3 +79,13 @@ Oid	  get_tpquery_index_oid(TpQuery *tpquery);
 char *get_tpquery_text(TpQuery *tpquery);
 bool  tpquery_has_index(TpQuery *tpquery);
 bool  tpquery_is_explicit_index(TpQuery *tpquery);
+
+/*
+ * Score floor of an index scan's query: the lowest score any row the
+ * scan returns can pass the query's filter with, pushed down from a
+ * score comparison by the planner hook.  The floor only ever appears
+ * on the ORDER BY argument of a planned index scan; it is neither
+ * output nor sent.
+ */
+TpQuery *tpquery_with_score_floor(TpQuery *tpquery, float4 score_floor);
+float4	 tpquery_score_floor(TpQuery *tpquery);
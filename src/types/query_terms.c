@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * query_terms.c - Tokenized query texts, cached per backend
+ *
+ * Every execution of a ranked or matching scan turns its query text
+ * into terms with the index's text search configuration, which runs
+ * the parser and every dictionary over the text.  Search traffic
+ * repeats a small set of query texts at high rates, so the result is
+ * kept in a backend-local LRU keyed by (configuration, text).
+ *
+ * Tokenization depends only on the configuration's catalog entries
+ * and those of its parser and dictionaries, so the cache is emptied
+ * whenever any of them changes, as PostgreSQL's own text search cache
+ * is.  The index is not part of the key: the partitions of a table
+ * share one configuration, and with it their cached queries.
+ */
+#include <postgres.h>
+
+#include <common/hashfn.h>
+#include <lib/ilist.h>
+#include <utils/builtins.h>
+#include <utils/hsearch.h>
+#include <utils/inval.h>
+#include <utils/memutils.h>
+#include <utils/syscache.h>
+
+#include "access/am.h"
+#include "constants.h"
+#include "types/query_terms.h"
+
+/* Longer query texts are tokenized on every use */
+#define TP_QUERY_TERMS_MAX_TEXT_LEN 8192
+
+typedef struct QueryTermsKey
+{
+	Oid	   text_config_oid;
+	uint32 text_hash;
+} QueryTermsKey;
+
+typedef struct QueryTermsEntry
+{
+	QueryTermsKey key;
+	char		 *query_text; /* Tells colliding texts apart */
+	TpQueryTerms *terms;
+	dlist_node	  lru_node; /* Most recently used at the head */
+} QueryTermsEntry;
+
+static HTAB			*query_terms_cache = NULL;
+static MemoryContext query_terms_cxt   = NULL;
+static dlist_head	 query_terms_lru   = DLIST_STATIC_INIT(query_terms_lru);
+static int			 query_terms_count = 0;
+
+/* Bumped by every invalidation, to spot one during tokenization */
+static uint64 query_terms_inval_count = 0;
+static bool	  query_terms_callbacks	  = false;
+
+/*
+ * Syscache callback for the text search catalogs: drop every entry.
+ */
+static void
+query_terms_invalidate(
+		Datum arg		 pg_attribute_unused(),
+		int cacheid		 pg_attribute_unused(),
+		uint32 hashvalue pg_attribute_unused())
+{
+	query_terms_inval_count++;
+
+	if (query_terms_cache == NULL)
+		return;
+
+	/* The hash table lives in the context too */
+	query_terms_cache = NULL;
+	MemoryContextReset(query_terms_cxt);
+	dlist_init(&query_terms_lru);
+	query_terms_count = 0;
+}
+
+/*
+ * Copy terms and frequencies into a single chunk allocated in `cxt`.
+ */
+static TpQueryTerms *
+query_terms_flatten(
+		MemoryContext cxt, char **terms, int32 *frequencies, int term_count)
+{
+	TpQueryTerms *result;
+	Size		  size;
+	char		 *ptr;
+
+	size = MAXALIGN(sizeof(TpQueryTerms)) +
+		   MAXALIGN(term_count * sizeof(char *)) +
+		   MAXALIGN(term_count * sizeof(int32));
+	for (int i = 0; i < term_count; i++)
+		size += strlen(terms[i]) + 1;
+
+	result = MemoryContextAlloc(cxt, size);
+	ptr	   = (char *)result + MAXALIGN(sizeof(TpQueryTerms));
+
+	result->term_count = term_count;
+	result->terms	   = (char **)ptr;
+	ptr += MAXALIGN(term_count * sizeof(char *));
+	result->frequencies = (int32 *)ptr;
+	ptr += MAXALIGN(term_count * sizeof(int32));
+
+	for (int i = 0; i < term_count; i++)
+	{
+		Size len = strlen(terms[i]) + 1;
+
+		memcpy(ptr, terms[i], len);
+		result->terms[i]	   = ptr;
+		result->frequencies[i] = frequencies[i];
+		ptr += len;
+	}
+
+	return result;
+}
+
+/*
+ * Tokenize a query text into a chunk allocated in `cxt`.  The parser's
+ * garbage goes with a temporary context.
+ */
+static TpQueryTerms *
+query_terms_tokenize(
+		MemoryContext cxt, Oid text_config_oid, const char *query_text)
+{
+	MemoryContext tokenize_cxt;
+	MemoryContext oldcontext;
+	TpQueryTerms *result;
+	char		**terms;
+	int32		 *frequencies;
+	int			  term_count;
+
+	tokenize_cxt = AllocSetContextCreate(
+			CurrentMemoryContext,
+			"Tapir query tokenization",
+			ALLOCSET_SMALL_SIZES);
+	oldcontext = MemoryContextSwitchTo(tokenize_cxt);
+
+	(void)tp_tokenize_text(
+			cstring_to_text(query_text),
+			text_config_oid,
+			&terms,
+			&frequencies,
+			&term_count);
+
+	MemoryContextSwitchTo(oldcontext);
+	result = query_terms_flatten(cxt, terms, frequencies, term_count);
+	MemoryContextDelete(tokenize_cxt);
+
+	return result;
+}
+
+static void
+query_terms_remove(QueryTermsEntry *entry)
+{
+	dlist_delete(&entry->lru_node);
+	pfree(entry->query_text);
+	pfree(entry->terms);
+	hash_search(query_terms_cache, &entry->key, HASH_REMOVE, NULL);
+	query_terms_count--;
+}
+
+/*
+ * Cache a tokenization, evicting the least recently used entries over
+ * pg_textsearch.query_cache_size.  A colliding text replaces the entry.
+ */
+static void
+query_terms_store(
+		QueryTermsKey *key, const char *query_text, TpQueryTerms *terms)
+{
+	QueryTermsEntry *entry;
+	char			*text_copy;
+	TpQueryTerms	*terms_copy;
+	bool			 found;
+
+	if (query_terms_cxt == NULL)
+		query_terms_cxt = AllocSetContextCreate(
+				CacheMemoryContext,
+				"BM25 query term cache",
+				ALLOCSET_DEFAULT_SIZES);
+
+	if (query_terms_cache == NULL)
+	{
+		HASHCTL ctl;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize	  = sizeof(QueryTermsKey);
+		ctl.entrysize = sizeof(QueryTermsEntry);
+		ctl.hcxt	  = query_terms_cxt;
+
+		query_terms_cache = hash_create(
+				"BM25 query term cache",
+				256,
+				&ctl,
+				HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	/* Copied first, so an entry is never left half-filled */
+	text_copy  = MemoryContextStrdup(query_terms_cxt, query_text);
+	terms_copy = query_terms_flatten(
+			query_terms_cxt,
+			terms->terms,
+			terms->frequencies,
+			terms->term_count);
+
+	entry = (QueryTermsEntry *)
+			hash_search(query_terms_cache, key, HASH_ENTER, &found);
+	if (found)
+	{
+		dlist_delete(&entry->lru_node);
+		pfree(entry->query_text);
+		pfree(entry->terms);
+	}
+	else
+		query_terms_count++;
+
+	entry->query_text = text_copy;
+	entry->terms	  = terms_copy;
+	dlist_push_head(&query_terms_lru, &entry->lru_node);
+
+	while (query_terms_count > tp_query_cache_size)
+		query_terms_remove(dlist_tail_element(
+				QueryTermsEntry, lru_node, &query_terms_lru));
+}
+
+TpQueryTerms *
+tp_query_terms_get(Oid text_config_oid, const char *query_text)
+{
+	QueryTermsKey	 key;
+	QueryTermsEntry *entry;
+	TpQueryTerms	*result;
+	uint64			 inval_count;
+	Size			 text_len = strlen(query_text);
+
+	if (tp_query_cache_size <= 0 || text_len > TP_QUERY_TERMS_MAX_TEXT_LEN)
+		return query_terms_tokenize(
+				CurrentMemoryContext, text_config_oid, query_text);
+
+	if (!query_terms_callbacks)
+	{
+		CacheRegisterSyscacheCallback(
+				TSCONFIGOID, query_terms_invalidate, (Datum)0);
+		CacheRegisterSyscacheCallback(
+				TSCONFIGMAP, query_terms_invalidate, (Datum)0);
+		CacheRegisterSyscacheCallback(
+				TSDICTOID, query_terms_invalidate, (Datum)0);
+		CacheRegisterSyscacheCallback(
+				TSPARSEROID, query_terms_invalidate, (Datum)0);
+		query_terms_callbacks = true;
+	}
+
+	/* Hashed as raw bytes, padding included */
+	memset(&key, 0, sizeof(QueryTermsKey));
+	key.text_config_oid = text_config_oid;
+	key.text_hash = hash_bytes((const unsigned char *)query_text, text_len);
+
+	if (query_terms_cache != NULL)
+	{
+		entry = (QueryTermsEntry *)
+				hash_search(query_terms_cache, &key, HASH_FIND, NULL);
+		if (entry != NULL && strcmp(entry->query_text, query_text) == 0)
+		{
+			dlist_move_head(&query_terms_lru, &entry->lru_node);
+			return query_terms_flatten(
+					CurrentMemoryContext,
+					entry->terms->terms,
+					entry->terms->frequencies,
+					entry->terms->term_count);
+		}
+	}
+
+	/*
+	 * Not cached if an invalidation arrived meanwhile: the parser may
+	 * have seen the configuration from before it.
+	 */
+	inval_count = query_terms_inval_count;
+	result		= query_terms_tokenize(
+			 CurrentMemoryContext, text_config_oid, query_text);
+	if (inval_count == query_terms_inval_count)
+		query_terms_store(&key, query_text, result);
+
+	return result;
+}
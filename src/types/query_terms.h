@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2025-2026 Tiger Data, Inc.
+ * Licensed under the PostgreSQL License. See LICENSE for details.
+ *
+ * query_terms.h - Tokenized query texts, cached per backend
+ */
+#pragma once
+
+#include <postgres.h>
+
+/*
+ * A query text's distinct terms and their frequencies, as tokenized by
+ * a text search configuration.  Allocated as a single chunk: pfree the
+ * struct to free it all.
+ */
+typedef struct TpQueryTerms
+{
+	int	   term_count;
+	char **terms;
+	int32 *frequencies;
+} TpQueryTerms;
+
+/*
+ * Tokenize `query_text` with `text_config_oid`, in CurrentMemoryContext.
+ *
+ * Served from a backend-local LRU keyed by configuration and text
+ * (pg_textsearch.query_cache_size entries), so a query repeated by
+ * many executions, or by the scans of many partitions, is parsed and
+ * stemmed once.  Changes to any text search configuration or
+ * dictionary empty the cache.
+ */
+extern TpQueryTerms *
+tp_query_terms_get(Oid text_config_oid, const char *query_text);
@@ -0,0 +1,123 @@
+#!/bin/bash
+#
+# replication_result_cache.sh -- the shared top-k result cache stays
+# off on a hot standby.
+#
+# Entries are invalidated by bumping the index's generations from the
+# primary's write paths; WAL redo does not bump them.  A standby that
+# cached a ranking would serve it after replaying rows that change it,
+# so tp_result_cache_key_init refuses every key while in recovery.
+#
+# The test runs one long-lived standby backend with
+# pg_textsearch.result_cache on, repeats a ranked query, replays an
+# insert that outranks every row, and checks that the standby neither
+# looked up nor stored anything and ranks the new row first.  The same
+# queries on the primary must hit the cache, so the check is not
+# vacuous.
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PRIMARY_PORT=55464
+STANDBY_PORT=55465
+TEST_DB=replication_result_cache
+PRIMARY_DIR="${SCRIPT_DIR}/../tmp_repl_result_cache_primary"
+STANDBY_DIR="${SCRIPT_DIR}/../tmp_repl_result_cache_standby"
+
+# shellcheck source=replication_lib.sh
+source "${SCRIPT_DIR}/replication_lib.sh"
+
+trap repl_cleanup EXIT INT TERM
+
+# Best five 'apples' documents, most relevant first, as one line
+TOP5="SELECT string_agg(id::text, ',' ORDER BY score) FROM (
+        SELECT id, body <@> to_bm25query('apples', 'rc_idx') AS score
+        FROM rc_docs
+        ORDER BY body <@> to_bm25query('apples', 'rc_idx')
+        LIMIT 5) s;"
+
+# Lookups the node's result cache has answered either way
+LOOKUPS="SELECT hits + misses FROM bm25_result_cache_stats();"
+
+# Last line of long_lived_query output (skips INFO chatter)
+last_line() {
+    printf '%s\n' "$1" | tail -n 1
+}
+
+main() {
+    log "Starting result cache replication test..."
+    check_required_tools
+
+    setup_primary
+
+    # Every 10th document has 'apples', in ever longer documents, so
+    # the ranking is strictly by id
+    primary_sql "
+        CREATE TABLE rc_docs (id int PRIMARY KEY, body text);
+        INSERT INTO rc_docs
+        SELECT i, 'doc' || repeat(' filler', i)
+                  || CASE WHEN i % 10 = 0 THEN ' apples' ELSE '' END
+        FROM generate_series(1, 100) AS i;
+        CREATE INDEX rc_idx ON rc_docs USING bm25(body)
+            WITH (text_config = 'simple');
+    " >/dev/null
+
+    setup_standby
+    wait_for_standby_catchup
+
+    # Standby: the same ranked query twice with the cache on
+    long_lived_open "${STANDBY_PORT}"
+    long_lived_query "SET pg_textsearch.result_cache = on;" >/dev/null
+    local first second
+    first=$(last_line "$(long_lived_query "${TOP5}")")
+    second=$(last_line "$(long_lived_query "${TOP5}")")
+    log "  standby top 5: ${first} then ${second}"
+    if [ "${first}" != "10,20,30,40,50" ] || [ "${second}" != "${first}" ]
+    then
+        long_lived_close
+        error "standby ranked '${first}' then '${second}', expected \
+10,20,30,40,50 twice"
+    fi
+
+    # A row that outranks every other one, replayed on the standby
+    primary_sql "INSERT INTO rc_docs VALUES (1000, 'apples apples');" \
+        >/dev/null
+    wait_for_standby_catchup
+
+    local replayed lookups
+    replayed=$(last_line "$(long_lived_query "${TOP5}")")
+    lookups=$(last_line "$(long_lived_query "${LOOKUPS}")")
+    long_lived_close
+
+    log "  standby top 5 after replay: ${replayed}"
+    log "  standby cache lookups:      ${lookups} (expect 0)"
+    if [ "${replayed}" != "1000,10,20,30,40" ]; then
+        error "standby ranked '${replayed}' after replay, expected \
+1000,10,20,30,40 -- a cached ranking outlived the replayed insert"
+    fi
+    if [ "${lookups}" != "0" ]; then
+        error "standby result cache was consulted ${lookups} time(s) \
+during recovery, expected none"
+    fi
+    log "PASS: the standby never used the result cache"
+
+    # Primary: the same queries are cached there
+    local hits
+    hits=$(primary_sql_quiet "
+        SET pg_textsearch.result_cache = on;
+        ${TOP5}
+        ${TOP5}
+        SELECT hits FROM bm25_result_cache_stats();" | tail -n 1)
+    log "  primary cache hits: ${hits} (expect 1)"
+    if [ "${hits}" != "1" ]; then
+        error "primary result cache hits ${hits}, expected 1"
+    fi
+    log "PASS: the primary serves the repeated query from the cache"
+
+    log "All result cache replication tests passed!"
+    exit 0
+}
+
+if [ "${BASH_SOURCE[0]}" == "${0}" ]; then
+    main "$@"
+fi
@@ -0,0 +1,72 @@
+-- Background spill worker (pg_textsearch.background_spill).
+--
+-- With the GUC on, an insert that pushes the memtable chain past
+-- memtable_pages_threshold queues the spill for the
+-- pg_textsearch background worker instead of spilling inside the
+-- inserting transaction.  The worker runs asynchronously, so the
+-- test polls for the chain to drain rather than asserting on
+-- intermediate state.
+
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+CREATE TABLE bg_spill_test (id serial PRIMARY KEY, body text);
+CREATE INDEX bg_spill_idx ON bg_spill_test
+    USING bm25(body) WITH (text_config = 'english');
+
+-- The launcher is registered from _PG_init and is always running.
+SELECT count(*) AS launcher_running
+FROM pg_stat_activity
+WHERE backend_type = 'pg_textsearch spill launcher';
+
+SET pg_textsearch.memtable_pages_threshold = 1;
+SET pg_textsearch.background_spill = on;
+
+INSERT INTO bg_spill_test (body)
+SELECT 'gamma ' || i || ' delta ' || (i+1) || ' epsilon ' || (i+2)
+FROM generate_series(1, 300) i;
+
+-- Every insert past the threshold either queued a request or found
+-- one pending, so the worker's last spill runs after the last
+-- insert and leaves the chain empty.
+DO $$
+BEGIN
+    FOR i IN 1..600 LOOP
+        EXIT WHEN (SELECT count(*)
+                   FROM bm25_memtable_chain('bg_spill_idx')) = 0;
+        PERFORM pg_sleep(0.1);
+    END LOOP;
+END $$;
+
+SELECT count(*) AS chain_pages_after_background_spill
+FROM bm25_memtable_chain('bg_spill_idx');
+
+-- The worker's segments serve queries exactly like a foreground
+-- spill's would.
+SELECT count(*) AS gamma_hits FROM (
+    SELECT 1 FROM bg_spill_test
+    ORDER BY body <@> to_bm25query('gamma', 'bg_spill_idx')
+    LIMIT 1000
+) sub;
+
+-- With the GUC off, the insert spills synchronously: the chain is
+-- already empty when the statement returns.
+SET pg_textsearch.background_spill = off;
+
+INSERT INTO bg_spill_test (body)
+SELECT 'zeta ' || i || ' eta ' || (i+1) || ' theta ' || (i+2)
+FROM generate_series(1, 100) i;
+
+SELECT count(*) AS chain_pages_after_foreground_spill
+FROM bm25_memtable_chain('bg_spill_idx');
+
+SELECT count(*) AS zeta_hits FROM (
+    SELECT 1 FROM bg_spill_test
+    ORDER BY body <@> to_bm25query('zeta', 'bg_spill_idx')
+    LIMIT 1000
+) sub;
+
+RESET pg_textsearch.background_spill;
+RESET pg_textsearch.memtable_pages_threshold;
+
+DROP TABLE bg_spill_test;
+DROP EXTENSION pg_textsearch CASCADE;
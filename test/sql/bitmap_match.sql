@@ -0,0 +1,97 @@
+-- Match predicates: text @@@ bm25query (any term) and text @@& bm25query
+-- (every term).
+--
+-- The bm25 index answers them without scoring, as a bitmap scan, so they
+-- combine with other indexes through BitmapAnd / BitmapOr.  Results must
+-- agree with evaluating the operators row by row.
+
+SET client_min_messages = WARNING; -- suppress index-build NOTICE chatter
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+CREATE TABLE bm_docs (id int PRIMARY KEY, tenant int, body text);
+CREATE INDEX bm_tenant_idx ON bm_docs (tenant);
+
+INSERT INTO bm_docs
+SELECT i, i % 10, 'doc w' || i || ' g' || (i % 7) || ' h' || (i % 11)
+FROM generate_series(1, 1000) AS i;
+
+CREATE INDEX bm_idx ON bm_docs USING bm25(body)
+    WITH (text_config = 'simple');
+
+-- Later rows land in the memtable, so both sources are matched
+INSERT INTO bm_docs
+SELECT i, i % 10, 'doc w' || i || ' g' || (i % 7) || ' h' || (i % 11)
+FROM generate_series(1001, 2000) AS i;
+ANALYZE bm_docs;
+
+SET enable_seqscan = off;
+SET enable_indexscan = off;
+
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM bm_docs
+WHERE body @@@ to_bm25query('g1 h1', 'bm_idx');
+
+SELECT count(*) FROM bm_docs
+WHERE body @@@ to_bm25query('g1 h1', 'bm_idx');
+
+SELECT count(*) FROM bm_docs
+WHERE body @@& to_bm25query('g1 h1', 'bm_idx');
+
+-- A term no document contains: nothing for all, the rest for any
+SELECT count(*) FROM bm_docs
+WHERE body @@& to_bm25query('g1 nosuchterm', 'bm_idx');
+
+SELECT count(*) FROM bm_docs
+WHERE body @@@ to_bm25query('g1 nosuchterm', 'bm_idx');
+
+-- Combined with the btree through BitmapOr
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM bm_docs
+WHERE body @@& to_bm25query('g1 h1', 'bm_idx') OR tenant = 3;
+
+SELECT count(*) FROM bm_docs
+WHERE body @@& to_bm25query('g1 h1', 'bm_idx') OR tenant = 3;
+
+SELECT count(*) FROM bm_docs
+WHERE body @@& to_bm25query('g1 h1', 'bm_idx') AND tenant = 3;
+
+-- Two match quals on the same index are intersected
+SELECT count(*) FROM bm_docs
+WHERE body @@@ to_bm25query('g1 g2', 'bm_idx')
+  AND body @@@ to_bm25query('h1 h2', 'bm_idx');
+
+-- A NULL query matches nothing
+SELECT count(*) FROM bm_docs WHERE body @@@ NULL::bm25query;
+
+-- Matching needs the index's configuration, so the query must name it
+SELECT 'g1 h1'::text @@@ to_bm25query('g1');
+SELECT ARRAY['g1', 'h1'] @@& to_bm25query('g1 h1');
+
+-- Match quals alongside ORDER BY filter the ranked results
+RESET enable_indexscan;
+SELECT count(*) FROM (
+    SELECT id FROM bm_docs
+    WHERE body @@& to_bm25query('g1 h1', 'bm_idx')
+    ORDER BY body <@> to_bm25query('g1 h1', 'bm_idx')
+    LIMIT 100) sub;
+
+-- Row-by-row evaluation agrees with the index
+SET enable_seqscan = on;
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+
+SELECT count(*) FROM bm_docs
+WHERE body @@@ to_bm25query('g1 h1', 'bm_idx');
+
+SELECT count(*) FROM bm_docs
+WHERE body @@& to_bm25query('g1 h1', 'bm_idx') OR tenant = 3;
+
+SELECT count(*) FROM bm_docs
+WHERE body @@@ to_bm25query('g1 g2', 'bm_idx')
+  AND body @@@ to_bm25query('h1 h2', 'bm_idx');
+
+RESET enable_bitmapscan;
+RESET enable_indexscan;
+RESET enable_seqscan;
+DROP TABLE bm_docs;
+RESET client_min_messages;
@@ -0,0 +1,49 @@
+-- Shared fixture for the index build tests
+--
+-- build_fixture_table creates a table of 200000 short documents, each
+-- with a unique term w<i>, one of 13 group terms g<n>, and "common".
+-- Tests build two bm25 indexes on it in different ways and compare
+-- them with build_fixture_mismatches, which counts the rows that one
+-- index ranks or scores differently from the other for a query.
+
+CREATE OR REPLACE FUNCTION build_fixture_table(tbl text)
+RETURNS void AS $$
+BEGIN
+    EXECUTE format(
+        'CREATE TABLE %I (id serial PRIMARY KEY, content text)', tbl);
+    EXECUTE format($q$
+        INSERT INTO %I (content)
+        SELECT 'doc w' || i || ' group g' || (i % 13) || ' common'
+        FROM generate_series(1, 200000) AS i$q$, tbl);
+    EXECUTE format('ANALYZE %I', tbl);
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE OR REPLACE FUNCTION build_fixture_mismatches(
+    tbl text, idx_a text, idx_b text, query text, lim int)
+RETURNS bigint AS $$
+DECLARE
+    result bigint;
+BEGIN
+    EXECUTE format($q$
+        WITH a AS (
+            SELECT id, round((content <@> to_bm25query(%2$L, %3$L))
+                             ::numeric, 6) AS score
+            FROM %1$I
+            ORDER BY content <@> to_bm25query(%2$L, %3$L)
+            LIMIT %5$s),
+        b AS (
+            SELECT id, round((content <@> to_bm25query(%2$L, %4$L))
+                             ::numeric, 6) AS score
+            FROM %1$I
+            ORDER BY content <@> to_bm25query(%2$L, %4$L)
+            LIMIT %5$s)
+        SELECT count(*) FROM (
+            (SELECT * FROM a EXCEPT ALL SELECT * FROM b)
+            UNION ALL
+            (SELECT * FROM b EXCEPT ALL SELECT * FROM a)
+        ) diff$q$, tbl, query, idx_a, idx_b, lim)
+    INTO result;
+    RETURN result;
+END;
+$$ LANGUAGE plpgsql;
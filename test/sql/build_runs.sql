@@ -0,0 +1,46 @@
+-- Serial build larger than maintenance_work_mem.
+--
+-- With the smallest maintenance_work_mem the build spills several
+-- sorted runs to a temp file and merges them in one pass at the end.
+-- The index must come out as a single segment and answer like one
+-- built in memory.
+
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+\set ECHO none
+\i test/sql/build_fixture.sql
+\set ECHO all
+
+SET enable_seqscan = off;
+SET max_parallel_maintenance_workers = 0;
+
+SELECT build_fixture_table('brun_t');
+
+SET maintenance_work_mem = '1MB';
+CREATE INDEX brun_small_idx ON brun_t USING bm25(content)
+  WITH (text_config='simple');
+
+SET maintenance_work_mem = '256MB';
+CREATE INDEX brun_big_idx ON brun_t USING bm25(content)
+  WITH (text_config='simple');
+RESET maintenance_work_mem;
+
+-- One segment, no level cascade; only the small build merged runs
+SELECT i AS index_name, level_counts, merge_rounds
+FROM unnest(ARRAY['brun_small_idx', 'brun_big_idx']) AS i,
+     bm25_merge_stats(i)
+ORDER BY i;
+
+SELECT COUNT(*) AS common_count FROM (SELECT 1 FROM brun_t
+ORDER BY content <@> to_bm25query('common', 'brun_small_idx')) sub;
+
+SELECT COUNT(*) AS g5_count FROM (SELECT 1 FROM brun_t
+ORDER BY content <@> to_bm25query('g5', 'brun_small_idx')) sub;
+
+-- Same matches and scores as the in-memory build
+SELECT build_fixture_mismatches('brun_t', 'brun_small_idx', 'brun_big_idx',
+                                'w17 w4242 w150001', 10) AS mismatches;
+
+DROP TABLE brun_t;
+RESET max_parallel_maintenance_workers;
+RESET enable_seqscan;
@@ -106,10 +106,55 @@ SELECT count(*) AS b_hits FROM (
     LIMIT 100
 ) q;
 
+-- ---------- access-aware victim choice ----------
+-- The queries above rebuilt A and B and recorded an access on
+-- each.  C is small but has never been read; A is larger but
+-- hot (read several times, just now).  Eviction weighs bytes
+-- against access rate and rebuild cost, so with caller = B it
+-- must pick C, not the largest cache.
+CREATE TABLE cache_cap_c (id int, body text);
+CREATE INDEX cache_cap_c_idx ON cache_cap_c
+    USING bm25 (body) WITH (text_config = 'english');
+INSERT INTO cache_cap_c
+SELECT g, 'plum ' || g
+  FROM generate_series(1, 5) g;
+
+SELECT result,
+       (estimated_bytes > 0) AS c_bytes_nonzero
+  FROM bm25_cache_cold_build('cache_cap_c_idx');
+
+SELECT count(*) AS a_hits_again FROM (
+    SELECT id FROM cache_cap_a
+    ORDER BY body <@> to_bm25query('banana', 'cache_cap_a_idx')
+    LIMIT 100
+) q;
+
+SELECT count(*) AS a_hits_again FROM (
+    SELECT id FROM cache_cap_a
+    ORDER BY body <@> to_bm25query('cherry', 'cache_cap_a_idx')
+    LIMIT 100
+) q;
+
+SELECT bm25_cache_evict_largest('cache_cap_b_idx') AS evict_cold_c;
+
+-- The diagnostics SRF shows the inputs behind that choice:
+-- A and B are still cached and have been read; C was drained
+-- and never read.
+SELECT c.relname,
+       e.estimated_bytes > 0 AS cached,
+       e.access_count > 0 AS accessed,
+       e.last_access IS NOT NULL AS has_last_access
+  FROM bm25_cache_eviction_candidates() e
+  JOIN pg_class c ON c.oid = e.index_oid
+ WHERE c.relname LIKE 'cache_cap_%'
+ ORDER BY c.relname;
+
 -- Cleanup
 RESET pg_textsearch.memtable_cache_enabled;
 DROP INDEX cache_cap_a_idx;
 DROP INDEX cache_cap_b_idx;
+DROP INDEX cache_cap_c_idx;
 DROP TABLE cache_cap_a;
 DROP TABLE cache_cap_b;
+DROP TABLE cache_cap_c;
 DROP EXTENSION pg_textsearch CASCADE;
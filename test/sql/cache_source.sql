@@ -78,6 +78,32 @@ SELECT id, body
 
 RESET pg_textsearch.memtable_cache_enabled;
 
+-- ---------- sealed posting blocks ----------
+-- 300 more documents push 'shared' past several full open tails,
+-- so the cache serves it from sealed compressed blocks followed
+-- by the tail.  Counts and the scored set must match the chain.
+INSERT INTO cache_source_t
+SELECT g, 'shared bulk ' || g
+  FROM generate_series(6, 305) g;
+
+SELECT bm25_test_cache_source('cache_source_idx', 'lookup:share');
+
+SET pg_textsearch.memtable_cache_enabled = off;
+SELECT count(*), sum(id)
+  FROM (SELECT id
+          FROM cache_source_t
+         ORDER BY body <@> to_bm25query('shared', 'cache_source_idx')
+         LIMIT 1000) s;
+
+SET pg_textsearch.memtable_cache_enabled = on;
+SELECT count(*), sum(id)
+  FROM (SELECT id
+          FROM cache_source_t
+         ORDER BY body <@> to_bm25query('shared', 'cache_source_idx')
+         LIMIT 1000) s;
+
+RESET pg_textsearch.memtable_cache_enabled;
+
 DROP INDEX cache_source_idx;
 DROP TABLE cache_source_t;
 DROP EXTENSION pg_textsearch CASCADE;
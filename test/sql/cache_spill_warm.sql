@@ -0,0 +1,78 @@
+-- Spilling from a warm memtable cache (tp_cache_extract_for_spill)
+-- must write the same segment as spilling from the chain.
+--
+-- Two identical tables are spilled: one with the cache warmed and
+-- generation-matched beforehand, one with the cache disabled so the
+-- spill re-walks the chain.  Scores and bm25_merge_stats must agree.
+
+SET client_min_messages = WARNING; -- suppress index-build NOTICE chatter
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+CREATE TABLE csw_warm (id int, body text);
+CREATE TABLE csw_cold (id int, body text);
+CREATE INDEX csw_warm_idx ON csw_warm USING bm25 (body)
+    WITH (text_config = 'simple');
+CREATE INDEX csw_cold_idx ON csw_cold USING bm25 (body)
+    WITH (text_config = 'simple');
+
+CREATE FUNCTION csw_fill(lo int, hi int) RETURNS void
+LANGUAGE sql AS $$
+    INSERT INTO csw_warm
+    SELECT i, 'doc' || repeat(' alpha', i % 3)
+              || CASE WHEN i % 4 = 0 THEN ' beta beta' ELSE '' END
+              || CASE WHEN i % 5 = 0 THEN ' gamma' ELSE '' END
+              || repeat(' filler', i % 7)
+    FROM generate_series(lo, hi) AS i;
+    INSERT INTO csw_cold SELECT * FROM csw_warm WHERE id BETWEEN lo AND hi;
+$$;
+
+SELECT csw_fill(1, 60);
+
+-- Warm the first index's cache over the first batch
+SET pg_textsearch.memtable_cache_enabled = on;
+SELECT result, records_applied FROM bm25_cache_cold_build('csw_warm_idx');
+
+-- A second batch the cache has not seen; the spill catches up on it
+SELECT csw_fill(61, 100);
+
+SELECT bm25_spill_index('csw_warm_idx') IS NOT NULL AS warm_spilled;
+
+-- The cold index's cache was never built, so its spill walks the chain
+SET pg_textsearch.memtable_cache_enabled = off;
+SELECT result FROM bm25_cache_apply_to_tail('csw_cold_idx');
+SELECT bm25_spill_index('csw_cold_idx') IS NOT NULL AS cold_spilled;
+RESET pg_textsearch.memtable_cache_enabled;
+
+-- Both memtables are empty again; everything lives in one segment
+SELECT w.level_counts AS warm_levels, c.level_counts AS cold_levels,
+       w.bytes_ingested = c.bytes_ingested AS same_bytes
+FROM bm25_merge_stats('csw_warm_idx') w, bm25_merge_stats('csw_cold_idx') c;
+
+-- Every document scores the same for every query
+CREATE TABLE csw_results (src text, q text, id int, score numeric);
+INSERT INTO csw_results
+SELECT 'warm', q, id,
+       round((body <@> to_bm25query(q, 'csw_warm_idx'))::numeric, 6)
+FROM csw_warm, unnest(ARRAY['alpha', 'beta', 'gamma', 'alpha gamma']) AS q;
+INSERT INTO csw_results
+SELECT 'cold', q, id,
+       round((body <@> to_bm25query(q, 'csw_cold_idx'))::numeric, 6)
+FROM csw_cold, unnest(ARRAY['alpha', 'beta', 'gamma', 'alpha gamma']) AS q;
+
+SELECT count(*) AS mismatches FROM (
+    (SELECT q, id, score FROM csw_results WHERE src = 'warm'
+     EXCEPT ALL
+     SELECT q, id, score FROM csw_results WHERE src = 'cold')
+    UNION ALL
+    (SELECT q, id, score FROM csw_results WHERE src = 'cold'
+     EXCEPT ALL
+     SELECT q, id, score FROM csw_results WHERE src = 'warm')
+) diff;
+
+SELECT q, count(*) FILTER (WHERE score < 0) AS matching
+FROM csw_results WHERE src = 'warm' GROUP BY q ORDER BY q;
+
+DROP TABLE csw_results;
+DROP FUNCTION csw_fill;
+DROP TABLE csw_warm;
+DROP TABLE csw_cold;
@@ -0,0 +1,41 @@
+-- Term-statistics cost model for BM25 index scans.
+--
+-- tp_costestimate looks up the doc frequencies of the query's terms,
+-- so the same filtered top-k query is planned differently depending on
+-- how many postings the search term has: a rare term is cheapest to
+-- score first and filter afterwards, while a term in every document is
+-- cheaper to score only on the few rows the filter lets through.
+
+SET client_min_messages = WARNING; -- suppress index-build NOTICE chatter
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+CREATE TABLE cts_docs (id int PRIMARY KEY, body text);
+
+INSERT INTO cts_docs
+SELECT i, 'doc w' || i || ' common'
+FROM generate_series(1, 20000) AS i;
+
+CREATE INDEX cts_idx ON cts_docs USING bm25(body)
+    WITH (text_config = 'simple');
+ANALYZE cts_docs;
+
+-- One posting: the BM25 scan, with the range as a Filter
+EXPLAIN (COSTS OFF)
+SELECT id FROM cts_docs WHERE id BETWEEN 1 AND 20
+ORDER BY body <@> to_bm25query('w7', 'cts_idx')
+LIMIT 10;
+
+-- A posting per row: the range first, then score and sort 20 rows
+EXPLAIN (COSTS OFF)
+SELECT id FROM cts_docs WHERE id BETWEEN 1 AND 20
+ORDER BY body <@> to_bm25query('common', 'cts_idx')
+LIMIT 10;
+
+-- Unfiltered, block-max WAND skips most of the common term's blocks
+EXPLAIN (COSTS OFF)
+SELECT id FROM cts_docs
+ORDER BY body <@> to_bm25query('common', 'cts_idx')
+LIMIT 10;
+
+DROP TABLE cts_docs;
+RESET client_min_messages;
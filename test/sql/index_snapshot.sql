@@ -0,0 +1,90 @@
+-- Scoring runs against an index snapshot (src/index/snapshot.c):
+-- segment level heads plus the query terms' memtable postings,
+-- captured under a brief per-index lock.  These checks make sure
+-- the snapshot sees both halves of the index, collapses duplicate
+-- query terms, and leaves a lock taken earlier in the transaction
+-- alone.
+
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+CREATE TABLE snap_t (id int, body text);
+CREATE INDEX snap_idx ON snap_t
+    USING bm25 (body) WITH (text_config = 'english');
+
+-- Empty index: nothing captured, nothing scored.
+SELECT count(*) AS empty_hits FROM (
+    SELECT id FROM snap_t
+    ORDER BY body <@> to_bm25query('alpha', 'snap_idx')
+    LIMIT 100
+) q;
+
+-- ---------- segment + memtable ----------
+INSERT INTO snap_t
+SELECT g, 'alpha term ' || g
+  FROM generate_series(1, 10) g;
+
+SELECT bm25_spill_index('snap_idx') > 0 AS spill_wrote_docs;
+
+INSERT INTO snap_t
+SELECT g, 'alpha beta ' || g
+  FROM generate_series(11, 15) g;
+
+-- 10 docs from the segment, 5 from the memtable.
+SELECT count(*) AS alpha_hits FROM (
+    SELECT id FROM snap_t
+    ORDER BY body <@> to_bm25query('alpha', 'snap_idx')
+    LIMIT 100
+) q;
+
+-- Memtable-only term; the top hits all come from the memtable.
+SELECT count(*) AS beta_hits, bool_and(id > 10) AS all_memtable FROM (
+    SELECT id FROM snap_t
+    ORDER BY body <@> to_bm25query('beta', 'snap_idx')
+    LIMIT 5
+) q;
+
+-- Duplicate query terms share one materialized entry.
+SELECT count(*) AS dup_term_hits FROM (
+    SELECT id FROM snap_t
+    ORDER BY body <@> to_bm25query('beta beta alpha', 'snap_idx')
+    LIMIT 100
+) q;
+
+-- ---------- same answers through the chain source ----------
+SET pg_textsearch.memtable_cache_enabled = off;
+
+SELECT count(*) AS alpha_hits_chain FROM (
+    SELECT id FROM snap_t
+    ORDER BY body <@> to_bm25query('alpha', 'snap_idx')
+    LIMIT 100
+) q;
+
+RESET pg_textsearch.memtable_cache_enabled;
+
+-- ---------- lock already held by the transaction ----------
+-- The insert takes the per-index lock first; the snapshot must
+-- not release it out from under the rest of the transaction.
+BEGIN;
+INSERT INTO snap_t VALUES (16, 'alpha gamma 16');
+SELECT count(*) AS in_xact_hits FROM (
+    SELECT id FROM snap_t
+    ORDER BY body <@> to_bm25query('alpha', 'snap_idx')
+    LIMIT 100
+) q;
+INSERT INTO snap_t VALUES (17, 'alpha gamma 17');
+SELECT count(*) AS in_xact_gamma_hits FROM (
+    SELECT id FROM snap_t
+    ORDER BY body <@> to_bm25query('gamma', 'snap_idx')
+    LIMIT 100
+) q;
+COMMIT;
+
+SELECT count(*) AS final_hits FROM (
+    SELECT id FROM snap_t
+    ORDER BY body <@> to_bm25query('alpha', 'snap_idx')
+    LIMIT 100
+) q;
+
+DROP INDEX snap_idx;
+DROP TABLE snap_t;
+DROP EXTENSION pg_textsearch CASCADE;
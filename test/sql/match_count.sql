@@ -0,0 +1,75 @@
+-- bm25_count(index_name, query): documents containing any query term,
+-- counted from the index's posting lists without scoring or heap
+-- access.
+--
+-- Until VACUUM it counts what the index holds, deleted rows included;
+-- afterwards it must agree with count(*) over text @@@ bm25query.
+
+SET client_min_messages = WARNING; -- suppress index-build NOTICE chatter
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+CREATE TABLE mc_docs (id int PRIMARY KEY, body text);
+
+INSERT INTO mc_docs
+SELECT i, 'doc w' || i || ' g' || (i % 7) || ' h' || (i % 11)
+FROM generate_series(1, 1000) AS i;
+
+CREATE INDEX mc_idx ON mc_docs USING bm25(body)
+    WITH (text_config = 'simple');
+
+-- Later rows land in the memtable, so both sources are counted
+INSERT INTO mc_docs
+SELECT i, 'doc w' || i || ' g' || (i % 7) || ' h' || (i % 11)
+FROM generate_series(1001, 2000) AS i;
+
+SET enable_seqscan = off;
+
+-- One term, several terms, every document, no document
+SELECT bm25_count('mc_idx', 'g1') AS indexed,
+       (SELECT count(*) FROM mc_docs
+        WHERE body @@@ to_bm25query('g1', 'mc_idx')) AS visible;
+SELECT bm25_count('mc_idx', 'g1 h1') AS indexed,
+       (SELECT count(*) FROM mc_docs
+        WHERE body @@@ to_bm25query('g1 h1', 'mc_idx')) AS visible;
+SELECT bm25_count('mc_idx', 'doc');
+SELECT bm25_count('mc_idx', 'nosuchterm');
+
+-- Deleted rows count until VACUUM marks them dead
+DELETE FROM mc_docs WHERE id <= 500 AND id % 7 = 1;
+
+SELECT bm25_count('mc_idx', 'g1') AS indexed,
+       (SELECT count(*) FROM mc_docs
+        WHERE body @@@ to_bm25query('g1', 'mc_idx')) AS visible;
+
+VACUUM mc_docs;
+
+SELECT bm25_count('mc_idx', 'g1') AS indexed,
+       (SELECT count(*) FROM mc_docs
+        WHERE body @@@ to_bm25query('g1', 'mc_idx')) AS visible;
+SELECT bm25_count('mc_idx', 'g1 h1') AS indexed,
+       (SELECT count(*) FROM mc_docs
+        WHERE body @@@ to_bm25query('g1 h1', 'mc_idx')) AS visible;
+
+-- A partitioned index sums its partitions
+CREATE TABLE mc_parts (id int, body text) PARTITION BY RANGE (id);
+CREATE TABLE mc_parts_1 PARTITION OF mc_parts FOR VALUES FROM (1) TO (201);
+CREATE TABLE mc_parts_2 PARTITION OF mc_parts FOR VALUES FROM (201) TO (401);
+
+INSERT INTO mc_parts
+SELECT i, CASE WHEN (i <= 200 AND i % 2 = 0) OR i % 4 = 0
+               THEN 'apple' ELSE 'pear' END
+FROM generate_series(1, 400) AS i;
+
+CREATE INDEX mc_parts_idx ON mc_parts USING bm25(body)
+    WITH (text_config = 'simple');
+
+SELECT bm25_count('mc_parts_idx', 'apple');
+SELECT bm25_count('mc_parts_idx', 'apple pear');
+
+-- Errors
+SELECT bm25_count('mc_no_such_idx', 'g1');
+SELECT bm25_count('mc_docs_pkey', 'g1');
+
+DROP TABLE mc_parts;
+DROP TABLE mc_docs;
+RESET enable_seqscan;
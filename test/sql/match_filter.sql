@@ -0,0 +1,96 @@
+-- Match quals as a candidate filter for ranked scans.
+--
+-- With ORDER BY <@> ... LIMIT k and a @@@ / @@& qual on the same index,
+-- block-max WAND only scores documents satisfying the qual, so a very
+-- selective qual still yields k rows from a single scoring pass.
+
+SET client_min_messages = WARNING; -- suppress index-build NOTICE chatter
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+CREATE TABLE mf_docs (id int PRIMARY KEY, body text);
+
+-- 'rare' in one document in a thousand
+INSERT INTO mf_docs
+SELECT i, 'doc w' || i || ' common'
+          || CASE WHEN i % 1000 = 0 THEN ' rare' ELSE '' END
+FROM generate_series(1, 3000) AS i;
+
+CREATE INDEX mf_idx ON mf_docs USING bm25(body)
+    WITH (text_config = 'simple');
+
+-- Later rows land in the memtable, so both sources are filtered
+INSERT INTO mf_docs
+SELECT i, 'doc w' || i || ' common'
+          || CASE WHEN i % 1000 = 0 THEN ' rare' ELSE '' END
+FROM generate_series(3001, 5000) AS i;
+ANALYZE mf_docs;
+
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+
+EXPLAIN (COSTS OFF)
+SELECT id FROM mf_docs
+WHERE body @@@ to_bm25query('rare', 'mf_idx')
+ORDER BY body <@> to_bm25query('common', 'mf_idx')
+LIMIT 3;
+
+-- k rows, all satisfying the qual
+SELECT count(*), bool_and(body LIKE '%rare') AS all_match FROM (
+    SELECT body FROM mf_docs
+    WHERE body @@@ to_bm25query('rare', 'mf_idx')
+    ORDER BY body <@> to_bm25query('common', 'mf_idx')
+    LIMIT 3) sub;
+
+-- Multi-term ranking, same filter
+SELECT count(*), bool_and(body LIKE '%rare') AS all_match FROM (
+    SELECT body FROM mf_docs
+    WHERE body @@@ to_bm25query('rare', 'mf_idx')
+    ORDER BY body <@> to_bm25query('common doc', 'mf_idx')
+    LIMIT 3) sub;
+
+-- A larger k returns exactly the matching documents
+SELECT array_agg(id ORDER BY id) FROM (
+    SELECT id FROM mf_docs
+    WHERE body @@@ to_bm25query('rare', 'mf_idx')
+    ORDER BY body <@> to_bm25query('common', 'mf_idx')
+    LIMIT 10) sub;
+
+-- All-terms qual: only w4000 has both
+SELECT array_agg(id ORDER BY id) FROM (
+    SELECT id FROM mf_docs
+    WHERE body @@& to_bm25query('rare w4000', 'mf_idx')
+    ORDER BY body <@> to_bm25query('common', 'mf_idx')
+    LIMIT 10) sub;
+
+-- The filter does not change scores
+WITH filtered AS (
+    SELECT id, round((body <@> to_bm25query('common doc', 'mf_idx'))
+                     ::numeric, 6) AS score
+    FROM mf_docs
+    WHERE body @@@ to_bm25query('rare', 'mf_idx')
+    ORDER BY body <@> to_bm25query('common doc', 'mf_idx')
+    LIMIT 10),
+unfiltered AS (
+    SELECT id, round((body <@> to_bm25query('common doc', 'mf_idx'))
+                     ::numeric, 6) AS score
+    FROM mf_docs
+    WHERE id % 1000 = 0
+    ORDER BY body <@> to_bm25query('common doc', 'mf_idx')
+    LIMIT 10)
+SELECT count(*) AS mismatches FROM (
+    (SELECT * FROM filtered EXCEPT ALL SELECT * FROM unfiltered)
+    UNION ALL
+    (SELECT * FROM unfiltered EXCEPT ALL SELECT * FROM filtered)
+) diff;
+
+-- No document satisfies the qual
+SELECT count(*) FROM (
+    SELECT id FROM mf_docs
+    WHERE body @@& to_bm25query('rare nosuchterm', 'mf_idx')
+    ORDER BY body <@> to_bm25query('common', 'mf_idx')
+    LIMIT 3) sub;
+
+RESET enable_bitmapscan;
+RESET enable_seqscan;
+DROP TABLE mf_docs;
+RESET client_min_messages;
@@ -0,0 +1,115 @@
+-- Parallel segment merge (pg_textsearch.parallel_merge_workers).
+--
+-- A merge with enough terms splits its posting streams by term range
+-- across parallel workers and stitches the results back together.
+-- Two indexes on one table get the same two segments; one is
+-- force-merged in parallel and one serially, and they must answer
+-- alike.
+
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+SET pg_textsearch.segments_per_level = 64;
+SET pg_textsearch.memtable_pages_threshold = 0;
+SET pg_textsearch.bulk_load_threshold = 0;
+SET max_parallel_maintenance_workers = 2;
+
+CREATE TABLE merge_par_t (id serial PRIMARY KEY, body text);
+
+CREATE INDEX merge_par_idx ON merge_par_t
+    USING bm25(body) WITH (text_config = 'simple');
+CREATE INDEX merge_ser_idx ON merge_par_t
+    USING bm25(body) WITH (text_config = 'simple');
+
+-- Two segments, each with 6000 distinct terms plus shared ones.
+INSERT INTO merge_par_t (body)
+SELECT 'w' || i || ' common g' || (i % 50) FROM generate_series(1, 6000) i;
+SELECT bm25_spill_index('merge_par_idx') IS NOT NULL AS spilled;
+SELECT bm25_spill_index('merge_ser_idx') IS NOT NULL AS spilled;
+
+INSERT INTO merge_par_t (body)
+SELECT 'w' || i || ' common g' || (i % 50) FROM generate_series(6001, 12000) i;
+SELECT bm25_spill_index('merge_par_idx') IS NOT NULL AS spilled;
+SELECT bm25_spill_index('merge_ser_idx') IS NOT NULL AS spilled;
+
+-- Dead docs must be dropped by the parallel merge too.
+DELETE FROM merge_par_t WHERE id % 10 = 0;
+VACUUM merge_par_t;
+
+SET pg_textsearch.parallel_merge_workers = 2;
+SELECT bm25_force_merge('merge_par_idx');
+
+SET pg_textsearch.parallel_merge_workers = 0;
+SELECT bm25_force_merge('merge_ser_idx');
+RESET pg_textsearch.parallel_merge_workers;
+
+-- Both merged into one segment, but only merge_par_idx used workers
+SELECT i AS index_name,
+       (SELECT sum(c) FROM unnest(level_counts) c) AS segments,
+       merges > 0 AS merged, parallel_workers > 0 AS parallel
+FROM unnest(ARRAY['merge_par_idx', 'merge_ser_idx']) AS i,
+     bm25_merge_stats(i)
+ORDER BY i;
+
+SET enable_seqscan = off;
+
+-- Every live doc is still found through the shared term.
+SELECT count(*) AS common_hits FROM (
+    SELECT id FROM merge_par_t
+    ORDER BY body <@> to_bm25query('common', 'merge_par_idx')
+    LIMIT 20000
+) sub;
+
+-- Terms at both ends of the dictionary and from both segments.
+SELECT 'w1' AS term, count(*) AS hits FROM (
+    SELECT id FROM merge_par_t
+    ORDER BY body <@> to_bm25query('w1', 'merge_par_idx') LIMIT 10) s
+UNION ALL
+SELECT 'w5999' AS term, count(*) AS hits FROM (
+    SELECT id FROM merge_par_t
+    ORDER BY body <@> to_bm25query('w5999', 'merge_par_idx') LIMIT 10) s
+UNION ALL
+SELECT 'w6001' AS term, count(*) AS hits FROM (
+    SELECT id FROM merge_par_t
+    ORDER BY body <@> to_bm25query('w6001', 'merge_par_idx') LIMIT 10) s
+UNION ALL
+SELECT 'w9999' AS term, count(*) AS hits FROM (
+    SELECT id FROM merge_par_t
+    ORDER BY body <@> to_bm25query('w9999', 'merge_par_idx') LIMIT 10) s
+UNION ALL
+SELECT 'w11999' AS term, count(*) AS hits FROM (
+    SELECT id FROM merge_par_t
+    ORDER BY body <@> to_bm25query('w11999', 'merge_par_idx') LIMIT 10) s;
+
+-- A deleted doc's unique term finds nothing.
+SELECT count(*) AS deleted_hits FROM (
+    SELECT id FROM merge_par_t
+    ORDER BY body <@> to_bm25query('w6010', 'merge_par_idx')
+    LIMIT 10
+) sub;
+
+-- Same matches and scores as the serially merged index.
+WITH par AS (
+    SELECT id, round((body <@> to_bm25query('g7 w107', 'merge_par_idx'))
+                     ::numeric, 6) AS score
+    FROM merge_par_t
+    ORDER BY body <@> to_bm25query('g7 w107', 'merge_par_idx')
+    LIMIT 1000),
+ser AS (
+    SELECT id, round((body <@> to_bm25query('g7 w107', 'merge_ser_idx'))
+                     ::numeric, 6) AS score
+    FROM merge_par_t
+    ORDER BY body <@> to_bm25query('g7 w107', 'merge_ser_idx')
+    LIMIT 1000)
+SELECT count(*) AS mismatches FROM (
+    (SELECT * FROM par EXCEPT ALL SELECT * FROM ser)
+    UNION ALL
+    (SELECT * FROM ser EXCEPT ALL SELECT * FROM par)
+) diff;
+
+RESET enable_seqscan;
+
+DROP TABLE merge_par_t;
+RESET max_parallel_maintenance_workers;
+RESET pg_textsearch.bulk_load_threshold;
+RESET pg_textsearch.memtable_pages_threshold;
+RESET pg_textsearch.segments_per_level;
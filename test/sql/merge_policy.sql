@@ -0,0 +1,67 @@
+-- Merge policies (merge_policy reloption) and write-amplification
+-- accounting (bm25_merge_stats).
+--
+-- The tiered policy merges a level when it is full or when a
+-- segment's dead-doc share reaches merge_deletes_pct; the level
+-- policy only on a full level.
+
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+SET pg_textsearch.segments_per_level = 4;
+
+CREATE TABLE merge_policy_t (id serial PRIMARY KEY, body text);
+
+-- Invalid values are rejected.
+CREATE INDEX merge_policy_bad_idx ON merge_policy_t
+    USING bm25(body) WITH (text_config = 'english', merge_policy = 'bogus');
+CREATE INDEX merge_policy_bad_idx ON merge_policy_t
+    USING bm25(body) WITH (text_config = 'english', merge_deletes_pct = 150);
+
+CREATE INDEX merge_policy_idx ON merge_policy_t
+    USING bm25(body)
+    WITH (text_config = 'english', merge_policy = 'tiered',
+          merge_deletes_pct = 50);
+
+INSERT INTO merge_policy_t (body)
+SELECT 'alpha ' || i FROM generate_series(1, 20) i;
+SELECT bm25_spill_index('merge_policy_idx') IS NOT NULL AS spilled;
+
+-- One L0 segment, nothing merged yet: write amplification is 1.
+SELECT merge_policy, level_counts, bytes_ingested > 0 AS ingested,
+       bytes_merged, write_amplification
+FROM bm25_merge_stats('merge_policy_idx');
+
+-- VACUUM marks 15 of the segment's 20 docs dead (75%).  The level
+-- holds two segments after the next spill, far below
+-- segments_per_level, so only the deletion trigger can merge them.
+DELETE FROM merge_policy_t WHERE id <= 15;
+VACUUM merge_policy_t;
+
+INSERT INTO merge_policy_t (body)
+SELECT 'beta ' || i FROM generate_series(1, 5) i;
+SELECT bm25_spill_index('merge_policy_idx') IS NOT NULL AS spilled;
+
+SELECT merge_policy, level_counts, bytes_merged > 0 AS merged,
+       write_amplification > 1 AS amplified
+FROM bm25_merge_stats('merge_policy_idx');
+
+SET enable_seqscan = off;
+SELECT count(*) AS alpha_hits FROM (
+    SELECT id FROM merge_policy_t
+    ORDER BY body <@> to_bm25query('alpha', 'merge_policy_idx')
+    LIMIT 100
+) sub;
+SELECT count(*) AS beta_hits FROM (
+    SELECT id FROM merge_policy_t
+    ORDER BY body <@> to_bm25query('beta', 'merge_policy_idx')
+    LIMIT 100
+) sub;
+RESET enable_seqscan;
+
+-- The policy can be changed in place.
+ALTER INDEX merge_policy_idx SET (merge_policy = 'level');
+SELECT merge_policy FROM bm25_merge_stats('merge_policy_idx');
+
+RESET pg_textsearch.segments_per_level;
+DROP TABLE merge_policy_t;
+DROP EXTENSION pg_textsearch CASCADE;
@@ -0,0 +1,101 @@
+-- Merge I/O throttling (pg_textsearch.merge_cost_delay,
+-- merge_cost_limit) and the merge slot cap (max_concurrent_merges).
+--
+-- Throttling only ever delays I/O; the segments written must be the
+-- same.  Spills and bm25_force_merge hold the index lock, so they must
+-- never sleep; only the merges of a parallel CREATE INDEX do.
+-- bm25_merge_stats counts the sleeps.
+
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+SET pg_textsearch.segments_per_level = 64;
+SET pg_textsearch.memtable_pages_threshold = 0;
+SET pg_textsearch.bulk_load_threshold = 0;
+
+-- Charge limit low enough that every throttle point is over it
+SET pg_textsearch.merge_cost_delay = '1ms';
+SET pg_textsearch.merge_cost_limit = 20;
+SHOW pg_textsearch.merge_cost_delay;
+SHOW pg_textsearch.merge_cost_limit;
+
+CREATE TABLE merge_thr_t (id serial PRIMARY KEY, body text);
+CREATE INDEX merge_thr_idx ON merge_thr_t
+    USING bm25(body) WITH (text_config = 'simple');
+
+INSERT INTO merge_thr_t (body)
+SELECT 'w' || i || ' common' FROM generate_series(1, 2000) i;
+SELECT bm25_spill_index('merge_thr_idx') IS NOT NULL AS spilled;
+
+INSERT INTO merge_thr_t (body)
+SELECT 'w' || i || ' common' FROM generate_series(2001, 4000) i;
+SELECT bm25_spill_index('merge_thr_idx') IS NOT NULL AS spilled;
+
+INSERT INTO merge_thr_t (body)
+SELECT 'w' || i || ' common' FROM generate_series(4001, 6000) i;
+
+SELECT bm25_force_merge('merge_thr_idx');
+
+-- One segment, written without a single sleep
+SELECT (SELECT sum(c) FROM unnest(level_counts) c) AS segments,
+       throttle_sleeps
+FROM bm25_merge_stats('merge_thr_idx');
+
+SET enable_seqscan = off;
+
+SELECT count(*) AS common_hits FROM (
+    SELECT id FROM merge_thr_t
+    ORDER BY body <@> to_bm25query('common', 'merge_thr_idx')
+    LIMIT 10000
+) sub;
+
+SELECT count(*) AS w4500_hits FROM (
+    SELECT id FROM merge_thr_t
+    ORDER BY body <@> to_bm25query('w4500', 'merge_thr_idx')
+    LIMIT 10
+) sub;
+
+RESET enable_seqscan;
+
+-- A parallel build holds no index lock.  More workers than a level
+-- holds keeps their segments in temp files, so the leader merges them
+-- into the index, and that merge sleeps.
+\set ECHO none
+\i test/sql/build_fixture.sql
+\set ECHO all
+
+SET pg_textsearch.segments_per_level = 2;
+SET min_parallel_table_scan_size = 0;
+SET maintenance_work_mem = '256MB';
+
+SELECT build_fixture_table('merge_thr_par_t');
+
+SET max_parallel_maintenance_workers = 4;
+CREATE INDEX merge_thr_par_idx ON merge_thr_par_t USING bm25(content)
+  WITH (text_config='simple');
+RESET max_parallel_maintenance_workers;
+
+SELECT level_counts, merge_rounds > 0 AS merged, throttle_sleeps > 0 AS slept
+FROM bm25_merge_stats('merge_thr_par_idx');
+
+SET enable_seqscan = off;
+SELECT COUNT(*) AS common_count FROM (SELECT 1 FROM merge_thr_par_t
+ORDER BY content <@> to_bm25query('common', 'merge_thr_par_idx')) sub;
+RESET enable_seqscan;
+
+-- The slot cap is cluster-wide, so it is a server setting
+SHOW pg_textsearch.max_concurrent_merges;
+SET pg_textsearch.max_concurrent_merges = 1;
+
+-- Out-of-range values are rejected
+SET pg_textsearch.merge_cost_limit = 0;
+SET pg_textsearch.merge_cost_delay = -1;
+
+DROP TABLE merge_thr_t;
+DROP TABLE merge_thr_par_t;
+RESET maintenance_work_mem;
+RESET min_parallel_table_scan_size;
+RESET pg_textsearch.merge_cost_limit;
+RESET pg_textsearch.merge_cost_delay;
+RESET pg_textsearch.bulk_load_threshold;
+RESET pg_textsearch.memtable_pages_threshold;
+RESET pg_textsearch.segments_per_level;
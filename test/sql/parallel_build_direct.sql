@@ -0,0 +1,56 @@
+-- Parallel build workers writing their segments into the index.
+--
+-- Each of the four workers' shares of this table fits its memory
+-- budget, so together they write fewer segments than a level holds.
+-- They write them straight into the index rather than temp files,
+-- and the leader links them into L0 without merging.  The index must
+-- answer like a serially built one.
+
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+\set ECHO none
+\i test/sql/build_fixture.sql
+\set ECHO all
+
+SET enable_seqscan = off;
+SET min_parallel_table_scan_size = 0;
+SET maintenance_work_mem = '256MB';
+
+SELECT build_fixture_table('pbd_t');
+
+SET max_parallel_maintenance_workers = 4;
+CREATE INDEX pbd_par_idx ON pbd_t USING bm25(content)
+  WITH (text_config='simple');
+
+SET max_parallel_maintenance_workers = 0;
+CREATE INDEX pbd_ser_idx ON pbd_t USING bm25(content)
+  WITH (text_config='simple');
+RESET max_parallel_maintenance_workers;
+
+-- The parallel build left several L0 segments, none merged into L1,
+-- and never merged its workers' segments
+SELECT i AS index_name, level_counts[1] > 1 AS several_l0,
+       level_counts[2] = 0 AS no_l1, merge_rounds > 0 AS merged
+FROM unnest(ARRAY['pbd_par_idx', 'pbd_ser_idx']) AS i,
+     bm25_merge_stats(i)
+ORDER BY i;
+
+SELECT COUNT(*) AS common_count FROM (SELECT 1 FROM pbd_t
+ORDER BY content <@> to_bm25query('common', 'pbd_par_idx')) sub;
+
+SELECT COUNT(*) AS g5_count FROM (SELECT 1 FROM pbd_t
+ORDER BY content <@> to_bm25query('g5', 'pbd_par_idx')) sub;
+
+-- Same matches and scores as the serial build
+SELECT build_fixture_mismatches('pbd_t', 'pbd_par_idx', 'pbd_ser_idx',
+                                'w17 w4242 w150001', 10) AS mismatches;
+
+-- New documents still go to the memtable and are found
+INSERT INTO pbd_t (content) VALUES ('doc fresh common');
+SELECT COUNT(*) AS fresh_count FROM (SELECT 1 FROM pbd_t
+ORDER BY content <@> to_bm25query('fresh', 'pbd_par_idx')) sub;
+
+DROP TABLE pbd_t;
+RESET maintenance_work_mem;
+RESET min_parallel_table_scan_size;
+RESET enable_seqscan;
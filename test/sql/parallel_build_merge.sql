@@ -0,0 +1,59 @@
+-- Merge rounds of a parallel build (pg_textsearch.parallel_build_merge_fanin).
+--
+-- With a fan-in of 2, the four workers' segments are merged into two
+-- by a round of parallel batch merges before the leader merges those
+-- into the index.  The index must answer like a serially built one.
+
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+\set ECHO none
+\i test/sql/build_fixture.sql
+\set ECHO all
+
+SET enable_seqscan = off;
+SET min_parallel_table_scan_size = 0;
+SET maintenance_work_mem = '256MB';
+
+SHOW pg_textsearch.parallel_build_merge_fanin;
+SET pg_textsearch.parallel_build_merge_fanin = 2;
+
+-- More workers than a level holds keeps their segments in temp files
+SET pg_textsearch.segments_per_level = 2;
+
+SELECT build_fixture_table('pbm_t');
+
+SET max_parallel_maintenance_workers = 4;
+CREATE INDEX pbm_par_idx ON pbm_t USING bm25(content)
+  WITH (text_config='simple');
+
+SET max_parallel_maintenance_workers = 0;
+CREATE INDEX pbm_ser_idx ON pbm_t USING bm25(content)
+  WITH (text_config='simple');
+RESET max_parallel_maintenance_workers;
+
+-- A single segment either way, but only the parallel build merged in
+-- rounds: at least one round of batches, then the final merge
+SELECT i AS index_name, level_counts, merge_rounds > 1 AS rounds
+FROM unnest(ARRAY['pbm_par_idx', 'pbm_ser_idx']) AS i,
+     bm25_merge_stats(i)
+ORDER BY i;
+
+SELECT COUNT(*) AS common_count FROM (SELECT 1 FROM pbm_t
+ORDER BY content <@> to_bm25query('common', 'pbm_par_idx')) sub;
+
+SELECT COUNT(*) AS g5_count FROM (SELECT 1 FROM pbm_t
+ORDER BY content <@> to_bm25query('g5', 'pbm_par_idx')) sub;
+
+-- Same matches and scores as the serial build
+SELECT build_fixture_mismatches('pbm_t', 'pbm_par_idx', 'pbm_ser_idx',
+                                'w17 w4242 w150001', 10) AS mismatches;
+
+-- Out-of-range values are rejected
+SET pg_textsearch.parallel_build_merge_fanin = 1;
+
+DROP TABLE pbm_t;
+RESET pg_textsearch.parallel_build_merge_fanin;
+RESET pg_textsearch.segments_per_level;
+RESET maintenance_work_mem;
+RESET min_parallel_table_scan_size;
+RESET enable_seqscan;
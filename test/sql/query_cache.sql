@@ -0,0 +1,103 @@
+-- Backend-local cache of tokenized query texts
+-- (pg_textsearch.query_cache_size).
+--
+-- Repeated query texts are tokenized once and then served from the
+-- cache, which must not change any result, must evict least recently
+-- used entries when full, and must forget everything when a text
+-- search configuration changes.
+
+SET client_min_messages = WARNING; -- suppress index-build NOTICE chatter
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+SHOW pg_textsearch.query_cache_size;
+
+CREATE TEXT SEARCH CONFIGURATION qc_cfg (COPY = simple);
+
+CREATE TABLE qc_docs (id int PRIMARY KEY, body text);
+INSERT INTO qc_docs
+SELECT i, 'doc w' || i
+          || CASE WHEN i % 10 = 0 THEN ' apples' ELSE '' END
+          || CASE WHEN i % 7 = 0 THEN ' pears' ELSE '' END
+FROM generate_series(1, 200) AS i;
+
+CREATE INDEX qc_idx ON qc_docs USING bm25(body)
+    WITH (text_config = 'qc_cfg');
+
+SET enable_seqscan = off;
+
+CREATE TABLE qc_results (run text, q text, score numeric);
+
+-- Tokenized on first use, then served from the cache
+INSERT INTO qc_results
+SELECT 'cold', 'apples', round((body <@> 'apples')::numeric, 4)
+FROM qc_docs ORDER BY body <@> 'apples' LIMIT 10;
+INSERT INTO qc_results
+SELECT 'cold', 'apples pears', round((body <@> 'apples pears')::numeric, 4)
+FROM qc_docs ORDER BY body <@> 'apples pears' LIMIT 10;
+
+INSERT INTO qc_results
+SELECT 'warm', 'apples', round((body <@> 'apples')::numeric, 4)
+FROM qc_docs ORDER BY body <@> 'apples' LIMIT 10;
+INSERT INTO qc_results
+SELECT 'warm', 'apples pears', round((body <@> 'apples pears')::numeric, 4)
+FROM qc_docs ORDER BY body <@> 'apples pears' LIMIT 10;
+
+-- Disabled
+SET pg_textsearch.query_cache_size = 0;
+
+INSERT INTO qc_results
+SELECT 'off', 'apples', round((body <@> 'apples')::numeric, 4)
+FROM qc_docs ORDER BY body <@> 'apples' LIMIT 10;
+INSERT INTO qc_results
+SELECT 'off', 'apples pears', round((body <@> 'apples pears')::numeric, 4)
+FROM qc_docs ORDER BY body <@> 'apples pears' LIMIT 10;
+
+-- One entry: each query evicts the other
+SET pg_textsearch.query_cache_size = 1;
+
+INSERT INTO qc_results
+SELECT 'evicting', 'apples', round((body <@> 'apples')::numeric, 4)
+FROM qc_docs ORDER BY body <@> 'apples' LIMIT 10;
+INSERT INTO qc_results
+SELECT 'evicting', 'apples pears',
+       round((body <@> 'apples pears')::numeric, 4)
+FROM qc_docs ORDER BY body <@> 'apples pears' LIMIT 10;
+
+RESET pg_textsearch.query_cache_size;
+
+-- Every run returned the same scores
+SELECT q, count(*) AS runs, count(DISTINCT scores) AS distinct_results
+FROM (SELECT run, q, string_agg(score::text, ',' ORDER BY score DESC) AS scores
+      FROM qc_results GROUP BY run, q) r
+GROUP BY q ORDER BY q;
+
+-- Match quals share the cache
+SELECT count(*) FROM qc_docs
+WHERE body @@@ to_bm25query('apples pears', 'qc_idx');
+SELECT count(*) FROM qc_docs
+WHERE body @@@ to_bm25query('apples pears', 'qc_idx');
+SELECT count(*) FROM qc_docs
+WHERE body @@& to_bm25query('apples pears', 'qc_idx');
+
+-- A configuration change is seen at once: 'apples' now stems to a
+-- term the index never stored
+ALTER TEXT SEARCH CONFIGURATION qc_cfg
+    ALTER MAPPING FOR asciiword WITH english_stem;
+
+SELECT count(*) FROM (
+    SELECT id FROM qc_docs ORDER BY body <@> 'apples' LIMIT 50) s;
+SELECT count(*) FROM qc_docs
+WHERE body @@@ to_bm25query('apples pears', 'qc_idx');
+
+ALTER TEXT SEARCH CONFIGURATION qc_cfg
+    ALTER MAPPING FOR asciiword WITH simple;
+
+SELECT count(*) FROM (
+    SELECT id FROM qc_docs ORDER BY body <@> 'apples' LIMIT 50) s;
+SELECT count(*) FROM qc_docs
+WHERE body @@@ to_bm25query('apples pears', 'qc_idx');
+
+DROP TABLE qc_results;
+DROP TABLE qc_docs;
+DROP TEXT SEARCH CONFIGURATION qc_cfg;
+RESET enable_seqscan;
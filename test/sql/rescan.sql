@@ -265,9 +265,138 @@ LATERAL (
 ) t
 ORDER BY v.x, t.id;
 
+------------------------------------------------------------------------
+-- Test 11: rescan memoization
+--
+-- Each outer row rescans with its own query text.  A rescan repeating
+-- the previous text restarts the batch it already scored; results must
+-- be those of a fresh scan, however the texts alternate.  Only the
+-- first scan and the two after a change of text score: a repeat
+-- reuses the batch (bm25_scoring_stats).  The planner's LIMIT reaches
+-- the first scan only and rescans rank default_limit rows, so the two
+-- are made equal here.
+------------------------------------------------------------------------
+
+SET pg_textsearch.default_limit = 3;
+
+SELECT scoring_passes AS passes0 FROM bm25_scoring_stats() \gset
+SELECT v.n, v.q, string_agg(t.category, ',' ORDER BY t.category)
+FROM (VALUES (1, 'database'), (2, 'database'), (3, 'enterprise'),
+             (4, 'enterprise'), (5, 'database')) AS v(n, q),
+LATERAL (
+    SELECT category FROM rescan_test
+    ORDER BY content <@> to_bm25query(v.q, 'rescan_idx')
+    LIMIT 3
+) t
+GROUP BY v.n, v.q
+ORDER BY v.n;
+
+SELECT scoring_passes - :passes0 AS scoring_passes FROM bm25_scoring_stats();
+
+------------------------------------------------------------------------
+-- Test 12: rescans that must score again
+--
+-- Only a batch that is the exact top of the whole index, scored at the
+-- index's current result generation, can be kept.  Match quals, a
+-- threshold shared with sibling partitions and a write to the index
+-- each make an identical rescan score again.
+------------------------------------------------------------------------
+
+-- Match quals: the batch holds only their matches
+SET enable_bitmapscan = off;
+SELECT scoring_passes AS passes0 FROM bm25_scoring_stats() \gset
+
+SELECT count(*) AS ranked
+FROM (VALUES ('database'), ('database'), ('database')) AS v(q),
+LATERAL (
+    SELECT id FROM rescan_test
+    WHERE content @@@ to_bm25query(v.q, 'rescan_idx')
+    ORDER BY content <@> to_bm25query(v.q, 'rescan_idx')
+    LIMIT 3
+) t;
+
+SELECT scoring_passes - :passes0 AS scoring_passes FROM bm25_scoring_stats();
+
+RESET enable_bitmapscan;
+
+-- A shared threshold: partition 0 fills its batch first, so partition
+-- 1's batch is cut at its kth score and the next rescan scores again.
+-- With sharing off, each partition scores once.
+SET client_min_messages = WARNING;
+CREATE TABLE rescan_parts (id int, part int, content text)
+    PARTITION BY RANGE (part);
+CREATE TABLE rescan_parts_0 PARTITION OF rescan_parts
+    FOR VALUES FROM (0) TO (1);
+CREATE TABLE rescan_parts_1 PARTITION OF rescan_parts
+    FOR VALUES FROM (1) TO (2);
+INSERT INTO rescan_parts
+SELECT i, p,
+       CASE WHEN p = 0 THEN 'database database database management'
+            ELSE 'the modern application framework provides a database '
+                 'connection pooling layer for enterprise deployments'
+       END
+FROM generate_series(0, 1) AS p, generate_series(1, 20) AS i;
+CREATE INDEX rescan_parts_idx ON rescan_parts
+USING bm25(content) WITH (text_config='english');
+SET client_min_messages = NOTICE;
+
+SET pg_textsearch.shared_topk = off;
+SELECT scoring_passes AS passes0 FROM bm25_scoring_stats() \gset
+
+SELECT count(*) AS ranked
+FROM generate_series(1, 3) AS g,
+LATERAL (
+    SELECT id FROM rescan_parts
+    WHERE id > -g
+    ORDER BY content <@> 'database'
+    LIMIT 3
+) t;
+
+SELECT scoring_passes - :passes0 AS scoring_passes FROM bm25_scoring_stats();
+
+SET pg_textsearch.shared_topk = on;
+SELECT scoring_passes AS passes0 FROM bm25_scoring_stats() \gset
+
+SELECT count(*) AS ranked
+FROM generate_series(1, 3) AS g,
+LATERAL (
+    SELECT id FROM rescan_parts
+    WHERE id > -g
+    ORDER BY content <@> 'database'
+    LIMIT 3
+) t;
+
+SELECT scoring_passes - :passes0 > 2 AS rescored FROM bm25_scoring_stats();
+
+RESET pg_textsearch.shared_topk;
+
+-- A write to the index between rescans advances its result generation
+CREATE FUNCTION rescan_touch(q text) RETURNS text LANGUAGE plpgsql AS $$
+BEGIN
+    INSERT INTO rescan_test (category, content)
+    VALUES ('touch', 'unrelated words');
+    RETURN q;
+END $$;
+SELECT scoring_passes AS passes0 FROM bm25_scoring_stats() \gset
+
+SELECT count(*) AS ranked
+FROM (SELECT rescan_touch('database') AS q
+      FROM generate_series(1, 3) OFFSET 0) AS v,
+LATERAL (
+    SELECT id FROM rescan_test
+    ORDER BY content <@> to_bm25query(v.q, 'rescan_idx')
+    LIMIT 3
+) t;
+
+SELECT scoring_passes - :passes0 AS scoring_passes FROM bm25_scoring_stats();
+
+SET pg_textsearch.default_limit = 1000;
+
 ------------------------------------------------------------------------
 -- Cleanup
 ------------------------------------------------------------------------
 DROP TABLE rescan_test CASCADE;
 DROP TABLE rescan_large CASCADE;
+DROP TABLE rescan_parts CASCADE;
+DROP FUNCTION rescan_touch(text);
 DROP EXTENSION pg_textsearch CASCADE;
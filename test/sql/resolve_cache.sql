@@ -0,0 +1,77 @@
+-- Cached implicit index resolution.
+--
+-- The BM25 index serving a column or expression is cached per backend
+-- and forgotten when the table's indexes change, so implicit <@>
+-- queries, prepared or not, always resolve to a current index and
+-- report ambiguity every time.
+
+SET client_min_messages = WARNING; -- suppress index-build NOTICE chatter
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+CREATE TABLE rc_docs (id int PRIMARY KEY, body text, meta jsonb);
+INSERT INTO rc_docs
+SELECT i, 'doc w' || i || CASE WHEN i % 10 = 0 THEN ' apple' ELSE '' END,
+       jsonb_build_object('title', 'title t' || i)
+FROM generate_series(1, 200) AS i;
+
+CREATE INDEX rc_idx_a ON rc_docs USING bm25(body)
+    WITH (text_config = 'simple');
+
+SET enable_seqscan = off;
+
+EXPLAIN (COSTS OFF)
+SELECT id FROM rc_docs ORDER BY body <@> 'apple' LIMIT 3;
+
+-- Resolved again, from the cache
+EXPLAIN (COSTS OFF)
+SELECT id FROM rc_docs ORDER BY body <@> 'apple' LIMIT 3;
+
+PREPARE rc_top AS
+SELECT id FROM rc_docs ORDER BY body <@> 'apple' LIMIT 3;
+PREPARE rc_count AS
+SELECT count(*) FROM (
+    SELECT id FROM rc_docs ORDER BY body <@> 'apple' LIMIT 30) s;
+
+EXPLAIN (COSTS OFF) EXECUTE rc_top;
+EXECUTE rc_count;
+
+-- Replace the index: new queries and the prepared ones follow it
+DROP INDEX rc_idx_a;
+CREATE INDEX rc_idx_b ON rc_docs USING bm25(body)
+    WITH (text_config = 'simple');
+
+EXPLAIN (COSTS OFF)
+SELECT id FROM rc_docs ORDER BY body <@> 'apple' LIMIT 3;
+EXPLAIN (COSTS OFF) EXECUTE rc_top;
+EXECUTE rc_count;
+
+-- A second index on the column warns on every resolution
+CREATE INDEX rc_idx_c ON rc_docs USING bm25(body)
+    WITH (text_config = 'simple');
+SELECT count(*) FROM (
+    SELECT id FROM rc_docs ORDER BY body <@> 'apple' LIMIT 30) s;
+SELECT count(*) FROM (
+    SELECT id FROM rc_docs ORDER BY body <@> 'apple' LIMIT 30) s;
+DROP INDEX rc_idx_c;
+
+-- Expressions are cached too
+CREATE INDEX rc_expr_a ON rc_docs USING bm25((meta->>'title'))
+    WITH (text_config = 'simple');
+
+EXPLAIN (COSTS OFF)
+SELECT id FROM rc_docs ORDER BY (meta->>'title') <@> 't7' LIMIT 3;
+
+DROP INDEX rc_expr_a;
+CREATE INDEX rc_expr_b ON rc_docs USING bm25((meta->>'title'))
+    WITH (text_config = 'simple');
+
+EXPLAIN (COSTS OFF)
+SELECT id FROM rc_docs ORDER BY (meta->>'title') <@> 't7' LIMIT 3;
+
+-- Non-BM25 statements are unaffected
+SELECT count(*) FROM rc_docs WHERE body LIKE '%apple';
+
+DEALLOCATE rc_top;
+DEALLOCATE rc_count;
+DROP TABLE rc_docs;
+RESET enable_seqscan;
@@ -0,0 +1,100 @@
+-- Shared top-k result cache (pg_textsearch.result_cache).
+--
+-- A ranked scan repeated against an unchanged index is answered from
+-- the cache.  Any change to the index makes its entries miss, unless
+-- pg_textsearch.result_cache_staleness admits them, and a VACUUM makes
+-- them miss regardless.  Cached results must match computed ones.
+
+SET client_min_messages = WARNING; -- suppress index-build NOTICE chatter
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+SHOW pg_textsearch.result_cache;
+SHOW pg_textsearch.result_cache_entries;
+SHOW pg_textsearch.result_cache_staleness;
+SELECT entries FROM bm25_result_cache_stats();
+
+-- Every 10th document has 'apples', in ever longer documents, so the
+-- ranking is strictly by id
+CREATE TABLE rc_docs (id int PRIMARY KEY, body text);
+INSERT INTO rc_docs
+SELECT i, 'doc' || repeat(' filler', i)
+          || CASE WHEN i % 10 = 0 THEN ' apples' ELSE '' END
+          || CASE WHEN i % 7 = 0 THEN ' pears' ELSE '' END
+FROM generate_series(1, 100) AS i;
+
+CREATE INDEX rc_idx ON rc_docs USING bm25(body)
+    WITH (text_config = 'simple');
+
+SET enable_seqscan = off;
+SET pg_textsearch.result_cache = on;
+
+-- Hits and misses since here
+CREATE TABLE rc_base AS SELECT hits, misses FROM bm25_result_cache_stats();
+CREATE TABLE rc_results (run text, id int, score float8);
+
+-- Computed, then served from the cache
+SELECT id FROM rc_docs ORDER BY body <@> 'apples' LIMIT 5;
+SELECT id FROM rc_docs ORDER BY body <@> 'apples' LIMIT 5;
+SELECT s.hits - b.hits AS hits, s.misses - b.misses AS misses
+FROM bm25_result_cache_stats() s, rc_base b;
+
+-- Word order does not matter; the limit does
+SELECT count(*) FROM (
+    SELECT id FROM rc_docs ORDER BY body <@> 'apples pears' LIMIT 5) s;
+SELECT count(*) FROM (
+    SELECT id FROM rc_docs ORDER BY body <@> 'pears apples' LIMIT 5) s;
+SELECT id FROM rc_docs ORDER BY body <@> 'apples' LIMIT 3;
+SELECT s.hits - b.hits AS hits, s.misses - b.misses AS misses
+FROM bm25_result_cache_stats() s, rc_base b;
+
+-- An insert is seen at once
+INSERT INTO rc_docs VALUES (1000, 'apples apples');
+SELECT id FROM rc_docs ORDER BY body <@> 'apples' LIMIT 5;
+SELECT id FROM rc_docs ORDER BY body <@> 'apples' LIMIT 5;
+SELECT s.hits - b.hits AS hits, s.misses - b.misses AS misses
+FROM bm25_result_cache_stats() s, rc_base b;
+
+-- ...unless stale results are allowed: 1001 is missing
+SET pg_textsearch.result_cache_staleness = '1h';
+INSERT INTO rc_docs VALUES (1001, 'apples');
+SELECT id FROM rc_docs ORDER BY body <@> 'apples' LIMIT 5;
+SELECT s.hits - b.hits AS hits, s.misses - b.misses AS misses
+FROM bm25_result_cache_stats() s, rc_base b;
+
+-- VACUUM frees CTIDs for reuse, so nothing from before it is served
+DELETE FROM rc_docs WHERE id >= 1000;
+VACUUM rc_docs;
+SELECT id FROM rc_docs ORDER BY body <@> 'apples' LIMIT 5;
+INSERT INTO rc_results
+SELECT 'cached', id, body <@> 'apples'
+FROM rc_docs ORDER BY body <@> 'apples' LIMIT 5;
+SELECT s.hits - b.hits AS hits, s.misses - b.misses AS misses
+FROM bm25_result_cache_stats() s, rc_base b;
+RESET pg_textsearch.result_cache_staleness;
+
+-- Scans with match quals are always computed
+SELECT id FROM rc_docs
+WHERE body @@@ to_bm25query('apples pears', 'rc_idx')
+ORDER BY body <@> 'apples' LIMIT 5;
+SELECT s.hits - b.hits AS hits, s.misses - b.misses AS misses
+FROM bm25_result_cache_stats() s, rc_base b;
+
+-- Disabled
+SET pg_textsearch.result_cache = off;
+INSERT INTO rc_results
+SELECT 'off', id, body <@> 'apples'
+FROM rc_docs ORDER BY body <@> 'apples' LIMIT 5;
+SELECT s.hits - b.hits AS hits, s.misses - b.misses AS misses
+FROM bm25_result_cache_stats() s, rc_base b;
+
+-- Cached and computed scores agree
+SELECT c.id, c.score = o.score AS same_score
+FROM rc_results c JOIN rc_results o USING (id)
+WHERE c.run = 'cached' AND o.run = 'off'
+ORDER BY c.id;
+
+RESET pg_textsearch.result_cache;
+DROP TABLE rc_results;
+DROP TABLE rc_base;
+DROP TABLE rc_docs;
+RESET enable_seqscan;
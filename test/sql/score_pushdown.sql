@@ -0,0 +1,187 @@
+-- Score bounds pushed into BM25 scans (pg_textsearch.score_pushdown).
+--
+-- A ranked scan whose filter bounds its own score by a constant scores
+-- nothing below the bound and ends there, with or without a LIMIT.
+-- Results must match the executor applying the bound alone, for every
+-- comparison form and across partitions.
+
+SET client_min_messages = WARNING; -- suppress index-build NOTICE chatter
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+SHOW pg_textsearch.score_pushdown;
+
+-- Every 10th document has 'apples', in ever longer documents, so the
+-- ranking is strictly by id
+CREATE TABLE sp_docs (id int PRIMARY KEY, body text);
+INSERT INTO sp_docs
+SELECT i, 'doc' || repeat(' filler', i)
+          || CASE WHEN i % 10 = 0 THEN ' apples' ELSE '' END
+          || CASE WHEN i % 7 = 0 THEN ' pears' ELSE '' END
+FROM generate_series(1, 300) AS i;
+
+CREATE INDEX sp_idx ON sp_docs USING bm25(body)
+    WITH (text_config = 'simple');
+
+-- Later rows land in the memtable
+INSERT INTO sp_docs
+SELECT i, 'doc' || repeat(' filler', i)
+          || CASE WHEN i % 10 = 0 THEN ' apples' ELSE '' END
+          || CASE WHEN i % 7 = 0 THEN ' pears' ELSE '' END
+FROM generate_series(301, 400) AS i;
+
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+
+-- Bounds halfway between the 5th and 6th, and the 25th and 26th, best
+-- 'apples' scores, and the 5th best score itself
+SELECT avg(score) FILTER (WHERE rank IN (5, 6)) AS bound5,
+       avg(score) FILTER (WHERE rank IN (25, 26)) AS bound25,
+       min(score) FILTER (WHERE rank = 5) AS score5
+FROM (SELECT body <@> 'apples' AS score,
+             row_number() OVER (ORDER BY id) AS rank
+      FROM sp_docs WHERE id % 10 = 0) s \gset
+
+-- The filter compares the scan's own score
+EXPLAIN (COSTS OFF)
+SELECT id FROM sp_docs
+WHERE body <@> 'apples' < -1000
+ORDER BY body <@> 'apples' LIMIT 10;
+
+CREATE TABLE sp_results (pushed bool, q text, id int);
+
+CREATE FUNCTION sp_run(
+    pushed bool, bound5 float8, bound25 float8, score5 float8)
+RETURNS void LANGUAGE plpgsql AS $$
+BEGIN
+    EXECUTE format('SET pg_textsearch.score_pushdown = %s', pushed);
+
+    -- Fewer rows pass than the LIMIT asks for
+    EXECUTE format($q$
+        INSERT INTO sp_results
+        SELECT %s, 'lt limit', id FROM sp_docs
+        WHERE body <@> 'apples' < %s
+        ORDER BY body <@> 'apples' LIMIT 10$q$, pushed, bound5);
+
+    -- More rows pass than the LIMIT asks for
+    EXECUTE format($q$
+        INSERT INTO sp_results
+        SELECT %s, 'le limit', id FROM sp_docs
+        WHERE body <@> 'apples' <= %s
+        ORDER BY body <@> 'apples' LIMIT 3$q$, pushed, bound5);
+
+    -- A bound some row scores exactly, which it passes
+    EXECUTE format($q$
+        INSERT INTO sp_results
+        SELECT %s, 'le equal', id FROM sp_docs
+        WHERE body <@> 'apples' <= %s
+        ORDER BY body <@> 'apples' LIMIT 10$q$, pushed, score5);
+
+    -- No LIMIT, bound first
+    EXECUTE format($q$
+        INSERT INTO sp_results
+        SELECT %s, 'gt', id FROM sp_docs
+        WHERE %s > body <@> 'apples'
+        ORDER BY body <@> 'apples'$q$, pushed, bound25);
+
+    -- Another filter discards rows above the bound
+    EXECUTE format($q$
+        INSERT INTO sp_results
+        SELECT %s, 'filtered', id FROM sp_docs
+        WHERE body <@> 'apples' < %s AND id %% 20 = 0
+        ORDER BY body <@> 'apples' LIMIT 50$q$, pushed, bound25);
+
+    -- Two bounds: the higher one wins
+    EXECUTE format($q$
+        INSERT INTO sp_results
+        SELECT %s, 'two bounds', id FROM sp_docs
+        WHERE body <@> 'apples' < %s AND body <@> 'apples' < %s
+        ORDER BY body <@> 'apples'$q$, pushed, bound25, bound5);
+
+    -- Several terms
+    EXECUTE format($q$
+        INSERT INTO sp_results
+        SELECT %s, 'apples pears', id FROM sp_docs
+        WHERE body <@> 'apples pears' < %s
+        ORDER BY body <@> 'apples pears' LIMIT 100$q$, pushed, bound25);
+
+    -- Nothing reaches the bound
+    EXECUTE format($q$
+        INSERT INTO sp_results
+        SELECT %s, 'none', id FROM sp_docs
+        WHERE body <@> 'apples' < -1000
+        ORDER BY body <@> 'apples' LIMIT 10$q$, pushed);
+
+    -- Every row passes a bound of zero or more
+    EXECUTE format($q$
+        INSERT INTO sp_results
+        SELECT %s, 'all', id FROM sp_docs
+        WHERE body <@> 'apples' < 0.5
+        ORDER BY body <@> 'apples' LIMIT 10$q$, pushed);
+
+    RESET pg_textsearch.score_pushdown;
+END $$;
+
+SELECT sp_run(true, :bound5, :bound25, :score5);
+SELECT sp_run(false, :bound5, :bound25, :score5);
+
+SELECT q, count(*) FILTER (WHERE pushed) AS pushed_rows,
+       count(*) FILTER (WHERE NOT pushed) AS filtered_rows
+FROM sp_results WHERE q <> 'apples pears' GROUP BY q ORDER BY q;
+
+-- Same rows either way
+SELECT count(*) AS mismatches FROM (
+    (SELECT q, id FROM sp_results WHERE pushed
+     EXCEPT ALL
+     SELECT q, id FROM sp_results WHERE NOT pushed)
+    UNION ALL
+    (SELECT q, id FROM sp_results WHERE NOT pushed
+     EXCEPT ALL
+     SELECT q, id FROM sp_results WHERE pushed)
+) diff;
+
+SELECT id FROM sp_results WHERE pushed AND q = 'lt limit' ORDER BY id;
+
+-- A prepared statement's bound is pushed once planned as a constant
+PREPARE sp_bounded(float8) AS
+SELECT id FROM sp_docs
+WHERE body <@> 'apples' < $1
+ORDER BY body <@> 'apples' LIMIT 10;
+EXECUTE sp_bounded(:bound5);
+DEALLOCATE sp_bounded;
+
+-- Partitions: each scan is bounded by the same constant.  Both hold
+-- the same documents, so their scores agree with the executor's.
+CREATE TABLE sp_parts (id int, body text) PARTITION BY RANGE (id);
+CREATE TABLE sp_parts_1 PARTITION OF sp_parts FOR VALUES FROM (1) TO (201);
+CREATE TABLE sp_parts_2 PARTITION OF sp_parts FOR VALUES FROM (201) TO (401);
+INSERT INTO sp_parts
+SELECT id + 200 * half, body
+FROM sp_docs, generate_series(0, 1) AS half WHERE id <= 200;
+CREATE INDEX sp_parts_idx ON sp_parts USING bm25(body)
+    WITH (text_config = 'simple');
+
+SELECT avg(score) FILTER (WHERE rank IN (4, 5)) AS part_bound
+FROM (SELECT body <@> 'apples' AS score,
+             row_number() OVER (ORDER BY id) AS rank
+      FROM sp_parts WHERE id <= 200 AND id % 10 = 0) s \gset
+
+SELECT id FROM (
+    SELECT id FROM sp_parts
+    WHERE body <@> 'apples' < :part_bound
+    ORDER BY body <@> 'apples' LIMIT 20) p
+ORDER BY id;
+
+SET pg_textsearch.score_pushdown = off;
+SELECT id FROM (
+    SELECT id FROM sp_parts
+    WHERE body <@> 'apples' < :part_bound
+    ORDER BY body <@> 'apples' LIMIT 20) p
+ORDER BY id;
+RESET pg_textsearch.score_pushdown;
+
+DROP TABLE sp_parts;
+DROP FUNCTION sp_run;
+DROP TABLE sp_results;
+DROP TABLE sp_docs;
+RESET enable_bitmapscan;
+RESET enable_seqscan;
@@ -0,0 +1,159 @@
+-- Cross-partition top-k threshold sharing (pg_textsearch.shared_topk).
+--
+-- A LIMIT over a partitioned table merges each partition's ranked
+-- scan.  With sharing on, a partition's scan skips documents scoring
+-- below the kth score an earlier partition found, and a partition
+-- that cannot reach it ranks only its best row for the merge to start
+-- from, scoring the rest once the merge gets that far.  Results must
+-- match the unshared scans exactly, including when a filter above the
+-- scans discards rows and a pruned partition has to be scanned again;
+-- bm25_scoring_stats() shows the skipped scoring work.
+
+SET client_min_messages = WARNING; -- suppress index-build NOTICE chatter
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+SHOW pg_textsearch.shared_topk;
+
+CREATE TABLE stk_docs (id int, part int, content text)
+    PARTITION BY RANGE (part);
+
+DO $$
+BEGIN
+    FOR p IN 0..7 LOOP
+        EXECUTE format(
+            'CREATE TABLE stk_docs_%s PARTITION OF stk_docs
+             FOR VALUES FROM (%s) TO (%s)',
+            p, p, p + 1);
+    END LOOP;
+END $$;
+
+-- Earlier partitions hold the stronger 'alpha' matches; in partition 5
+-- every document has it, so its best possible score is tiny
+INSERT INTO stk_docs
+SELECT i, p,
+       repeat('alpha ',
+              CASE WHEN i % 3 = 0 OR p = 5 THEN 1 + i % (8 - p) ELSE 0 END)
+       || CASE WHEN i % 5 = 0 THEN 'beta ' ELSE '' END
+       || CASE WHEN p = 6 THEN 'gamma ' ELSE '' END
+       || 'w' || i || ' filler' || repeat(' pad', i % 4)
+FROM generate_series(0, 7) AS p,
+     generate_series(p * 1000 + 1, p * 1000 + 600) AS i;
+
+CREATE INDEX stk_idx ON stk_docs USING bm25(content)
+    WITH (text_config = 'simple');
+
+-- Later rows land in each partition's memtable
+INSERT INTO stk_docs
+SELECT i, p,
+       repeat('alpha ',
+              CASE WHEN i % 3 = 0 OR p = 5 THEN 1 + i % (8 - p) ELSE 0 END)
+       || CASE WHEN i % 5 = 0 THEN 'beta ' ELSE '' END
+       || CASE WHEN p = 6 THEN 'gamma ' ELSE '' END
+       || 'w' || i || ' filler' || repeat(' pad', i % 4)
+FROM generate_series(0, 7) AS p,
+     generate_series(p * 1000 + 601, p * 1000 + 1000) AS i;
+ANALYZE stk_docs;
+
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+
+CREATE TABLE stk_results (shared bool, q text, score numeric);
+
+-- Each query with sharing off, then on
+SET pg_textsearch.shared_topk = off;
+
+INSERT INTO stk_results
+SELECT false, 'alpha', round((content <@> 'alpha')::numeric, 4)
+FROM stk_docs ORDER BY content <@> 'alpha' LIMIT 10;
+
+INSERT INTO stk_results
+SELECT false, 'alpha beta', round((content <@> 'alpha beta')::numeric, 4)
+FROM stk_docs ORDER BY content <@> 'alpha beta' LIMIT 10;
+
+-- Only partition 6 has 'gamma'
+INSERT INTO stk_results
+SELECT false, 'gamma', round((content <@> 'gamma')::numeric, 4)
+FROM stk_docs ORDER BY content <@> 'gamma' LIMIT 5;
+
+-- The filter discards most of each partition's top rows
+INSERT INTO stk_results
+SELECT false, 'alpha filtered', round((content <@> 'alpha')::numeric, 4)
+FROM stk_docs WHERE id % 7 = 0
+ORDER BY content <@> 'alpha' LIMIT 10;
+
+-- More rows than match: every partition is read to the end
+INSERT INTO stk_results
+SELECT false, 'beta', round((content <@> 'beta')::numeric, 4)
+FROM stk_docs ORDER BY content <@> 'beta' LIMIT 2000;
+
+SET pg_textsearch.shared_topk = on;
+
+INSERT INTO stk_results
+SELECT true, 'alpha', round((content <@> 'alpha')::numeric, 4)
+FROM stk_docs ORDER BY content <@> 'alpha' LIMIT 10;
+
+INSERT INTO stk_results
+SELECT true, 'alpha beta', round((content <@> 'alpha beta')::numeric, 4)
+FROM stk_docs ORDER BY content <@> 'alpha beta' LIMIT 10;
+
+INSERT INTO stk_results
+SELECT true, 'gamma', round((content <@> 'gamma')::numeric, 4)
+FROM stk_docs ORDER BY content <@> 'gamma' LIMIT 5;
+
+INSERT INTO stk_results
+SELECT true, 'alpha filtered', round((content <@> 'alpha')::numeric, 4)
+FROM stk_docs WHERE id % 7 = 0
+ORDER BY content <@> 'alpha' LIMIT 10;
+
+INSERT INTO stk_results
+SELECT true, 'beta', round((content <@> 'beta')::numeric, 4)
+FROM stk_docs ORDER BY content <@> 'beta' LIMIT 2000;
+
+RESET pg_textsearch.shared_topk;
+
+SELECT q, count(*) FILTER (WHERE shared) AS shared_rows,
+       count(*) FILTER (WHERE NOT shared) AS unshared_rows
+FROM stk_results GROUP BY q ORDER BY q;
+
+-- Same scores either way
+SELECT count(*) AS mismatches FROM (
+    (SELECT q, score FROM stk_results WHERE shared
+     EXCEPT ALL
+     SELECT q, score FROM stk_results WHERE NOT shared)
+    UNION ALL
+    (SELECT q, score FROM stk_results WHERE NOT shared
+     EXCEPT ALL
+     SELECT q, score FROM stk_results WHERE shared)
+) diff;
+
+-- The merged order holds across the partitions
+SELECT count(*) AS out_of_order FROM (
+    SELECT score, lag(score) OVER (ORDER BY ord) AS prev
+    FROM (SELECT score, row_number() OVER () AS ord
+          FROM (SELECT content <@> 'alpha' AS score FROM stk_docs
+                ORDER BY content <@> 'alpha' LIMIT 50) top) numbered
+) s WHERE score < prev;
+
+-- Scoring work for one LIMIT: with sharing off no partition is
+-- skipped; with it on, partition 5 cannot reach the kth score and is
+-- skipped, and the seeded threshold scores fewer documents in total
+SET pg_textsearch.shared_topk = off;
+SELECT indexes_skipped AS skipped0, docs_scored AS docs0
+FROM bm25_scoring_stats() \gset
+SELECT count(*) AS top_rows FROM (
+    SELECT id FROM stk_docs ORDER BY content <@> 'alpha' LIMIT 10) top;
+SELECT indexes_skipped AS skipped1, docs_scored AS docs1
+FROM bm25_scoring_stats() \gset
+SET pg_textsearch.shared_topk = on;
+SELECT count(*) AS top_rows FROM (
+    SELECT id FROM stk_docs ORDER BY content <@> 'alpha' LIMIT 10) top;
+RESET pg_textsearch.shared_topk;
+SELECT :skipped1 - :skipped0 AS unshared_skipped,
+       indexes_skipped - :skipped1 > 0 AS shared_skipped,
+       docs_scored - :docs1 < :docs1 - :docs0 AS fewer_docs
+FROM bm25_scoring_stats();
+
+DROP TABLE stk_results;
+DROP TABLE stk_docs;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
@@ -0,0 +1,87 @@
+-- VACUUM merges segments whose dead-doc share reaches
+-- merge_deletes_pct, together with the segments ahead of them on
+-- their level, so queries stop reading the dead postings.
+
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+SET pg_textsearch.segments_per_level = 64;
+SET pg_textsearch.memtable_pages_threshold = 0;
+SET pg_textsearch.bulk_load_threshold = 0;
+
+CREATE TABLE vac_cmp_t (id int, body text);
+CREATE TABLE vac_keep_t (id int, body text);
+
+CREATE INDEX vac_cmp_idx ON vac_cmp_t
+    USING bm25(body) WITH (text_config = 'simple');
+CREATE INDEX vac_keep_idx ON vac_keep_t
+    USING bm25(body) WITH (text_config = 'simple', merge_deletes_pct = 0);
+
+-- Four L0 segments of 1000 docs each; the newest is at the chain head
+DO $$
+BEGIN
+    FOR s IN 0..3 LOOP
+        INSERT INTO vac_cmp_t
+        SELECT i, 'w' || i || ' common'
+        FROM generate_series(s * 1000 + 1, (s + 1) * 1000) i;
+        INSERT INTO vac_keep_t
+        SELECT i, 'w' || i || ' common'
+        FROM generate_series(s * 1000 + 1, (s + 1) * 1000) i;
+        PERFORM bm25_spill_index('vac_cmp_idx');
+        PERFORM bm25_spill_index('vac_keep_idx');
+    END LOOP;
+END $$;
+
+-- Half of the second segment goes; a tenth of the others
+DELETE FROM vac_cmp_t WHERE id BETWEEN 1001 AND 1500 OR id % 10 = 0;
+DELETE FROM vac_keep_t WHERE id BETWEEN 1001 AND 1500 OR id % 10 = 0;
+
+VACUUM vac_cmp_t;
+VACUUM vac_keep_t;
+
+-- In vac_cmp_idx one merge took the three segments up to the
+-- dead-heavy one into L1; merge_deletes_pct = 0 left vac_keep_idx alone
+SELECT i AS index_name, level_counts, merges
+FROM unnest(ARRAY['vac_cmp_idx', 'vac_keep_idx']) AS i,
+     bm25_merge_stats(i)
+ORDER BY i;
+
+SET enable_seqscan = off;
+
+SELECT count(*) AS common_hits FROM (
+    SELECT id FROM vac_cmp_t
+    ORDER BY body <@> to_bm25query('common', 'vac_cmp_idx')
+    LIMIT 5000
+) sub;
+
+SELECT count(*) AS deleted_hits FROM (
+    SELECT id FROM vac_cmp_t
+    ORDER BY body <@> to_bm25query('w1200 w3000', 'vac_cmp_idx')
+    LIMIT 10
+) sub;
+
+-- Same matches and scores as the index that kept its segments
+WITH cmp AS (
+    SELECT id, round((body <@> to_bm25query('w17 w1601 w3333', 'vac_cmp_idx'))
+                     ::numeric, 6) AS score
+    FROM vac_cmp_t
+    ORDER BY body <@> to_bm25query('w17 w1601 w3333', 'vac_cmp_idx')
+    LIMIT 10),
+keep AS (
+    SELECT id, round((body <@> to_bm25query('w17 w1601 w3333', 'vac_keep_idx'))
+                     ::numeric, 6) AS score
+    FROM vac_keep_t
+    ORDER BY body <@> to_bm25query('w17 w1601 w3333', 'vac_keep_idx')
+    LIMIT 10)
+SELECT count(*) AS mismatches FROM (
+    (SELECT * FROM cmp EXCEPT ALL SELECT * FROM keep)
+    UNION ALL
+    (SELECT * FROM keep EXCEPT ALL SELECT * FROM cmp)
+) diff;
+
+RESET enable_seqscan;
+
+DROP TABLE vac_cmp_t;
+DROP TABLE vac_keep_t;
+RESET pg_textsearch.bulk_load_threshold;
+RESET pg_textsearch.memtable_pages_threshold;
+RESET pg_textsearch.segments_per_level;
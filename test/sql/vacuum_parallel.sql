@@ -0,0 +1,99 @@
+-- Parallel bulk-delete across an index's segments in VACUUM.
+--
+-- With enough segments, VACUUM spreads the docmap reads and alive
+-- bitset marking of one bm25 index over max_parallel_maintenance_workers
+-- workers.  Vacuum the same five-segment index with and without
+-- workers and check that they answer alike, and that only the first
+-- launched any.
+
+CREATE EXTENSION IF NOT EXISTS pg_textsearch;
+
+SET pg_textsearch.segments_per_level = 64;
+SET pg_textsearch.memtable_pages_threshold = 0;
+SET pg_textsearch.bulk_load_threshold = 0;
+
+-- No other index, so PostgreSQL's own parallel vacuum stays out
+CREATE TABLE vac_par_t (id int, body text);
+CREATE TABLE vac_ser_t (id int, body text);
+
+CREATE INDEX vac_par_idx ON vac_par_t
+    USING bm25(body) WITH (text_config = 'simple');
+CREATE INDEX vac_ser_idx ON vac_ser_t
+    USING bm25(body) WITH (text_config = 'simple');
+
+-- Five segments of 3000 docs each
+DO $$
+BEGIN
+    FOR s IN 0..4 LOOP
+        INSERT INTO vac_par_t
+        SELECT i, 'w' || i || ' common g' || (i % 20)
+        FROM generate_series(s * 3000 + 1, (s + 1) * 3000) i;
+        INSERT INTO vac_ser_t
+        SELECT i, 'w' || i || ' common g' || (i % 20)
+        FROM generate_series(s * 3000 + 1, (s + 1) * 3000) i;
+        PERFORM bm25_spill_index('vac_par_idx');
+        PERFORM bm25_spill_index('vac_ser_idx');
+    END LOOP;
+END $$;
+
+SELECT (SELECT sum(c) FROM unnest(level_counts) c) AS segments
+FROM bm25_merge_stats('vac_par_idx');
+
+-- Every segment loses docs; the second loses all of them
+DELETE FROM vac_par_t WHERE id % 7 = 0 OR id BETWEEN 3001 AND 6000;
+DELETE FROM vac_ser_t WHERE id % 7 = 0 OR id BETWEEN 3001 AND 6000;
+
+SET max_parallel_maintenance_workers = 4;
+VACUUM vac_par_t;
+SET max_parallel_maintenance_workers = 0;
+VACUUM vac_ser_t;
+RESET max_parallel_maintenance_workers;
+
+-- The fully deleted segment is gone; only vac_par_idx used workers
+SELECT i AS index_name,
+       (SELECT sum(c) FROM unnest(level_counts) c) AS segments,
+       parallel_workers > 0 AS parallel
+FROM unnest(ARRAY['vac_par_idx', 'vac_ser_idx']) AS i,
+     bm25_merge_stats(i)
+ORDER BY i;
+
+SET enable_seqscan = off;
+
+SELECT count(*) AS common_hits FROM (
+    SELECT id FROM vac_par_t
+    ORDER BY body <@> to_bm25query('common', 'vac_par_idx')
+    LIMIT 20000
+) sub;
+
+SELECT count(*) AS deleted_hits FROM (
+    SELECT id FROM vac_par_t
+    ORDER BY body <@> to_bm25query('w7 w4500 w14000', 'vac_par_idx')
+    LIMIT 10
+) sub;
+
+-- Same matches and scores as the serially vacuumed index
+WITH par AS (
+    SELECT id, round((body <@> to_bm25query('g3 w101', 'vac_par_idx'))
+                     ::numeric, 6) AS score
+    FROM vac_par_t
+    ORDER BY body <@> to_bm25query('g3 w101', 'vac_par_idx')
+    LIMIT 1000),
+ser AS (
+    SELECT id, round((body <@> to_bm25query('g3 w101', 'vac_ser_idx'))
+                     ::numeric, 6) AS score
+    FROM vac_ser_t
+    ORDER BY body <@> to_bm25query('g3 w101', 'vac_ser_idx')
+    LIMIT 1000)
+SELECT count(*) AS mismatches FROM (
+    (SELECT * FROM par EXCEPT ALL SELECT * FROM ser)
+    UNION ALL
+    (SELECT * FROM ser EXCEPT ALL SELECT * FROM par)
+) diff;
+
+RESET enable_seqscan;
+
+DROP TABLE vac_par_t;
+DROP TABLE vac_ser_t;
+RESET pg_textsearch.bulk_load_threshold;
+RESET pg_textsearch.memtable_pages_threshold;
+RESET pg_textsearch.segments_per_level;